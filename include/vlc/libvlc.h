@@ -398,6 +398,44 @@ VLC_PUBLIC_API int
    libvlc_media_is_preparsed( libvlc_media_t * p_md,
                                          libvlc_exception_t * p_e );
 
+/**
+ * Get the statistics of a media descriptor object, as computed by the last
+ * input thread that played it. They are only final once the media player
+ * has been stopped.
+ *
+ * \param p_md media descriptor object
+ * \param p_stats structure that receives the statistics
+ * \param p_e an initialized exception object
+ * \return true if statistics are available, false otherwise
+ */
+VLC_PUBLIC_API int
+   libvlc_media_get_stats( libvlc_media_t * p_md,
+                                      libvlc_media_stats_t * p_stats,
+                                      libvlc_exception_t * p_e );
+
+/**
+ * Save thumbnails of a media descriptor object, taken at evenly spaced
+ * positions. The media is opened once for all of them, and only the key
+ * frame nearest to each position is decoded.
+ *
+ * \param p_md media descriptor object
+ * \param psz_filepath path of the image, whose extension gives the format;
+ *        with several thumbnails, their number (from 1) is inserted before
+ *        the extension, as in "thumb-00001.png"
+ * \param i_count number of thumbnails
+ * \param i_width the thumbnail's width, 0 to keep the aspect ratio
+ * \param i_height the thumbnail's height, 0 to keep the aspect ratio
+ * \param p_e an initialized exception object
+ * \return the number of thumbnails saved
+ */
+VLC_PUBLIC_API int
+   libvlc_media_save_thumbnails( libvlc_media_t * p_md,
+                                 const char * psz_filepath,
+                                 unsigned int i_count,
+                                 unsigned int i_width,
+                                 unsigned int i_height,
+                                 libvlc_exception_t * p_e );
+
 /**
  * Sets media descriptor's user_data. user_data is specialized data 
  * accessed by the host application, VLC.framework uses it as a pointer to 
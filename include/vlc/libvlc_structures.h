@@ -110,6 +110,39 @@ typedef enum libvlc_meta_t {
 
 typedef struct libvlc_media_t libvlc_media_t;
 
+/**
+ * Statistics of a media, as gathered by its last input thread.
+ * Bitrates are in kilobytes per second.
+ */
+typedef struct libvlc_media_stats_t
+{
+    /* Input */
+    int         i_read_bytes;
+    float       f_input_bitrate;
+
+    /* Demux */
+    int         i_demux_read_packets;
+    int         i_demux_read_bytes;
+    float       f_demux_bitrate;
+
+    /* Decoders */
+    int         i_decoded_video;
+    int         i_decoded_audio;
+
+    /* Video Output */
+    int         i_displayed_pictures;
+    int         i_lost_pictures;
+
+    /* Audio output */
+    int         i_played_abuffers;
+    int         i_lost_abuffers;
+
+    /* Stream output */
+    int         i_sent_packets;
+    int         i_sent_bytes;
+    float       f_send_bitrate;
+} libvlc_media_stats_t;
+
 /**@} */
 
 
@@ -26,6 +26,10 @@
 
 #include <vlc_block.h>
 
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
 typedef struct block_bytestream_t
 {
     block_t             *p_chain;
@@ -436,6 +440,52 @@ static inline int block_PeekOffsetBytes( block_bytestream_t *p_bytestream,
     return VLC_SUCCESS;
 }
 
+/**
+ * Finds the first 00 00 01 start code lying entirely within a buffer.
+ *
+ * \param p beginning of the buffer
+ * \param p_end end of the buffer
+ * \return a pointer to the first byte of the start code, or NULL
+ */
+static inline const uint8_t *block_ScanStartcode( const uint8_t *p,
+                                                  const uint8_t *p_end )
+{
+#ifdef __SSE2__
+    /* Tests 16 positions at once: p[i] == 0, p[i+1] == 0, p[i+2] == 1 */
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8( 1 );
+
+    while( p_end - p >= 18 )
+    {
+        __m128i a = _mm_loadu_si128( (const __m128i *)p );
+        __m128i b = _mm_loadu_si128( (const __m128i *)(p + 1) );
+        __m128i c = _mm_loadu_si128( (const __m128i *)(p + 2) );
+        int i_mask = _mm_movemask_epi8(
+            _mm_and_si128( _mm_and_si128( _mm_cmpeq_epi8( a, zero ),
+                                          _mm_cmpeq_epi8( b, zero ) ),
+                           _mm_cmpeq_epi8( c, one ) ) );
+        if( i_mask )
+            return p + __builtin_ctz( i_mask );
+        p += 16;
+    }
+#endif
+
+    /* Looks at every third byte: if it is neither 0 nor 1, no start code
+     * can begin at any of the three positions up to it. */
+    while( p_end - p >= 3 )
+    {
+        if( p[2] > 1 )
+            p += 3;
+        else if( p[2] == 0 )
+            p++;
+        else if( p[0] == 0 && p[1] == 0 )
+            return p;
+        else
+            p += 3;
+    }
+    return NULL;
+}
+
 static inline int block_FindStartcodeFromOffset(
     block_bytestream_t *p_bytestream, size_t *pi_offset,
     uint8_t *p_startcode, int i_startcode_length )
@@ -444,6 +494,8 @@ static inline int block_FindStartcodeFromOffset(
     int i_size = 0;
     size_t i_offset, i_offset_backup = 0;
     int i_caller_offset_backup = 0, i_match;
+    const bool b_scan = i_startcode_length == 3 && p_startcode[0] == 0 &&
+                        p_startcode[1] == 0 && p_startcode[2] == 1;
 
     /* Find the right place */
     i_size = *pi_offset + p_bytestream->i_offset;
@@ -470,6 +522,21 @@ static inline int block_FindStartcodeFromOffset(
     {
         for( i_offset = i_size; i_offset < p_block->i_buffer; i_offset++ )
         {
+            if( b_scan && !i_match && i_offset + 3 <= p_block->i_buffer )
+            {
+                /* Fast path for start codes within this block. Only those
+                 * straddling the next block are left to the loop below. */
+                const uint8_t *p = block_ScanStartcode(
+                    p_block->p_buffer + i_offset,
+                    p_block->p_buffer + p_block->i_buffer );
+                if( p != NULL )
+                {
+                    *pi_offset += p - p_block->p_buffer;
+                    return VLC_SUCCESS;
+                }
+                i_offset = p_block->i_buffer - 2;
+            }
+
             if( p_block->p_buffer[i_offset] == p_startcode[i_match] )
             {
                 if( !i_match )
@@ -157,6 +157,7 @@ typedef struct services_discovery_sys_t services_discovery_sys_t;
 typedef struct playlist_add_t playlist_add_t;
 typedef struct playlist_preparse_t playlist_preparse_t;
 typedef struct playlist_fetcher_t playlist_fetcher_t;
+typedef struct playlist_index_t playlist_index_t;
 
 /* Modules */
 typedef struct module_bank_t module_bank_t;
@@ -844,6 +845,7 @@ VLC_EXPORT(int, vlc_wclosedir, ( void *_p_dir ));
 #define CPU_CAPABILITY_ALTIVEC (1<<16)
 #define CPU_CAPABILITY_FPU     (1<<31)
 VLC_EXPORT( unsigned, vlc_CPU, ( void ) );
+VLC_EXPORT( unsigned, vlc_GetCPUCount, ( void ) );
 
 typedef void *(*vlc_memcpy_t) (void *tgt, const void *src, size_t n);
 typedef void *(*vlc_memset_t) (void *tgt, int c, size_t n);
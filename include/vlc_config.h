@@ -209,5 +209,12 @@
  * queue are printed, but not sent to the threads */
 #define VLC_MSG_QSIZE                   256
 
+/* Number of unformatted messages each thread can keep pending for the
+ * message consumer thread (must be a power of two) */
+#define VLC_MSG_RINGSIZE                128
+
+/* Period at which the message consumer formats pending messages */
+#define VLC_MSG_CONSUMER_PERIOD         ((mtime_t)(0.020*CLOCK_FREQ))
+
 /* Maximal depth of the object tree output by vlc_dumpstructure */
 #define MAX_DUMPSTRUCTURE_DEPTH         100
@@ -191,6 +191,43 @@ static inline block_t *filter_NewAudioBuffer( filter_t *p_filter, int i_size )
         return p_outpic;                                                \
     }
 
+/**
+ * Slice-parallel filtering
+ *
+ * A video filter can cut its work in horizontal bands of lines, and have
+ * them run at the same time on the worker threads (see vlc_jobs.h).
+ * Create the slices when opening the filter, and delete them when closing.
+ */
+typedef struct filter_slices_t filter_slices_t;
+
+/** Maximum number of slices */
+#define FILTER_SLICES_MAX 16
+
+/**
+ * Returns NULL if there is a single worker thread, or on error. The other
+ * functions accept NULL, and then run everything on the calling thread.
+ */
+VLC_EXPORT( filter_slices_t *, filter_SlicesNew, ( filter_t * ) );
+VLC_EXPORT( void, filter_SlicesDelete, ( filter_slices_t * ) );
+
+/**
+ * Calls pf_slice( p_data, i_slice, i_slices ) for each slice, and returns
+ * when all of them are done. The calls may happen on different threads at
+ * the same time.
+ */
+VLC_EXPORT( void, filter_SlicesRun, ( filter_slices_t *, void (*pf_slice)( void *, int, int ), void *p_data ) );
+
+/**
+ * Computes the lines [*pi_first, *pi_last[ of slice i_slice for a plane of
+ * i_lines lines.
+ */
+static inline void filter_SliceLines( int i_lines, int i_slice, int i_slices,
+                                      int *pi_first, int *pi_last )
+{
+    *pi_first = i_lines * i_slice / i_slices;
+    *pi_last = i_lines * (i_slice + 1) / i_slices;
+}
+
 /**
  * Filter chain management API
  * The filter chain management API is used to dynamically construct filters
@@ -468,6 +468,9 @@ VLC_EXPORT( int, __input_Preparse, ( vlc_object_t *, input_item_t * ) );
 
 #define input_Read(a,b,c) __input_Read(VLC_OBJECT(a),b, c)
 VLC_EXPORT( int, __input_Read, ( vlc_object_t *, input_item_t *, bool ) );
+
+#define input_Thumbnails(a,b,c,d,e,f) __input_Thumbnails(VLC_OBJECT(a),b,c,d,e,f)
+VLC_EXPORT( int, __input_Thumbnails, ( vlc_object_t *, input_item_t *, const char *, unsigned, unsigned, unsigned ) );
 VLC_EXPORT( void,             input_StopThread,     ( input_thread_t * ) );
 
 enum input_query_e
@@ -0,0 +1,71 @@
+/*****************************************************************************
+ * vlc_jobs.h: shared pool of worker threads
+ *****************************************************************************
+ * Copyright (C) 2009 the VideoLAN team
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_JOBS_H
+#define VLC_JOBS_H 1
+
+/**
+ * \file
+ * This file defines the job queues, which run their jobs on a pool of
+ * worker threads shared by all the queues of a libvlc instance.
+ *
+ * The pool has one thread per CPU, at least two (or "worker-threads"),
+ * however many queues there are. When a worker is free, it takes the first
+ * job of the queue with the highest priority, then with the earliest
+ * deadline, then with the oldest job. The queues with a negative priority
+ * are for jobs which may block; they never get the last worker.
+ */
+
+typedef struct job_queue_t job_queue_t;
+
+/**
+ * Creates a job queue.
+ *
+ * \param i_priority higher priority queues are served first
+ * \param i_parallel how many jobs of the queue may run at once; with 1,
+ * the jobs run one after the other, in the order they were submitted.
+ * 0 means no limit.
+ */
+VLC_EXPORT( job_queue_t *, __job_queue_New, ( vlc_object_t *, int i_priority, unsigned i_parallel ) );
+#define job_queue_New(a,b,c) __job_queue_New(VLC_OBJECT(a),b,c)
+
+/**
+ * Deletes a job queue. The jobs which have not started yet are dropped
+ * (it is up to the caller to release their data), and the running ones
+ * are waited for.
+ */
+VLC_EXPORT( void, job_queue_Delete, ( job_queue_t * ) );
+
+/**
+ * Submits a job.
+ *
+ * \param i_deadline date before which the job should be run, 0 if none
+ */
+VLC_EXPORT( int, job_queue_Submit, ( job_queue_t *, void (*pf_run)( void * ), void *p_data, mtime_t i_deadline ) );
+
+/**
+ * Waits until every job of the queue has been run.
+ */
+VLC_EXPORT( void, job_queue_Wait, ( job_queue_t * ) );
+
+VLC_EXPORT( void, job_queue_SetPriority, ( job_queue_t *, int ) );
+
+#endif
@@ -128,9 +128,15 @@ enum
     STATS_MAX,
     STATS_MIN,
     STATS_DERIVATIVE,
-    STATS_TIMER
+    STATS_TIMER,
+    STATS_HISTOGRAM
 };
 
+/** Number of buckets of a histogram counter. Bucket 0 holds the values
+ * below 1, bucket i the values in [2^(i-1), 2^i) and the last one all
+ * the larger values. */
+#define STATS_HISTOGRAM_BUCKETS 28
+
 struct counter_sample_t
 {
     vlc_value_t value;
@@ -149,8 +155,21 @@ struct counter_t
 
     mtime_t             update_interval;
     mtime_t             last_update;
+
+    vlc_mutex_t         lock;      /**< protects the samples */
+    void              * p_shards;  /**< per-thread integer accumulators */
 };
 
+/**
+ * Snapshot of a histogram counter
+ */
+typedef struct stats_histogram_t
+{
+    uint64_t i_count;                              /**< number of samples */
+    int64_t  i_sum;                                /**< sum of the samples */
+    uint64_t pi_buckets[STATS_HISTOGRAM_BUCKETS];  /**< non cumulative */
+} stats_histogram_t;
+
 enum
 {
     STATS_INPUT_BITRATE,
@@ -190,6 +209,8 @@ VLC_EXPORT( int, __stats_Update, (vlc_object_t*, counter_t *, vlc_value_t, vlc_v
 VLC_EXPORT( counter_t *, __stats_CounterCreate, (vlc_object_t*, int, int) );
 #define stats_Get(a,b,c) __stats_Get( VLC_OBJECT(a), b, c)
 VLC_EXPORT( int, __stats_Get, (vlc_object_t*, counter_t *, vlc_value_t*) );
+#define stats_GetHistogram(a,b,c) __stats_GetHistogram( VLC_OBJECT(a), b, c)
+VLC_EXPORT( int, __stats_GetHistogram, (vlc_object_t*, counter_t *, stats_histogram_t *) );
 
 VLC_EXPORT (void, stats_CounterClean, (counter_t * ) );
 
@@ -245,6 +266,16 @@ static inline int __stats_UpdateFloat( vlc_object_t *p_obj, counter_t *p_co,
     return i_ret;
 }
 
+#define stats_UpdateHistogram(a,b,c) __stats_UpdateHistogram( VLC_OBJECT(a),b,c )
+static inline int __stats_UpdateHistogram( vlc_object_t *p_obj,
+                                           counter_t *p_co, mtime_t i )
+{
+    vlc_value_t val;
+    if( !p_co ) return VLC_EGENERIC;
+    val.i_time = i;
+    return __stats_Update( p_obj, p_co, val, NULL );
+}
+
 /******************
  * Input stats
  ******************/
@@ -280,6 +311,10 @@ struct input_stats_t
     /* Aout */
     int i_played_abuffers;
     int i_lost_abuffers;
+
+    /* Latencies (in microseconds) */
+    stats_histogram_t decode_time;          /**< per decoded picture/buffer */
+    stats_histogram_t picture_lateness;     /**< vout display lateness */
 };
 
 VLC_EXPORT( void, stats_ComputeInputStats, (input_thread_t*, input_stats_t*) );
@@ -202,6 +202,7 @@ struct playlist_t
     bool            b_cant_sleep;
     playlist_preparse_t  *p_preparse; /**< Preparser object */
     playlist_fetcher_t   *p_fetcher;/**< Meta and art fetcher object */
+    playlist_index_t     *p_index;  /**< Search and input lookup index */
 
     struct {
         /* Current status. These fields are readonly, only the playlist
@@ -313,6 +314,10 @@ VLC_EXPORT( void,  playlist_Clear, ( playlist_t *, bool ) );
 /** Enqueue an input item for preparsing */
 VLC_EXPORT( int, playlist_PreparseEnqueue, (playlist_t *, input_item_t *) );
 
+/** Enqueue an input item shown to the user for preparsing, before the
+ * items which are not */
+VLC_EXPORT( int, playlist_PreparseEnqueueVisible, (playlist_t *, input_item_t *) );
+
 /** Enqueue a playlist item and all of its children if any for preparsing */
 VLC_EXPORT( int, playlist_PreparseEnqueueItem, (playlist_t *, playlist_item_t *) );
 /** Request the art for an input item to be fetched */
@@ -187,6 +187,26 @@ VLC_EXPORT( int, __var_TriggerCallback, ( vlc_object_t *, const char * ) );
  */
 #define var_TriggerCallback(a,b) __var_TriggerCallback( VLC_OBJECT(a), b )
 
+/*****************************************************************************
+ * Variable handles
+ *****************************************************************************
+ * A handle saves the lookup of the variable by name, for the variables
+ * which are set or read often. Setting a boolean, integer, float or time
+ * variable through a handle only holds the variables lock for a moment,
+ * unless there are callbacks to run or boundaries to check. Where the CPU
+ * has 64-bits atomic operations, getting one does not lock at all.
+ *****************************************************************************/
+VLC_EXPORT( variable_t *, __var_Hold, ( vlc_object_t *, const char * ) );
+VLC_EXPORT( void, var_Release, ( variable_t * ) );
+VLC_EXPORT( int, var_SetByHandle, ( variable_t *, vlc_value_t ) );
+VLC_EXPORT( int, var_SetValueByHandle, ( variable_t *, vlc_value_t ) );
+VLC_EXPORT( int, var_GetByHandle, ( variable_t *, vlc_value_t * ) );
+
+/**
+ * __var_Hold() with automatic casting
+ */
+#define var_Hold(a,b) __var_Hold( VLC_OBJECT(a), b )
+
 /*****************************************************************************
  * helpers functions
  *****************************************************************************/
@@ -613,6 +633,95 @@ static inline char *__var_CreateGetNonEmptyStringCommand( vlc_object_t *p_obj,
  */
 #define var_CreateGetStringCommand(a,b)   __var_CreateGetStringCommand( VLC_OBJECT(a),b)
 #define var_CreateGetNonEmptyStringCommand(a,b)   __var_CreateGetNonEmptyStringCommand( VLC_OBJECT(a),b)
+
+/**
+ * Set the value of an integer variable through a handle
+ */
+static inline int var_SetIntegerByHandle( variable_t *p_var, int i )
+{
+    vlc_value_t val;
+    val.i_int = i;
+    return var_SetByHandle( p_var, val );
+}
+
+/**
+ * Set the value of a boolean variable through a handle
+ */
+static inline int var_SetBoolByHandle( variable_t *p_var, bool b )
+{
+    vlc_value_t val;
+    val.b_bool = b;
+    return var_SetByHandle( p_var, val );
+}
+
+/**
+ * Set the value of a time variable through a handle
+ */
+static inline int var_SetTimeByHandle( variable_t *p_var, int64_t i )
+{
+    vlc_value_t val;
+    val.i_time = i;
+    return var_SetByHandle( p_var, val );
+}
+
+/**
+ * Set the value of a float variable through a handle
+ */
+static inline int var_SetFloatByHandle( variable_t *p_var, float f )
+{
+    vlc_value_t val;
+    val.f_float = f;
+    return var_SetByHandle( p_var, val );
+}
+
+/**
+ * Get the value of an integer variable through a handle
+ */
+static inline int var_GetIntegerByHandle( variable_t *p_var )
+{
+    vlc_value_t val; val.i_int = 0;
+    if( !var_GetByHandle( p_var, &val ) )
+        return val.i_int;
+    else
+        return 0;
+}
+
+/**
+ * Get the value of a boolean variable through a handle
+ */
+static inline bool var_GetBoolByHandle( variable_t *p_var )
+{
+    vlc_value_t val; val.b_bool = false;
+    if( !var_GetByHandle( p_var, &val ) )
+        return val.b_bool;
+    else
+        return false;
+}
+
+/**
+ * Get the value of a time variable through a handle
+ */
+static inline int64_t var_GetTimeByHandle( variable_t *p_var )
+{
+    vlc_value_t val; val.i_time = 0L;
+    if( !var_GetByHandle( p_var, &val ) )
+        return val.i_time;
+    else
+        return 0;
+}
+
+/**
+ * Get the value of a float variable through a handle
+ */
+static inline float var_GetFloatByHandle( variable_t *p_var )
+{
+    vlc_value_t val; val.f_float = 0.0;
+    if( !var_GetByHandle( p_var, &val ) )
+        return val.f_float;
+    else
+        return 0.0;
+}
+
 /**
  * @}
  */
@@ -38,11 +38,15 @@
 #include <vlc_charset.h>
 #include <vlc_input.h>
 
+#include <fcntl.h>
 #include <unistd.h>
 
 #ifdef WIN32
 #  include <direct.h>                                        /* _wgetcwd  */
 #endif
+#ifndef O_BINARY
+#   define O_BINARY 0
+#endif
 
 /*****************************************************************************
  * Module descriptor
@@ -50,10 +54,10 @@
 static int  Open ( vlc_object_t * );
 static void Close( vlc_object_t * );
 
-#define GRANULARITY_TEXT N_("Timeshift granularity")
-/// \bug [String] typo
-#define GRANULARITY_LONGTEXT N_( "This is the size of the temporary files " \
-  "that will be used to store the timeshifted streams." )
+#define SIZE_TEXT N_("Timeshift size")
+#define SIZE_LONGTEXT N_( "This is the size (in MB) of the temporary file " \
+  "used to store the timeshifted stream. When it is full, the oldest data " \
+  "is overwritten." )
 #define DIR_TEXT N_("Timeshift directory")
 #define DIR_LONGTEXT N_( "Directory used to store the timeshift temporary " \
   "files." )
@@ -70,8 +74,9 @@ vlc_module_begin();
     add_shortcut( "timeshift" );
     set_callbacks( Open, Close );
 
-    add_integer( "timeshift-granularity", 50, NULL, GRANULARITY_TEXT,
-                 GRANULARITY_LONGTEXT, true );
+    add_obsolete_integer( "timeshift-granularity" );
+    add_integer( "timeshift-size", 1024, NULL, SIZE_TEXT, SIZE_LONGTEXT,
+                 true );
     add_directory( "timeshift-dir", 0, 0, DIR_TEXT, DIR_LONGTEXT, false );
         change_unsafe();
     add_bool( "timeshift-force", false, NULL, FORCE_TEXT, FORCE_LONGTEXT,
@@ -86,38 +91,55 @@ static int      Seek( access_t *, int64_t );
 static block_t *Block  ( access_t *p_access );
 static int      Control( access_t *, int i_query, va_list args );
 static void*    Thread ( vlc_object_t *p_this );
-static int      WriteBlockToFile( access_t *p_access, block_t *p_block );
-static block_t *ReadBlockFromFile( access_t *p_access );
 static char    *GetTmpFilePath( access_t *p_access );
 
-#define TIMESHIFT_FIFO_MAX (10*1024*1024)
-#define TIMESHIFT_FIFO_MIN (TIMESHIFT_FIFO_MAX/4)
-#define TMP_FILE_MAX 256
-
-typedef struct ts_entry_t
+/* The stream is stored in a ring file of fixed size, written one chunk at
+ * a time at chunk aligned offsets. The chunk being filled stays in memory,
+ * so the live edge is read without going through the disk.
+ *
+ * Positions are counted from the beginning of the stream: the ring holds
+ * [i_begin, i_flushed) and the chunk [i_flushed, i_end). A reader that
+ * falls out of the window (because it was paused for too long) is moved
+ * forward to the oldest data still there. */
+#define TIMESHIFT_CHUNK     (512*1024)
+#define TIMESHIFT_READ      (64*1024)
+
+/* One index entry every second of input, at a block boundary (a TS or RTP
+ * packet), to seek to with a packet aligned position */
+#define TIMESHIFT_INDEX_INTERVAL (INT64_C(1000000))
+
+typedef struct
 {
-    FILE *file;
-    struct ts_entry_t *p_next;
-
-} ts_entry_t;
+    mtime_t i_date;     /* when it was received */
+    int64_t i_pos;
+} ts_index_t;
 
 struct access_sys_t
 {
-    block_fifo_t *p_fifo;
-
-    unsigned  i_files;
-    unsigned  i_file_size;
-    unsigned  i_write_size;
-
-    ts_entry_t *p_read_list;
-    ts_entry_t **pp_read_last;
-    ts_entry_t *p_write_list;
-    ts_entry_t **pp_write_last;
-
-    char *psz_filename_base;
-    char *psz_filename;
-
-    int64_t i_data;
+    /* Ring file, with a descriptor for each thread */
+    char    *psz_filename;
+    int     i_fd_write;
+    int     i_fd_read;
+    int64_t i_ring_size;
+
+    /* Chunk being filled */
+    uint8_t *p_chunk;
+
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;
+    int64_t     i_begin;
+    int64_t     i_flushed;
+    int64_t     i_end;
+    bool        b_eof;          /* of the source */
+
+    /* Read position (only used by the input thread) */
+    int64_t     i_pos;
+
+    /* Time index, sorted, i_index_start first entries are stale */
+    ts_index_t  *p_index;
+    int         i_index;
+    int         i_index_start;
+    int         i_index_alloc;
 };
 
 /*****************************************************************************
@@ -128,6 +150,7 @@ static int Open( vlc_object_t *p_this )
     access_t *p_access = (access_t*)p_this;
     access_t *p_src = p_access->p_source;
     access_sys_t *p_sys;
+    char *psz_base;
     bool b_bool;
 
     var_Create( p_access, "timeshift-force", VLC_VAR_BOOL|VLC_VAR_DOINHERIT );
@@ -158,42 +181,89 @@ static int Open( vlc_object_t *p_this )
     p_access->pf_seek = Seek;
     p_access->pf_control = Control;
     p_access->info = p_src->info;
+    p_access->info.i_size = 0;
+    p_access->info.i_pos = 0;
 
-    p_access->p_sys = p_sys = malloc( sizeof( access_sys_t ) );
+    p_access->p_sys = p_sys = calloc( 1, sizeof( access_sys_t ) );
     if( !p_sys )
         return VLC_ENOMEM;
 
-    /* */
-    p_sys->p_fifo = block_FifoNew();
-    p_sys->i_write_size = 0;
-    p_sys->i_files = 0;
-    p_sys->i_data = 0;
-
-    p_sys->p_read_list = NULL;
-    p_sys->pp_read_last = &p_sys->p_read_list;
-    p_sys->p_write_list = NULL;
-    p_sys->pp_write_last = &p_sys->p_write_list;
-
     var_Create( p_access, "timeshift-dir",
                 VLC_VAR_DIRECTORY | VLC_VAR_DOINHERIT );
-    var_Create( p_access, "timeshift-granularity",
+    var_Create( p_access, "timeshift-size",
                 VLC_VAR_INTEGER | VLC_VAR_DOINHERIT );
-    p_sys->i_file_size = var_GetInteger( p_access, "timeshift-granularity" );
-    if( p_sys->i_file_size < 1 ) p_sys->i_file_size = 1;
-    p_sys->i_file_size *= 1024 * 1024; /* In MBytes */
+    p_sys->i_ring_size = var_GetInteger( p_access, "timeshift-size" );
+    if( p_sys->i_ring_size < 1 ) p_sys->i_ring_size = 1;
+    p_sys->i_ring_size *= 1024 * 1024; /* In MBytes */
+    p_sys->i_ring_size -= p_sys->i_ring_size % TIMESHIFT_CHUNK;
+
+    /* Create and preallocate the ring file */
+    psz_base = GetTmpFilePath( p_access );
+    if( !psz_base ||
+        asprintf( &p_sys->psz_filename, "%sring.dat", psz_base ) == -1 )
+        p_sys->psz_filename = NULL;
+    free( psz_base );
+    p_sys->p_chunk = malloc( TIMESHIFT_CHUNK );
+    if( !p_sys->psz_filename || !p_sys->p_chunk )
+    {
+        free( p_sys->psz_filename );
+        free( p_sys->p_chunk );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    p_sys->i_fd_write = utf8_open( p_sys->psz_filename,
+                                   O_RDWR | O_CREAT | O_EXCL | O_BINARY, 0600 );
+    p_sys->i_fd_read = p_sys->i_fd_write == -1 ? -1 :
+                       utf8_open( p_sys->psz_filename, O_RDONLY | O_BINARY, 0 );
+    if( p_sys->i_fd_read == -1 )
+    {
+        msg_Err( p_access, "cannot open temporary file '%s' (%m)",
+                 p_sys->psz_filename );
+        goto error;
+    }
+    /* Reserve the blocks now, so that the disk cannot fill up later on;
+     * a sparse file will do where that is not supported */
+#ifdef HAVE_POSIX_FALLOCATE
+    errno = posix_fallocate( p_sys->i_fd_write, 0, p_sys->i_ring_size );
+    if( errno && ftruncate( p_sys->i_fd_write, p_sys->i_ring_size ) )
+#else
+    if( ftruncate( p_sys->i_fd_write, p_sys->i_ring_size ) )
+#endif
+    {
+        msg_Err( p_access, "cannot allocate %"PRId64" bytes for '%s' (%m)",
+                 p_sys->i_ring_size, p_sys->psz_filename );
+        goto error;
+    }
+    msg_Dbg( p_access, "using %"PRId64" MB of %s", p_sys->i_ring_size >> 20,
+             p_sys->psz_filename );
 
-    p_sys->psz_filename_base = GetTmpFilePath( p_access );
-    p_sys->psz_filename = malloc( strlen( p_sys->psz_filename_base ) + 1000 );
+    vlc_mutex_init( &p_sys->lock );
+    vlc_cond_init( p_access, &p_sys->wait );
 
     if( vlc_thread_create( p_access, "timeshift thread", Thread,
                            VLC_THREAD_PRIORITY_LOW, false ) )
     {
-        Close( p_this );
+        vlc_cond_destroy( &p_sys->wait );
+        vlc_mutex_destroy( &p_sys->lock );
         msg_Err( p_access, "cannot spawn timeshift access thread" );
-        return VLC_EGENERIC;
+        goto error;
     }
 
     return VLC_SUCCESS;
+
+error:
+    if( p_sys->i_fd_read != -1 )
+        close( p_sys->i_fd_read );
+    if( p_sys->i_fd_write != -1 )
+    {
+        close( p_sys->i_fd_write );
+        utf8_unlink( p_sys->psz_filename );
+    }
+    free( p_sys->psz_filename );
+    free( p_sys->p_chunk );
+    free( p_sys );
+    return VLC_EGENERIC;
 }
 
 /*****************************************************************************
@@ -203,47 +273,97 @@ static void Close( vlc_object_t *p_this )
 {
     access_t     *p_access = (access_t*)p_this;
     access_sys_t *p_sys = p_access->p_sys;
-    ts_entry_t *p_entry;
-    unsigned i;
 
     msg_Dbg( p_access, "timeshift close called" );
     vlc_thread_join( p_access );
 
-    for( p_entry = p_sys->p_write_list; p_entry; )
-    {
-        ts_entry_t *p_next = p_entry->p_next;
-        fclose( p_entry->file );
-        free( p_entry );
-        p_entry = p_next;
-    }
-    for( p_entry = p_sys->p_read_list; p_entry; )
+    close( p_sys->i_fd_read );
+    close( p_sys->i_fd_write );
+    utf8_unlink( p_sys->psz_filename );
+
+    vlc_cond_destroy( &p_sys->wait );
+    vlc_mutex_destroy( &p_sys->lock );
+    free( p_sys->p_index );
+    free( p_sys->p_chunk );
+    free( p_sys->psz_filename );
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * Time index (lock must be held)
+ *****************************************************************************/
+static void IndexAdd( access_sys_t *p_sys, mtime_t i_date, int64_t i_pos )
+{
+    if( p_sys->i_index > p_sys->i_index_start &&
+        i_date - p_sys->p_index[p_sys->i_index - 1].i_date <
+            TIMESHIFT_INDEX_INTERVAL )
+        return;
+
+    /* Forget the entries out of the window */
+    while( p_sys->i_index_start < p_sys->i_index &&
+           p_sys->p_index[p_sys->i_index_start].i_pos < p_sys->i_begin )
+        p_sys->i_index_start++;
+
+    if( p_sys->i_index >= p_sys->i_index_alloc )
     {
-        ts_entry_t *p_next = p_entry->p_next;
-        fclose( p_entry->file );
-        free( p_entry );
-        p_entry = p_next;
+        if( p_sys->i_index_start > p_sys->i_index / 2 )
+        {
+            p_sys->i_index -= p_sys->i_index_start;
+            memmove( p_sys->p_index, &p_sys->p_index[p_sys->i_index_start],
+                     p_sys->i_index * sizeof( *p_sys->p_index ) );
+            p_sys->i_index_start = 0;
+        }
+        else
+        {
+            const int i_alloc = p_sys->i_index_alloc ?
+                                2 * p_sys->i_index_alloc : 1024;
+            ts_index_t *p_index = realloc( p_sys->p_index,
+                                           i_alloc * sizeof( *p_index ) );
+            if( !p_index )
+                return;
+            p_sys->p_index = p_index;
+            p_sys->i_index_alloc = i_alloc;
+        }
     }
-    for( i = 0; i < p_sys->i_files; i++ )
+    p_sys->p_index[p_sys->i_index].i_date = i_date;
+    p_sys->p_index[p_sys->i_index].i_pos = i_pos;
+    p_sys->i_index++;
+}
+
+/* Returns the first entry at or after i_pos, or -1 */
+static int IndexFind( access_sys_t *p_sys, int64_t i_pos )
+{
+    int i_low = p_sys->i_index_start, i_high = p_sys->i_index;
+
+    while( i_low < i_high )
     {
-        sprintf( p_sys->psz_filename, "%s%i.dat",
-                 p_sys->psz_filename_base, i );
-        unlink( p_sys->psz_filename );
+        const int i_mid = ( i_low + i_high ) / 2;
+        if( p_sys->p_index[i_mid].i_pos < i_pos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
+    return i_low < p_sys->i_index ? i_low : -1;
+}
 
-    free( p_sys->psz_filename );
-    free( p_sys->psz_filename_base );
-    block_FifoRelease( p_sys->p_fifo );
-    free( p_sys );
+/* Where to resume from when i_pos is out of the window */
+static int64_t ResyncPos( access_sys_t *p_sys )
+{
+    const int i = IndexFind( p_sys, p_sys->i_begin );
+    return i >= 0 ? p_sys->p_index[i].i_pos : p_sys->i_begin;
 }
 
 /*****************************************************************************
- *
+ * Block: reads from the ring file or from the current chunk
  *****************************************************************************/
 static block_t *Block( access_t *p_access )
 {
     access_sys_t *p_sys = p_access->p_sys;
     access_t *p_src = p_access->p_source;
-    block_t *p_block = NULL;
+    block_t *p_block;
+    int64_t i_pos = p_sys->i_pos;
+    int64_t i_offset;
+    size_t i_size;
 
     /* Update info (we probably ought to be time caching that as well) */
     if( p_src->info.i_update & INPUT_UPDATE_META )
@@ -252,26 +372,101 @@ static block_t *Block( access_t *p_access )
         p_access->info.i_update |= INPUT_UPDATE_META;
     }
 
-    /* Get data from timeshift fifo */
-    if( !p_access->info.b_eof )
-        p_block = block_FifoGet( p_sys->p_fifo );
+    vlc_mutex_lock( &p_sys->lock );
+    if( i_pos >= p_sys->i_end && !p_sys->b_eof )
+        vlc_cond_timedwait( &p_sys->wait, &p_sys->lock, mdate() + 100000 );
 
-    if( p_block && !p_block->i_buffer ) /* Used to signal EOF */
-    { block_Release( p_block ); p_block = 0; }
+    if( i_pos < p_sys->i_begin )
+    {
+        i_pos = ResyncPos( p_sys );
+        msg_Warn( p_access, "timeshift window exceeded, skipping %"PRId64
+                  " bytes", i_pos - p_sys->i_pos );
+    }
+    p_access->info.i_size = p_sys->i_end;
+    p_access->info.i_update |= INPUT_UPDATE_SIZE;
 
-    if( p_block )
+    if( i_pos >= p_sys->i_end )
     {
-        p_sys->i_data -= p_block->i_buffer;
-        return p_block;
+        p_access->info.b_eof = p_sys->b_eof;
+        vlc_mutex_unlock( &p_sys->lock );
+        return NULL;
     }
 
-    p_access->info.b_eof = p_src->info.b_eof;
-    return NULL;
+    if( i_pos >= p_sys->i_flushed )
+    {
+        /* Live edge: still in memory */
+        i_size = __MIN( p_sys->i_end - i_pos, TIMESHIFT_READ );
+        p_block = block_New( p_access, i_size );
+        if( p_block )
+            memcpy( p_block->p_buffer,
+                    &p_sys->p_chunk[i_pos - p_sys->i_flushed], i_size );
+        vlc_mutex_unlock( &p_sys->lock );
+    }
+    else
+    {
+        /* Do not read across the end of the ring */
+        i_offset = i_pos % p_sys->i_ring_size;
+        i_size = __MIN( p_sys->i_flushed - i_pos, TIMESHIFT_READ );
+        i_size = __MIN( (int64_t)i_size, p_sys->i_ring_size - i_offset );
+        vlc_mutex_unlock( &p_sys->lock );
+
+        p_block = block_New( p_access, i_size );
+        if( p_block )
+        {
+            ssize_t i_read = -1;
+
+            if( lseek( p_sys->i_fd_read, i_offset, SEEK_SET ) == i_offset )
+                i_read = read( p_sys->i_fd_read, p_block->p_buffer, i_size );
+            if( i_read <= 0 )
+            {
+                msg_Err( p_access, "cannot read timeshift file (%m)" );
+                block_Release( p_block );
+                p_block = NULL;
+            }
+            else
+                p_block->i_buffer = i_read;
+        }
+
+        /* The data may have been overwritten meanwhile */
+        vlc_mutex_lock( &p_sys->lock );
+        if( i_pos < p_sys->i_begin && p_block )
+        {
+            block_Release( p_block );
+            p_block = NULL;
+        }
+        vlc_mutex_unlock( &p_sys->lock );
+    }
+
+    if( p_block )
+        i_pos += p_block->i_buffer;
+    p_sys->i_pos = p_access->info.i_pos = i_pos;
+    return p_block;
 }
 
 /*****************************************************************************
- *
+ * Thread: stores the source data
  *****************************************************************************/
+static void Flush( access_t *p_access )
+{
+    access_sys_t *p_sys = p_access->p_sys;
+    const int64_t i_offset = p_sys->i_flushed % p_sys->i_ring_size;
+
+    /* That overwrites the oldest chunk */
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->i_begin = __MAX( p_sys->i_begin, p_sys->i_flushed +
+                            TIMESHIFT_CHUNK - p_sys->i_ring_size );
+    vlc_mutex_unlock( &p_sys->lock );
+
+    if( lseek( p_sys->i_fd_write, i_offset, SEEK_SET ) != i_offset ||
+        write( p_sys->i_fd_write, p_sys->p_chunk, TIMESHIFT_CHUNK )
+            != TIMESHIFT_CHUNK )
+        msg_Err( p_access, "cannot write timeshift file (%m)" );
+
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->i_flushed += TIMESHIFT_CHUNK;
+    vlc_mutex_unlock( &p_sys->lock );
+}
+
 static void* Thread( vlc_object_t* p_this )
 {
     access_t *p_access = (access_t*)p_this;
@@ -309,222 +504,66 @@ static void* Thread( vlc_object_t* p_this )
           continue;
         }
 
-        p_sys->i_data += p_block->i_buffer;
-
-        /* Write block */
-        if( !p_sys->p_write_list && !p_sys->p_read_list &&
-            block_FifoSize( p_sys->p_fifo ) < TIMESHIFT_FIFO_MAX )
-        {
-            /* If there isn't too much timeshifted data,
-             * write directly to FIFO */
-            block_FifoPut( p_sys->p_fifo, p_block );
-            continue;
-        }
-
-        WriteBlockToFile( p_access, p_block );
-        block_Release( p_block );
+        vlc_mutex_lock( &p_sys->lock );
+        IndexAdd( p_sys, mdate(), p_sys->i_end );
+        vlc_mutex_unlock( &p_sys->lock );
 
-        /* Read from file to fill up the fifo */
-        while( block_FifoSize( p_sys->p_fifo ) < TIMESHIFT_FIFO_MIN &&
-               vlc_object_alive (p_access) )
+        /* Append to the current chunk, and store it once full */
+        for( block_t *p_next = p_block; p_next; p_next = p_next->p_next )
         {
-            p_block = ReadBlockFromFile( p_access );
-            if( !p_block ) break;
-
-            block_FifoPut( p_sys->p_fifo, p_block );
-        }
-    }
+            const uint8_t *p_data = p_next->p_buffer;
+            size_t i_data = p_next->i_buffer;
 
-    msg_Dbg( p_access, "timeshift: no more input data" );
-
-    while( vlc_object_alive (p_access) &&
-           (p_sys->p_read_list || block_FifoSize( p_sys->p_fifo ) ) )
-    {
-        /* Read from file to fill up the fifo */
-        while( block_FifoSize( p_sys->p_fifo ) < TIMESHIFT_FIFO_MIN &&
-               vlc_object_alive (p_access) && p_sys->p_read_list )
-        {
-            p_block = ReadBlockFromFile( p_access );
-            if( !p_block ) break;
-
-            block_FifoPut( p_sys->p_fifo, p_block );
+            while( i_data > 0 )
+            {
+                const size_t i_fill = p_sys->i_end - p_sys->i_flushed;
+                const size_t i_copy = __MIN( i_data,
+                                             TIMESHIFT_CHUNK - i_fill );
+
+                vlc_mutex_lock( &p_sys->lock );
+                memcpy( &p_sys->p_chunk[i_fill], p_data, i_copy );
+                p_sys->i_end += i_copy;
+                vlc_cond_signal( &p_sys->wait );
+                vlc_mutex_unlock( &p_sys->lock );
+
+                if( i_fill + i_copy == TIMESHIFT_CHUNK )
+                    Flush( p_access );
+                p_data += i_copy;
+                i_data -= i_copy;
+            }
         }
-
-        msleep( 100000 );
+        block_ChainRelease( p_block );
     }
 
     msg_Dbg( p_access, "timeshift: EOF" );
-    p_src->info.b_eof = true;
-
-    /* Send dummy packet to avoid deadlock in Block() */
-    block_FifoPut( p_sys->p_fifo, block_New( p_access, 0 ) );
+    vlc_mutex_lock( &p_sys->lock );
+    p_sys->b_eof = true;
+    vlc_cond_signal( &p_sys->wait );
+    vlc_mutex_unlock( &p_sys->lock );
     return NULL;
 }
 
 /*****************************************************************************
- * NextFileWrite:
+ * Seek: seek to a position within the timeshift window
  *****************************************************************************/
-static void NextFileWrite( access_t *p_access )
-{
-    access_sys_t *p_sys = p_access->p_sys;
-    ts_entry_t   *p_next;
-
-    if( !p_sys->p_write_list )
-    {
-        p_sys->i_write_size = 0;
-        return;
-    }
-
-    p_next = p_sys->p_write_list->p_next;
-
-    /* Put written file in read list */
-    if( p_sys->i_write_size < p_sys->i_file_size )
-        ftruncate( fileno( p_sys->p_write_list->file ), p_sys->i_write_size );
-
-    fseek( p_sys->p_write_list->file, 0, SEEK_SET );
-    *p_sys->pp_read_last = p_sys->p_write_list;
-    p_sys->pp_read_last = &p_sys->p_write_list->p_next;
-    p_sys->p_write_list->p_next = 0;
-
-    /* Switch to next file to write */
-    p_sys->p_write_list = p_next;
-    if( !p_sys->p_write_list ) p_sys->pp_write_last = &p_sys->p_write_list;
-
-    p_sys->i_write_size = 0;
-}
-
-/*****************************************************************************
- * NextFileRead:
- *****************************************************************************/
-static void NextFileRead( access_t *p_access )
-{
-    access_sys_t *p_sys = p_access->p_sys;
-    ts_entry_t   *p_next;
-
-    if( !p_sys->p_read_list ) return;
-
-    p_next = p_sys->p_read_list->p_next;
-
-    /* Put read file in write list */
-    fseek( p_sys->p_read_list->file, 0, SEEK_SET );
-    *p_sys->pp_write_last = p_sys->p_read_list;
-    p_sys->pp_write_last = &p_sys->p_read_list->p_next;
-    p_sys->p_read_list->p_next = 0;
-
-    /* Switch to next file to read */
-    p_sys->p_read_list = p_next;
-    if( !p_sys->p_read_list ) p_sys->pp_read_last = &p_sys->p_read_list;
-}
-
-/*****************************************************************************
- * WriteBlockToFile:
- *****************************************************************************/
-static int WriteBlockToFile( access_t *p_access, block_t *p_block )
-{
-    access_sys_t *p_sys = p_access->p_sys;
-    int i_write, i_buffer;
-
-    if( p_sys->i_write_size == p_sys->i_file_size ) NextFileWrite( p_access );
-
-    /* Open new file if necessary */
-    if( !p_sys->p_write_list )
-    {
-        FILE *file;
-
-        sprintf( p_sys->psz_filename, "%s%u.dat",
-                 p_sys->psz_filename_base, p_sys->i_files );
-        file = utf8_fopen( p_sys->psz_filename, "w+b" );
-
-        if( !file && p_sys->i_files < 2 )
-        {
-            /* We just can't work with less than 2 buffer files */
-            msg_Err( p_access, "cannot open temporary file '%s' (%m)",
-                     p_sys->psz_filename );
-            return VLC_EGENERIC;
-        }
-        else if( !file ) return VLC_EGENERIC;
-
-        p_sys->p_write_list = malloc( sizeof(ts_entry_t) );
-        p_sys->p_write_list->p_next = 0;
-        p_sys->p_write_list->file = file;
-        p_sys->pp_write_last = &p_sys->p_write_list->p_next;
-
-        p_sys->i_files++;
-    }
-
-    /* Write to file */
-    i_buffer = __MIN( p_block->i_buffer,
-                      p_sys->i_file_size - p_sys->i_write_size );
-
-    i_write = fwrite( p_block->p_buffer, 1, i_buffer,
-                      p_sys->p_write_list->file );
-
-    if( i_write > 0 ) p_sys->i_write_size += i_write;
-
-    //p_access->info.i_size += i_write;
-    //p_access->info.i_update |= INPUT_UPDATE_SIZE;
-
-    if( i_write < i_buffer )
-    {
-        /* Looks like we're short of space */
-
-        if( !p_sys->p_write_list->p_next )
-        {
-            msg_Warn( p_access, "no more space, overwritting old data" );
-            NextFileRead( p_access );
-            NextFileRead( p_access );
-        }
-
-        /* Make sure we switch to next file in write list */
-        p_sys->i_write_size = p_sys->i_file_size;
-    }
-
-    p_block->p_buffer += i_write;
-    p_block->i_buffer -= i_write;
-
-    /* Check if we have some data left */
-    if( p_block->i_buffer ) return WriteBlockToFile( p_access, p_block );
-
-    return VLC_SUCCESS;
-}
-
-/*****************************************************************************
- * ReadBlockFromFile:
- *****************************************************************************/
-static block_t *ReadBlockFromFile( access_t *p_access )
+static int Seek( access_t *p_access, int64_t i_pos )
 {
     access_sys_t *p_sys = p_access->p_sys;
-    block_t *p_block;
+    int i;
 
-    if( !p_sys->p_read_list && p_sys->p_write_list )
-    {
-        /* Force switching to next write file, that should
-         * give us something to read */
-        NextFileWrite( p_access );
-    }
+    vlc_mutex_lock( &p_sys->lock );
+    if( i_pos < p_sys->i_begin )
+        i_pos = ResyncPos( p_sys );
+    if( i_pos > p_sys->i_end )
+        i_pos = p_sys->i_end;
 
-    if( !p_sys->p_read_list ) return 0;
+    i = IndexFind( p_sys, i_pos );
+    msg_Dbg( p_access, "seek to %"PRId64" (%"PRId64" s behind live)", i_pos,
+             i >= 0 ? ( mdate() - p_sys->p_index[i].i_date ) / 1000000 : 0 );
+    vlc_mutex_unlock( &p_sys->lock );
 
-    p_block = block_New( p_access, 4096 );
-    p_block->i_buffer = fread( p_block->p_buffer, 1, 4096,
-                               p_sys->p_read_list->file );
-
-    if( p_block->i_buffer == 0 ) NextFileRead( p_access );
-
-    //p_access->info.i_size -= p_block->i_buffer;
-    //p_access->info.i_update |= INPUT_UPDATE_SIZE;
-
-    return p_block;
-}
-
-/*****************************************************************************
- * Seek: seek to a specific location in a file
- *****************************************************************************/
-static int Seek( access_t *p_access, int64_t i_pos )
-{
-    //access_sys_t *p_sys = p_access->p_sys;
-    (void)p_access;
-    (void)i_pos;
+    p_sys->i_pos = p_access->info.i_pos = i_pos;
+    p_access->info.b_eof = false;
     return VLC_SUCCESS;
 }
 
@@ -227,6 +227,7 @@ static int Open( vlc_object_t *p_this )
 
     p_sys->i_files  = 0;
     p_sys->pp_files = NULL;
+    TAB_INIT( p_sys->i_templates, p_sys->pp_templates );
 
     psz_src = config_GetPsz( p_intf, "http-src" );
     if( ( psz_src == NULL ) || ( *psz_src == '\0' ) )
@@ -334,6 +335,9 @@ static void Close ( vlc_object_t *p_this )
     if( p_sys->p_art_handler )
         httpd_HandlerDelete( p_sys->p_art_handler );
     httpd_HostDelete( p_sys->p_httpd_host );
+    for( i = 0; i < p_sys->i_templates; i++ )
+        TemplateRelease( p_sys->pp_templates[i] );
+    TAB_CLEAN( p_sys->i_templates, p_sys->pp_templates );
     free( p_sys->psz_address );
     free( p_sys );
     pl_Release( p_this );
@@ -366,7 +370,7 @@ static void Callback404( httpd_file_sys_t *p_args, char **pp_data,
     *pi_data = strlen( *pp_data );
 }
 
-static void ParseExecute( httpd_file_sys_t *p_args, char *p_buffer,
+static void ParseExecute( httpd_file_sys_t *p_args, template_op_t *p_ops,
                           int i_buffer, char *p_request,
                           char **pp_data, int *pi_data )
 {
@@ -488,12 +492,14 @@ static void ParseExecute( httpd_file_sys_t *p_args, char *p_buffer,
     *pi_data = i_buffer + 1000;
     dst = *pp_data = malloc( *pi_data );
 
-    /* we parse executing all  <vlc /> macros */
-    Execute( p_args, p_request, i_request, pp_data, pi_data, &dst,
-                 &p_buffer[0], &p_buffer[i_buffer] );
+    /* we run all the <vlc /> macros */
+    TemplateExecute( p_args, p_ops, p_request, i_request,
+                     pp_data, pi_data, &dst );
 
-    *dst     = '\0';
+    /* *pi_data was the size of the buffer, there may be no room left */
     *pi_data = dst - *pp_data;
+    *pp_data = realloc( *pp_data, *pi_data + 1 );
+    (*pp_data)[*pi_data] = '\0';
 
     if( p_sys->p_input != NULL )
     {
@@ -514,28 +520,29 @@ int  HttpCallback( httpd_file_sys_t *p_args,
     char **pp_data = (char **)_pp_data;
     FILE *f;
 
-    if( ( f = utf8_fopen( p_args->file, "r" ) ) == NULL )
+    if( p_args->b_html )
     {
-        Callback404( p_args, pp_data, pi_data );
+        /* the page is compiled the first time, and when it changes */
+        template_t *p_tpl = TemplateGet( p_args->p_intf, p_args->file );
+
+        if( p_tpl == NULL )
+        {
+            Callback404( p_args, pp_data, pi_data );
+            return VLC_SUCCESS;
+        }
+        ParseExecute( p_args, p_tpl->p_ops, p_tpl->i_size, p_request,
+                      pp_data, pi_data );
+        TemplateRelease( p_tpl );
         return VLC_SUCCESS;
     }
 
-    if( !p_args->b_html )
+    if( ( f = utf8_fopen( p_args->file, "r" ) ) == NULL )
     {
-        FileLoad( f, pp_data, pi_data );
+        Callback404( p_args, pp_data, pi_data );
+        return VLC_SUCCESS;
     }
-    else
-    {
-        int  i_buffer;
-        char *p_buffer;
-
-        /* first we load in a temporary buffer */
-        FileLoad( f, &p_buffer, &i_buffer );
 
-        ParseExecute( p_args, p_buffer, i_buffer, p_request, pp_data, pi_data );
-
-        free( p_buffer );
-    }
+    FileLoad( f, pp_data, pi_data );
 
     fclose( f );
 
@@ -765,9 +772,12 @@ int  HandlerCallback( httpd_handler_sys_t *p_args,
     }
     else
     {
-        ParseExecute( (httpd_file_sys_t *)p_args, p_buffer, i_buffer,
+        template_op_t *p_ops = TemplateCompile( p_buffer, i_buffer );
+
+        ParseExecute( (httpd_file_sys_t *)p_args, p_ops, i_buffer,
                       p_request, pp_data, pi_data );
 
+        TemplateDelete( p_ops );
         free( p_buffer );
     }
 
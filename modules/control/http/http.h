@@ -255,6 +255,30 @@ void SSClean( rpn_stack_t * );
 void  EvaluateRPN( intf_thread_t *p_intf, mvar_t  *vars,
                        rpn_stack_t *st, char *exp );
 
+/** \struct rpn_t
+ * This structure represents an RPN expression split into words, so that
+ * it can be run several times without being parsed again
+ */
+typedef struct
+{
+    char *psz;
+    bool b_string;      ///< quoted word, pushed as is
+} rpn_word_t;
+
+typedef struct
+{
+    int        i_words;
+    rpn_word_t *p_words;
+} rpn_t;
+
+/** This function splits an expression into words */
+rpn_t *RPNCompile( const char *psz_exp );
+/** This function deletes a compiled expression */
+void RPNDelete( rpn_t * );
+/** This function evaluates a compiled expression */
+void RPNExecute( intf_thread_t *p_intf, mvar_t  *vars,
+                 rpn_stack_t *st, const rpn_t * );
+
 /* Push an operand on top of the RPN stack */
 void SSPush  ( rpn_stack_t *, const char * );
 /* Remove the first operand from the RPN Stack */
@@ -291,12 +315,51 @@ typedef struct
     char *param2;       ///< Second parameter
 } macro_t;
 
-/** This function parses a file for macros */
-void Execute( httpd_file_sys_t *p_args,
-                  char *p_request, int i_request,
-                  char **pp_data, int *pi_data,
-                  char **pp_dst,
-                  char *_src, char *_end );
+/** \struct template_op_t
+ * This structure represents an instruction of a compiled page: some text
+ * to copy, or a macro, with the body of the <vlc id="if"> and
+ * <vlc id="foreach"> blocks
+ */
+typedef struct template_op_t template_op_t;
+struct template_op_t
+{
+    int           i_type;       ///< Macro type, or TEMPLATE_TEXT
+    macro_t       m;
+    rpn_t         *p_rpn;       ///< param1 of the "if", "rpn" and "value"
+    char          *psz_text;    ///< Text to copy
+    int           i_text;
+    template_op_t *p_body;      ///< Body of an "if" or a "foreach"
+    template_op_t *p_else;      ///< "else" part of an "if"
+    template_op_t *p_next;
+};
+
+#define TEMPLATE_TEXT (-1)
+
+/** \struct template_t
+ * This structure represents a compiled page, kept as long as the file
+ * it was compiled from does not change
+ */
+typedef struct
+{
+    char          *psz_file;
+    time_t        i_mtime;
+    int64_t       i_size;
+    int           i_refs;
+    template_op_t *p_ops;
+} template_t;
+
+/** This function compiles the macros of a page */
+template_op_t *TemplateCompile( const char *p_buffer, int i_buffer );
+/** This function deletes a compiled page */
+void TemplateDelete( template_op_t * );
+/** This function gets the compiled version of a file, compiling it again
+ * if it changed. It must be released with TemplateRelease() */
+template_t *TemplateGet( intf_thread_t *p_intf, const char *psz_file );
+void TemplateRelease( template_t * );
+/** This function runs a compiled page */
+void TemplateExecute( httpd_file_sys_t *p_args, template_op_t *p_ops,
+                      char *p_request, int i_request,
+                      char **pp_data, int *pi_data, char **pp_dst );
 
 /**@}*/
 
@@ -356,6 +419,9 @@ struct intf_sys_t
     int                 i_files;
     httpd_file_sys_t    **pp_files;
 
+    int                 i_templates;
+    template_t          **pp_templates; ///< Compiled pages
+
     int                 i_handlers;
     http_association_t  **pp_handlers;
     httpd_handler_t     *p_art_handler;
@@ -135,23 +135,32 @@ static int StrToMacroType( const char *name )
     return MVLC_UNKNOWN;
 }
 
+/* *pi_data is the size of the output buffer, which grows geometrically */
+static void TemplateAlloc( char **pp_data, int *pi_data, char **pp_dst,
+                           int i_len )
+{
+    int i_index = *pp_dst - *pp_data;
+
+    if( i_index + i_len <= *pi_data )
+        return;
+    *pi_data = __MAX( 2 * *pi_data, i_index + i_len );
+    *pp_data = realloc( *pp_data, *pi_data );
+    *pp_dst = (*pp_data) + i_index;
+}
+
 static void MacroDo( httpd_file_sys_t *p_args,
-                     macro_t *m,
+                     template_op_t *p_op,
                      char *p_request, int i_request,
                      char **pp_data,  int *pi_data,
                      char **pp_dst )
 {
     intf_thread_t  *p_intf = p_args->p_intf;
     intf_sys_t     *p_sys = p_args->p_intf->p_sys;
+    macro_t        *m = &p_op->m;
     char control[512];
 
 #define ALLOC( l ) \
-    {               \
-        int __i__ = *pp_dst - *pp_data; \
-        *pi_data += (l);                  \
-        *pp_data = realloc( *pp_data, *pi_data );   \
-        *pp_dst = (*pp_data) + __i__;   \
-    }
+    TemplateAlloc( pp_data, pi_data, pp_dst, (l) );
 #define PRINT( str ) \
     ALLOC( strlen( str ) + 1 ); \
     *pp_dst += sprintf( *pp_dst, "%s", str );
@@ -170,7 +179,7 @@ static void MacroDo( httpd_file_sys_t *p_args,
         } \
     }
 
-    switch( StrToMacroType( m->id ) )
+    switch( p_op->i_type )
     {
         case MVLC_CONTROL:
             if( i_request <= 0 )
@@ -765,7 +774,7 @@ static void MacroDo( httpd_file_sys_t *p_args,
 
             if( m->param1 )
             {
-                EvaluateRPN( p_intf, p_args->vars, &p_args->stack, m->param1 );
+                RPNExecute( p_intf, p_args->vars, &p_args->stack, p_op->p_rpn );
                 s = SSPop( &p_args->stack );
                 v = mvar_GetValue( p_args->vars, s );
             }
@@ -779,7 +788,7 @@ static void MacroDo( httpd_file_sys_t *p_args,
             break;
         }
         case MVLC_RPN:
-            EvaluateRPN( p_intf, p_args->vars, &p_args->stack, m->param1 );
+            RPNExecute( p_intf, p_args->vars, &p_args->stack, p_op->p_rpn );
             break;
 
         /* Useful to learn stack management */
@@ -803,320 +812,351 @@ static void MacroDo( httpd_file_sys_t *p_args,
 #undef ALLOC
 }
 
-static
-char *MacroSearch( char *src, char *end, int i_mvlc, bool b_after )
+
+/****************************************************************************
+ * Page compilation
+ ****************************************************************************
+ * A page is split once into text and macros; the "if" and "foreach"
+ * blocks get their body attached, so that running the page again does not
+ * need to search for the matching "else" and "end".
+ ****************************************************************************/
+static void TemplateAppend( template_op_t ***ppp_last, template_op_t *p_op )
+{
+    **ppp_last = p_op;
+    *ppp_last = &p_op->p_next;
+}
+
+/* Compiles up to the end of the page, or to the "end" (or the "else" when
+ * b_else) closing the current block, which is returned in *pi_stop */
+static template_op_t *TemplateCompileBlock( const char **pp_src,
+                                            const char *end, int i_depth,
+                                            bool b_else, int *pi_stop )
 {
-    int     i_id;
-    int     i_level = 0;
+    template_op_t *p_first = NULL, **pp_last = &p_first;
+    const char *src = *pp_src;
 
+    *pi_stop = MVLC_UNKNOWN;
     while( src < end )
     {
-        if( src + 4 < end  && !strncmp( (char *)src, "<vlc", 4 ) )
+        const char *p = strstr( src, "<vlc" );
+        template_op_t *p_op;
+        macro_t m;
+        int i_type, i_stop;
+
+        if( p == NULL || p > end )
+            p = end;
+        if( p > src )
         {
-            int i_skip;
-            macro_t m;
-
-            i_skip = MacroParse( &m, src );
-
-            i_id = StrToMacroType( m.id );
-
-            switch( i_id )
-            {
-                case MVLC_IF:
-                case MVLC_FOREACH:
-                    i_level++;
-                    break;
-                case MVLC_END:
-                    i_level--;
-                    break;
-                default:
-                    break;
-            }
+            p_op = calloc( 1, sizeof( *p_op ) );
+            if( p_op == NULL )
+                break;
+            p_op->i_type = TEMPLATE_TEXT;
+            p_op->i_text = p - src;
+            p_op->psz_text = malloc( p_op->i_text );
+            if( p_op->psz_text != NULL )
+                memcpy( p_op->psz_text, src, p_op->i_text );
+            else
+                p_op->i_text = 0;
+            TemplateAppend( &pp_last, p_op );
+            src = p;
+            continue;
+        }
 
+        src += MacroParse( &m, (char *)src );
+        i_type = StrToMacroType( m.id );
+        if( i_depth > 0 &&
+            ( i_type == MVLC_END || ( b_else && i_type == MVLC_ELSE ) ) )
+        {
             MacroClean( &m );
+            *pi_stop = i_type;
+            break;
+        }
 
-            if( ( i_mvlc == MVLC_END && i_level == -1 ) ||
-                ( i_mvlc != MVLC_END && i_level == 0 && i_mvlc == i_id ) )
-            {
-                return src + ( b_after ? i_skip : 0 );
-            }
-            else if( i_level < 0 )
-            {
-                return NULL;
-            }
-
-            src += i_skip;
+        p_op = calloc( 1, sizeof( *p_op ) );
+        if( p_op == NULL )
+        {
+            MacroClean( &m );
+            break;
         }
-        else
+        p_op->i_type = i_type;
+        p_op->m = m;
+        switch( i_type )
         {
-            src++;
+            case MVLC_IF:
+                p_op->p_rpn = RPNCompile( m.param1 );
+                p_op->p_body = TemplateCompileBlock( &src, end, i_depth + 1,
+                                                     true, &i_stop );
+                if( i_stop == MVLC_ELSE )
+                    p_op->p_else = TemplateCompileBlock( &src, end,
+                                                         i_depth + 1, false,
+                                                         &i_stop );
+                break;
+            case MVLC_FOREACH:
+                p_op->p_body = TemplateCompileBlock( &src, end, i_depth + 1,
+                                                     false, &i_stop );
+                break;
+            case MVLC_VALUE:
+            case MVLC_RPN:
+                p_op->p_rpn = RPNCompile( m.param1 );
+                break;
         }
+        TemplateAppend( &pp_last, p_op );
     }
 
-    return NULL;
+    *pp_src = src;
+    return p_first;
 }
 
-void Execute( httpd_file_sys_t *p_args,
-                     char *p_request, int i_request,
-                     char **pp_data, int *pi_data,
-                     char **pp_dst,
-                     char *_src, char *_end )
+template_op_t *TemplateCompile( const char *p_buffer, int i_buffer )
 {
-    intf_thread_t  *p_intf = p_args->p_intf;
+    template_op_t *p_ops;
+    char *dup = malloc( i_buffer + 1 );
+    const char *src = dup;
+    int i_stop;
 
-    char *src, *dup, *end;
-    char *dst = *pp_dst;
+    if( dup == NULL )
+        return NULL;
+    memcpy( dup, p_buffer, i_buffer );
+    dup[i_buffer] = '\0';
 
-    src = dup = malloc( _end - _src + 1 );
-    end = src +( _end - _src );
-
-    memcpy( src, _src, _end - _src );
-    *end = '\0';
+    p_ops = TemplateCompileBlock( &src, dup + i_buffer, 0, false, &i_stop );
+    free( dup );
+    return p_ops;
+}
 
-    /* we parse searching <vlc */
-    while( src < end )
+void TemplateDelete( template_op_t *p_op )
+{
+    while( p_op != NULL )
     {
-        char *p;
-        int i_copy;
+        template_op_t *p_next = p_op->p_next;
+
+        if( p_op->i_type != TEMPLATE_TEXT )
+            MacroClean( &p_op->m );
+        RPNDelete( p_op->p_rpn );
+        free( p_op->psz_text );
+        TemplateDelete( p_op->p_body );
+        TemplateDelete( p_op->p_else );
+        free( p_op );
+        p_op = p_next;
+    }
+}
+
+/****************************************************************************
+ * Compiled pages cache
+ ****************************************************************************/
+template_t *TemplateGet( intf_thread_t *p_intf, const char *psz_file )
+{
+    intf_sys_t *p_sys = p_intf->p_sys;
+    template_t *p_tpl;
+    struct stat st;
+    char *p_buffer;
+    int  i_buffer;
+    FILE *f;
+
+    if( utf8_stat( psz_file, &st ) )
+        return NULL;
 
-        p = (char *)strstr( (char *)src, "<vlc" );
-        if( p < end && p == src )
+    for( int i = 0; i < p_sys->i_templates; i++ )
+    {
+        p_tpl = p_sys->pp_templates[i];
+        if( strcmp( p_tpl->psz_file, psz_file ) )
+            continue;
+        if( p_tpl->i_mtime == st.st_mtime && p_tpl->i_size == st.st_size )
         {
-            macro_t m;
+            p_tpl->i_refs++;
+            return p_tpl;
+        }
+        /* The file was modified: forget the old version */
+        TAB_REMOVE( p_sys->i_templates, p_sys->pp_templates, p_tpl );
+        TemplateRelease( p_tpl );
+        break;
+    }
+
+    if( ( f = utf8_fopen( psz_file, "r" ) ) == NULL )
+        return NULL;
+    FileLoad( f, &p_buffer, &i_buffer );
+    fclose( f );
+
+    p_tpl = malloc( sizeof( *p_tpl ) );
+    if( p_tpl == NULL )
+    {
+        free( p_buffer );
+        return NULL;
+    }
+    p_tpl->psz_file = strdup( psz_file );
+    p_tpl->i_mtime = st.st_mtime;
+    p_tpl->i_size = st.st_size;
+    p_tpl->i_refs = 2; /* one for the cache, one for the caller */
+    p_tpl->p_ops = TemplateCompile( p_buffer, i_buffer );
+    free( p_buffer );
+
+    TAB_APPEND( p_sys->i_templates, p_sys->pp_templates, p_tpl );
+    return p_tpl;
+}
 
-            src += MacroParse( &m, src );
+void TemplateRelease( template_t *p_tpl )
+{
+    if( --p_tpl->i_refs > 0 )
+        return;
+    TemplateDelete( p_tpl->p_ops );
+    free( p_tpl->psz_file );
+    free( p_tpl );
+}
 
-            //msg_Dbg( p_intf, "macro_id=%s", m.id );
+/****************************************************************************
+ * Page execution
+ ****************************************************************************/
+void TemplateExecute( httpd_file_sys_t *p_args, template_op_t *p_op,
+                      char *p_request, int i_request,
+                      char **pp_data, int *pi_data, char **pp_dst )
+{
+    intf_thread_t  *p_intf = p_args->p_intf;
+
+    for( ; p_op != NULL; p_op = p_op->p_next )
+    {
+        macro_t *m = &p_op->m;
 
-            switch( StrToMacroType( m.id ) )
+        switch( p_op->i_type )
+        {
+            case TEMPLATE_TEXT:
+                TemplateAlloc( pp_data, pi_data, pp_dst, p_op->i_text );
+                memcpy( *pp_dst, p_op->psz_text, p_op->i_text );
+                *pp_dst += p_op->i_text;
+                break;
+            case MVLC_INCLUDE:
             {
-                case MVLC_INCLUDE:
-                {
-                    FILE *f;
-                    int  i_buffer;
-                    char *p_buffer;
-                    char psz_file[MAX_DIR_SIZE];
-                    char *p;
-                    char sep;
+                template_t *p_tpl;
+                char psz_file[MAX_DIR_SIZE];
+                char *p;
+                char sep;
 
 #if defined( WIN32 )
-                    sep = '\\';
+                sep = '\\';
 #else
-                    sep = '/';
+                sep = '/';
 #endif
 
-                    if( m.param1[0] != sep )
-                    {
-                        strcpy( psz_file, p_args->file );
-                        p = strrchr( psz_file, sep );
-                        if( p != NULL )
-                            strcpy( p + 1, m.param1 );
-                        else
-                            strcpy( psz_file, m.param1 );
-                    }
+                if( m->param1[0] != sep )
+                {
+                    strcpy( psz_file, p_args->file );
+                    p = strrchr( psz_file, sep );
+                    if( p != NULL )
+                        strcpy( p + 1, m->param1 );
                     else
-                    {
-                        strcpy( psz_file, m.param1 );
-                    }
-
-                    /* We hereby assume that psz_file is in the
-                     * local character encoding */
-                    if( ( f = fopen( psz_file, "r" ) ) == NULL )
-                    {
-                        msg_Warn( p_args->p_intf,
-                                  "unable to include file %s (%m)",
-                                  psz_file );
-                        break;
-                    }
-
-                    /* first we load in a temporary buffer */
-                    FileLoad( f, &p_buffer, &i_buffer );
-
-                    /* we parse executing all  <vlc /> macros */
-                    Execute( p_args, p_request, i_request, pp_data, pi_data,
-                             &dst, &p_buffer[0], &p_buffer[i_buffer] );
-                    free( p_buffer );
-                    fclose(f);
-                    break;
+                        strcpy( psz_file, m->param1 );
                 }
-                case MVLC_IF:
+                else
                 {
-                    bool i_test;
-                    char    *endif;
-
-                    EvaluateRPN( p_intf, p_args->vars, &p_args->stack, m.param1 );
-                    if( SSPopN( &p_args->stack, p_args->vars ) )
-                    {
-                        i_test = 1;
-                    }
-                    else
-                    {
-                        i_test = 0;
-                    }
-                    endif = MacroSearch( src, end, MVLC_END, true );
-
-                    if( i_test == 0 )
-                    {
-                        char *start = MacroSearch( src, endif, MVLC_ELSE, true );
-
-                        if( start )
-                        {
-                            char *stop  = MacroSearch( start, endif, MVLC_END, false );
-                            if( stop )
-                            {
-                                Execute( p_args, p_request, i_request,
-                                         pp_data, pi_data, &dst, start, stop );
-                            }
-                        }
-                    }
-                    else if( i_test == 1 )
-                    {
-                        char *stop;
-                        if( ( stop = MacroSearch( src, endif, MVLC_ELSE, false ) ) == NULL )
-                        {
-                            stop = MacroSearch( src, endif, MVLC_END, false );
-                        }
-                        if( stop )
-                        {
-                            Execute( p_args, p_request, i_request,
-                                     pp_data, pi_data, &dst, src, stop );
-                        }
-                    }
+                    strcpy( psz_file, m->param1 );
+                }
 
-                    src = endif;
+                if( ( p_tpl = TemplateGet( p_intf, psz_file ) ) == NULL )
+                {
+                    msg_Warn( p_args->p_intf,
+                              "unable to include file %s (%m)",
+                              psz_file );
                     break;
                 }
-                case MVLC_FOREACH:
-                {
-                    char *endfor = MacroSearch( src, end, MVLC_END, true );
-                    char *start = src;
-                    char *stop = MacroSearch( src, end, MVLC_END, false );
 
-                    if( stop )
-                    {
-                        mvar_t *index;
-                        int    i_idx;
-                        mvar_t *v;
-                        if( !strcmp( m.param2, "integer" ) )
-                        {
-                            char *arg = SSPop( &p_args->stack );
-                            index = mvar_IntegerSetNew( m.param1, arg );
-                            free( arg );
-                        }
-                        else if( !strcmp( m.param2, "directory" ) )
-                        {
-                            char *arg = SSPop( &p_args->stack );
-                            index = mvar_FileSetNew( p_intf, m.param1, arg );
-                            free( arg );
-                        }
-                        else if( !strcmp( m.param2, "object" ) )
-                        {
-                            char *arg = SSPop( &p_args->stack );
-                            index = mvar_ObjectSetNew( p_intf, m.param1, arg );
-                            free( arg );
-                        }
-                        else if( !strcmp( m.param2, "playlist" ) )
-                        {
-                            index = mvar_PlaylistSetNew( p_intf, m.param1,
-                                                    p_intf->p_sys->p_playlist );
-                        }
-                        else if( !strcmp( m.param2, "information" ) )
-                        {
-                            index = mvar_InfoSetNew( m.param1,
-                                                     p_intf->p_sys->p_input );
-                        }
-                        else if( !strcmp( m.param2, "program" )
-                                  || !strcmp( m.param2, "title" )
-                                  || !strcmp( m.param2, "chapter" )
-                                  || !strcmp( m.param2, "audio-es" )
-                                  || !strcmp( m.param2, "video-es" )
-                                  || !strcmp( m.param2, "spu-es" ) )
-                        {
-                            index = mvar_InputVarSetNew( p_intf, m.param1,
-                                                         p_intf->p_sys->p_input,
-                                                         m.param2 );
-                        }
+                /* we parse executing all  <vlc /> macros */
+                TemplateExecute( p_args, p_tpl->p_ops, p_request, i_request,
+                                 pp_data, pi_data, pp_dst );
+                TemplateRelease( p_tpl );
+                break;
+            }
+            case MVLC_IF:
+                RPNExecute( p_intf, p_args->vars, &p_args->stack,
+                            p_op->p_rpn );
+                TemplateExecute( p_args,
+                                 SSPopN( &p_args->stack, p_args->vars )
+                                     ? p_op->p_body : p_op->p_else,
+                                 p_request, i_request,
+                                 pp_data, pi_data, pp_dst );
+                break;
+            case MVLC_FOREACH:
+            {
+                mvar_t *index;
+                int    i_idx;
+                mvar_t *v;
+                if( !strcmp( m->param2, "integer" ) )
+                {
+                    char *arg = SSPop( &p_args->stack );
+                    index = mvar_IntegerSetNew( m->param1, arg );
+                    free( arg );
+                }
+                else if( !strcmp( m->param2, "directory" ) )
+                {
+                    char *arg = SSPop( &p_args->stack );
+                    index = mvar_FileSetNew( p_intf, m->param1, arg );
+                    free( arg );
+                }
+                else if( !strcmp( m->param2, "object" ) )
+                {
+                    char *arg = SSPop( &p_args->stack );
+                    index = mvar_ObjectSetNew( p_intf, m->param1, arg );
+                    free( arg );
+                }
+                else if( !strcmp( m->param2, "playlist" ) )
+                {
+                    index = mvar_PlaylistSetNew( p_intf, m->param1,
+                                            p_intf->p_sys->p_playlist );
+                }
+                else if( !strcmp( m->param2, "information" ) )
+                {
+                    index = mvar_InfoSetNew( m->param1,
+                                             p_intf->p_sys->p_input );
+                }
+                else if( !strcmp( m->param2, "program" )
+                          || !strcmp( m->param2, "title" )
+                          || !strcmp( m->param2, "chapter" )
+                          || !strcmp( m->param2, "audio-es" )
+                          || !strcmp( m->param2, "video-es" )
+                          || !strcmp( m->param2, "spu-es" ) )
+                {
+                    index = mvar_InputVarSetNew( p_intf, m->param1,
+                                                 p_intf->p_sys->p_input,
+                                                 m->param2 );
+                }
 #ifdef ENABLE_VLM
-                        else if( !strcmp( m.param2, "vlm" ) )
-                        {
-                            if( p_intf->p_sys->p_vlm == NULL )
-                                p_intf->p_sys->p_vlm = vlm_New( p_intf );
-                            index = mvar_VlmSetNew( m.param1, p_intf->p_sys->p_vlm );
-                        }
-#endif
-#if 0
-                        else if( !strcmp( m.param2, "hosts" ) )
-                        {
-                            index = mvar_HttpdInfoSetNew( m.param1, p_intf->p_sys->p_httpd, HTTPD_GET_HOSTS );
-                        }
-                        else if( !strcmp( m.param2, "urls" ) )
-                        {
-                            index = mvar_HttpdInfoSetNew( m.param1, p_intf->p_sys->p_httpd, HTTPD_GET_URLS );
-                        }
-                        else if( !strcmp( m.param2, "connections" ) )
-                        {
-                            index = mvar_HttpdInfoSetNew(m.param1, p_intf->p_sys->p_httpd, HTTPD_GET_CONNECTIONS);
-                        }
+                else if( !strcmp( m->param2, "vlm" ) )
+                {
+                    if( p_intf->p_sys->p_vlm == NULL )
+                        p_intf->p_sys->p_vlm = vlm_New( p_intf );
+                    index = mvar_VlmSetNew( m->param1, p_intf->p_sys->p_vlm );
+                }
 #endif
-                        else if( ( v = mvar_GetVar( p_args->vars, m.param2 ) ) )
-                        {
-                            index = mvar_Duplicate( v );
-                        }
-                        else
-                        {
-                            msg_Dbg( p_intf, "invalid index constructor (%s)", m.param2 );
-                            src = endfor;
-                            break;
-                        }
-
-                        for( i_idx = 0; i_idx < index->i_field; i_idx++ )
-                        {
-                            mvar_t *f = mvar_Duplicate( index->field[i_idx] );
-
-                            //msg_Dbg( p_intf, "foreach field[%d] name=%s value=%s", i_idx, f->name, f->value );
-
-                            free( f->name );
-                            f->name = strdup( m.param1 );
-
-
-                            mvar_PushVar( p_args->vars, f );
-                            Execute( p_args, p_request, i_request,
-                                     pp_data, pi_data, &dst, start, stop );
-                            mvar_RemoveVar( p_args->vars, f );
-
-                            mvar_Delete( f );
-                        }
-                        mvar_Delete( index );
-
-                        src = endfor;
-                    }
-                    break;
+                else if( ( v = mvar_GetVar( p_args->vars, m->param2 ) ) )
+                {
+                    index = mvar_Duplicate( v );
                 }
-                default:
-                    MacroDo( p_args, &m, p_request, i_request,
-                             pp_data, pi_data, &dst );
+                else
+                {
+                    msg_Dbg( p_intf, "invalid index constructor (%s)", m->param2 );
                     break;
-            }
+                }
 
-            MacroClean( &m );
-            continue;
-        }
+                for( i_idx = 0; i_idx < index->i_field; i_idx++ )
+                {
+                    mvar_t *f = mvar_Duplicate( index->field[i_idx] );
 
-        i_copy =   ( (p == NULL || p > end ) ? end : p  ) - src;
-        if( i_copy > 0 )
-        {
-            int i_index = dst - *pp_data;
+                    free( f->name );
+                    f->name = strdup( m->param1 );
 
-            *pi_data += i_copy;
-            *pp_data = realloc( *pp_data, *pi_data );
-            dst = (*pp_data) + i_index;
+                    mvar_PushVar( p_args->vars, f );
+                    TemplateExecute( p_args, p_op->p_body,
+                                     p_request, i_request,
+                                     pp_data, pi_data, pp_dst );
+                    mvar_RemoveVar( p_args->vars, f );
 
-            memcpy( dst, src, i_copy );
-            dst += i_copy;
-            src += i_copy;
+                    mvar_Delete( f );
+                }
+                mvar_Delete( index );
+                break;
+            }
+            default:
+                MacroDo( p_args, p_op, p_request, i_request,
+                         pp_data, pi_data, pp_dst );
+                break;
         }
     }
-
-    *pp_dst = dst;
-    free( dup );
 }
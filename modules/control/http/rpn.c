@@ -125,14 +125,28 @@ void SSPushN( rpn_stack_t *st, int i )
     SSPush( st, v );
 }
 
-void EvaluateRPN( intf_thread_t *p_intf, mvar_t  *vars,
-                      rpn_stack_t *st, char *exp )
+rpn_t *RPNCompile( const char *psz_exp )
 {
-    intf_sys_t    *p_sys = p_intf->p_sys;
+    rpn_t *p_rpn = malloc( sizeof( *p_rpn ) );
+    char *dup, *exp;
+
+    if( p_rpn == NULL )
+        return NULL;
+    p_rpn->i_words = 0;
+    p_rpn->p_words = NULL;
+
+    exp = dup = strdup( psz_exp != NULL ? psz_exp : "" );
+    if( dup == NULL )
+    {
+        free( p_rpn );
+        return NULL;
+    }
 
     while( exp != NULL && *exp != '\0' )
     {
+        rpn_word_t *p_words;
         char *p, *s;
+        bool b_string;
 
         /* skip space */
         while( *exp == ' ' )
@@ -140,30 +154,64 @@ void EvaluateRPN( intf_thread_t *p_intf, mvar_t  *vars,
             exp++;
         }
 
-        if( *exp == '\'' )
-        {
-            /* extract string */
-            p = FirstWord( exp, exp );
-            SSPush( st, exp );
-            exp = p;
-            continue;
-        }
-
-        /* extract token */
+        /* extract the word, which is a string if it is quoted */
+        b_string = *exp == '\'';
         p = FirstWord( exp, exp );
         s = exp;
-        if( p == NULL )
+        exp = p;
+        if( !b_string && *s == '\0' )
         {
-            exp += strlen( exp );
-        }
-        else
-        {
-            exp = p;
+            break;
         }
 
-        if( *s == '\0' )
-        {
+        p_words = realloc( p_rpn->p_words,
+                           ( p_rpn->i_words + 1 ) * sizeof( *p_words ) );
+        if( p_words == NULL )
+            break;
+        p_rpn->p_words = p_words;
+        p_words[p_rpn->i_words].psz = strdup( s );
+        p_words[p_rpn->i_words].b_string = b_string;
+        if( p_words[p_rpn->i_words].psz == NULL )
             break;
+        p_rpn->i_words++;
+    }
+
+    free( dup );
+    return p_rpn;
+}
+
+void RPNDelete( rpn_t *p_rpn )
+{
+    if( p_rpn == NULL )
+        return;
+    for( int i = 0; i < p_rpn->i_words; i++ )
+        free( p_rpn->p_words[i].psz );
+    free( p_rpn->p_words );
+    free( p_rpn );
+}
+
+void EvaluateRPN( intf_thread_t *p_intf, mvar_t  *vars,
+                      rpn_stack_t *st, char *exp )
+{
+    rpn_t *p_rpn = RPNCompile( exp );
+
+    RPNExecute( p_intf, vars, st, p_rpn );
+    RPNDelete( p_rpn );
+}
+
+void RPNExecute( intf_thread_t *p_intf, mvar_t  *vars,
+                 rpn_stack_t *st, const rpn_t *p_rpn )
+{
+    intf_sys_t    *p_sys = p_intf->p_sys;
+
+    for( int i = 0; p_rpn != NULL && i < p_rpn->i_words; i++ )
+    {
+        char *p, *s = p_rpn->p_words[i].psz;
+
+        if( p_rpn->p_words[i].b_string )
+        {
+            SSPush( st, s );
+            continue;
         }
 
         /* 1. Integer function */
@@ -0,0 +1,422 @@
+/*****************************************************************************
+ * metrics.c : Prometheus-style statistics export over HTTP
+ *****************************************************************************
+ * Copyright (C) 2008 the VideoLAN team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_interface.h>
+#include <vlc_input.h>
+#include <vlc_httpd.h>
+
+#include <stdarg.h>
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define HOST_TEXT N_( "Host address" )
+#define HOST_LONGTEXT N_( \
+    "Address and port the statistics will be served on, at the /metrics " \
+    "URL. It defaults to all network interfaces on port 9090." )
+
+vlc_module_begin();
+    set_shortname( N_("Metrics") );
+    set_description( N_("Statistics export interface (Prometheus format)") );
+    set_category( CAT_INTERFACE );
+    set_subcategory( SUBCAT_INTERFACE_CONTROL );
+    add_string( "metrics-host", NULL, NULL, HOST_TEXT, HOST_LONGTEXT, true );
+    set_capability( "interface", 0 );
+    set_callbacks( Open, Close );
+vlc_module_end();
+
+/*****************************************************************************
+ * Local prototypes
+ *****************************************************************************/
+struct httpd_file_sys_t
+{
+    intf_thread_t *p_intf;
+};
+
+struct intf_sys_t
+{
+    httpd_host_t     *p_host;
+    httpd_file_t     *p_file;
+    httpd_file_sys_t  file_sys;
+};
+
+static int Fill( httpd_file_sys_t *, httpd_file_t *, uint8_t *,
+                 uint8_t **, int * );
+
+/*****************************************************************************
+ * Open: start listening
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    intf_thread_t *p_intf = (intf_thread_t *)p_this;
+    intf_sys_t    *p_sys;
+    char          *psz_address;
+    int            i_port = 0;
+
+    psz_address = var_CreateGetNonEmptyString( p_intf, "metrics-host" );
+    if( psz_address != NULL )
+    {
+        char *psz_parser = strrchr( psz_address, ':' );
+        if( psz_parser )
+        {
+            *psz_parser++ = '\0';
+            i_port = atoi( psz_parser );
+        }
+    }
+    else
+        psz_address = strdup( "" );
+    if( psz_address == NULL )
+        return VLC_ENOMEM;
+    if( i_port <= 0 )
+        i_port = 9090;
+
+    p_intf->p_sys = p_sys = malloc( sizeof( intf_sys_t ) );
+    if( p_sys == NULL )
+    {
+        free( psz_address );
+        return VLC_ENOMEM;
+    }
+
+    p_sys->p_host = httpd_HostNew( VLC_OBJECT(p_intf), psz_address, i_port );
+    if( p_sys->p_host == NULL )
+    {
+        msg_Err( p_intf, "cannot listen on %s:%d", psz_address, i_port );
+        free( psz_address );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    p_sys->file_sys.p_intf = p_intf;
+    p_sys->p_file = httpd_FileNew( p_sys->p_host, "/metrics",
+                                   "text/plain; version=0.0.4",
+                                   NULL, NULL, NULL, Fill, &p_sys->file_sys );
+    if( p_sys->p_file == NULL )
+    {
+        msg_Err( p_intf, "cannot register /metrics" );
+        httpd_HostDelete( p_sys->p_host );
+        free( psz_address );
+        free( p_sys );
+        return VLC_EGENERIC;
+    }
+
+    msg_Dbg( p_intf, "serving statistics on %s:%d/metrics",
+             psz_address, i_port );
+    free( psz_address );
+
+    /* Nothing to do in the interface thread: requests are answered from
+     * the httpd thread. */
+    p_intf->pf_run = NULL;
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Close: stop listening
+ *****************************************************************************/
+static void Close( vlc_object_t *p_this )
+{
+    intf_thread_t *p_intf = (intf_thread_t *)p_this;
+    intf_sys_t    *p_sys = p_intf->p_sys;
+
+    httpd_FileDelete( p_sys->p_file );
+    httpd_HostDelete( p_sys->p_host );
+    free( p_sys );
+}
+
+/*****************************************************************************
+ * Output buffer
+ *****************************************************************************/
+typedef struct
+{
+    char   *psz;
+    size_t  i_len;
+    size_t  i_size;
+} buffer_t;
+
+static void Append( buffer_t *p_buf, const char *psz_fmt, ... )
+    LIBVLC_FORMAT( 2, 3 );
+
+static void Append( buffer_t *p_buf, const char *psz_fmt, ... )
+{
+    va_list args;
+    int i_ret;
+
+    if( p_buf->psz == NULL && p_buf->i_size != 0 )
+        return; /* earlier allocation failure */
+
+    for( ;; )
+    {
+        size_t i_room = p_buf->i_size - p_buf->i_len;
+
+        va_start( args, psz_fmt );
+        i_ret = vsnprintf( p_buf->psz ? p_buf->psz + p_buf->i_len : NULL,
+                           i_room, psz_fmt, args );
+        va_end( args );
+        if( i_ret < 0 )
+            return;
+        if( (size_t)i_ret < i_room )
+            break;
+
+        size_t i_size = __MAX( 2 * p_buf->i_size, p_buf->i_len + i_ret + 1 );
+        char *psz = realloc( p_buf->psz, i_size );
+        if( psz == NULL )
+        {
+            free( p_buf->psz );
+            p_buf->psz = NULL;
+            p_buf->i_size = 1;
+            return;
+        }
+        p_buf->psz = psz;
+        p_buf->i_size = i_size;
+    }
+    p_buf->i_len += i_ret;
+}
+
+/* Prometheus label values need \, " and newlines escaped */
+static char *EscapeLabel( const char *psz_in )
+{
+    char *psz_out = malloc( 2 * strlen( psz_in ) + 1 ), *p;
+    if( psz_out == NULL )
+        return NULL;
+
+    for( p = psz_out; *psz_in; psz_in++ )
+    {
+        switch( *psz_in )
+        {
+            case '\\': *p++ = '\\'; *p++ = '\\'; break;
+            case '"':  *p++ = '\\'; *p++ = '"';  break;
+            case '\n': *p++ = '\\'; *p++ = 'n';  break;
+            default:   *p++ = *psz_in;
+        }
+    }
+    *p = '\0';
+    return psz_out;
+}
+
+/*****************************************************************************
+ * Metrics
+ *****************************************************************************/
+typedef struct
+{
+    const char *psz_name;
+    const char *psz_type;
+    const char *psz_help;
+    size_t      i_offset;
+    bool        b_float;
+} metric_t;
+
+#define INT_METRIC( name, type, help, field ) \
+    { name, type, help, offsetof( input_stats_t, field ), false }
+#define FLOAT_METRIC( name, help, field ) \
+    { name, "gauge", help, offsetof( input_stats_t, field ), true }
+
+static const metric_t p_metrics[] =
+{
+    INT_METRIC( "vlc_input_read_packets_total", "counter",
+                "Packets read by the access", i_read_packets ),
+    INT_METRIC( "vlc_input_read_bytes_total", "counter",
+                "Bytes read by the access", i_read_bytes ),
+    FLOAT_METRIC( "vlc_input_bitrate_bytes_per_second",
+                  "Access read bitrate", f_input_bitrate ),
+    INT_METRIC( "vlc_demux_read_packets_total", "counter",
+                "Packets read by the demuxer", i_demux_read_packets ),
+    INT_METRIC( "vlc_demux_read_bytes_total", "counter",
+                "Bytes read by the demuxer", i_demux_read_bytes ),
+    FLOAT_METRIC( "vlc_demux_bitrate_bytes_per_second",
+                  "Demuxer read bitrate", f_demux_bitrate ),
+    INT_METRIC( "vlc_decoded_audio_total", "counter",
+                "Decoded audio blocks", i_decoded_audio ),
+    INT_METRIC( "vlc_decoded_video_total", "counter",
+                "Decoded video pictures", i_decoded_video ),
+    INT_METRIC( "vlc_vout_displayed_pictures_total", "counter",
+                "Pictures displayed", i_displayed_pictures ),
+    INT_METRIC( "vlc_vout_lost_pictures_total", "counter",
+                "Pictures dropped", i_lost_pictures ),
+    INT_METRIC( "vlc_aout_played_buffers_total", "counter",
+                "Audio buffers played", i_played_abuffers ),
+    INT_METRIC( "vlc_aout_lost_buffers_total", "counter",
+                "Audio buffers dropped", i_lost_abuffers ),
+    INT_METRIC( "vlc_sout_sent_packets_total", "counter",
+                "Packets sent by the stream output", i_sent_packets ),
+    INT_METRIC( "vlc_sout_sent_bytes_total", "counter",
+                "Bytes sent by the stream output", i_sent_bytes ),
+    FLOAT_METRIC( "vlc_sout_bitrate_bytes_per_second",
+                  "Stream output bitrate", f_send_bitrate ),
+};
+
+typedef struct
+{
+    int            i_id;
+    char          *psz_name;
+    input_stats_t  stats;
+} snapshot_t;
+
+static void DumpHistogram( buffer_t *p_buf, const char *psz_name,
+                           const char *psz_help, const snapshot_t *p_snap,
+                           int i_snap, size_t i_offset )
+{
+    Append( p_buf, "# HELP %s %s\n# TYPE %s histogram\n",
+            psz_name, psz_help, psz_name );
+
+    for( int i = 0; i < i_snap; i++ )
+    {
+        const stats_histogram_t *h = (const stats_histogram_t *)
+            ((const uint8_t *)&p_snap[i].stats + i_offset);
+        uint64_t i_cumul = 0;
+
+        /* Bucket b holds the values below 2^b microseconds */
+        for( unsigned b = 0; b < STATS_HISTOGRAM_BUCKETS - 1; b++ )
+        {
+            i_cumul += h->pi_buckets[b];
+            Append( p_buf, "%s_bucket{input=\"%d\",name=\"%s\",le=\"%g\"} %"
+                    PRIu64"\n", psz_name, p_snap[i].i_id, p_snap[i].psz_name,
+                    (double)(((int64_t)1 << b) - 1) / 1000000., i_cumul );
+        }
+        Append( p_buf, "%s_bucket{input=\"%d\",name=\"%s\",le=\"+Inf\"} %"
+                PRIu64"\n", psz_name, p_snap[i].i_id, p_snap[i].psz_name,
+                h->i_count );
+        Append( p_buf, "%s_sum{input=\"%d\",name=\"%s\"} %g\n",
+                psz_name, p_snap[i].i_id, p_snap[i].psz_name,
+                (double)h->i_sum / 1000000. );
+        Append( p_buf, "%s_count{input=\"%d\",name=\"%s\"} %"PRIu64"\n",
+                psz_name, p_snap[i].i_id, p_snap[i].psz_name, h->i_count );
+    }
+}
+
+static int Fill( httpd_file_sys_t *p_args, httpd_file_t *p_file,
+                 uint8_t *psz_request, uint8_t **pp_data, int *pi_data )
+{
+    intf_thread_t *p_intf = p_args->p_intf;
+    buffer_t buf = { NULL, 0, 0 };
+    snapshot_t *p_snap = NULL;
+    int i_snap = 0;
+    VLC_UNUSED(p_file); VLC_UNUSED(psz_request);
+
+    /* Take a consistent copy of each input statistics first, so that no
+     * lock is held while formatting */
+    vlc_list_t *p_list = vlc_list_find( p_intf, VLC_OBJECT_INPUT,
+                                        FIND_ANYWHERE );
+    if( p_list != NULL )
+    {
+        if( p_list->i_count > 0 )
+            p_snap = calloc( p_list->i_count, sizeof( *p_snap ) );
+        for( int i = 0; p_snap != NULL && i < p_list->i_count; i++ )
+        {
+            input_thread_t *p_input =
+                (input_thread_t *)p_list->p_values[i].p_object;
+            input_item_t *p_item = input_GetItem( p_input );
+            if( p_item == NULL || p_item->p_stats == NULL )
+                continue;
+
+            char *psz_name = input_item_GetName( p_item );
+            snapshot_t *p_cur = &p_snap[i_snap];
+
+            p_cur->i_id = p_input->i_object_id;
+            p_cur->psz_name = EscapeLabel( psz_name ? psz_name : "" );
+            free( psz_name );
+            if( p_cur->psz_name == NULL )
+                continue;
+
+            vlc_mutex_lock( &p_item->p_stats->lock );
+            p_cur->stats = *p_item->p_stats;
+            vlc_mutex_unlock( &p_item->p_stats->lock );
+            i_snap++;
+        }
+        vlc_list_release( p_list );
+    }
+
+    for( size_t m = 0; m < sizeof( p_metrics ) / sizeof( p_metrics[0] ); m++ )
+    {
+        const metric_t *p_metric = &p_metrics[m];
+
+        Append( &buf, "# HELP %s %s\n# TYPE %s %s\n",
+                p_metric->psz_name, p_metric->psz_help,
+                p_metric->psz_name, p_metric->psz_type );
+        for( int i = 0; i < i_snap; i++ )
+        {
+            const uint8_t *p_field =
+                (const uint8_t *)&p_snap[i].stats + p_metric->i_offset;
+
+            if( p_metric->b_float )
+                Append( &buf, "%s{input=\"%d\",name=\"%s\"} %g\n",
+                        p_metric->psz_name, p_snap[i].i_id,
+                        p_snap[i].psz_name,
+                        /* bitrates are kept in bytes per microsecond */
+                        *(const float *)p_field * 1000000. );
+            else
+                Append( &buf, "%s{input=\"%d\",name=\"%s\"} %d\n",
+                        p_metric->psz_name, p_snap[i].i_id,
+                        p_snap[i].psz_name, *(const int *)p_field );
+        }
+    }
+
+    DumpHistogram( &buf, "vlc_decode_time_seconds",
+                   "Time spent decoding one block", p_snap, i_snap,
+                   offsetof( input_stats_t, decode_time ) );
+    DumpHistogram( &buf, "vlc_vout_picture_lateness_seconds",
+                   "Delay between the display date and actual display",
+                   p_snap, i_snap,
+                   offsetof( input_stats_t, picture_lateness ) );
+
+    for( int i = 0; i < i_snap; i++ )
+        free( p_snap[i].psz_name );
+    free( p_snap );
+
+    /* Global statistics */
+    global_stats_t *p_global = p_intf->p_libvlc->p_stats;
+    if( p_global != NULL )
+    {
+        float f_input, f_demux, f_output;
+
+        vlc_mutex_lock( &p_global->lock );
+        f_input  = p_global->f_input_bitrate;
+        f_demux  = p_global->f_demux_bitrate;
+        f_output = p_global->f_output_bitrate;
+        vlc_mutex_unlock( &p_global->lock );
+
+        Append( &buf, "# HELP vlc_global_bitrate_bytes_per_second "
+                "Aggregated bitrate of all inputs\n"
+                "# TYPE vlc_global_bitrate_bytes_per_second gauge\n"
+                "vlc_global_bitrate_bytes_per_second{stage=\"input\"} %g\n"
+                "vlc_global_bitrate_bytes_per_second{stage=\"demux\"} %g\n"
+                "vlc_global_bitrate_bytes_per_second{stage=\"output\"} %g\n",
+                f_input * 1000000., f_demux * 1000000.,
+                f_output * 1000000. );
+    }
+
+    if( buf.psz == NULL )
+        return VLC_ENOMEM;
+
+    free( *pp_data );
+    *pp_data = (uint8_t *)buf.psz;
+    *pi_data = buf.i_len;
+    return VLC_SUCCESS;
+}
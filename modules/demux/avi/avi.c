@@ -39,6 +39,7 @@
 #include <vlc_charset.h>
 
 #include "libavi.h"
+#include "../index_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -2353,6 +2354,70 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
+/* Index created by a previous scan of the same file */
+#define AVI_INDEX_CACHE VLC_FOURCC('a','v','i',' ')
+
+static int AVI_IndexCacheLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    index_cache_t *p_cache;
+    unsigned int i_stream;
+
+    if( ( p_cache = index_cache_Load( p_demux, AVI_INDEX_CACHE ) ) == NULL )
+        return VLC_EGENERIC;
+
+    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    {
+        avi_track_t *tk = p_sys->track[i_stream];
+        const avi_entry_t *p_index;
+        size_t i_count;
+
+        p_index = index_cache_Table( p_cache, i_stream, sizeof( avi_entry_t ),
+                                     &i_count );
+        if( p_index == NULL || ( i_count > 0 &&
+            ( tk->p_index = malloc( i_count * sizeof( avi_entry_t ) ) ) == NULL ) )
+        {
+            while( i_stream-- > 0 )
+            {
+                FREENULL( p_sys->track[i_stream]->p_index );
+                p_sys->track[i_stream]->i_idxnb  = 0;
+                p_sys->track[i_stream]->i_idxmax = 0;
+            }
+            index_cache_Release( p_cache );
+            return VLC_EGENERIC;
+        }
+        if( i_count > 0 )
+        {
+            memcpy( tk->p_index, p_index, i_count * sizeof( avi_entry_t ) );
+            if( p_sys->i_movi_lastchunk_pos < p_index[i_count - 1].i_pos )
+                p_sys->i_movi_lastchunk_pos = p_index[i_count - 1].i_pos;
+        }
+        tk->i_idxnb  = i_count;
+        tk->i_idxmax = i_count;
+    }
+    index_cache_Release( p_cache );
+    return VLC_SUCCESS;
+}
+
+static void AVI_IndexCacheSave( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    unsigned int i_stream;
+
+    if( p_sys->i_track == 0 )
+        return;
+
+    index_cache_table_t table[p_sys->i_track];
+
+    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    {
+        table[i_stream].p_data       = p_sys->track[i_stream]->p_index;
+        table[i_stream].i_entry_size = sizeof( avi_entry_t );
+        table[i_stream].i_count      = p_sys->track[i_stream]->i_idxnb;
+    }
+    index_cache_Save( p_demux, AVI_INDEX_CACHE, table, p_sys->i_track );
+}
+
 static void AVI_IndexCreate( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -2365,6 +2430,7 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
     mtime_t i_dialog_update;
     int     i_dialog_id;
+    bool    b_save = true;
 
     p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0);
     p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0);
@@ -2381,6 +2447,14 @@ static void AVI_IndexCreate( demux_t *p_demux )
         p_sys->track[i_stream]->i_idxmax = 0;
         p_sys->track[i_stream]->p_index  = NULL;
     }
+
+    i_dialog_id = -1;
+    if( !AVI_IndexCacheLoad( p_demux ) )
+    {
+        b_save = false;
+        goto print_stat;
+    }
+
     i_movi_end = __MIN( (off_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
                         stream_Size( p_demux->s ) );
 
@@ -2389,7 +2463,6 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
 
     /* Only show dialog if AVI is > 10MB */
-    i_dialog_id = -1;
     i_dialog_update = mdate();
     if( stream_Size( p_demux->s ) > 10000000 )
         i_dialog_id = intf_IntfProgress( p_demux, _("Fixing AVI Index..."), 0.0 );
@@ -2399,13 +2472,19 @@ static void AVI_IndexCreate( demux_t *p_demux )
         avi_packet_t pk;
 
         if( !vlc_object_alive (p_demux) )
+        {
+            b_save = false;
             break;
+        }
 
         /* Don't update/check dialog too often */
         if( i_dialog_id > 0 && mdate() - i_dialog_update > 100000 )
         {
             if( intf_ProgressIsCancelled( p_demux, i_dialog_id ) )
+            {
+                b_save = false;
                 break;
+            }
 
             double f_pos = 100.0 * stream_Tell( p_demux->s ) /
                            stream_Size( p_demux->s );
@@ -2476,6 +2555,10 @@ print_stat:
     if( i_dialog_id > 0 )
         intf_UserHide( p_demux, i_dialog_id );
 
+    /* Unless it was interrupted, a new scan would find the same thing */
+    if( b_save )
+        AVI_IndexCacheSave( p_demux );
+
     for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
     {
         msg_Dbg( p_demux, "stream[%d] creating %d index entries",
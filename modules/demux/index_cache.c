@@ -0,0 +1,364 @@
+/*****************************************************************************
+ * index_cache.c: on-disk cache of demuxer seek indexes
+ *****************************************************************************
+ * Copyright (C) 2009 the VideoLAN team
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_demux.h>
+#include <vlc_block.h>
+#include <vlc_charset.h>
+#include <vlc_rand.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+
+#include "index_cache.h"
+
+/* The cache file is made of a header, the path of the indexed file, one
+ * descriptor per table, then the tables; everything is aligned on
+ * 8 bytes, so that the tables can be used where they are mapped. */
+#define INDEX_CACHE_MAGIC   "VLCINDEX"
+#define INDEX_CACHE_VERSION 1
+#define INDEX_CACHE_ALIGN(i) (((i) + 7) & ~(uint64_t)7)
+
+typedef struct
+{
+    char         magic[8];
+    uint32_t     i_version;
+    vlc_fourcc_t i_format;
+    uint64_t     i_file_size;   /* of the indexed file */
+    int64_t      i_file_mtime;
+    uint64_t     i_cache_size;  /* of the cache file, to detect truncation */
+    uint32_t     i_path;        /* length of the path */
+    uint32_t     i_tables;
+} index_cache_header_t;
+
+typedef struct
+{
+    uint64_t     i_offset;      /* from the beginning of the cache file */
+    uint64_t     i_entry_size;
+    uint64_t     i_count;
+} index_cache_desc_t;
+
+struct index_cache_t
+{
+    block_t                  *p_block;
+    const index_cache_desc_t *p_desc;
+    unsigned                 i_tables;
+};
+
+/*****************************************************************************
+ * IndexCacheName: checks that the file can be cached, and names its cache
+ *****************************************************************************/
+static char *IndexCacheName( demux_t *p_demux, vlc_fourcc_t i_format,
+                             struct stat *p_st )
+{
+    const char *psz_path = p_demux->psz_path;
+    char *psz_cachedir, *psz_name;
+    uint64_t i_hash = UINT64_C(0xcbf29ce484222325); /* FNV-1a */
+
+    /* Only local files have an identity */
+    if( ( *p_demux->psz_access && strcmp( p_demux->psz_access, "file" ) ) ||
+        !*psz_path || !var_CreateGetBool( p_demux, "index-cache" ) )
+        return NULL;
+    if( utf8_stat( psz_path, p_st ) || !S_ISREG( p_st->st_mode ) ||
+        p_st->st_size != stream_Size( p_demux->s ) )
+        return NULL;
+
+    for( const char *p = psz_path; *p; p++ )
+        i_hash = ( i_hash ^ (uint8_t)*p ) * UINT64_C(0x100000001b3);
+    for( int i = 0; i < 4; i++ )
+        i_hash = ( i_hash ^ ( ( i_format >> (8 * i) ) & 0xff ) ) *
+                 UINT64_C(0x100000001b3);
+
+    psz_cachedir = config_GetCacheDir();
+    if( !psz_cachedir )
+        return NULL;
+    if( asprintf( &psz_name, "%s"DIR_SEP"index"DIR_SEP"%016"PRIx64".idx",
+                  psz_cachedir, i_hash ) == -1 )
+        psz_name = NULL;
+    free( psz_cachedir );
+    return psz_name;
+}
+
+/*****************************************************************************
+ * index_cache_Load:
+ *****************************************************************************/
+index_cache_t *index_cache_Load( demux_t *p_demux, vlc_fourcc_t i_format )
+{
+    const char *psz_path = p_demux->psz_path;
+    index_cache_header_t header;
+    index_cache_t *p_cache;
+    block_t *p_block;
+    struct stat st;
+    uint64_t i_desc;
+    char *psz_name;
+    int fd;
+
+    psz_name = IndexCacheName( p_demux, i_format, &st );
+    if( !psz_name )
+        return NULL;
+    fd = utf8_open( psz_name, O_RDONLY, 0 );
+    if( fd == -1 )
+    {
+        free( psz_name );
+        return NULL;
+    }
+    p_block = block_File( fd );
+    close( fd );
+    if( !p_block )
+    {
+        free( psz_name );
+        return NULL;
+    }
+
+    if( p_block->i_buffer < sizeof( header ) )
+        goto error;
+    memcpy( &header, p_block->p_buffer, sizeof( header ) );
+    if( memcmp( header.magic, INDEX_CACHE_MAGIC, 8 ) ||
+        header.i_version != INDEX_CACHE_VERSION ||
+        header.i_format != i_format ||
+        header.i_cache_size != p_block->i_buffer ||
+        header.i_path != strlen( psz_path ) ||
+        sizeof( header ) + header.i_path > p_block->i_buffer ||
+        memcmp( p_block->p_buffer + sizeof( header ), psz_path,
+                header.i_path ) )
+        goto error;
+    if( header.i_file_size != (uint64_t)st.st_size ||
+        header.i_file_mtime != (int64_t)st.st_mtime )
+    {
+        msg_Dbg( p_demux, "cached index %s is outdated", psz_name );
+        goto error;
+    }
+
+    /* Check that every table fits in the file */
+    i_desc = INDEX_CACHE_ALIGN( sizeof( header ) + header.i_path );
+    if( i_desc > p_block->i_buffer ||
+        header.i_tables > ( p_block->i_buffer - i_desc ) /
+                          sizeof( index_cache_desc_t ) )
+        goto error;
+    for( unsigned i = 0; i < header.i_tables; i++ )
+    {
+        index_cache_desc_t desc;
+
+        memcpy( &desc, p_block->p_buffer + i_desc + i * sizeof( desc ),
+                sizeof( desc ) );
+        if( desc.i_offset > p_block->i_buffer || ( desc.i_offset & 7 ) ||
+            ( desc.i_entry_size > 0 && desc.i_count >
+              ( p_block->i_buffer - desc.i_offset ) / desc.i_entry_size ) )
+            goto error;
+    }
+
+    p_cache = malloc( sizeof( *p_cache ) );
+    if( !p_cache )
+        goto error;
+    p_cache->p_block = p_block;
+    p_cache->p_desc = (const index_cache_desc_t *)(p_block->p_buffer + i_desc);
+    p_cache->i_tables = header.i_tables;
+
+    msg_Dbg( p_demux, "using cached index %s", psz_name );
+    free( psz_name );
+    return p_cache;
+
+error:
+    block_Release( p_block );
+    free( psz_name );
+    return NULL;
+}
+
+const void *index_cache_Table( index_cache_t *p_cache, unsigned i_table,
+                               size_t i_entry_size, size_t *pi_count )
+{
+    const index_cache_desc_t *p_desc;
+
+    if( i_table >= p_cache->i_tables )
+        return NULL;
+    p_desc = &p_cache->p_desc[i_table];
+    if( p_desc->i_entry_size != i_entry_size )
+        return NULL;
+    *pi_count = p_desc->i_count;
+    return p_cache->p_block->p_buffer + p_desc->i_offset;
+}
+
+void index_cache_Release( index_cache_t *p_cache )
+{
+    block_Release( p_cache->p_block );
+    free( p_cache );
+}
+
+/*****************************************************************************
+ * index_cache_Save:
+ *****************************************************************************/
+static int IndexCachePad( FILE *file, uint64_t *pi_pos, uint64_t i_pos )
+{
+    static const uint8_t zero[8];
+
+    if( i_pos > *pi_pos &&
+        fwrite( zero, i_pos - *pi_pos, 1, file ) != 1 )
+        return VLC_EGENERIC;
+    *pi_pos = i_pos;
+    return VLC_SUCCESS;
+}
+
+/* Creates a new file next to psz_name. It is renamed over psz_name once
+ * written, so that the processes which have mapped the cache never see it
+ * truncated or half written. */
+static FILE *IndexCacheCreate( const char *psz_name, char **ppsz_tmp )
+{
+    for( int i = 0; i < 16; i++ )
+    {
+        uint32_t i_rand;
+        int fd, i_errno;
+
+        vlc_rand_bytes( &i_rand, sizeof( i_rand ) );
+        if( asprintf( ppsz_tmp, "%s.%08"PRIx32".tmp", psz_name, i_rand ) == -1 )
+            break;
+
+        fd = utf8_open( *ppsz_tmp, O_WRONLY | O_CREAT | O_EXCL, 0600 );
+        if( fd != -1 )
+        {
+            FILE *file = fdopen( fd, "wb" );
+            if( file != NULL )
+                return file;
+            close( fd );
+            utf8_unlink( *ppsz_tmp );
+        }
+        i_errno = errno;
+        free( *ppsz_tmp );
+        if( fd != -1 || i_errno != EEXIST )
+        {
+            errno = i_errno;
+            break;
+        }
+    }
+    *ppsz_tmp = NULL;
+    return NULL;
+}
+
+int index_cache_Save( demux_t *p_demux, vlc_fourcc_t i_format,
+                      const index_cache_table_t *p_tables, unsigned i_tables )
+{
+    const char *psz_path = p_demux->psz_path;
+    index_cache_header_t header;
+    struct stat st;
+    uint64_t i_pos;
+    char *psz_name, *psz_dir, *psz_tmp;
+    FILE *file;
+
+    /* Nothing worth caching (and no zero-length array below) */
+    if( i_tables == 0 )
+        return VLC_EGENERIC;
+
+    index_cache_desc_t desc[i_tables];
+
+    psz_name = IndexCacheName( p_demux, i_format, &st );
+    if( !psz_name )
+        return VLC_EGENERIC;
+
+    /* Create the cache directory and its index subdirectory */
+    psz_dir = strdup( psz_name );
+    if( psz_dir )
+    {
+        for( int i = 0; i < 2; i++ )
+            *strrchr( psz_dir, DIR_SEP_CHAR ) = '\0';
+        utf8_mkdir( psz_dir, 0700 );
+        strcat( psz_dir, DIR_SEP"index" );
+        utf8_mkdir( psz_dir, 0700 );
+        free( psz_dir );
+    }
+
+    memset( &header, 0, sizeof( header ) );
+    memcpy( header.magic, INDEX_CACHE_MAGIC, 8 );
+    header.i_version = INDEX_CACHE_VERSION;
+    header.i_format = i_format;
+    header.i_file_size = st.st_size;
+    header.i_file_mtime = st.st_mtime;
+    header.i_path = strlen( psz_path );
+    header.i_tables = i_tables;
+
+    i_pos = INDEX_CACHE_ALIGN( sizeof( header ) + header.i_path ) +
+            i_tables * sizeof( *desc );
+    for( unsigned i = 0; i < i_tables; i++ )
+    {
+        i_pos = INDEX_CACHE_ALIGN( i_pos );
+        desc[i].i_offset = i_pos;
+        desc[i].i_entry_size = p_tables[i].i_entry_size;
+        desc[i].i_count = p_tables[i].i_count;
+        i_pos += p_tables[i].i_entry_size * p_tables[i].i_count;
+    }
+    header.i_cache_size = i_pos;
+
+    file = IndexCacheCreate( psz_name, &psz_tmp );
+    if( !file )
+    {
+        msg_Warn( p_demux, "cannot create %s (%m)", psz_name );
+        free( psz_name );
+        return VLC_EGENERIC;
+    }
+
+    i_pos = sizeof( header ) + header.i_path;
+    if( fwrite( &header, sizeof( header ), 1, file ) != 1 ||
+        fwrite( psz_path, header.i_path, 1, file ) != 1 ||
+        IndexCachePad( file, &i_pos, INDEX_CACHE_ALIGN( i_pos ) ) ||
+        fwrite( desc, sizeof( *desc ), i_tables, file ) != i_tables )
+        goto error;
+    i_pos += i_tables * sizeof( *desc );
+
+    for( unsigned i = 0; i < i_tables; i++ )
+    {
+        const size_t i_size = desc[i].i_entry_size * desc[i].i_count;
+
+        if( IndexCachePad( file, &i_pos, desc[i].i_offset ) ||
+            ( i_size > 0 &&
+              fwrite( p_tables[i].p_data, i_size, 1, file ) != 1 ) )
+            goto error;
+        i_pos += i_size;
+    }
+
+    if( fclose( file ) )
+    {
+        file = NULL;
+        goto error;
+    }
+    file = NULL;
+    if( utf8_rename( psz_tmp, psz_name ) )
+        goto error;
+    msg_Dbg( p_demux, "saved index to %s", psz_name );
+    free( psz_tmp );
+    free( psz_name );
+    return VLC_SUCCESS;
+
+error:
+    msg_Warn( p_demux, "cannot write %s (%m)", psz_name );
+    if( file )
+        fclose( file );
+    utf8_unlink( psz_tmp );
+    free( psz_tmp );
+    free( psz_name );
+    return VLC_EGENERIC;
+}
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * index_cache.h: on-disk cache of demuxer seek indexes
+ *****************************************************************************
+ * Copyright (C) 2009 the VideoLAN team
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef _INDEX_CACHE_H
+#define _INDEX_CACHE_H 1
+
+/* A demuxer that had to build its seek index by scanning a local file
+ * saves it as a set of tables of fixed size entries, and maps them back
+ * the next time the same file (same path, size and modification time) is
+ * opened. The entries are stored as they are in memory: the cache is only
+ * meant for the machine that wrote it. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct index_cache_t index_cache_t;
+
+typedef struct
+{
+    const void *p_data;
+    size_t      i_entry_size;
+    size_t      i_count;
+} index_cache_table_t;
+
+#define index_cache_Load    __index_cache_Load
+#define index_cache_Table   __index_cache_Table
+#define index_cache_Release __index_cache_Release
+#define index_cache_Save    __index_cache_Save
+
+/**
+ * Maps the cached index of the file being demuxed, if it is still valid.
+ * \param i_format identifies the demuxer and the version of its tables
+ * \return NULL if there is none
+ */
+index_cache_t *index_cache_Load( demux_t *, vlc_fourcc_t i_format );
+
+/**
+ * Gets a table of a cached index.
+ * \return NULL if there is no such table, or if its entries do not have
+ * the expected size; the table is valid until index_cache_Release()
+ */
+const void *index_cache_Table( index_cache_t *, unsigned i_table,
+                               size_t i_entry_size, size_t *pi_count );
+
+void index_cache_Release( index_cache_t * );
+
+/**
+ * Saves the index of the file being demuxed. Nothing is saved without any
+ * table.
+ */
+int index_cache_Save( demux_t *, vlc_fourcc_t i_format,
+                      const index_cache_table_t *p_tables, unsigned i_tables );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _INDEX_CACHE_H */
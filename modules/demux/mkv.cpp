@@ -103,6 +103,7 @@
 extern "C" {
    #include "mp4/libmp4.h"
 }
+#include "index_cache.h"
 #ifdef HAVE_ZLIB_H
 #   include <zlib.h>
 #endif
@@ -1036,6 +1037,7 @@ public:
         ,p_prev_segment_uid(NULL)
         ,p_next_segment_uid(NULL)
         ,b_cues(false)
+        ,b_index_complete(false)
         ,i_index(0)
         ,i_index_max(1024)
         ,psz_muxing_application(NULL)
@@ -1127,6 +1129,7 @@ public:
     KaxNextUID              *p_next_segment_uid;
 
     bool                    b_cues;
+    bool                    b_index_complete; /* clusters indexed up to EOF */
     int                     i_index;
     int                     i_index_max;
     mkv_index_t             *p_indexes;
@@ -1428,6 +1431,9 @@ static int  Demux  ( demux_t * );
 static int  Control( demux_t *, int, va_list );
 static void Seek   ( demux_t *, mtime_t i_date, double f_percent, chapter_item_c *psz_chapter );
 
+static void IndexCacheLoad( demux_t *, matroska_stream_c * );
+static void IndexCacheSave( demux_t *, matroska_stream_c * );
+
 #define MKV_IS_ID( el, C ) ( EbmlId( (*el) ) == C::ClassInfos.GlobalId )
 
 static inline char * ToUTF8( const UTFstring &u )
@@ -1487,6 +1493,7 @@ static int Open( vlc_object_t * p_this )
     {
         p_stream->segments[i]->Preload();
     }
+    IndexCacheLoad( p_demux, p_stream );
 
     p_segment = p_stream->segments[0];
     if( p_segment->cluster == NULL )
@@ -1619,9 +1626,86 @@ static void Close( vlc_object_t *p_this )
     demux_t     *p_demux = (demux_t*)p_this;
     demux_sys_t *p_sys   = p_demux->p_sys;
 
+    if( !p_sys->streams.empty() )
+        IndexCacheSave( p_demux, p_sys->streams[0] );
     delete p_sys;
 }
 
+/*****************************************************************************
+ * Index cache: the clusters of the segments without cues, as found by a
+ * previous playback of the same file
+ *****************************************************************************/
+#define MKV_INDEX_CACHE VLC_FOURCC('m','k','v',' ')
+
+static void IndexCacheLoad( demux_t *p_demux, matroska_stream_c *p_stream )
+{
+    index_cache_t *p_cache = index_cache_Load( p_demux, MKV_INDEX_CACHE );
+
+    if( p_cache == NULL )
+        return;
+
+    for( size_t i = 0; i < p_stream->segments.size(); i++ )
+    {
+        matroska_segment_c *p_segment = p_stream->segments[i];
+        const mkv_index_t  *p_index;
+        mkv_index_t        *p_indexes;
+        size_t             i_count;
+
+        if( p_segment->b_cues )
+            continue;
+        p_index = (const mkv_index_t *)index_cache_Table( p_cache, i,
+                                          sizeof( mkv_index_t ), &i_count );
+        if( p_index == NULL || i_count == 0 )
+            continue;
+
+        /* Keep room for IndexAppendCluster() */
+        p_indexes = (mkv_index_t *)realloc( p_segment->p_indexes,
+                                  sizeof( mkv_index_t ) * ( i_count + 1024 ) );
+        if( p_indexes == NULL )
+            continue;
+        memcpy( p_indexes, p_index, sizeof( mkv_index_t ) * i_count );
+        p_segment->p_indexes   = p_indexes;
+        p_segment->i_index     = i_count;
+        p_segment->i_index_max = i_count + 1024;
+        p_segment->b_cues      = true;
+        msg_Dbg( p_demux, "segment %u: %u cached index entries",
+                 (unsigned)i, (unsigned)i_count );
+    }
+    index_cache_Release( p_cache );
+}
+
+static void IndexCacheSave( demux_t *p_demux, matroska_stream_c *p_stream )
+{
+    const size_t i_segments = p_stream->segments.size();
+    std::vector< std::vector<mkv_index_t> > indexes( i_segments );
+    std::vector<index_cache_table_t> tables( i_segments );
+    bool b_save = false;
+
+    for( size_t i = 0; i < i_segments; i++ )
+    {
+        matroska_segment_c *p_segment = p_stream->segments[i];
+
+        tables[i].i_entry_size = sizeof( mkv_index_t );
+        tables[i].i_count = 0;
+        tables[i].p_data = NULL;
+        if( p_segment->b_cues || !p_segment->b_index_complete )
+            continue;
+
+        /* The last cluster may not have been read */
+        for( int j = 0; j < p_segment->i_index; j++ )
+            if( p_segment->p_indexes[j].i_time >= 0 )
+                indexes[i].push_back( p_segment->p_indexes[j] );
+        if( indexes[i].empty() )
+            continue;
+        tables[i].p_data = &indexes[i][0];
+        tables[i].i_count = indexes[i].size();
+        b_save = true;
+    }
+
+    if( b_save )
+        index_cache_Save( p_demux, MKV_INDEX_CACHE, &tables[0], i_segments );
+}
+
 /*****************************************************************************
  * Control:
  *****************************************************************************/
@@ -1804,6 +1888,7 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
                 continue;
             }
             msg_Warn( &sys.demuxer, "EOF" );
+            b_index_complete = true;
             return VLC_EGENERIC;
         }
 
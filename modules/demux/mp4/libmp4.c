@@ -779,6 +779,134 @@ static int MP4_ReadBox_dref( stream_t *p_stream, MP4_Box_t *p_box )
     MP4_READBOX_EXIT( 1 );
 }
 
+/*****************************************************************************
+ * Table boxes (stts, ctts, stsc, stsz, stco, co64, stss)
+ *****************************************************************************
+ * When a file is read lazily, only the header of these boxes is read: the
+ * entries are read from the stream when they are needed, either all at once
+ * by MP4_BoxLoad, or one by one by MP4_BoxTableEntry.
+ *****************************************************************************/
+static bool MP4_BoxIsTable( uint32_t i_type )
+{
+    switch( i_type )
+    {
+        case FOURCC_stts:
+        case FOURCC_ctts:
+        case FOURCC_stsc:
+        case FOURCC_stsz:
+        case FOURCC_stco:
+        case FOURCC_co64:
+        case FOURCC_stss:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Gets the position, the number and the size of the entries of a table */
+static int MP4_BoxTableLayout( const MP4_Box_t *p_box, uint64_t *pi_pos,
+                               uint32_t *pi_count, unsigned *pi_size )
+{
+    /* version, flags and entry count */
+    *pi_pos = p_box->i_pos + MP4_BOX_HEADERSIZE( p_box ) + 8;
+
+    switch( p_box->i_type )
+    {
+        case FOURCC_stts:
+            *pi_count = p_box->data.p_stts->i_entry_count;
+            *pi_size = 8;
+            break;
+        case FOURCC_ctts:
+            *pi_count = p_box->data.p_ctts->i_entry_count;
+            *pi_size = 8;
+            break;
+        case FOURCC_stsc:
+            *pi_count = p_box->data.p_stsc->i_entry_count;
+            *pi_size = 12;
+            break;
+        case FOURCC_stsz:
+            /* The entries are only there without a common sample size */
+            *pi_pos += 4;
+            *pi_count = p_box->data.p_stsz->i_sample_size ? 0 :
+                        p_box->data.p_stsz->i_sample_count;
+            *pi_size = 4;
+            break;
+        case FOURCC_stco:
+        case FOURCC_co64:
+            *pi_count = p_box->data.p_co64->i_entry_count;
+            *pi_size = p_box->i_type == FOURCC_co64 ? 8 : 4;
+            break;
+        case FOURCC_stss:
+            *pi_count = p_box->data.p_stss->i_entry_count;
+            *pi_size = 4;
+            break;
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+static int MP4_ReadBoxTableHeader( stream_t *p_stream, MP4_Box_t *p_box )
+{
+    const int i_header = MP4_BOX_HEADERSIZE( p_box );
+    const uint8_t *p_peek;
+    int i_read;
+    size_t i_data;
+
+    i_read = stream_Peek( p_stream, &p_peek, i_header + 12 );
+    if( i_read < i_header + 8 )
+        return 0;
+    p_peek += i_header;
+    i_read -= i_header;
+
+    switch( p_box->i_type )
+    {
+        case FOURCC_stts: i_data = sizeof( MP4_Box_data_stts_t ); break;
+        case FOURCC_ctts: i_data = sizeof( MP4_Box_data_ctts_t ); break;
+        case FOURCC_stsc: i_data = sizeof( MP4_Box_data_stsc_t ); break;
+        case FOURCC_stsz: i_data = sizeof( MP4_Box_data_stsz_t ); break;
+        case FOURCC_stss: i_data = sizeof( MP4_Box_data_stss_t ); break;
+        default:          i_data = sizeof( MP4_Box_data_co64_t ); break;
+    }
+    if( !( p_box->data.p_data = calloc( 1, i_data ) ) )
+        return 0;
+
+    switch( p_box->i_type )
+    {
+        case FOURCC_stts:
+            MP4_GETVERSIONFLAGS( p_box->data.p_stts );
+            MP4_GET4BYTES( p_box->data.p_stts->i_entry_count );
+            break;
+        case FOURCC_ctts:
+            MP4_GETVERSIONFLAGS( p_box->data.p_ctts );
+            MP4_GET4BYTES( p_box->data.p_ctts->i_entry_count );
+            break;
+        case FOURCC_stsc:
+            MP4_GETVERSIONFLAGS( p_box->data.p_stsc );
+            MP4_GET4BYTES( p_box->data.p_stsc->i_entry_count );
+            break;
+        case FOURCC_stsz:
+            MP4_GETVERSIONFLAGS( p_box->data.p_stsz );
+            MP4_GET4BYTES( p_box->data.p_stsz->i_sample_size );
+            MP4_GET4BYTES( p_box->data.p_stsz->i_sample_count );
+            break;
+        case FOURCC_stss:
+            MP4_GETVERSIONFLAGS( p_box->data.p_stss );
+            MP4_GET4BYTES( p_box->data.p_stss->i_entry_count );
+            break;
+        default:
+            MP4_GETVERSIONFLAGS( p_box->data.p_co64 );
+            MP4_GET4BYTES( p_box->data.p_co64->i_entry_count );
+            break;
+    }
+
+#ifdef MP4_VERBOSE
+    msg_Dbg( p_stream, "read box: \"%4.4s\" (table left on disk)",
+             (char*)&p_box->i_type );
+#endif
+    return i_read >= 0 ? 1 : 0;
+}
+
 static void MP4_FreeBox_stts( MP4_Box_t *p_box )
 {
     FREENULL( p_box->data.p_stts->i_sample_count );
@@ -788,6 +916,9 @@ static void MP4_FreeBox_stts( MP4_Box_t *p_box )
 static int MP4_ReadBox_stts( stream_t *p_stream, MP4_Box_t *p_box )
 {
     unsigned int i;
+
+    if( p_box->b_lazy )
+        return MP4_ReadBoxTableHeader( p_stream, p_box );
     MP4_READBOX_ENTER( MP4_Box_data_stts_t );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_stts );
@@ -827,6 +958,9 @@ static void MP4_FreeBox_ctts( MP4_Box_t *p_box )
 static int MP4_ReadBox_ctts( stream_t *p_stream, MP4_Box_t *p_box )
 {
     unsigned int i;
+
+    if( p_box->b_lazy )
+        return MP4_ReadBoxTableHeader( p_stream, p_box );
     MP4_READBOX_ENTER( MP4_Box_data_ctts_t );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_ctts );
@@ -1459,6 +1593,9 @@ static int MP4_ReadBox_stsz( stream_t *p_stream, MP4_Box_t *p_box )
 {
     unsigned int i;
 
+    if( p_box->b_lazy )
+        return MP4_ReadBoxTableHeader( p_stream, p_box );
+
     MP4_READBOX_ENTER( MP4_Box_data_stsz_t );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_stsz );
@@ -1505,6 +1642,9 @@ static int MP4_ReadBox_stsc( stream_t *p_stream, MP4_Box_t *p_box )
 {
     unsigned int i;
 
+    if( p_box->b_lazy )
+        return MP4_ReadBoxTableHeader( p_stream, p_box );
+
     MP4_READBOX_ENTER( MP4_Box_data_stsc_t );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_stsc );
@@ -1543,6 +1683,9 @@ static int MP4_ReadBox_stco_co64( stream_t *p_stream, MP4_Box_t *p_box )
 {
     unsigned int i;
 
+    if( p_box->b_lazy )
+        return MP4_ReadBoxTableHeader( p_stream, p_box );
+
     MP4_READBOX_ENTER( MP4_Box_data_co64_t );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_co64 );
@@ -1591,6 +1734,9 @@ static int MP4_ReadBox_stss( stream_t *p_stream, MP4_Box_t *p_box )
 {
     unsigned int i;
 
+    if( p_box->b_lazy )
+        return MP4_ReadBoxTableHeader( p_stream, p_box );
+
     MP4_READBOX_ENTER( MP4_Box_data_stss_t );
 
     MP4_GETVERSIONFLAGS( p_box->data.p_stss );
@@ -2641,6 +2787,17 @@ static MP4_Box_t *MP4_ReadBox( stream_t *p_stream, MP4_Box_t *p_father )
     }
     p_box->p_father = p_father;
 
+    /* The tables of a file read lazily are left on disk */
+    if( MP4_BoxIsTable( p_box->i_type ) && p_father )
+    {
+        const MP4_Box_t *p_root = p_father;
+
+        while( p_root->p_father )
+            p_root = p_root->p_father;
+        p_box->b_lazy = p_root->i_type == VLC_FOURCC( 'r', 'o', 'o', 't' ) &&
+                        p_root->b_lazy;
+    }
+
     /* Now search function to call */
     for( i_index = 0; ; i_index++ )
     {
@@ -2713,13 +2870,144 @@ void MP4_BoxFree( stream_t *s, MP4_Box_t *p_box )
     free( p_box );
 }
 
+/*****************************************************************************
+ * MP4_BoxLoad : load the entries of a table box read lazily
+ *****************************************************************************/
+int MP4_BoxLoad( stream_t *s, MP4_Box_t *p_box )
+{
+    unsigned int i_index;
+
+    if( !p_box->b_lazy )
+        return VLC_SUCCESS;
+
+    for( i_index = 0; MP4_Box_Function[i_index].i_type != p_box->i_type;
+         i_index++ );
+    if( stream_Seek( s, p_box->i_pos ) )
+        return VLC_EGENERIC;
+
+    MP4_Box_Function[i_index].MP4_FreeBox_function( p_box );
+    FREENULL( p_box->data.p_data );
+    p_box->b_lazy = false;
+
+    if( !MP4_Box_Function[i_index].MP4_ReadBox_function( s, p_box ) )
+    {
+        msg_Warn( s, "cannot load box %4.4s", (char*)&p_box->i_type );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * MP4_BoxTableEntry : read one entry of a table box, loaded or not
+ *****************************************************************************/
+int MP4_BoxTableEntry( stream_t *s, MP4_Box_t *p_box, uint32_t i_entry,
+                       int64_t *pi_value )
+{
+    uint64_t i_pos;
+    uint32_t i_count;
+    unsigned i_size;
+    uint8_t  p_buffer[12];
+
+    if( !p_box->data.p_data ||
+        MP4_BoxTableLayout( p_box, &i_pos, &i_count, &i_size ) ||
+        i_entry >= i_count )
+        return VLC_EGENERIC;
+
+    if( !p_box->b_lazy )
+    {
+        switch( p_box->i_type )
+        {
+            case FOURCC_stts:
+                pi_value[0] = p_box->data.p_stts->i_sample_count[i_entry];
+                pi_value[1] = p_box->data.p_stts->i_sample_delta[i_entry];
+                break;
+            case FOURCC_ctts:
+                pi_value[0] = p_box->data.p_ctts->i_sample_count[i_entry];
+                pi_value[1] = p_box->data.p_ctts->i_sample_offset[i_entry];
+                break;
+            case FOURCC_stsc:
+                pi_value[0] = p_box->data.p_stsc->i_first_chunk[i_entry];
+                pi_value[1] = p_box->data.p_stsc->i_samples_per_chunk[i_entry];
+                pi_value[2] =
+                    p_box->data.p_stsc->i_sample_description_index[i_entry];
+                break;
+            case FOURCC_stsz:
+                pi_value[0] = p_box->data.p_stsz->i_entry_size[i_entry];
+                break;
+            case FOURCC_stss:
+                pi_value[0] = p_box->data.p_stss->i_sample_number[i_entry];
+                break;
+            default:
+                pi_value[0] = p_box->data.p_co64->i_chunk_offset[i_entry];
+                break;
+        }
+        return VLC_SUCCESS;
+    }
+
+    i_pos += (uint64_t)i_entry * i_size;
+    if( i_pos + i_size > p_box->i_pos + p_box->i_size ||
+        stream_Seek( s, i_pos ) ||
+        stream_Read( s, p_buffer, i_size ) < (int)i_size )
+        return VLC_EGENERIC;
+
+    switch( p_box->i_type )
+    {
+        case FOURCC_ctts:
+            pi_value[0] = GetDWBE( p_buffer );
+            pi_value[1] = (int32_t)GetDWBE( &p_buffer[4] );
+            break;
+        case FOURCC_stss:
+            /* XXX in libmp4 sample begin at 0 */
+            pi_value[0] = (uint32_t)( GetDWBE( p_buffer ) - 1 );
+            break;
+        case FOURCC_co64:
+            pi_value[0] = GetQWBE( p_buffer );
+            break;
+        default:
+            for( unsigned i = 0; i < i_size / 4; i++ )
+                pi_value[i] = GetDWBE( &p_buffer[4 * i] );
+            break;
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * MP4_BoxTableFind : binary search in a table sorted on its first field
+ *****************************************************************************/
+int MP4_BoxTableFind( stream_t *s, MP4_Box_t *p_box, int64_t i_value,
+                      uint32_t *pi_entry )
+{
+    uint64_t i_pos;
+    uint32_t i_low = 0, i_high;
+    unsigned i_size;
+
+    if( !p_box->data.p_data ||
+        MP4_BoxTableLayout( p_box, &i_pos, &i_high, &i_size ) )
+        return VLC_EGENERIC;
+
+    while( i_low < i_high )
+    {
+        const uint32_t i_mid = i_low + ( i_high - i_low ) / 2;
+        int64_t pi_entry_value[3];
+
+        if( MP4_BoxTableEntry( s, p_box, i_mid, pi_entry_value ) )
+            return VLC_EGENERIC;
+        if( pi_entry_value[0] < i_value )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    *pi_entry = i_low;
+    return VLC_SUCCESS;
+}
+
 /*****************************************************************************
  * MP4_BoxGetRoot : Parse the entire file, and create all boxes in memory
  *****************************************************************************
  *  The first box is a virtual box "root" and is the father for all first
  *  level boxes for the file, a sort of virtual contener
  *****************************************************************************/
-MP4_Box_t *MP4_BoxGetRoot( stream_t *s )
+MP4_Box_t *MP4_BoxGetRoot( stream_t *s, bool b_lazy )
 {
     MP4_Box_t *p_root;
     stream_t *p_stream;
@@ -2734,6 +3022,7 @@ MP4_Box_t *MP4_BoxGetRoot( stream_t *s )
     p_root->i_shortsize = 1;
     p_root->i_size = stream_Size( s );
     CreateUUID( &p_root->i_uuid, p_root->i_type );
+    p_root->b_lazy = b_lazy;
 
     p_root->data.p_data = NULL;
     p_root->p_father = NULL;
@@ -928,6 +928,9 @@ typedef struct MP4_Box_s
 
     struct MP4_Box_s *p_next;   /* pointer on the next boxes at the same level */
 
+    bool         b_lazy;    /* for a table box, the entries are not loaded;
+                               for the root, the tables are read lazily */
+
 } MP4_Box_t;
 
 
@@ -937,8 +940,36 @@ typedef struct MP4_Box_s
  *****************************************************************************
  *  The first box is a virtual box "root" and is the father for all first
  *  level boxes
+ *  If b_lazy is set, only the header of the table boxes (stts, ctts, stsc,
+ *  stsz, stco, co64, stss) is read, see MP4_BoxLoad and MP4_BoxTableEntry
+ *****************************************************************************/
+MP4_Box_t *MP4_BoxGetRoot( stream_t *, bool b_lazy );
+
+/*****************************************************************************
+ * MP4_BoxLoad : load the entries of a table box read lazily
+ *****************************************************************************
+ *  Does nothing if they are already loaded. The stream position is lost.
+ *****************************************************************************/
+int MP4_BoxLoad( stream_t *, MP4_Box_t *p_box );
+
+/*****************************************************************************
+ * MP4_BoxTableEntry : read one entry of a table box
+ *****************************************************************************
+ *  pi_value receives the fields of the entry (3 at most, for stsc), in the
+ *  order of the box; if the table is not loaded, the entry is read from the
+ *  stream and the stream position is lost.
+ *****************************************************************************/
+int MP4_BoxTableEntry( stream_t *, MP4_Box_t *p_box, uint32_t i_entry,
+                       int64_t *pi_value );
+
+/*****************************************************************************
+ * MP4_BoxTableFind : find the first entry whose first field is >= i_value
+ *****************************************************************************
+ *  The table has to be sorted on its first field (stsc, stss). *pi_entry
+ *  is the entry count if there is none.
  *****************************************************************************/
-MP4_Box_t *MP4_BoxGetRoot( stream_t * );
+int MP4_BoxTableFind( stream_t *, MP4_Box_t *p_box, int64_t i_value,
+                      uint32_t *pi_entry );
 
 /*****************************************************************************
  * MP4_FreeBox : free memory allocated after read with MP4_ReadBox
@@ -163,6 +163,8 @@ struct demux_sys_t
 
     /* */
     input_title_t *p_title;
+
+    bool         b_preparse;     /* only the es formats and meta are needed */
 };
 
 /*****************************************************************************
@@ -276,6 +278,7 @@ static int Open( vlc_object_t * p_this )
     MP4_Box_t       *p_rmra;
     MP4_Box_t       *p_mvhd;
     MP4_Box_t       *p_trak;
+    input_thread_t  *p_input;
 
     unsigned int    i;
     bool      b_seekable;
@@ -317,8 +320,16 @@ static int Open( vlc_object_t * p_this )
     p_demux->p_sys = p_sys = malloc( sizeof( demux_sys_t ) );
     memset( p_sys, 0, sizeof( demux_sys_t ) );
 
-    /* Now load all boxes ( except raw data ) */
-    if( ( p_sys->p_root = MP4_BoxGetRoot( p_demux->s ) ) == NULL )
+    p_input = vlc_object_find( p_demux, VLC_OBJECT_INPUT, FIND_PARENT );
+    if( p_input )
+    {
+        p_sys->b_preparse = p_input->b_preparsing;
+        vlc_object_release( p_input );
+    }
+
+    /* Now load all boxes ( except raw data ); the sample tables are only
+     * read when they are needed */
+    if( ( p_sys->p_root = MP4_BoxGetRoot( p_demux->s, true ) ) == NULL )
     {
         msg_Warn( p_demux, "MP4 plugin discarded (not a valid file)" );
         goto error;
@@ -368,7 +379,7 @@ static int Open( vlc_object_t * p_this )
 
         msg_Dbg( p_demux, "detected playlist mov file (%d ref)", i_count );
 
-        input_thread_t * p_input = vlc_object_find( p_demux, VLC_OBJECT_INPUT, FIND_PARENT );
+        p_input = vlc_object_find( p_demux, VLC_OBJECT_INPUT, FIND_PARENT );
         input_item_t * p_current = input_GetItem( p_input );
         p_current->i_type = ITEM_TYPE_PLAYLIST;
 
@@ -538,7 +549,8 @@ static int Open( vlc_object_t * p_this )
     }
 
     /* */
-    LoadChapter( p_demux );
+    if( !p_sys->b_preparse )
+        LoadChapter( p_demux );
 
     return VLC_SUCCESS;
 
@@ -1100,6 +1112,8 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     {
         return( VLC_EGENERIC );
     }
+    if( MP4_BoxLoad( p_demux->s, p_co64 ) || MP4_BoxLoad( p_demux->s, p_stsc ) )
+        return VLC_EGENERIC;
 
     p_demux_track->i_chunk_count = p_co64->data.p_co64->i_entry_count;
     if( !p_demux_track->i_chunk_count )
@@ -1198,6 +1212,8 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         msg_Warn( p_demux, "cannot find STSZ box" );
         return VLC_EGENERIC;
     }
+    if( MP4_BoxLoad( p_demux->s, p_box ) )
+        return VLC_EGENERIC;
     stsz = p_box->data.p_stsz;
 
     /* Find stts
@@ -1209,6 +1225,8 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         msg_Warn( p_demux, "cannot find STTS box" );
         return VLC_EGENERIC;
     }
+    if( MP4_BoxLoad( p_demux->s, p_box ) )
+        return VLC_EGENERIC;
     stts = p_box->data.p_stts;
 
     /* Use stsz table to create a sample number -> sample size table */
@@ -1304,7 +1322,7 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
      *  Gives the delta between decoding time (dts) and composition table (pts)
      */
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "ctts" );
-    if( p_box )
+    if( p_box && !MP4_BoxLoad( p_demux->s, p_box ) )
     {
         MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
 
@@ -1373,6 +1391,43 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
+/* When preparsing, only the first chunk is needed to create the es, so the
+ * sample tables are not loaded */
+static int TrackCreateFirstChunk( demux_t *p_demux,
+                                  mp4_track_t *p_demux_track )
+{
+    MP4_Box_t *p_co64, *p_stsc, *p_stsz;
+    int64_t i_offset, pi_stsc[3];
+    uint32_t i_index;
+
+    if( ( !(p_co64 = MP4_BoxGet( p_demux_track->p_stbl, "stco" ) )&&
+          !(p_co64 = MP4_BoxGet( p_demux_track->p_stbl, "co64" ) ) )||
+        !(p_stsc = MP4_BoxGet( p_demux_track->p_stbl, "stsc" ) ) ||
+        !(p_stsz = MP4_BoxGet( p_demux_track->p_stbl, "stsz" ) ) )
+        return VLC_EGENERIC;
+
+    /* The first chunk uses the last stsc entry starting at chunk 1 */
+    if( MP4_BoxTableEntry( p_demux->s, p_co64, 0, &i_offset ) ||
+        MP4_BoxTableFind( p_demux->s, p_stsc, 2, &i_index ) || !i_index ||
+        MP4_BoxTableEntry( p_demux->s, p_stsc, i_index - 1, pi_stsc ) )
+    {
+        msg_Warn( p_demux, "cannot read chunk table or table empty" );
+        return VLC_EGENERIC;
+    }
+
+    p_demux_track->chunk = calloc( 1, sizeof( mp4_chunk_t ) );
+    if( p_demux_track->chunk == NULL )
+        return VLC_ENOMEM;
+    p_demux_track->i_chunk_count = 1;
+    p_demux_track->chunk[0].i_offset = i_offset;
+    p_demux_track->chunk[0].i_sample_count = pi_stsc[1];
+    p_demux_track->chunk[0].i_sample_description_index = pi_stsc[2];
+
+    p_demux_track->i_sample_count = p_stsz->data.p_stsz->i_sample_count;
+    p_demux_track->i_sample_size = p_stsz->data.p_stsz->i_sample_size;
+    return VLC_SUCCESS;
+}
+
 /*
  * TrackCreateES:
  * Create ES and PES to init decoder if needed, for a track starting at i_chunk
@@ -1745,11 +1800,12 @@ static int TrackCreateES( demux_t *p_demux, mp4_track_t *p_track,
         p_track->fmt.video.i_frame_rate_base = 1;
 
         if( p_track->fmt.video.i_frame_rate &&
-            (p_box = MP4_BoxGet( p_track->p_stbl, "stts" )) &&
-            p_box->data.p_stts->i_entry_count >= 1 )
+            (p_box = MP4_BoxGet( p_track->p_stbl, "stts" )) )
         {
-            p_track->fmt.video.i_frame_rate_base =
-                p_box->data.p_stts->i_sample_delta[0];
+            int64_t pi_stts[2];
+
+            if( !MP4_BoxTableEntry( p_demux->s, p_box, 0, pi_stts ) )
+                p_track->fmt.video.i_frame_rate_base = pi_stts[1];
         }
 
         break;
@@ -1898,42 +1954,39 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
     /* *** Try to find nearest sync points *** */
     if( ( p_stss = MP4_BoxGet( p_track->p_stbl, "stss" ) ) )
     {
-        unsigned int i_index;
+        uint32_t i_index;
+        int64_t i_sync;
         msg_Dbg( p_demux,
                     "track[Id 0x%x] using Sync Sample Box (stss)",
                     p_track->i_track_ID );
-        for( i_index = 0; i_index < p_stss->data.p_stss->i_entry_count; i_index++ )
+        /* The sync samples are sorted: find the first one >= i_sample */
+        if( !MP4_BoxTableFind( p_demux->s, p_stss, i_sample, &i_index ) &&
+            i_index < p_stss->data.p_stss->i_entry_count &&
+            !MP4_BoxTableEntry( p_demux->s, p_stss,
+                                i_index > 0 ? i_index - 1 : 0, &i_sync ) )
         {
-            if( p_stss->data.p_stss->i_sample_number[i_index] >= i_sample )
+            msg_Dbg( p_demux, "stts gives %d --> %d (sample number)",
+                     i_sample, (int)i_sync );
+            if( i_index > 0 )
             {
-                if( i_index > 0 )
+                i_sample = i_sync;
+                /* new i_sample is less than old so i_chunk can only decreased */
+                while( i_chunk > 0 &&
+                        i_sample < p_track->chunk[i_chunk].i_sample_first )
                 {
-                    msg_Dbg( p_demux, "stts gives %d --> %d (sample number)",
-                            i_sample,
-                            p_stss->data.p_stss->i_sample_number[i_index-1] );
-                    i_sample = p_stss->data.p_stss->i_sample_number[i_index-1];
-                    /* new i_sample is less than old so i_chunk can only decreased */
-                    while( i_chunk > 0 &&
-                            i_sample < p_track->chunk[i_chunk].i_sample_first )
-                    {
-                        i_chunk--;
-                    }
+                    i_chunk--;
                 }
-                else
+            }
+            else
+            {
+                i_sample = i_sync;
+                /* new i_sample is more than old so i_chunk can only increased */
+                while( i_chunk < p_track->i_chunk_count - 1 &&
+                       i_sample >= p_track->chunk[i_chunk].i_sample_first +
+                         p_track->chunk[i_chunk].i_sample_count )
                 {
-                    msg_Dbg( p_demux, "stts gives %d --> %d (sample number)",
-                            i_sample,
-                            p_stss->data.p_stss->i_sample_number[i_index] );
-                    i_sample = p_stss->data.p_stss->i_sample_number[i_index];
-                    /* new i_sample is more than old so i_chunk can only increased */
-                    while( i_chunk < p_track->i_chunk_count - 1 &&
-                           i_sample >= p_track->chunk[i_chunk].i_sample_first +
-                             p_track->chunk[i_chunk].i_sample_count )
-                    {
-                        i_chunk++;
-                    }
+                    i_chunk++;
                 }
-                break;
             }
         }
     }
@@ -2166,8 +2219,13 @@ static void MP4_TrackCreate( demux_t *p_demux, mp4_track_t *p_track,
     }
 
     /* Create chunk index table and sample index table */
-    if( TrackCreateChunksIndex( p_demux,p_track  ) ||
-        TrackCreateSamplesIndex( p_demux, p_track ) )
+    if( p_sys->b_preparse )
+    {
+        if( TrackCreateFirstChunk( p_demux, p_track ) )
+            return;
+    }
+    else if( TrackCreateChunksIndex( p_demux,p_track  ) ||
+             TrackCreateSamplesIndex( p_demux, p_track ) )
     {
         return; /* cannot create chunks index */
     }
@@ -34,6 +34,7 @@
 #include <vlc_demux.h>
 
 #include "ps.h"
+#include "time_index.h"
 
 /* TODO:
  *  - re-add pre-scanning.
@@ -45,6 +46,14 @@
     "to calculate position and duration. However sometimes this might not " \
     "be usable. Disable this option to calculate from the bitrate instead." )
 
+/* Seek that much before the requested time, so that the decoders find a
+ * reference picture; the pictures in between are decoded but not shown */
+#define PS_SEEK_PREROLL (INT64_C(1000000))
+/* Good enough seek precision, in bytes */
+#define PS_SEEK_WINDOW  (65536)
+/* Do not read more than that to find a timestamp while seeking */
+#define PS_PROBE_SIZE   (1024*1024)
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -87,14 +96,20 @@ struct demux_sys_t
     bool  b_lost_sync;
     bool  b_have_pack;
     bool  b_seekable;
+
+    time_index_t index;
 };
 
 static int Demux  ( demux_t *p_demux );
 static int Control( demux_t *p_demux, int i_query, va_list args );
+static void FindLength( demux_t *p_demux );
 
 static int      ps_pkt_resynch( stream_t *, uint32_t *pi_code );
 static block_t *ps_pkt_read   ( stream_t *, uint32_t i_code );
 
+static int      ProbeTime( demux_t *, int64_t i_pos, int64_t i_end,
+                           time_index_entry_t *p_found );
+
 /*****************************************************************************
  * Open
  *****************************************************************************/
@@ -141,9 +156,14 @@ static int OpenCommon( vlc_object_t *p_this, bool b_force )
 
     ps_psm_init( &p_sys->psm );
     ps_track_init( p_sys->tk );
+    time_index_Init( &p_sys->index );
 
     /* TODO prescanning of ES */
 
+    /* The length is needed to seek by time, including to the start-time */
+    if( p_sys->b_seekable )
+        FindLength( p_demux );
+
     return VLC_SUCCESS;
 }
 
@@ -177,6 +197,7 @@ static void Close( vlc_object_t *p_this )
     }
 
     ps_psm_destroy( &p_sys->psm );
+    time_index_Clean( &p_sys->index );
 
     free( p_sys );
 }
@@ -281,6 +302,7 @@ static int Demux( demux_t *p_demux )
     int i_ret, i_id, i_mux_rate;
     uint32_t i_code;
     block_t *p_pkt;
+    int64_t i_pos;
 
     i_ret = ps_pkt_resynch( p_demux->s, &i_code );
     if( i_ret < 0 )
@@ -302,6 +324,7 @@ static int Demux( demux_t *p_demux )
     if( p_sys->i_length < 0 && p_sys->b_seekable )
         FindLength( p_demux );
 
+    i_pos = stream_Tell( p_demux->s );
     if( ( p_pkt = ps_pkt_read( p_demux->s, i_code ) ) == NULL )
     {
         return 0;
@@ -404,6 +427,12 @@ static int Demux( demux_t *p_demux )
                     p_sys->i_current_pts = (int64_t)p_pkt->i_pts;
                 }
 
+                /* Remember where we were, for the next seeks */
+                if( p_sys->b_seekable && p_pkt->i_pts > 0 &&
+                    p_sys->i_time_track == PS_ID_TO_TK(i_id) )
+                    time_index_Add( &p_sys->index,
+                                    p_pkt->i_pts - tk->i_first_pts, i_pos );
+
                 es_out_Send( p_demux->out, tk->es, p_pkt );
             }
             else
@@ -487,14 +516,33 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 
         case DEMUX_SET_TIME:
             i64 = (int64_t)va_arg( args, int64_t );
-            if( p_sys->i_time_track >= 0 && p_sys->i_current_pts > 0 )
+            if( p_sys->b_seekable && p_sys->i_time_track >= 0 &&
+                p_sys->i_length > 0 )
             {
-                int64_t i_now = p_sys->i_current_pts - p_sys->tk[p_sys->i_time_track].i_first_pts;
-                int64_t i_pos = stream_Tell( p_demux->s );
-                int64_t i_offset = i_pos / (i_now / 1000000) * ((i64 - i_now) / 1000000);
-                stream_Seek( p_demux->s, i_pos + i_offset);
-
+                const int64_t i_first_pts =
+                    p_sys->tk[p_sys->i_time_track].i_first_pts;
+                time_index_entry_t low = { 0, 0 };
+                time_index_entry_t high = { p_sys->i_length,
+                                            stream_Size( p_demux->s ) };
+                int64_t i_pos;
+                int i;
+
+                i_pos = time_index_Seek( p_demux, &p_sys->index, ProbeTime,
+                                         __MAX( i64 - PS_SEEK_PREROLL, 0 ),
+                                         low, high, PS_SEEK_WINDOW );
+                if( stream_Seek( p_demux->s, i_pos ) )
+                    return VLC_EGENERIC;
+
+                p_sys->i_current_pts = 0;
                 es_out_Control( p_demux->out, ES_OUT_RESET_PCR );
+                for( i = 0; i < PS_TK_COUNT; i++ )
+                {
+                    ps_track_t *tk = &p_sys->tk[i];
+                    if( tk->b_seen && tk->es )
+                        es_out_Control( p_demux->out,
+                                        ES_OUT_SET_NEXT_DISPLAY_TIME,
+                                        tk->es, i_first_pts + i64 );
+                }
                 return VLC_SUCCESS;
             }
             return VLC_EGENERIC;
@@ -598,3 +646,45 @@ static block_t *ps_pkt_read( stream_t *s, uint32_t i_code )
 
     return NULL;
 }
+
+/* ProbeTime: finds the first timestamp of the time track after i_pos
+ */
+static int ProbeTime( demux_t *p_demux, int64_t i_pos, int64_t i_end,
+                      time_index_entry_t *p_found )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ps_track_t  *tk = &p_sys->tk[p_sys->i_time_track];
+    uint32_t    i_code;
+    block_t     *p_pkt;
+    int         i_ret, i_id;
+
+    i_end = __MIN( i_end, i_pos + PS_PROBE_SIZE );
+    if( stream_Seek( p_demux->s, i_pos ) )
+        return VLC_EGENERIC;
+
+    while( vlc_object_alive( p_demux ) &&
+           ( i_pos = stream_Tell( p_demux->s ) ) < i_end )
+    {
+        i_ret = ps_pkt_resynch( p_demux->s, &i_code );
+        if( i_ret < 0 )
+            break;
+        else if( i_ret == 0 )
+            continue;
+
+        i_pos = stream_Tell( p_demux->s );
+        if( ( p_pkt = ps_pkt_read( p_demux->s, i_code ) ) == NULL )
+            break;
+
+        if( (i_id = ps_pkt_id( p_pkt )) >= 0xc0 &&
+            PS_ID_TO_TK(i_id) == p_sys->i_time_track &&
+            !ps_pkt_parse_pes( p_pkt, tk->i_skip ) && p_pkt->i_pts > 0 )
+        {
+            p_found->i_time = p_pkt->i_pts - tk->i_first_pts;
+            p_found->i_pos = i_pos;
+            block_Release( p_pkt );
+            return VLC_SUCCESS;
+        }
+        block_Release( p_pkt );
+    }
+    return VLC_EGENERIC;
+}
@@ -0,0 +1,204 @@
+/*****************************************************************************
+ * time_index.h: sparse time to byte offset index for demuxers
+ *****************************************************************************
+ * Copyright (C) 2009 the VideoLAN team
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* The index is filled with the timestamps met while playing and with those
+ * found by the seek probes, so that each seek makes the next ones cheaper.
+ * Entries are sorted by position, and by time as well: a timestamp that
+ * would break that order (a discontinuity) is not indexed. */
+
+#include <vlc_demux.h>
+
+/* Do not index two timestamps closer than that */
+#define TIME_INDEX_SPACING (INT64_C(500000))
+
+/* Give up refining a seek after that many probes */
+#define TIME_INDEX_PROBES 32
+
+typedef struct
+{
+    int64_t i_time;
+    int64_t i_pos;
+} time_index_entry_t;
+
+typedef struct
+{
+    int                 i_count;
+    int                 i_alloc;
+    time_index_entry_t *p_entry;
+} time_index_t;
+
+/**
+ * Finds the timestamp which follows a position.
+ *
+ * \param i_pos position to start reading from
+ * \param i_end position not to read past
+ * \param p_found receives the timestamp and the position of the packet
+ * \return VLC_SUCCESS, or VLC_EGENERIC if there is none before i_end
+ */
+typedef int (*time_index_probe_t)( demux_t *, int64_t i_pos, int64_t i_end,
+                                   time_index_entry_t *p_found );
+
+static inline void time_index_Init( time_index_t *p_index )
+{
+    p_index->i_count = p_index->i_alloc = 0;
+    p_index->p_entry = NULL;
+}
+
+static inline void time_index_Clean( time_index_t *p_index )
+{
+    free( p_index->p_entry );
+    time_index_Init( p_index );
+}
+
+/* Returns the index of the first entry at or after i_pos */
+static inline int time_index_FindPos( const time_index_t *p_index,
+                                      int64_t i_pos )
+{
+    int i_low = 0, i_high = p_index->i_count;
+
+    while( i_low < i_high )
+    {
+        const int i_mid = ( i_low + i_high ) / 2;
+        if( p_index->p_entry[i_mid].i_pos < i_pos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/* Returns the index of the first entry after i_time */
+static inline int time_index_FindTime( const time_index_t *p_index,
+                                       int64_t i_time )
+{
+    int i_low = 0, i_high = p_index->i_count;
+
+    while( i_low < i_high )
+    {
+        const int i_mid = ( i_low + i_high ) / 2;
+        if( p_index->p_entry[i_mid].i_time <= i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+static inline void time_index_Add( time_index_t *p_index,
+                                   int64_t i_time, int64_t i_pos )
+{
+    const int i = time_index_FindPos( p_index, i_pos );
+    const time_index_entry_t *p_prev = i > 0 ? &p_index->p_entry[i - 1]
+                                             : NULL;
+    const time_index_entry_t *p_next = i < p_index->i_count
+                                     ? &p_index->p_entry[i] : NULL;
+
+    if( i_time < 0 || i_pos < 0 )
+        return;
+    if( p_prev && i_time < p_prev->i_time + TIME_INDEX_SPACING )
+        return;
+    if( p_next && ( p_next->i_pos == i_pos ||
+                    i_time > p_next->i_time - TIME_INDEX_SPACING ) )
+        return;
+
+    if( p_index->i_count >= p_index->i_alloc )
+    {
+        const int i_alloc = p_index->i_alloc ? 2 * p_index->i_alloc : 256;
+        time_index_entry_t *p_entry =
+            realloc( p_index->p_entry, i_alloc * sizeof(*p_entry) );
+        if( p_entry == NULL )
+            return;
+        p_index->p_entry = p_entry;
+        p_index->i_alloc = i_alloc;
+    }
+    memmove( &p_index->p_entry[i + 1], &p_index->p_entry[i],
+             ( p_index->i_count - i ) * sizeof(*p_index->p_entry) );
+    p_index->p_entry[i].i_time = i_time;
+    p_index->p_entry[i].i_pos = i_pos;
+    p_index->i_count++;
+}
+
+/**
+ * Finds the position of the last timestamp at or before a time.
+ *
+ * The index narrows the search down, then the demuxer is probed by
+ * interpolation between the closest known points, falling back to
+ * bisection when interpolation does not converge. Probed timestamps are
+ * added to the index.
+ *
+ * \param low known point at or before i_time (e.g. the start of the file)
+ * \param high known point after i_time (e.g. the end of the file)
+ * \param i_window stop refining once the range is that small (bytes)
+ * \return the position to resume demuxing from
+ */
+static inline int64_t time_index_Seek( demux_t *p_demux,
+                                       time_index_t *p_index,
+                                       time_index_probe_t pf_probe,
+                                       int64_t i_time,
+                                       time_index_entry_t low,
+                                       time_index_entry_t high,
+                                       int64_t i_window )
+{
+    int i = time_index_FindTime( p_index, i_time );
+    bool b_bisect = false;
+
+    if( i > 0 && p_index->p_entry[i - 1].i_pos > low.i_pos )
+        low = p_index->p_entry[i - 1];
+    if( i < p_index->i_count && p_index->p_entry[i].i_pos < high.i_pos )
+        high = p_index->p_entry[i];
+
+    for( int i_probe = 0; i_probe < TIME_INDEX_PROBES &&
+                          high.i_pos - low.i_pos > i_window; i_probe++ )
+    {
+        const int64_t i_range = high.i_pos - low.i_pos;
+        time_index_entry_t found;
+        int64_t i_pos;
+
+        if( b_bisect || high.i_time <= low.i_time )
+            i_pos = low.i_pos + i_range / 2;
+        else
+            i_pos = low.i_pos + (int64_t)( (double)i_range *
+                    ( i_time - low.i_time ) / ( high.i_time - low.i_time ) );
+        /* Stay clear of the bounds, or the range may not shrink */
+        i_pos = __MAX( i_pos, low.i_pos + i_window / 4 );
+        i_pos = __MIN( i_pos, high.i_pos - i_window / 2 );
+
+        if( pf_probe( p_demux, i_pos, high.i_pos, &found ) )
+        {
+            /* No timestamp from there up to the high bound */
+            high.i_pos = i_pos;
+            b_bisect = true;
+            continue;
+        }
+        time_index_Add( p_index, found.i_time, found.i_pos );
+
+        if( found.i_time <= i_time )
+            low = found;
+        else
+            high = found;
+        /* Alternate with bisection if the range did not halve */
+        b_bisect = !b_bisect && high.i_pos - low.i_pos > i_range / 2;
+    }
+
+    msg_Dbg( p_demux, "seek to %"PRId64" us: offset %"PRId64" (%"PRId64
+             " us early)", i_time, low.i_pos, i_time - low.i_time );
+    return low.i_pos;
+}
@@ -47,6 +47,8 @@
 #include <vlc_charset.h>
 
 #include "../mux/mpeg/csa.h"
+#include "time_index.h"
+#include "index_cache.h"
 
 /* Include dvbpsi headers */
 #ifdef HAVE_DVBPSI_DR_H
@@ -372,6 +374,15 @@ struct demux_sys_t
 
     /* */
     bool        b_meta;
+
+    /* Seeking by time, using the PCR of one PID as clock */
+    bool        b_seekable;
+    int         i_pcr_pid;      /* -1 until a PCR is found */
+    int64_t     i_pcr_first;    /* 90 kHz */
+    int64_t     i_pcr_last;     /* 90 kHz, -1 after a seek */
+    int64_t     i_pcr_length;   /* us, 0 if unknown */
+    time_index_t index;
+    int         i_index_saved;  /* entries found in the cache */
 };
 
 static int Demux    ( demux_t *p_demux );
@@ -398,6 +409,12 @@ static bool GatherPES( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk );
 
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, block_t * );
 
+static void PCRFindLength( demux_t * );
+static int  IndexCacheLoad( demux_t * );
+static void IndexCacheSave( demux_t * );
+static int  PCRProbe( demux_t *, int64_t i_pos, int64_t i_end,
+                      time_index_entry_t *p_found );
+
 static iod_descriptor_t *IODNew( int , uint8_t * );
 static void              IODFree( iod_descriptor_t * );
 
@@ -410,6 +427,14 @@ static int UserPmt( demux_t *p_demux, const char * );
 #define TS_PACKET_SIZE_MAX 204
 #define TS_TOPFIELD_HEADER 1320
 
+/* Seek that much before the requested time, so that the decoders find a
+ * reference picture; the pictures in between are decoded but not shown */
+#define TS_SEEK_PREROLL (INT64_C(1000000))
+/* Good enough seek precision, in bytes */
+#define TS_SEEK_WINDOW  (256*1024)
+/* Do not read more than that to find a PCR */
+#define TS_PROBE_SIZE   (2*1024*1024)
+
 /*****************************************************************************
  * Open
  *****************************************************************************/
@@ -786,6 +811,18 @@ static int Open( vlc_object_t *p_this )
     var_Get( p_demux, "ts-silent", &val );
     p_sys->b_silent = val.b_bool;
 
+    /* Time index */
+    p_sys->i_pcr_pid = -1;
+    p_sys->i_pcr_first = -1;
+    p_sys->i_pcr_last = -1;
+    p_sys->i_pcr_length = 0;
+    time_index_Init( &p_sys->index );
+    stream_Control( p_demux->s, STREAM_CAN_SEEK, &p_sys->b_seekable );
+    if( p_sys->b_file_out || p_sys->b_udp_out )
+        p_sys->b_seekable = false;
+    if( p_sys->b_seekable && IndexCacheLoad( p_demux ) )
+        PCRFindLength( p_demux );
+
     return VLC_SUCCESS;
 }
 
@@ -885,6 +922,11 @@ static void Close( vlc_object_t *p_this )
     free( p_sys->psz_file );
     p_sys->psz_file = NULL;
 
+    if( p_sys->b_seekable && p_sys->i_pcr_length > 0 &&
+        p_sys->index.i_count > p_sys->i_index_saved )
+        IndexCacheSave( p_demux );
+    time_index_Clean( &p_sys->index );
+
     vlc_mutex_destroy( &p_sys->csa_lock );
     free( p_sys );
 }
@@ -1224,7 +1266,48 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             {
                 return VLC_EGENERIC;
             }
+            p_sys->i_pcr_last = -1;
+            return VLC_SUCCESS;
+
+        case DEMUX_SET_TIME:
+        {
+            time_index_entry_t low = { 0, 0 }, high;
+            int i;
+
+            i64 = (int64_t)va_arg( args, int64_t );
+            if( !p_sys->b_seekable || p_sys->i_pcr_length <= 0 )
+                return VLC_EGENERIC;
+
+            high.i_time = p_sys->i_pcr_length;
+            high.i_pos = stream_Size( p_demux->s );
+            if( stream_Seek( p_demux->s,
+                             time_index_Seek( p_demux, &p_sys->index, PCRProbe,
+                                              __MAX( i64 - TS_SEEK_PREROLL, 0 ),
+                                              low, high, TS_SEEK_WINDOW ) ) )
+                return VLC_EGENERIC;
+
+            es_out_Control( p_demux->out, ES_OUT_RESET_PCR );
+            p_sys->i_pcr_last = -1;
+
+            /* Decode from the preroll, display from the requested time */
+            i64 += p_sys->i_pcr_first * 100 / 9;
+            for( i = 0; i < 8192; i++ )
+            {
+                ts_pid_t *pid = &p_sys->pid[i];
+                int j;
+
+                if( !pid->b_valid || pid->psi || !pid->es->id )
+                    continue;
+                es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
+                                pid->es->id, i64 );
+                for( j = 0; j < pid->i_extra_es; j++ )
+                    if( pid->extra_es[j]->id )
+                        es_out_Control( p_demux->out,
+                                        ES_OUT_SET_NEXT_DISPLAY_TIME,
+                                        pid->extra_es[j]->id, i64 );
+            }
             return VLC_SUCCESS;
+        }
 #if 0
 
         case DEMUX_GET_TIME:
@@ -1251,13 +1334,19 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         case DEMUX_GET_TIME:
             pi64 = (int64_t*)va_arg( args, int64_t * );
             if( DVBEventInformation( p_demux, pi64, NULL ) )
-                *pi64 = 0;
+            {
+                if( p_sys->i_pcr_length > 0 && p_sys->i_pcr_last >= 0 )
+                    *pi64 = ( ( p_sys->i_pcr_last - p_sys->i_pcr_first ) &
+                              INT64_C(0x1ffffffff) ) * 100 / 9;
+                else
+                    *pi64 = 0;
+            }
             return VLC_SUCCESS;
 
         case DEMUX_GET_LENGTH:
             pi64 = (int64_t*)va_arg( args, int64_t * );
             if( DVBEventInformation( p_demux, NULL, pi64 ) )
-                *pi64 = 0;
+                *pi64 = p_sys->i_pcr_length;
             return VLC_SUCCESS;
 #endif
         case DEMUX_SET_GROUP:
@@ -1387,7 +1476,6 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
         }
 
         case DEMUX_GET_FPS:
-        case DEMUX_SET_TIME:
         default:
             return VLC_EGENERIC;
     }
@@ -1852,23 +1940,44 @@ static void ParsePES( demux_t *p_demux, ts_pid_t *pid )
     }
 }
 
-static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
+/* Returns the PCR of a TS packet (33 bits, 90 kHz), or -1 */
+static inline mtime_t PCRGet( const uint8_t *p )
 {
-    demux_sys_t   *p_sys = p_demux->p_sys;
-    const uint8_t *p = p_bk->p_buffer;
-
     if( ( p[3]&0x20 ) && /* adaptation */
         ( p[5]&0x10 ) &&
         ( p[4] >= 7 ) )
+    {
+        return ( (mtime_t)p[6] << 25 ) |
+               ( (mtime_t)p[7] << 17 ) |
+               ( (mtime_t)p[8] << 9 ) |
+               ( (mtime_t)p[9] << 1 ) |
+               ( (mtime_t)p[10] >> 7 );
+    }
+    return -1;
+}
+
+/* Converts a PCR to a time from the first PCR, in microseconds */
+static inline int64_t PCRTime( demux_sys_t *p_sys, mtime_t i_pcr )
+{
+    return ( ( i_pcr - p_sys->i_pcr_first ) & INT64_C(0x1ffffffff) ) * 100 / 9;
+}
+
+static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
+{
+    demux_sys_t   *p_sys = p_demux->p_sys;
+    const mtime_t i_pcr = PCRGet( p_bk->p_buffer );  /* 33 bits */
+
+    if( i_pcr >= 0 )
     {
         int i;
-        mtime_t i_pcr;  /* 33 bits */
 
-        i_pcr = ( (mtime_t)p[6] << 25 ) |
-                ( (mtime_t)p[7] << 17 ) |
-                ( (mtime_t)p[8] << 9 ) |
-                ( (mtime_t)p[9] << 1 ) |
-                ( (mtime_t)p[10] >> 7 );
+        if( pid->i_pid == p_sys->i_pcr_pid )
+        {
+            /* Remember where we were, for the next seeks */
+            p_sys->i_pcr_last = i_pcr;
+            time_index_Add( &p_sys->index, PCRTime( p_sys, i_pcr ),
+                            stream_Tell( p_demux->s ) - p_sys->i_packet_size );
+        }
 
         /* Search program and set the PCR */
         for( i = 0; i < p_sys->i_pmt; i++ )
@@ -1887,6 +1996,152 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
     }
 }
 
+/* PCRProbe: finds the first PCR of the clock PID after i_pos
+ */
+static int PCRProbe( demux_t *p_demux, int64_t i_pos, int64_t i_end,
+                     time_index_entry_t *p_found )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const int   i_size = p_sys->i_packet_size;
+
+    i_end = __MIN( i_end, i_pos + TS_PROBE_SIZE );
+    if( stream_Seek( p_demux->s, i_pos ) )
+        return VLC_EGENERIC;
+
+    while( vlc_object_alive( p_demux ) && i_pos < i_end )
+    {
+        const uint8_t *p_peek;
+        int i_peek, i_skip;
+        mtime_t i_pcr;
+
+        i_peek = stream_Peek( p_demux->s, &p_peek, 2 * i_size );
+        if( i_peek < i_size )
+            break;
+
+        /* Check sync byte and re-sync if needed */
+        if( p_peek[0] != 0x47 || ( i_peek > i_size && p_peek[i_size] != 0x47 ) )
+        {
+            for( i_skip = 1; i_skip < i_peek - i_size; i_skip++ )
+                if( p_peek[i_skip] == 0x47 && p_peek[i_skip + i_size] == 0x47 )
+                    break;
+            if( stream_Read( p_demux->s, NULL, i_skip ) < i_skip )
+                break;
+            i_pos += i_skip;
+            continue;
+        }
+
+        i_pcr = PCRGet( p_peek );
+        if( i_pcr >= 0 && ( p_sys->i_pcr_pid < 0 ||
+            ( ( (p_peek[1]&0x1f)<<8 )|p_peek[2] ) == p_sys->i_pcr_pid ) )
+        {
+            if( p_sys->i_pcr_pid < 0 )
+            {
+                /* The first PCR found is the clock */
+                p_sys->i_pcr_pid = ( (p_peek[1]&0x1f)<<8 )|p_peek[2];
+                p_sys->i_pcr_first = i_pcr;
+            }
+            p_found->i_time = PCRTime( p_sys, i_pcr );
+            p_found->i_pos = i_pos;
+            return VLC_SUCCESS;
+        }
+
+        if( stream_Read( p_demux->s, NULL, i_size ) < i_size )
+            break;
+        i_pos += i_size;
+    }
+    return VLC_EGENERIC;
+}
+
+/* PCRFindLength: gets the clock from the first PCR, and the length from
+ * the last one
+ */
+static void PCRFindLength( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const int64_t i_start = stream_Tell( p_demux->s );
+    const int64_t i_size = stream_Size( p_demux->s );
+    time_index_entry_t pcr, last;
+    int64_t i_pos;
+
+    if( i_size <= 0 || PCRProbe( p_demux, i_start, i_size, &pcr ) )
+    {
+        stream_Seek( p_demux->s, i_start );
+        return;
+    }
+    time_index_Add( &p_sys->index, pcr.i_time, pcr.i_pos );
+
+    last.i_time = -1;
+    i_pos = __MAX( pcr.i_pos + p_sys->i_packet_size, i_size - TS_PROBE_SIZE );
+    while( !PCRProbe( p_demux, i_pos, i_size, &pcr ) )
+    {
+        last = pcr;
+        i_pos = pcr.i_pos + p_sys->i_packet_size;
+    }
+    /* A PCR discontinuity would give a bogus length */
+    if( last.i_time > 0 && last.i_time < INT64_C(0x100000000) * 100 / 9 )
+    {
+        time_index_Add( &p_sys->index, last.i_time, last.i_pos );
+        p_sys->i_pcr_length = last.i_time;
+        msg_Dbg( p_demux, "PCR pid %d gives a length of %"PRId64" us",
+                 p_sys->i_pcr_pid, p_sys->i_pcr_length );
+    }
+    stream_Seek( p_demux->s, i_start );
+}
+
+/* Time index of a previous playback of the same file */
+#define TS_INDEX_CACHE VLC_FOURCC('t','s',' ',' ')
+
+typedef struct
+{
+    int64_t i_pcr_pid;
+    int64_t i_pcr_first;
+    int64_t i_pcr_length;
+} ts_index_clock_t;
+
+static int IndexCacheLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const ts_index_clock_t *p_clock;
+    const time_index_entry_t *p_entry;
+    index_cache_t *p_cache;
+    size_t i_clock, i_count;
+
+    if( ( p_cache = index_cache_Load( p_demux, TS_INDEX_CACHE ) ) == NULL )
+        return VLC_EGENERIC;
+
+    p_clock = index_cache_Table( p_cache, 0, sizeof( *p_clock ), &i_clock );
+    p_entry = index_cache_Table( p_cache, 1, sizeof( *p_entry ), &i_count );
+    if( !p_clock || i_clock != 1 || !p_entry || i_count == 0 ||
+        ( p_sys->index.p_entry = malloc( i_count * sizeof( *p_entry ) ) ) == NULL )
+    {
+        index_cache_Release( p_cache );
+        return VLC_EGENERIC;
+    }
+    memcpy( p_sys->index.p_entry, p_entry, i_count * sizeof( *p_entry ) );
+    p_sys->index.i_count = p_sys->index.i_alloc = i_count;
+    p_sys->i_index_saved = i_count;
+
+    p_sys->i_pcr_pid    = p_clock->i_pcr_pid;
+    p_sys->i_pcr_first  = p_clock->i_pcr_first;
+    p_sys->i_pcr_length = p_clock->i_pcr_length;
+    index_cache_Release( p_cache );
+    return VLC_SUCCESS;
+}
+
+static void IndexCacheSave( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const ts_index_clock_t clock = {
+        p_sys->i_pcr_pid, p_sys->i_pcr_first, p_sys->i_pcr_length };
+    const index_cache_table_t table[2] = {
+        { &clock, sizeof( clock ), 1 },
+        { p_sys->index.p_entry, sizeof( *p_sys->index.p_entry ),
+          p_sys->index.i_count },
+    };
+
+    index_cache_Save( p_demux, TS_INDEX_CACHE, table, 2 );
+}
+
 static bool GatherPES( demux_t *p_demux, ts_pid_t *pid, block_t *p_bk )
 {
     const uint8_t *p = p_bk->p_buffer;
@@ -95,13 +95,14 @@ PreferencesWindow::PreferencesWindow( intf_thread_t * _p_intf,
 
     /* Find the main module */
     module_t * p_module = NULL;
-    module_config_t * p_item = NULL;
+    module_config_t * p_config = NULL, * p_item;
+    unsigned i_confsize = 0;
     for( int i = 0; i < p_list->i_count; i++ )
     {
         p_module = (module_t*) p_list->p_values[i].p_object;
 
         if( !strcmp( p_module->psz_object_name, "main" ) &&
-            ( p_item = p_module->p_config ) )
+            ( p_config = module_GetConfig( p_module, &i_confsize ) ) )
             break;
         else
             p_module = NULL;
@@ -112,8 +113,9 @@ PreferencesWindow::PreferencesWindow( intf_thread_t * _p_intf,
     if( p_module )
     {
         /* We found the main module, build the category tree */
-        for( ; p_item->i_type != CONFIG_HINT_END; p_item++ )
+        for( unsigned j = 0; j < i_confsize; j++ )
         {
+            p_item = p_config + j;
             switch( p_item->i_type )
             {
                 case CONFIG_CATEGORY:
@@ -144,6 +146,7 @@ PreferencesWindow::PreferencesWindow( intf_thread_t * _p_intf,
                     break;
             }
         }
+        module_PutConfig( p_config );
     }
 
     /* Now parse all others modules */
@@ -162,11 +165,12 @@ PreferencesWindow::PreferencesWindow( intf_thread_t * _p_intf,
             continue;
 
         if( p_module->b_submodule ||
-            !( p_item = p_module->p_config ) )
+            !( p_config = module_GetConfig( p_module, &i_confsize ) ) )
             continue;
 
-        for( ; p_item->i_type != CONFIG_HINT_END; p_item++ )
+        for( unsigned j = 0; j < i_confsize; j++ )
         {
+            p_item = p_config + j;
             switch( p_item->i_type )
             {
                 case CONFIG_CATEGORY:
@@ -184,6 +188,7 @@ PreferencesWindow::PreferencesWindow( intf_thread_t * _p_intf,
                 break;
             }
         }
+        module_PutConfig( p_config );
 
         if( options < 1 || category < 0 || subcategory < 0 )
             continue;
@@ -449,14 +454,17 @@ ConfigItem::ConfigItem( intf_thread_t * _p_intf, char * name,
         /* Shouldn't happen */
         return;
 
-    module_config_t * p_item;
-    p_item = fSubModule ? ((module_t *)p_module->p_parent)->p_config :
-               p_module->p_config;
+    module_config_t * p_config, * p_item;
+    unsigned i_confsize, i_item = 0;
+    p_config = module_GetConfig( fSubModule ?
+                                 (module_t *)p_module->p_parent : p_module,
+                                 &i_confsize );
 
     if( fType == TYPE_SUBCATEGORY )
     {
-        for( ; p_item->i_type != CONFIG_HINT_END; p_item++ )
+        for( ; i_item < i_confsize; i_item++ )
         {
+            p_item = p_config + i_item;
             if( p_item->i_type == CONFIG_SUBCATEGORY &&
                 p_item->i_value == fObjectId )
             {
@@ -476,8 +484,9 @@ ConfigItem::ConfigItem( intf_thread_t * _p_intf, char * name,
     r.InsetBy( 10,10 );
 
     ConfigWidget * widget;
-    for( ; p_item->i_type != CONFIG_HINT_END; p_item++ )
+    for( ; i_item < i_confsize; i_item++ )
     {
+        p_item = p_config + i_item;
         if( ( p_item->i_type == CONFIG_CATEGORY ||
               p_item->i_type == CONFIG_SUBCATEGORY ) &&
             fType == TYPE_SUBCATEGORY &&
@@ -495,6 +504,7 @@ ConfigItem::ConfigItem( intf_thread_t * _p_intf, char * name,
         fView->AddChild( widget );
         r.top += widget->Bounds().Height();
     }
+    module_PutConfig( p_config );
 
     if( fType == TYPE_MODULE )
     {
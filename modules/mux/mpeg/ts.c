@@ -146,6 +146,12 @@ static void    Close  ( vlc_object_t * );
   "PCRs (Program Clock Reference) will be sent (in milliseconds). " \
   "This value should be below 100ms. (default is 70ms).")
 
+#define MUXRATE_TEXT N_("Mux rate (bits/s)")
+#define MUXRATE_LONGTEXT N_("Output a constant bitrate multiplex at this " \
+  "rate, stuffed with null packets, and check it against the T-STD " \
+  "buffer model. The rate must be above the total rate of the streams " \
+  "(0 disables).")
+
 #define BMIN_TEXT N_( "Minimum B (deprecated)")
 #define BMIN_LONGTEXT N_( "This setting is deprecated and not used anymore" )
 
@@ -175,6 +181,11 @@ static void    Close  ( vlc_object_t * );
 #define CU_LONGTEXT N_("CSA encryption key used. It can be the odd/first/1 " \
   "(default) or the even/second/2 one.")
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of threads used to packetize the " \
+  "elementary streams in parallel. This is only worth it when muxing " \
+  "many programs at once (0 packetizes on the muxer thread).")
+
 #define CPKT_TEXT N_("Packet size in bytes to encrypt")
 #define CPKT_LONGTEXT N_("Size of the TS packet to encrypt. " \
     "The encryption routines subtract the TS-header from the value before " \
@@ -228,12 +239,16 @@ vlc_module_begin();
 
     add_integer( SOUT_CFG_PREFIX "pcr", 70, NULL, PCR_TEXT, PCR_LONGTEXT,
                  true );
+    add_integer( SOUT_CFG_PREFIX "muxrate", 0, NULL, MUXRATE_TEXT,
+                 MUXRATE_LONGTEXT, true );
     add_integer( SOUT_CFG_PREFIX "bmin", 0, NULL, BMIN_TEXT, BMIN_LONGTEXT,
                  true );
     add_integer( SOUT_CFG_PREFIX "bmax", 0, NULL, BMAX_TEXT, BMAX_LONGTEXT,
                  true );
     add_integer( SOUT_CFG_PREFIX "dts-delay", 400, NULL, DTS_TEXT,
                  DTS_LONGTEXT, true );
+    add_integer( SOUT_CFG_PREFIX "threads", 0, NULL, THREADS_TEXT,
+                 THREADS_LONGTEXT, true );
 
     add_bool( SOUT_CFG_PREFIX "crypt-audio", true, NULL, ACRYPT_TEXT,
               ACRYPT_LONGTEXT, true );
@@ -258,7 +273,7 @@ static const char *const ppsz_sout_options[] = {
     "pid-video", "pid-audio", "pid-spu", "pid-pmt", "tsid", "netid",
     "es-id-pid", "shaping", "pcr", "bmin", "bmax", "use-key-frames",
     "dts-delay", "csa-ck", "csa2-ck", "csa-use", "csa-pkt", "crypt-audio", "crypt-video",
-    "muxpmt", "sdtdesc", "program-pmt", "alignment",
+    "muxpmt", "sdtdesc", "program-pmt", "alignment", "threads", "muxrate",
     NULL
 };
 
@@ -338,6 +353,126 @@ static inline void BufferChainClean( sout_buffer_chain_t *c )
     BufferChainInit( c );
 }
 
+/* TS packets are carved out of slabs, several UDP datagrams worth at a
+ * time, instead of being allocated one by one. A slab is freed once all
+ * its packets have been released. Each stream has its own arena, so that
+ * streams can be packetized from different threads. */
+#define TS_SLAB_PACKETS (7 * 8)
+
+typedef struct ts_slab_t ts_slab_t;
+
+typedef struct
+{
+    block_t     self;
+    ts_slab_t   *p_slab;
+} ts_packet_t;
+
+struct ts_slab_t
+{
+    vlc_spinlock_t lock;
+    unsigned       i_refs;
+    ts_packet_t    packets[TS_SLAB_PACKETS];
+    uint8_t        p_data[TS_SLAB_PACKETS * 188];
+};
+
+typedef struct
+{
+    ts_slab_t   *p_slab;
+    unsigned    i_used;
+} ts_arena_t;
+
+static void TSSlabRelease( ts_slab_t *p_slab, unsigned i_refs )
+{
+    vlc_spin_lock( &p_slab->lock );
+    p_slab->i_refs -= i_refs;
+    i_refs = p_slab->i_refs;
+    vlc_spin_unlock( &p_slab->lock );
+
+    if( i_refs == 0 )
+    {
+        vlc_spin_destroy( &p_slab->lock );
+        free( p_slab );
+    }
+}
+
+static void TSPacketRelease( block_t *p_block )
+{
+    TSSlabRelease( ((ts_packet_t *)p_block)->p_slab, 1 );
+}
+
+static inline void TSArenaInit( ts_arena_t *p_arena )
+{
+    p_arena->p_slab = NULL;
+    p_arena->i_used = 0;
+}
+
+static void TSArenaClean( ts_arena_t *p_arena )
+{
+    /* Drop the packets that were not handed out, and our own reference */
+    if( p_arena->p_slab )
+        TSSlabRelease( p_arena->p_slab,
+                       TS_SLAB_PACKETS - p_arena->i_used + 1 );
+    TSArenaInit( p_arena );
+}
+
+static block_t *TSPacketNew( ts_arena_t *p_arena )
+{
+    ts_packet_t *p_packet;
+
+    if( p_arena->p_slab == NULL || p_arena->i_used >= TS_SLAB_PACKETS )
+    {
+        ts_slab_t *p_slab = malloc( sizeof( *p_slab ) );
+
+        if( p_slab == NULL )
+            return NULL;
+        TSArenaClean( p_arena );
+
+        /* Every packet holds a reference from the start, plus the arena */
+        vlc_spin_init( &p_slab->lock );
+        p_slab->i_refs = TS_SLAB_PACKETS + 1;
+        p_arena->p_slab = p_slab;
+    }
+
+    p_packet = &p_arena->p_slab->packets[p_arena->i_used];
+    block_Init( &p_packet->self,
+                &p_arena->p_slab->p_data[188 * p_arena->i_used], 188 );
+    p_packet->self.pf_release = TSPacketRelease;
+    p_packet->p_slab = p_arena->p_slab;
+    p_arena->i_used++;
+
+    return &p_packet->self;
+}
+
+/* Simplified T-STD (ISO/IEC 13818-1 2.4.2) model of one elementary
+ * stream: the transport buffer TB leaks at Rx, and the access units leave
+ * the main buffer B at their decoding time. */
+#define TSTD_TB_SIZE    512
+#define TSTD_AU_MAX     64
+
+#define TS_PACKET_BITS_27MHZ INT64_C(40608000000)   /* 188 * 8 * 27 MHz */
+/* Restart the CBR clock if the streams drift that far from it */
+#define CBR_RESYNC_DELAY     INT64_C(2000000)
+#define CBR_REPORT_DELAY     INT64_C(10000000)
+
+typedef struct
+{
+    int64_t     i_rx;           /* TB leak rate (bits/s) */
+    int64_t     i_b_size;       /* B size (bytes) */
+
+    int64_t     i_tb;
+    int64_t     i_b;
+    mtime_t     i_last;         /* system time of the last packet */
+
+    struct
+    {
+        mtime_t i_dts;
+        int     i_size;
+        bool    b_late;
+    } au[TSTD_AU_MAX];
+    int         i_au_first;
+    int         i_au;
+} ts_tstd_t;
+
 typedef struct ts_stream_t
 {
     int             i_pid;
@@ -368,8 +503,22 @@ typedef struct ts_stream_t
     int                 i_pes_used;
     bool                b_key_frame;
 
+    ts_arena_t          arena;
+    ts_tstd_t           tstd;
+    /* TS packets built ahead of the interleaving */
+    sout_buffer_chain_t chain_ts;
+    bool                b_scrambled;
+
 } ts_stream_t;
 
+/* Packetizing thread */
+typedef struct
+{
+    VLC_COMMON_MEMBERS
+
+    sout_mux_t      *p_mux;
+} ts_thread_t;
+
 struct sout_mux_sys_t
 {
     int             i_pcr_pid;
@@ -424,6 +573,45 @@ struct sout_mux_sys_t
     int             i_csa_pkt_size;
     bool            b_crypt_audio;
     bool            b_crypt_video;
+
+    /* Constant bitrate output: the clock of the next packet slot is in
+     * 27 MHz units, advanced by i_cbr_step + i_cbr_step_rem / i_mux_rate
+     * per packet */
+    int64_t         i_mux_rate;
+    int64_t         i_cbr_clock;
+    int64_t         i_cbr_step;
+    int64_t         i_cbr_step_rem;
+    int64_t         i_cbr_rem;
+    int64_t         i_cbr_last_pcr;
+    int             i_cbr_pcr_pid;      /* PID of the last PCR PID packet */
+    int             i_cbr_pcr_cc;       /* and its continuity counter */
+    ts_arena_t      null_arena;
+    ts_stream_t     **pp_pid_stream;    /* for the T-STD model */
+
+    /* Statistics of the CBR mode */
+    uint64_t        i_null_packets;
+    uint64_t        i_late_packets;     /* sent after their slice */
+    uint64_t        i_tb_overflow;
+    uint64_t        i_b_overflow;
+    uint64_t        i_b_underflow;
+    int64_t         i_pcr_interval_max; /* 27 MHz */
+    int64_t         i_pcr_jitter_max;   /* 27 MHz / i_mux_rate */
+    mtime_t         i_stats_report;
+    uint64_t        i_stats_reported;
+
+    /* Parallel packetization: the streams in pp_jobs are handed out to the
+     * threads (and the muxer thread itself) one at a time */
+    int             i_threads;
+    ts_thread_t     **pp_threads;
+    vlc_mutex_t     lock_jobs;
+    vlc_cond_t      wait_jobs;
+    vlc_cond_t      wait_done;
+    ts_stream_t     **pp_jobs;
+    int             i_jobs;
+    int             i_job_next;
+    int             i_jobs_done;
+    mtime_t         i_job_dts;
+    unsigned        i_job_generation;
 };
 
 /* Reserve a pid and return it */
@@ -489,10 +677,17 @@ static void TSDate      ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
 static void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 
-static block_t *TSNew( sout_mux_t *p_mux, ts_stream_t *p_stream, bool b_pcr );
-static void TSSetPCR( block_t *p_ts, mtime_t i_dts );
+static block_t *TSNew( ts_stream_t *p_stream, bool b_pcr );
+static void TSSetPCR( block_t *p_ts, int64_t i_pcr );
+static void TSDateCBR( sout_mux_t *, sout_buffer_chain_t *,
+                       mtime_t i_pcr_length, mtime_t i_pcr_dts );
+static void TSReportCBR( sout_mux_t *, bool b_final );
+static void TSTDInit( ts_tstd_t *, const es_format_t * );
+static void TSPacketizeAll( sout_mux_t *, ts_stream_t *p_pcr_stream,
+                            mtime_t i_max_dts );
+static void* TSThread( vlc_object_t * );
 
-static void PEStoTS  ( sout_instance_t *, sout_buffer_chain_t *, block_t *, ts_stream_t * );
+static void PEStoTS  ( sout_buffer_chain_t *, block_t *, ts_stream_t * );
 
 /*****************************************************************************
  * Open:
@@ -589,6 +784,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->pat.i_pid = 0;
     p_sys->pat.i_continuity_counter = 0;
     p_sys->pat.b_discontinuity = false;
+    TSArenaInit( &p_sys->pat.arena );
 
     var_Get( p_mux, SOUT_CFG_PREFIX "tsid", &val );
     if ( val.i_int )
@@ -608,11 +804,13 @@ static int Open( vlc_object_t *p_this )
     {
         p_sys->pmt[i].i_continuity_counter = 0;
         p_sys->pmt[i].b_discontinuity = false;
+        TSArenaInit( &p_sys->pmt[i].arena );
     }
 
     p_sys->sdt.i_pid = 0x11;
     p_sys->sdt.i_continuity_counter = 0;
     p_sys->sdt.b_discontinuity = false;
+    TSArenaInit( &p_sys->sdt.arena );
 
 #ifdef HAVE_DVBPSI_SDT
     var_Get( p_mux, SOUT_CFG_PREFIX "sdtdesc", &val );
@@ -856,6 +1054,82 @@ static int Open( vlc_object_t *p_this )
     var_Get( p_mux, SOUT_CFG_PREFIX "crypt-video", &val );
     p_sys->b_crypt_video = val.b_bool;
 
+    /* Constant bitrate */
+    p_sys->i_mux_rate = var_GetInteger( p_mux, SOUT_CFG_PREFIX "muxrate" );
+    p_sys->pp_pid_stream = NULL;
+    if( p_sys->i_mux_rate > 0 && p_sys->i_mux_rate < 188 * 8 * 10 )
+    {
+        msg_Err( p_mux, "invalid mux rate (%"PRId64" bit/s)",
+                 p_sys->i_mux_rate );
+        p_sys->i_mux_rate = 0;
+    }
+    if( p_sys->i_mux_rate > 0 )
+    {
+        p_sys->pp_pid_stream = calloc( 8192, sizeof( ts_stream_t * ) );
+        if( !p_sys->pp_pid_stream )
+            p_sys->i_mux_rate = 0;
+        else
+            msg_Dbg( p_mux, "constant bitrate of %"PRId64" bit/s",
+                     p_sys->i_mux_rate );
+    }
+    if( p_sys->i_mux_rate > 0 )
+    {
+        p_sys->i_cbr_step = TS_PACKET_BITS_27MHZ / p_sys->i_mux_rate;
+        p_sys->i_cbr_step_rem = TS_PACKET_BITS_27MHZ % p_sys->i_mux_rate;
+    }
+    else
+        p_sys->i_mux_rate = 0;
+    p_sys->i_cbr_clock = -1;
+    p_sys->i_cbr_rem = 0;
+    p_sys->i_cbr_last_pcr = -1;
+    p_sys->i_cbr_pcr_pid = p_sys->i_cbr_pcr_cc = -1;
+    TSArenaInit( &p_sys->null_arena );
+    p_sys->i_null_packets = p_sys->i_late_packets = 0;
+    p_sys->i_tb_overflow = p_sys->i_b_overflow = p_sys->i_b_underflow = 0;
+    p_sys->i_pcr_interval_max = p_sys->i_pcr_jitter_max = 0;
+    p_sys->i_stats_report = 0;
+    p_sys->i_stats_reported = 0;
+
+    /* Packetizing threads */
+    vlc_mutex_init( &p_sys->lock_jobs );
+    vlc_cond_init( p_mux, &p_sys->wait_jobs );
+    vlc_cond_init( p_mux, &p_sys->wait_done );
+    p_sys->pp_jobs = NULL;
+    p_sys->i_jobs = p_sys->i_job_next = p_sys->i_jobs_done = 0;
+    p_sys->i_job_dts = 0;
+    p_sys->i_job_generation = 0;
+
+    p_sys->i_threads = var_GetInteger( p_mux, SOUT_CFG_PREFIX "threads" );
+    p_sys->pp_threads = NULL;
+    if( p_sys->i_threads > 0 )
+        p_sys->pp_threads = malloc( p_sys->i_threads *
+                                    sizeof( *p_sys->pp_threads ) );
+    if( !p_sys->pp_threads )
+        p_sys->i_threads = 0;
+    for( i = 0; i < p_sys->i_threads; i++ )
+    {
+        ts_thread_t *p_thread = vlc_object_create( p_mux,
+                                                   sizeof( *p_thread ) );
+        if( !p_thread )
+            break;
+        p_thread->p_mux = p_mux;
+        vlc_object_attach( p_thread, p_mux );
+        if( vlc_thread_create( p_thread, "ts mux packetizer", TSThread,
+                               VLC_THREAD_PRIORITY_OUTPUT, false ) )
+        {
+            vlc_object_detach( p_thread );
+            vlc_object_release( p_thread );
+            break;
+        }
+        p_sys->pp_threads[i] = p_thread;
+    }
+    if( i < p_sys->i_threads )
+        msg_Warn( p_mux, "cannot spawn packetizing threads (%d of %d)",
+                  i, p_sys->i_threads );
+    p_sys->i_threads = i;
+    if( p_sys->i_threads > 0 )
+        msg_Dbg( p_mux, "packetizing with %d threads", p_sys->i_threads );
+
     return VLC_SUCCESS;
 }
 
@@ -885,6 +1159,35 @@ static void Close( vlc_object_t * p_this )
         free( p_sys->sdt_descriptors[i].psz_provider );
     }
 
+    /* Stop the packetizing threads */
+    vlc_mutex_lock( &p_sys->lock_jobs );
+    for( i = 0; i < p_sys->i_threads; i++ )
+    {
+        vlc_object_kill( p_sys->pp_threads[i] );
+        vlc_cond_signal( &p_sys->wait_jobs );
+    }
+    vlc_mutex_unlock( &p_sys->lock_jobs );
+    for( i = 0; i < p_sys->i_threads; i++ )
+    {
+        vlc_thread_join( p_sys->pp_threads[i] );
+        vlc_object_detach( p_sys->pp_threads[i] );
+        vlc_object_release( p_sys->pp_threads[i] );
+    }
+    free( p_sys->pp_threads );
+    vlc_cond_destroy( &p_sys->wait_done );
+    vlc_cond_destroy( &p_sys->wait_jobs );
+    vlc_mutex_destroy( &p_sys->lock_jobs );
+
+    TSArenaClean( &p_sys->pat.arena );
+    for( i = 0; i < p_sys->i_num_pmt; i++ )
+        TSArenaClean( &p_sys->pmt[i].arena );
+    TSArenaClean( &p_sys->sdt.arena );
+
+    if( p_sys->i_mux_rate > 0 )
+        TSReportCBR( p_mux, true );
+    TSArenaClean( &p_sys->null_arena );
+    free( p_sys->pp_pid_stream );
+
     vlc_mutex_destroy( &p_sys->csa_lock );
     free( p_sys->dvbpmt );
     free( p_sys );
@@ -1256,6 +1559,15 @@ static int AddStream( sout_mux_t *p_mux, sout_input_t *p_input )
     p_stream->i_pes_used   = 0;
     p_stream->b_key_frame  = 0;
 
+    TSArenaInit( &p_stream->arena );
+    TSTDInit( &p_stream->tstd, p_input->p_fmt );
+    if( p_sys->pp_pid_stream )
+        p_sys->pp_pid_stream[p_stream->i_pid] = p_stream;
+    BufferChainInit( &p_stream->chain_ts );
+    p_stream->b_scrambled = p_sys->csa != NULL &&
+        ( p_input->p_fmt->i_cat != AUDIO_ES || p_sys->b_crypt_audio ) &&
+        ( p_input->p_fmt->i_cat != VIDEO_ES || p_sys->b_crypt_video );
+
     /* We only change PMT version (PAT isn't changed) */
     p_sys->i_pmt_version_number = ( p_sys->i_pmt_version_number + 1 )%32;
 
@@ -1328,6 +1640,11 @@ static int DelStream( sout_mux_t *p_mux, sout_input_t *p_input )
 
     /* Empty all data in chain_pes */
     BufferChainClean( &p_stream->chain_pes );
+    BufferChainClean( &p_stream->chain_ts );
+    TSArenaClean( &p_stream->arena );
+    if( p_sys->pp_pid_stream &&
+        p_sys->pp_pid_stream[p_stream->i_pid] == p_stream )
+        p_sys->pp_pid_stream[p_stream->i_pid] = NULL;
 
     free(p_stream->lang);
     free( p_stream->p_decoder_specific_info );
@@ -1686,30 +2003,42 @@ static int Mux( sout_mux_t *p_mux )
         i_packet_count += chain_ts.i_depth;
         /* msg_Dbg( p_mux, "estimated pck=%d", i_packet_count ); */
 
+        /* The other streams do not depend on the PCR placement, so their
+         * packets can be built beforehand, possibly in parallel */
+        TSPacketizeAll( p_mux, p_pcr_stream, i_pcr_dts + i_pcr_length );
+
         for( ;; )
         {
             int          i_stream;
             mtime_t      i_dts;
             ts_stream_t  *p_stream;
-            sout_input_t *p_input;
             block_t      *p_ts;
             bool         b_pcr;
 
             /* Select stream (lowest dts) */
             for( i = 0, i_stream = -1, i_dts = 0; i < p_mux->i_nb_inputs; i++ )
             {
+                mtime_t i_stream_dts;
+
                 p_stream = (ts_stream_t*)p_mux->pp_inputs[i]->p_sys;
 
-                if( p_stream->i_pes_dts == 0 )
+                if( p_stream == p_pcr_stream )
+                    i_stream_dts = p_stream->i_pes_dts;
+                else if( p_stream->chain_ts.p_first != NULL )
+                    i_stream_dts = p_stream->chain_ts.p_first->i_pts;
+                else
+                    i_stream_dts = 0;
+
+                if( i_stream_dts == 0 )
                 {
                     continue;
                 }
 
                 if( i_stream == -1 ||
-                    p_stream->i_pes_dts < i_dts )
+                    i_stream_dts < i_dts )
                 {
                     i_stream = i;
-                    i_dts = p_stream->i_pes_dts;
+                    i_dts = i_stream_dts;
                 }
             }
             if( i_stream == -1 || i_dts > i_pcr_dts + i_pcr_length )
@@ -1717,26 +2046,28 @@ static int Mux( sout_mux_t *p_mux )
                 break;
             }
             p_stream = (ts_stream_t*)p_mux->pp_inputs[i_stream]->p_sys;
-            p_input = p_mux->pp_inputs[i_stream];
 
-            /* do we need to issue pcr */
-            b_pcr = false;
-            if( p_stream == p_pcr_stream &&
-                i_pcr_dts + i_packet_pos * i_pcr_length / i_packet_count >=
-                p_sys->i_pcr + p_sys->i_pcr_delay )
+            if( p_stream == p_pcr_stream )
             {
-                b_pcr = true;
-                p_sys->i_pcr = i_pcr_dts + i_packet_pos *
-                    i_pcr_length / i_packet_count;
-            }
+                /* do we need to issue pcr */
+                b_pcr = false;
+                if( i_pcr_dts + i_packet_pos * i_pcr_length / i_packet_count >=
+                    p_sys->i_pcr + p_sys->i_pcr_delay )
+                {
+                    b_pcr = true;
+                    p_sys->i_pcr = i_pcr_dts + i_packet_pos *
+                        i_pcr_length / i_packet_count;
+                }
 
-            /* Build the TS packet */
-            p_ts = TSNew( p_mux, p_stream, b_pcr );
-            if( p_sys->csa != NULL &&
-                 (p_input->p_fmt->i_cat != AUDIO_ES || p_sys->b_crypt_audio) &&
-                 (p_input->p_fmt->i_cat != VIDEO_ES || p_sys->b_crypt_video) )
+                /* Build the TS packet */
+                p_ts = TSNew( p_stream, b_pcr );
+                if( p_stream->b_scrambled )
+                    p_ts->i_flags |= BLOCK_FLAG_SCRAMBLED;
+            }
+            else
             {
-                p_ts->i_flags |= BLOCK_FLAG_SCRAMBLED;
+                p_ts = BufferChainGet( &p_stream->chain_ts );
+                p_ts->i_pts = 0;
             }
             i_packet_pos++;
 
@@ -1924,6 +2255,305 @@ static void TSSchedule( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         TSDate( p_mux, &new_chain, i_pcr_length, i_pcr_dts );
 }
 
+/*****************************************************************************
+ * Constant bitrate output
+ *****************************************************************************/
+static void TSTDInit( ts_tstd_t *p_tstd, const es_format_t *p_fmt )
+{
+    memset( p_tstd, 0, sizeof( *p_tstd ) );
+
+    switch( p_fmt->i_cat )
+    {
+        case VIDEO_ES:
+        {
+            /* Rmax of the MPEG-2 main profile at main or high level */
+            const int64_t i_rmax = p_fmt->i_bitrate > 15000000 ?
+                                   __MAX( p_fmt->i_bitrate, 80000000 )
+                                   : 15000000;
+            const int64_t i_vbv = i_rmax > 15000000 ? 9781248 : 1835008;
+
+            p_tstd->i_rx = i_rmax * 6 / 5;
+            /* VBV + BSmux (4 ms) + BSoh (1/750 s) */
+            p_tstd->i_b_size = ( i_vbv + i_rmax * 4 / 1000 +
+                                 i_rmax / 750 ) / 8;
+            break;
+        }
+        case AUDIO_ES:
+            p_tstd->i_rx = 2000000;
+            p_tstd->i_b_size =
+                p_fmt->i_codec == VLC_FOURCC('a','5','2',' ') ? 5696 : 3584;
+            break;
+        default:
+            p_tstd->i_rx = 1000000;
+            p_tstd->i_b_size = 24576;   /* DVB subtitles */
+            break;
+    }
+}
+
+/* Feeds a packet to the model of its stream, at system time i_stc */
+static void TSTDPacket( sout_mux_sys_t *p_sys, ts_tstd_t *p_tstd,
+                        const block_t *p_ts, mtime_t i_stc )
+{
+    const uint8_t *p = p_ts->p_buffer;
+    /* Split PES have a dts on their first part only */
+    const bool b_new_au = ( p[1] & 0x40 ) && p_ts->i_dts > 0;
+    int i_payload = 184;
+
+    if( p[3] & 0x20 )
+        i_payload -= 1 + p[4];
+
+    /* Transport buffer */
+    if( p_tstd->i_last > 0 && i_stc > p_tstd->i_last )
+        p_tstd->i_tb = __MAX( 0, p_tstd->i_tb - ( i_stc - p_tstd->i_last ) *
+                                 p_tstd->i_rx / 8000000 );
+    p_tstd->i_last = i_stc;
+    p_tstd->i_tb += 188;
+    if( p_tstd->i_tb > TSTD_TB_SIZE )
+    {
+        p_sys->i_tb_overflow++;
+        p_tstd->i_tb = TSTD_TB_SIZE;
+    }
+
+    /* Remove the decoded access units, but the one being received */
+    while( p_tstd->i_au > 0 )
+    {
+        const int i_first = p_tstd->i_au_first;
+
+        if( p_tstd->au[i_first].i_dts > i_stc ||
+            ( p_tstd->i_au == 1 && !b_new_au ) )
+            break;
+        p_tstd->i_b -= p_tstd->au[i_first].i_size;
+        p_tstd->i_au_first = ( i_first + 1 ) % TSTD_AU_MAX;
+        p_tstd->i_au--;
+    }
+
+    if( b_new_au )
+    {
+        int i_last;
+
+        if( p_tstd->i_au >= TSTD_AU_MAX )
+        {
+            p_tstd->i_b -= p_tstd->au[p_tstd->i_au_first].i_size;
+            p_tstd->i_au_first = ( p_tstd->i_au_first + 1 ) % TSTD_AU_MAX;
+            p_tstd->i_au--;
+        }
+        i_last = ( p_tstd->i_au_first + p_tstd->i_au ) % TSTD_AU_MAX;
+        p_tstd->au[i_last].i_dts = p_ts->i_dts;
+        p_tstd->au[i_last].i_size = 0;
+        p_tstd->au[i_last].b_late = false;
+        p_tstd->i_au++;
+    }
+
+    if( p_tstd->i_au > 0 )
+    {
+        const int i_last = ( p_tstd->i_au_first + p_tstd->i_au - 1 )
+                           % TSTD_AU_MAX;
+
+        p_tstd->au[i_last].i_size += i_payload;
+        p_tstd->i_b += i_payload;
+        /* Still being received when it should be decoded */
+        if( p_tstd->au[i_last].i_dts < i_stc && !p_tstd->au[i_last].b_late )
+        {
+            p_tstd->au[i_last].b_late = true;
+            p_sys->i_b_underflow++;
+        }
+    }
+    if( p_tstd->i_b > p_tstd->i_b_size )
+        p_sys->i_b_overflow++;
+}
+
+/* Builds a packet for an empty slot: a PCR only packet if a PCR is due,
+ * a null packet otherwise */
+static block_t *TSStuffing( sout_mux_t *p_mux )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    block_t *p_ts = TSPacketNew( &p_sys->null_arena );
+
+    if( p_ts == NULL )
+        return NULL;
+
+    if( p_sys->p_pcr_input && p_sys->i_cbr_last_pcr >= 0 &&
+        p_sys->i_cbr_clock - p_sys->i_cbr_last_pcr >=
+            p_sys->i_pcr_delay * 27 &&
+        p_sys->i_cbr_pcr_pid ==
+            ((ts_stream_t*)p_sys->p_pcr_input->p_sys)->i_pid )
+    {
+        const int i_pid = p_sys->i_cbr_pcr_pid;
+
+        p_ts->p_buffer[0] = 0x47;
+        p_ts->p_buffer[1] = ( i_pid >> 8 )&0x1f;
+        p_ts->p_buffer[2] = i_pid & 0xff;
+        /* No payload, so the continuity counter is the one of the last
+         * packet sent on the PID (the stream may have built more packets
+         * for this slice already) */
+        p_ts->p_buffer[3] = 0x20 | p_sys->i_cbr_pcr_cc;
+        p_ts->p_buffer[4] = 183;
+        p_ts->p_buffer[5] = 0x10;   /* flags: PCR */
+        memset( &p_ts->p_buffer[6], 0xff, 188 - 6 );
+        p_ts->i_flags |= BLOCK_FLAG_CLOCK;
+        return p_ts;
+    }
+
+    p_ts->p_buffer[0] = 0x47;
+    p_ts->p_buffer[1] = 0x1f;
+    p_ts->p_buffer[2] = 0xff;
+    p_ts->p_buffer[3] = 0x10 | p_sys->i_null_continuity_counter;
+    memset( &p_ts->p_buffer[4], 0xff, 184 );
+    p_sys->i_null_continuity_counter =
+        ( p_sys->i_null_continuity_counter + 1 )%16;
+    p_sys->i_null_packets++;
+    return p_ts;
+}
+
+/* Sends a packet in the next slot */
+static void TSSendCBR( sout_mux_t *p_mux, block_t *p_ts )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    const mtime_t i_dts = p_sys->i_cbr_clock / 27;
+    const int i_pid = ( ( p_ts->p_buffer[1]&0x1f ) << 8 ) | p_ts->p_buffer[2];
+    ts_stream_t *p_stream = p_sys->pp_pid_stream[i_pid];
+
+    if( p_stream && ( p_ts->p_buffer[3] & 0x10 ) )
+        TSTDPacket( p_sys, &p_stream->tstd, p_ts,
+                    i_dts - p_sys->i_dts_delay );
+    if( p_sys->p_pcr_input &&
+        i_pid == ((ts_stream_t*)p_sys->p_pcr_input->p_sys)->i_pid )
+    {
+        p_sys->i_cbr_pcr_pid = i_pid;
+        p_sys->i_cbr_pcr_cc = p_ts->p_buffer[3] & 0x0f;
+    }
+
+    p_ts->i_dts    = i_dts;
+    p_ts->i_length = TS_PACKET_BITS_27MHZ / p_sys->i_mux_rate / 27;
+
+    if( p_ts->i_flags & BLOCK_FLAG_CLOCK )
+    {
+        TSSetPCR( p_ts, p_sys->i_cbr_clock - p_sys->i_dts_delay * 27 );
+        if( p_sys->i_cbr_last_pcr >= 0 )
+            p_sys->i_pcr_interval_max =
+                __MAX( p_sys->i_pcr_interval_max,
+                       p_sys->i_cbr_clock - p_sys->i_cbr_last_pcr );
+        p_sys->i_cbr_last_pcr = p_sys->i_cbr_clock;
+        /* The PCR is the slot clock rounded down to the 27 MHz tick: it is
+         * early by i_cbr_rem / i_mux_rate ticks against the exact position
+         * of the packet at the mux rate */
+        p_sys->i_pcr_jitter_max = __MAX( p_sys->i_pcr_jitter_max,
+                                         p_sys->i_cbr_rem );
+    }
+    if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
+    {
+        vlc_mutex_lock( &p_sys->csa_lock );
+        csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
+        vlc_mutex_unlock( &p_sys->csa_lock );
+    }
+
+    /* latency */
+    p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
+
+    sout_AccessOutWrite( p_mux->p_access, p_ts );
+
+    p_sys->i_cbr_clock += p_sys->i_cbr_step;
+    p_sys->i_cbr_rem += p_sys->i_cbr_step_rem;
+    if( p_sys->i_cbr_rem >= p_sys->i_mux_rate )
+    {
+        p_sys->i_cbr_rem -= p_sys->i_mux_rate;
+        p_sys->i_cbr_clock++;
+    }
+}
+
+static void TSDateCBR( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+                       mtime_t i_pcr_length, mtime_t i_pcr_dts )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    const int64_t i_packets = p_chain_ts->i_depth;
+    const int64_t i_end = ( i_pcr_dts + __MAX( i_pcr_length, 0 ) ) * 27;
+    int64_t i_slots = 0, i_nulls;
+
+    /* Start the clock at the first slice, restart it after a jump */
+    if( p_sys->i_cbr_clock < 0 ||
+        i_pcr_dts * 27 - p_sys->i_cbr_clock > CBR_RESYNC_DELAY * 27 ||
+        p_sys->i_cbr_clock - i_end > CBR_RESYNC_DELAY * 27 )
+    {
+        if( p_sys->i_cbr_clock >= 0 )
+            msg_Warn( p_mux, "restarting the CBR clock (%"PRId64" us off)",
+                      i_pcr_dts - p_sys->i_cbr_clock / 27 );
+        p_sys->i_cbr_clock = i_pcr_dts * 27;
+        p_sys->i_cbr_rem = 0;
+        p_sys->i_cbr_last_pcr = -1;
+    }
+
+    /* Slots left until the end of the slice */
+    if( i_end > p_sys->i_cbr_clock )
+        i_slots = ( ( i_end - p_sys->i_cbr_clock ) * p_sys->i_mux_rate +
+                    TS_PACKET_BITS_27MHZ - 1 ) / TS_PACKET_BITS_27MHZ;
+
+    if( i_slots < i_packets )
+    {
+        /* The streams need more than the mux rate: the packets are sent
+         * anyway, and the clock gets ahead of the streams */
+        p_sys->i_late_packets += i_packets - i_slots;
+        i_nulls = 0;
+    }
+    else
+        i_nulls = i_slots - i_packets;
+
+    /* Spread the stuffing evenly between the packets */
+    if( i_packets == 0 )
+    {
+        for( ; i_nulls > 0; i_nulls-- )
+        {
+            block_t *p_ts = TSStuffing( p_mux );
+            if( p_ts )
+                TSSendCBR( p_mux, p_ts );
+        }
+    }
+    for( int64_t i = 0; i < i_packets; i++ )
+    {
+        int64_t n = ( i + 1 ) * i_nulls / i_packets - i * i_nulls / i_packets;
+
+        for( ; n > 0; n-- )
+        {
+            block_t *p_ts = TSStuffing( p_mux );
+            if( p_ts )
+                TSSendCBR( p_mux, p_ts );
+        }
+        TSSendCBR( p_mux, BufferChainGet( p_chain_ts ) );
+    }
+
+    TSReportCBR( p_mux, false );
+}
+
+/* Reports the stream and buffer model errors, at most every 10 seconds */
+static void TSReportCBR( sout_mux_t *p_mux, bool b_final )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    const uint64_t i_errors = p_sys->i_late_packets + p_sys->i_tb_overflow +
+                              p_sys->i_b_overflow + p_sys->i_b_underflow;
+    const mtime_t i_now = mdate();
+
+    if( !b_final && ( i_errors == p_sys->i_stats_reported ||
+                      i_now < p_sys->i_stats_report ) )
+        return;
+    p_sys->i_stats_report = i_now + CBR_REPORT_DELAY;
+    p_sys->i_stats_reported = i_errors;
+
+    if( i_errors > 0 )
+        msg_Warn( p_mux, "%"PRIu64" packets over the mux rate, T-STD: "
+                  "%"PRIu64" TB overflows, %"PRIu64" B overflows, "
+                  "%"PRIu64" B underflows",
+                  p_sys->i_late_packets, p_sys->i_tb_overflow,
+                  p_sys->i_b_overflow, p_sys->i_b_underflow );
+    if( b_final )
+    {
+        const int64_t i_us = 27 * p_sys->i_mux_rate; /* jitter units per us */
+
+        msg_Dbg( p_mux, "%"PRIu64" null packets, PCR interval up to "
+                 "%"PRId64" us, PCR jitter up to %"PRId64" ns",
+                 p_sys->i_null_packets, p_sys->i_pcr_interval_max / 27,
+                 ( p_sys->i_pcr_jitter_max * 1000 + i_us - 1 ) / i_us );
+    }
+}
+
 static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
                     mtime_t i_pcr_length, mtime_t i_pcr_dts )
 {
@@ -1931,6 +2561,12 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     int i_packet_count = p_chain_ts->i_depth;
     int i;
 
+    if( p_sys->i_mux_rate > 0 )
+    {
+        TSDateCBR( p_mux, p_chain_ts, i_pcr_length, i_pcr_dts );
+        return;
+    }
+
     if ( i_pcr_length / 1000 > 0 )
     {
         int i_bitrate = ((uint64_t)i_packet_count * 188 * 8000)
@@ -1971,7 +2607,7 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         if( p_ts->i_flags & BLOCK_FLAG_CLOCK )
         {
             /* msg_Dbg( p_mux, "pcr=%lld ms", p_ts->i_dts / 1000 ); */
-            TSSetPCR( p_ts, p_ts->i_dts - p_sys->i_dts_delay );
+            TSSetPCR( p_ts, ( p_ts->i_dts - p_sys->i_dts_delay ) * 27 );
         }
         if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
         {
@@ -1987,8 +2623,7 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     }
 }
 
-static block_t *TSNew( sout_mux_t *p_mux, ts_stream_t *p_stream,
-                       bool b_pcr )
+static block_t *TSNew( ts_stream_t *p_stream, bool b_pcr )
 {
     block_t *p_pes = p_stream->chain_pes.p_first;
     block_t *p_ts;
@@ -2011,7 +2646,7 @@ static block_t *TSNew( sout_mux_t *p_mux, ts_stream_t *p_stream,
         b_adaptation_field = true;
     }
 
-    p_ts = block_New( p_mux, 188 );
+    p_ts = TSPacketNew( &p_stream->arena );
     p_ts->i_dts = p_pes->i_dts;
 
     p_ts->p_buffer[0] = 0x47;
@@ -2106,15 +2741,117 @@ static block_t *TSNew( sout_mux_t *p_mux, ts_stream_t *p_stream,
     return p_ts;
 }
 
-static void TSSetPCR( block_t *p_ts, mtime_t i_dts )
+/* Builds the TS packets of a stream, up to i_max_dts, in the order the
+ * interleaving loop would build them. The dts used to interleave them is
+ * kept in i_pts until then. */
+static void TSPacketize( ts_stream_t *p_stream, mtime_t i_max_dts )
+{
+    while( p_stream->i_pes_dts != 0 && p_stream->i_pes_dts <= i_max_dts )
+    {
+        const mtime_t i_dts = p_stream->i_pes_dts;
+        block_t *p_ts = TSNew( p_stream, false );
+
+        if( p_stream->b_scrambled )
+            p_ts->i_flags |= BLOCK_FLAG_SCRAMBLED;
+        p_ts->i_pts = i_dts;
+        BufferChainAppend( &p_stream->chain_ts, p_ts );
+    }
+}
+
+/* Runs the pending jobs (lock_jobs must be held) */
+static void TSRunJobs( sout_mux_sys_t *p_sys )
 {
-    mtime_t i_pcr = 9 * i_dts / 100;
+    while( p_sys->i_job_next < p_sys->i_jobs )
+    {
+        ts_stream_t *p_stream = p_sys->pp_jobs[p_sys->i_job_next++];
+        const mtime_t i_max_dts = p_sys->i_job_dts;
+
+        vlc_mutex_unlock( &p_sys->lock_jobs );
+        TSPacketize( p_stream, i_max_dts );
+        vlc_mutex_lock( &p_sys->lock_jobs );
+
+        if( ++p_sys->i_jobs_done >= p_sys->i_jobs )
+            vlc_cond_signal( &p_sys->wait_done );
+    }
+}
+
+static void TSPacketizeAll( sout_mux_t *p_mux, ts_stream_t *p_pcr_stream,
+                            mtime_t i_max_dts )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    ts_stream_t *pp_jobs[p_mux->i_nb_inputs];
+    int i_jobs = 0;
 
-    p_ts->p_buffer[6]  = ( i_pcr >> 25 )&0xff;
-    p_ts->p_buffer[7]  = ( i_pcr >> 17 )&0xff;
-    p_ts->p_buffer[8]  = ( i_pcr >> 9  )&0xff;
-    p_ts->p_buffer[9]  = ( i_pcr >> 1  )&0xff;
-    p_ts->p_buffer[10]|= ( i_pcr << 7  )&0x80;
+    for( int i = 0; i < p_mux->i_nb_inputs; i++ )
+    {
+        ts_stream_t *p_stream = (ts_stream_t*)p_mux->pp_inputs[i]->p_sys;
+
+        if( p_stream != p_pcr_stream && p_stream->i_pes_dts != 0 &&
+            p_stream->i_pes_dts <= i_max_dts )
+            pp_jobs[i_jobs++] = p_stream;
+    }
+
+    if( p_sys->i_threads <= 0 || i_jobs < 2 )
+    {
+        for( int i = 0; i < i_jobs; i++ )
+            TSPacketize( pp_jobs[i], i_max_dts );
+        return;
+    }
+
+    vlc_mutex_lock( &p_sys->lock_jobs );
+    p_sys->pp_jobs = pp_jobs;
+    p_sys->i_jobs = i_jobs;
+    p_sys->i_job_next = 0;
+    p_sys->i_jobs_done = 0;
+    p_sys->i_job_dts = i_max_dts;
+    p_sys->i_job_generation++;
+    /* One signal per thread wakes them all */
+    for( int i = 0; i < p_sys->i_threads; i++ )
+        vlc_cond_signal( &p_sys->wait_jobs );
+
+    TSRunJobs( p_sys );
+    while( p_sys->i_jobs_done < p_sys->i_jobs )
+        vlc_cond_wait( &p_sys->wait_done, &p_sys->lock_jobs );
+    p_sys->pp_jobs = NULL;
+    p_sys->i_jobs = 0;
+    vlc_mutex_unlock( &p_sys->lock_jobs );
+}
+
+static void* TSThread( vlc_object_t *p_this )
+{
+    ts_thread_t *p_thread = (ts_thread_t *)p_this;
+    sout_mux_sys_t *p_sys = p_thread->p_mux->p_sys;
+    unsigned i_generation = 0;
+
+    vlc_mutex_lock( &p_sys->lock_jobs );
+    for( ;; )
+    {
+        while( vlc_object_alive( p_thread ) &&
+               i_generation == p_sys->i_job_generation )
+            vlc_cond_wait( &p_sys->wait_jobs, &p_sys->lock_jobs );
+        if( !vlc_object_alive( p_thread ) )
+            break;
+
+        i_generation = p_sys->i_job_generation;
+        TSRunJobs( p_sys );
+    }
+    vlc_mutex_unlock( &p_sys->lock_jobs );
+    return NULL;
+}
+
+/* i_pcr is in 27 MHz units */
+static void TSSetPCR( block_t *p_ts, int64_t i_pcr )
+{
+    const int64_t i_base = i_pcr / 300;
+    const int     i_ext  = i_pcr % 300;
+
+    p_ts->p_buffer[6]  = ( i_base >> 25 )&0xff;
+    p_ts->p_buffer[7]  = ( i_base >> 17 )&0xff;
+    p_ts->p_buffer[8]  = ( i_base >> 9  )&0xff;
+    p_ts->p_buffer[9]  = ( i_base >> 1  )&0xff;
+    p_ts->p_buffer[10] = ( ( i_base << 7 )&0x80 ) | 0x7e |
+                         ( ( i_ext >> 8 )&0x01 );
+    p_ts->p_buffer[11] = i_ext & 0xff;
 }
 
 #if 0
@@ -2205,8 +2942,7 @@ static void TSSetConstraints( sout_mux_t *p_mux, sout_buffer_chain_t *c,
 }
 #endif
 
-static void PEStoTS( sout_instance_t *p_sout,
-                     sout_buffer_chain_t *c, block_t *p_pes,
+static void PEStoTS( sout_buffer_chain_t *c, block_t *p_pes,
                      ts_stream_t *p_stream )
 {
     uint8_t *p_data;
@@ -2225,7 +2961,7 @@ static void PEStoTS( sout_instance_t *p_sout,
         int           i_copy;
         block_t *p_ts;
 
-        p_ts = block_New( p_sout, 188 );
+        p_ts = TSPacketNew( &p_stream->arena );
         /* write header
          * 8b   0x47    sync byte
          * 1b           transport_error_indicator
@@ -2350,7 +3086,7 @@ static void GetPAT( sout_mux_t *p_mux,
 
     p_pat = WritePSISection( p_mux->p_sout, p_section );
 
-    PEStoTS( p_mux->p_sout, c, p_pat, &p_sys->pat );
+    PEStoTS( c, p_pat, &p_sys->pat );
 
     dvbpsi_DeletePSISections( p_section );
     dvbpsi_EmptyPAT( &pat );
@@ -2742,7 +3478,7 @@ static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
     {
         p_section[i] = dvbpsi_GenPMTSections( &p_sys->dvbpmt[i] );
         p_pmt[i] = WritePSISection( p_mux->p_sout, p_section[i] );
-        PEStoTS( p_mux->p_sout, c, p_pmt[i], &p_sys->pmt[i] );
+        PEStoTS( c, p_pmt[i], &p_sys->pmt[i] );
         dvbpsi_DeletePSISections( p_section[i] );
         dvbpsi_EmptyPMT( &p_sys->dvbpmt[i] );
     }
@@ -2752,7 +3488,7 @@ static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
     {
         p_section2 = dvbpsi_GenSDTSections( &sdt );
         p_sdt = WritePSISection( p_mux->p_sout, p_section2 );
-        PEStoTS( p_mux->p_sout, c, p_sdt, &p_sys->sdt );
+        PEStoTS( c, p_sdt, &p_sys->sdt );
         dvbpsi_DeletePSISections( p_section2 );
         dvbpsi_EmptySDT( &sdt );
     }
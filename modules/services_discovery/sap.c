@@ -79,6 +79,12 @@
 #define SAP_V4_LINK_ADDRESS     "224.0.0.255"
 #define ADD_SESSION 1
 
+/* Announces are indexed by (source, message id hash) and by session origin */
+#define SAP_HASH_SIZE 1024
+/* Expiry timer wheel: one slot per second */
+#define SAP_WHEEL_SIZE 256
+#define SAP_WHEEL_TICK INT64_C(1000000)
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -224,10 +230,19 @@ struct sap_announce_t
     uint16_t    i_hash;
     uint32_t    i_source[4];
 
+    /* Payload as received (possibly compressed), to spot unchanged
+     * refreshes without decompressing or parsing them again */
+    uint8_t     *p_raw;
+    size_t      i_raw;
+
     /* SAP annnounces must only contain one SDP */
     sdp_t       *p_sdp;
 
     input_item_t * p_item;
+
+    sap_announce_t *p_next_msg;     /* same (source, id hash) bucket */
+    sap_announce_t *p_next_session; /* same session origin bucket */
+    sap_announce_t *p_next_timer;   /* same timer wheel slot */
 };
 
 struct services_discovery_sys_t
@@ -238,7 +253,13 @@ struct services_discovery_sys_t
 
     /* Table of announces */
     int i_announces;
-    struct sap_announce_t **pp_announces;
+    sap_announce_t *pp_msgs[SAP_HASH_SIZE];
+    sap_announce_t *pp_sessions[SAP_HASH_SIZE];
+
+    /* Expiry timer wheel, checked lazily: an announce is only moved
+     * when its slot comes up */
+    sap_announce_t *pp_wheel[SAP_WHEEL_SIZE];
+    int64_t i_wheel_tick; /* next tick to check */
 
     /* Modes */
     bool  b_strict;
@@ -267,8 +288,19 @@ struct demux_sys_t
     static int ParseConnection( vlc_object_t *p_obj, sdp_t *p_sdp );
     static int ParseSAP( services_discovery_t *p_sd, const uint8_t *p_buffer, size_t i_read );
     static sdp_t *ParseSDP (vlc_object_t *p_sd, const char *psz_sdp);
-    static sap_announce_t *CreateAnnounce( services_discovery_t *, uint16_t, sdp_t * );
+    static sap_announce_t *CreateAnnounce( services_discovery_t *,
+                                           const uint32_t *, uint16_t,
+                                           const uint8_t *, size_t, sdp_t * );
     static int RemoveAnnounce( services_discovery_t *p_sd, sap_announce_t *p_announce );
+    static void RefreshAnnounce( sap_announce_t *p_announce );
+    static void ExpireAnnounces( services_discovery_t *p_sd, mtime_t now );
+
+/* Announce table functions */
+    static unsigned MsgHash( const uint32_t *pi_source, uint16_t i_hash );
+    static unsigned SessionHash( const sdp_t *p_sdp );
+    static void LinkMsg( services_discovery_sys_t *, sap_announce_t * );
+    static void TimerInsert( services_discovery_t *, sap_announce_t * );
+    static void UnlinkMsg( services_discovery_sys_t *, sap_announce_t * );
 
 /* Helper functions */
     static inline attribute_t *MakeAttribute (const char *str);
@@ -282,11 +314,6 @@ struct demux_sys_t
     static int Decompress( const unsigned char *psz_src, unsigned char **_dst, int i_len );
     static void FreeSDP( sdp_t *p_sdp );
 
-static inline int min_int( int a, int b )
-{
-    return a > b ? b : a;
-}
-
 static bool IsWellKnownPayload (int type)
 {
     switch (type)
@@ -310,7 +337,7 @@ static int Open( vlc_object_t *p_this )
 {
     services_discovery_t *p_sd = ( services_discovery_t* )p_this;
     services_discovery_sys_t *p_sys  = (services_discovery_sys_t *)
-                                malloc( sizeof( services_discovery_sys_t ) );
+                                calloc( 1, sizeof( services_discovery_sys_t ) );
     if( !p_sys )
         return VLC_ENOMEM;
 
@@ -339,7 +366,7 @@ static int Open( vlc_object_t *p_this )
     services_discovery_SetLocalizedName( p_sd, _("SAP") );
 
     p_sys->i_announces = 0;
-    p_sys->pp_announces = NULL;
+    p_sys->i_wheel_tick = mdate() / SAP_WHEEL_TICK;
 
     return VLC_SUCCESS;
 }
@@ -452,11 +479,11 @@ static void Close( vlc_object_t *p_this )
     }
 #endif
 
-    for( i = p_sys->i_announces  - 1;  i>= 0; i-- )
+    for( i = 0; i < SAP_HASH_SIZE; i++ )
     {
-        RemoveAnnounce( p_sd, p_sys->pp_announces[i] );
+        while( p_sys->pp_sessions[i] )
+            RemoveAnnounce( p_sd, p_sys->pp_sessions[i] );
     }
-    FREENULL( p_sys->pp_announces );
 
     free( p_sys );
 }
@@ -484,7 +511,6 @@ static void CloseDemux( vlc_object_t *p_this )
 static void Run( services_discovery_t *p_sd )
 {
     char *psz_addr;
-    int i;
     int timeout = -1;
 
     /* Braindead Winsock DNS resolver will get stuck over 2 seconds per failed
@@ -604,38 +630,25 @@ static void Run( services_discovery_t *p_sd )
 
         mtime_t now = mdate();
 
-        /* A 1 hour timeout correspong to the RFC Implicit timeout.
-         * This timeout is tuned in the following loop. */
-        timeout = 1000 * 60 * 60;
-
         /* Check for items that need deletion */
-        for( i = 0; i < p_sd->p_sys->i_announces; i++ )
-        {
-            mtime_t i_timeout = ( mtime_t ) 1000000 * p_sd->p_sys->i_timeout;
-            sap_announce_t * p_announce = p_sd->p_sys->pp_announces[i];
-            mtime_t i_last_period = now - p_announce->i_last;
-
-            /* Remove the annoucement, if the last announcement was 1 hour ago
-             * or if the last packet emitted was 3 times the average time
-             * between two packets */
-            if( ( p_announce->i_period_trust > 5 && i_last_period > 3 * p_announce->i_period ) ||
-                i_last_period > i_timeout )
-            {
-                RemoveAnnounce( p_sd, p_announce );
-            }
-            else
-            {
-                /* Compute next timeout */
-                if( p_announce->i_period_trust > 5 )
-                    timeout = min_int((3 * p_announce->i_period - i_last_period) / 1000, timeout);
-                timeout = min_int((i_timeout - i_last_period)/1000, timeout);
-            }
-        }
+        ExpireAnnounces( p_sd, now );
 
         if( !p_sd->p_sys->i_announces )
             timeout = -1; /* We can safely poll indefinitly. */
-        else if( timeout < 200 )
-            timeout = 200; /* Don't wakeup too fast. */
+        else
+        {
+            /* Wake up for the next slot of the wheel that is not empty */
+            services_discovery_sys_t *p_sys = p_sd->p_sys;
+            int64_t i_tick = p_sys->i_wheel_tick;
+
+            while( !p_sys->pp_wheel[i_tick % SAP_WHEEL_SIZE] &&
+                   i_tick < p_sys->i_wheel_tick + SAP_WHEEL_SIZE )
+                i_tick++;
+
+            timeout = (i_tick * SAP_WHEEL_TICK - now) / 1000 + 1;
+            if( timeout < 200 )
+                timeout = 200; /* Don't wakeup too fast. */
+        }
     }
 }
 
@@ -687,7 +700,8 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
 static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
                      size_t len )
 {
-    int i;
+    services_discovery_sys_t *p_sys = p_sd->p_sys;
+    sap_announce_t      *p_announce;
     const char          *psz_sdp;
     const uint8_t *end = buf + len;
     sdp_t               *p_sdp;
@@ -723,10 +737,29 @@ static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
     }
 
     // Skips source address and auth data
+    const uint8_t *p_source = buf + 4;
     buf += 4 + (b_ipv6 ? 16 : 4) + buf[1];
     if (buf > end)
         return VLC_EGENERIC;
 
+    uint32_t i_source[4] = { 0, 0, 0, 0 };
+    memcpy (i_source, p_source, b_ipv6 ? 16 : 4);
+
+    /* Unchanged refresh of a known announce: no need to parse it again */
+    for( p_announce = p_sys->pp_msgs[MsgHash( i_source, i_hash )];
+         p_announce != NULL; p_announce = p_announce->p_next_msg )
+    {
+        if( p_announce->i_hash == i_hash
+         && !memcmp( p_announce->i_source, i_source, sizeof( i_source ) )
+         && p_announce->i_raw == (size_t)(end - buf)
+         && !memcmp( p_announce->p_raw, buf, p_announce->i_raw ) )
+        {
+            if( !b_need_delete )
+                RefreshAnnounce( p_announce );
+            return VLC_SUCCESS;
+        }
+    }
+
     uint8_t *decomp = NULL;
     if( b_compressed )
     {
@@ -760,12 +793,16 @@ static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
         if (strcmp (psz_sdp, "application/sdp"))
         {
             msg_Dbg (p_sd, "unsupported content type: %s", psz_sdp);
+            free (decomp);
             return VLC_EGENERIC;
         }
 
         // skips content type
         if (len <= clen)
+        {
+            free (decomp);
             return VLC_EGENERIC;
+        }
 
         len -= clen;
         psz_sdp += clen;
@@ -775,7 +812,10 @@ static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
     p_sdp = ParseSDP( VLC_OBJECT(p_sd), psz_sdp );
 
     if( p_sdp == NULL )
+    {
+        free (decomp);
         return VLC_EGENERIC;
+    }
 
     p_sdp->psz_sdp = psz_sdp;
 
@@ -795,13 +835,13 @@ static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
     if( p_sdp->psz_uri == NULL )
     {
         FreeSDP( p_sdp );
+        free (decomp);
         return VLC_EGENERIC;
     }
 
-    for( i = 0 ; i< p_sd->p_sys->i_announces ; i++ )
+    for( p_announce = p_sys->pp_sessions[SessionHash( p_sdp )];
+         p_announce != NULL; p_announce = p_announce->p_next_session )
     {
-        sap_announce_t * p_announce = p_sd->p_sys->pp_announces[i];
-        /* FIXME: slow */
         /* FIXME: we create a new announce each time the sdp changes */
         if( IsSameSession( p_announce->p_sdp, p_sdp ) )
         {
@@ -810,34 +850,43 @@ static int ParseSAP( services_discovery_t *p_sd, const uint8_t *buf,
              * Intead we cleverly implement Implicit Announcement removal.
              *
              * if( b_need_delete )
-             *    RemoveAnnounce( p_sd, p_sd->p_sys->pp_announces[i]);
+             *    RemoveAnnounce( p_sd, p_announce );
              * else
              */
 
             if( !b_need_delete )
             {
-                /* No need to go after six, as we start to trust the
-                 * average period at six */
-                if( p_announce->i_period_trust <= 5 )
-                    p_announce->i_period_trust++;
-
-                /* Compute the average period */
-                mtime_t now = mdate();
-                p_announce->i_period = (p_announce->i_period + (now - p_announce->i_last)) / 2;
-                p_announce->i_last = now;
+                RefreshAnnounce( p_announce );
+
+                /* Recognize the next refreshes of this version */
+                uint8_t *p_raw = malloc( end - buf );
+                if( p_raw != NULL )
+                {
+                    memcpy( p_raw, buf, end - buf );
+                    UnlinkMsg( p_sys, p_announce );
+                    free( p_announce->p_raw );
+                    p_announce->p_raw = p_raw;
+                    p_announce->i_raw = end - buf;
+                    p_announce->i_hash = i_hash;
+                    memcpy( p_announce->i_source, i_source, sizeof( i_source ) );
+                    LinkMsg( p_sys, p_announce );
+                }
             }
             FreeSDP( p_sdp ); p_sdp = NULL;
+            free (decomp);
             return VLC_SUCCESS;
         }
     }
 
-    CreateAnnounce( p_sd, i_hash, p_sdp );
+    CreateAnnounce( p_sd, i_source, i_hash, buf, end - buf, p_sdp );
 
     FREENULL (decomp);
     return VLC_SUCCESS;
 }
 
-sap_announce_t *CreateAnnounce( services_discovery_t *p_sd, uint16_t i_hash,
+sap_announce_t *CreateAnnounce( services_discovery_t *p_sd,
+                                const uint32_t *pi_source, uint16_t i_hash,
+                                const uint8_t *p_raw, size_t i_raw,
                                 sdp_t *p_sdp )
 {
     input_item_t *p_input;
@@ -854,8 +903,18 @@ sap_announce_t *CreateAnnounce( services_discovery_t *p_sd, uint16_t i_hash,
     p_sap->i_period = 0;
     p_sap->i_period_trust = 0;
     p_sap->i_hash = i_hash;
+    memcpy( p_sap->i_source, pi_source, sizeof( p_sap->i_source ) );
     p_sap->p_sdp = p_sdp;
 
+    p_sap->p_raw = malloc( i_raw );
+    if( p_sap->p_raw == NULL )
+    {
+        free( p_sap );
+        return NULL;
+    }
+    memcpy( p_sap->p_raw, p_raw, i_raw );
+    p_sap->i_raw = i_raw;
+
     /* Released in RemoveAnnounce */
     p_input = input_item_NewWithType( VLC_OBJECT(p_sd),
                                      p_sap->p_sdp->psz_uri,
@@ -864,6 +923,7 @@ sap_announce_t *CreateAnnounce( services_discovery_t *p_sd, uint16_t i_hash,
     p_sap->p_item = p_input;
     if( !p_input )
     {
+        free( p_sap->p_raw );
         free( p_sap );
         return NULL;
     }
@@ -890,7 +950,12 @@ sap_announce_t *CreateAnnounce( services_discovery_t *p_sd, uint16_t i_hash,
 
     services_discovery_AddItem( p_sd, p_input, psz_value /* category name */ );
 
-    TAB_APPEND( p_sys->i_announces, p_sys->pp_announces, p_sap );
+    unsigned i_session = SessionHash( p_sdp );
+    p_sap->p_next_session = p_sys->pp_sessions[i_session];
+    p_sys->pp_sessions[i_session] = p_sap;
+    LinkMsg( p_sys, p_sap );
+    TimerInsert( p_sd, p_sap );
+    p_sys->i_announces++;
 
     return p_sap;
 }
@@ -1511,13 +1576,8 @@ static void FreeSDP( sdp_t *p_sdp )
 static int RemoveAnnounce( services_discovery_t *p_sd,
                            sap_announce_t *p_announce )
 {
-    int i;
-
-    if( p_announce->p_sdp )
-    {
-        FreeSDP( p_announce->p_sdp );
-        p_announce->p_sdp = NULL;
-    }
+    services_discovery_sys_t *p_sys = p_sd->p_sys;
+    sap_announce_t **pp;
 
     if( p_announce->p_item )
     {
@@ -1526,21 +1586,144 @@ static int RemoveAnnounce( services_discovery_t *p_sd,
         p_announce->p_item = NULL;
     }
 
-    for( i = 0; i< p_sd->p_sys->i_announces; i++)
+    UnlinkMsg( p_sys, p_announce );
+    for( pp = &p_sys->pp_sessions[SessionHash( p_announce->p_sdp )];
+         *pp != NULL; pp = &(*pp)->p_next_session )
     {
-        if( p_sd->p_sys->pp_announces[i] == p_announce )
+        if( *pp == p_announce )
         {
-            REMOVE_ELEM( p_sd->p_sys->pp_announces, p_sd->p_sys->i_announces,
-                         i);
+            *pp = p_announce->p_next_session;
             break;
         }
     }
+    p_sys->i_announces--;
 
+    FreeSDP( p_announce->p_sdp );
+    free( p_announce->p_raw );
     free( p_announce );
 
     return VLC_SUCCESS;
 }
 
+static void RefreshAnnounce( sap_announce_t *p_announce )
+{
+    /* No need to go after six, as we start to trust the
+     * average period at six */
+    if( p_announce->i_period_trust <= 5 )
+        p_announce->i_period_trust++;
+
+    /* Compute the average period */
+    mtime_t now = mdate();
+    p_announce->i_period = (p_announce->i_period + (now - p_announce->i_last)) / 2;
+    p_announce->i_last = now;
+}
+
+/* Remove the annoucement, if the last announcement was 1 hour ago
+ * or if the last packet emitted was 3 times the average time
+ * between two packets */
+static mtime_t ExpiryDate( services_discovery_t *p_sd,
+                           const sap_announce_t *p_announce )
+{
+    mtime_t i_date = p_announce->i_last
+                   + (mtime_t)1000000 * p_sd->p_sys->i_timeout;
+
+    if( p_announce->i_period_trust > 5 &&
+        p_announce->i_last + 3 * p_announce->i_period < i_date )
+        i_date = p_announce->i_last + 3 * p_announce->i_period;
+    return i_date;
+}
+
+/* Puts an announce in the wheel slot of its expiry date. Dates more than
+ * SAP_WHEEL_SIZE ticks ahead wrap around, and are only checked again. */
+static void TimerInsert( services_discovery_t *p_sd,
+                         sap_announce_t *p_announce )
+{
+    services_discovery_sys_t *p_sys = p_sd->p_sys;
+    int64_t i_tick = ExpiryDate( p_sd, p_announce ) / SAP_WHEEL_TICK + 1;
+    sap_announce_t **pp_slot;
+
+    if( i_tick < p_sys->i_wheel_tick )
+        i_tick = p_sys->i_wheel_tick;
+    pp_slot = &p_sys->pp_wheel[i_tick % SAP_WHEEL_SIZE];
+    p_announce->p_next_timer = *pp_slot;
+    *pp_slot = p_announce;
+}
+
+static void ExpireAnnounces( services_discovery_t *p_sd, mtime_t now )
+{
+    services_discovery_sys_t *p_sys = p_sd->p_sys;
+    int64_t i_now_tick = now / SAP_WHEEL_TICK;
+
+    /* After a long sleep, every slot needs to be checked only once */
+    if( p_sys->i_wheel_tick < i_now_tick - SAP_WHEEL_SIZE + 1 )
+        p_sys->i_wheel_tick = i_now_tick - SAP_WHEEL_SIZE + 1;
+
+    while( p_sys->i_wheel_tick <= i_now_tick )
+    {
+        sap_announce_t **pp_slot =
+            &p_sys->pp_wheel[p_sys->i_wheel_tick % SAP_WHEEL_SIZE];
+        sap_announce_t *p_announce = *pp_slot;
+
+        *pp_slot = NULL;
+        p_sys->i_wheel_tick++;
+
+        while( p_announce != NULL )
+        {
+            sap_announce_t *p_next = p_announce->p_next_timer;
+
+            if( ExpiryDate( p_sd, p_announce ) < now )
+                RemoveAnnounce( p_sd, p_announce );
+            else
+                TimerInsert( p_sd, p_announce );
+            p_announce = p_next;
+        }
+    }
+}
+
+static unsigned MsgHash( const uint32_t *pi_source, uint16_t i_hash )
+{
+    unsigned i_key = i_hash;
+
+    for( int i = 0; i < 4; i++ )
+        i_key = i_key * 31 + pi_source[i];
+    return (i_key ^ (i_key >> 16)) % SAP_HASH_SIZE;
+}
+
+static unsigned SessionHash( const sdp_t *p_sdp )
+{
+    unsigned i_key = p_sdp->session_id ^ (p_sdp->session_id >> 32);
+
+    for( const char *psz = p_sdp->orig_host; *psz; psz++ )
+        i_key = i_key * 31 + (unsigned char)*psz;
+    return (i_key ^ (i_key >> 16)) % SAP_HASH_SIZE;
+}
+
+static void LinkMsg( services_discovery_sys_t *p_sys,
+                     sap_announce_t *p_announce )
+{
+    unsigned i_msg = MsgHash( p_announce->i_source, p_announce->i_hash );
+
+    p_announce->p_next_msg = p_sys->pp_msgs[i_msg];
+    p_sys->pp_msgs[i_msg] = p_announce;
+}
+
+static void UnlinkMsg( services_discovery_sys_t *p_sys,
+                       sap_announce_t *p_announce )
+{
+    sap_announce_t **pp;
+
+    for( pp = &p_sys->pp_msgs[MsgHash( p_announce->i_source,
+                                       p_announce->i_hash )];
+         *pp != NULL; pp = &(*pp)->p_next_msg )
+    {
+        if( *pp == p_announce )
+        {
+            *pp = p_announce->p_next_msg;
+            break;
+        }
+    }
+}
+
 static bool IsSameSession( sdp_t *p_sdp1, sdp_t *p_sdp2 )
 {
     /* A session is identified by
@@ -416,6 +416,8 @@ static sout_stream_id_t * Add( sout_stream_t *p_stream, es_format_t *p_fmt )
     p_es->p_picture = NULL;
     p_es->pp_last = &p_es->p_picture;
     p_es->b_empty = false;
+    p_es->i_tile_width = p_es->i_tile_height = 0;
+    p_es->b_tile_ar = false;
 
     vlc_mutex_unlock( p_sys->p_lock );
 
@@ -553,6 +555,33 @@ static void PushPicture( sout_stream_t *p_stream, picture_t *p_picture )
     vlc_mutex_unlock( p_sys->p_lock );
 }
 
+/*****************************************************************************
+ * GetTileSize : size of a picture in the tile of the mosaic, 0 if unknown
+ *****************************************************************************/
+static void GetTileSize( sout_stream_t *p_stream, const picture_t *p_pic,
+                         unsigned int *pi_width, unsigned int *pi_height )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    bridged_es_t *p_es = p_sys->p_es;
+    unsigned int i_tile_width, i_tile_height;
+    bool b_ar;
+
+    vlc_mutex_lock( p_sys->p_lock );
+    i_tile_width = p_es->i_tile_width;
+    i_tile_height = p_es->i_tile_height;
+    b_ar = p_es->b_tile_ar;
+    vlc_mutex_unlock( p_sys->p_lock );
+
+    if( !i_tile_width || !i_tile_height )
+    {
+        *pi_width = *pi_height = 0;
+        return;
+    }
+    mosaic_TileSize( i_tile_width, i_tile_height, b_ar,
+                     p_pic->format.i_width, p_pic->format.i_height,
+                     pi_width, pi_height );
+}
+
 static int Send( sout_stream_t *p_stream, sout_stream_id_t *id,
                  block_t *p_buffer )
 {
@@ -569,8 +598,14 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_t *id,
                                                         &p_buffer )) )
     {
         picture_t *p_new_pic;
+        unsigned int i_tile_width = 0, i_tile_height = 0;
+
+        /* Without a size of our own, scale to the tile of the mosaic here
+         * rather than in the mosaic thread */
+        if( !p_sys->i_height && !p_sys->i_width )
+            GetTileSize( p_stream, p_pic, &i_tile_width, &i_tile_height );
 
-        if( p_sys->i_height || p_sys->i_width )
+        if( p_sys->i_height || p_sys->i_width || i_tile_width )
         {
             video_format_t fmt_out, fmt_in;
 
@@ -581,10 +616,19 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_t *id,
 
             if( p_sys->i_chroma )
                 fmt_out.i_chroma = p_sys->i_chroma;
+            else if( i_tile_width &&
+                     ( fmt_in.i_chroma == VLC_FOURCC('Y','U','V','A') ||
+                       fmt_in.i_chroma == VLC_FOURCC('R','G','B','A') ) )
+                fmt_out.i_chroma = VLC_FOURCC('Y','U','V','A');
             else
                 fmt_out.i_chroma = VLC_FOURCC('I','4','2','0');
 
-            if ( !p_sys->i_height )
+            if ( i_tile_width )
+            {
+                fmt_out.i_width = i_tile_width;
+                fmt_out.i_height = i_tile_height;
+            }
+            else if ( !p_sys->i_height )
             {
                 fmt_out.i_width = p_sys->i_width;
                 fmt_out.i_height = (p_sys->i_width * VOUT_ASPECT_FACTOR
@@ -606,6 +650,8 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_t *id,
             fmt_out.i_visible_width = fmt_out.i_width;
             fmt_out.i_visible_height = fmt_out.i_height;
 
+            if( !p_sys->p_image )
+                p_sys->p_image = image_HandlerCreate( p_stream );
             p_new_pic = image_Convert( p_sys->p_image,
                                        p_pic, &fmt_in, &fmt_out );
             if ( p_new_pic == NULL )
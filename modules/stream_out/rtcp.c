@@ -197,16 +197,22 @@ void CloseRTCP (rtcp_sender_t *rtcp)
 }
 
 
-void SendRTCP (rtcp_sender_t *restrict rtcp, const block_t *rtp)
+/**
+ * Accounts for RTP packets sent, and sends a Sender Report if it is time.
+ * @param rtp_header the (12 bytes) header of the last packet sent
+ * @param packets number of packets sent since the previous call
+ * @param bytes size of these packets
+ */
+void SendRTCP (rtcp_sender_t *restrict rtcp, const uint8_t *rtp_header,
+               unsigned packets, size_t bytes)
 {
-    if ((rtcp == NULL) /* RTCP sender off */
-     || (rtp->i_buffer < 12)) /* too short RTP packet */
+    if (rtcp == NULL) /* RTCP sender off */
         return;
 
     /* Updates statistics */
-    rtcp->packets++;
-    rtcp->bytes += rtp->i_buffer;
-    rtcp->counter += rtp->i_buffer;
+    rtcp->packets += packets;
+    rtcp->bytes += bytes;
+    rtcp->counter += bytes;
 
     /* 1.25% rate limit */
     if ((rtcp->counter / 80) < rtcp->length)
@@ -218,12 +224,12 @@ void SendRTCP (rtcp_sender_t *restrict rtcp, const block_t *rtp)
     if ((now64 >> 32) < (last + 5))
         return; // no more than one SR every 5 seconds
 
-    memcpy (ptr + 4, rtp->p_buffer + 8, 4); /* SR SSRC */
+    memcpy (ptr + 4, rtp_header + 8, 4); /* SR SSRC */
     SetQWBE (ptr + 8, now64);
-    memcpy (ptr + 16, rtp->p_buffer + 4, 4); /* RTP timestamp */
+    memcpy (ptr + 16, rtp_header + 4, 4); /* RTP timestamp */
     SetDWBE (ptr + 20, rtcp->packets);
     SetDWBE (ptr + 24, rtcp->bytes);
-    memcpy (ptr + 28 + 4, rtp->p_buffer + 8, 4); /* SDES SSRC */
+    memcpy (ptr + 28 + 4, rtp_header + 8, 4); /* SDES SSRC */
 
     if (send (rtcp->handle, ptr, rtcp->length, 0) == (ssize_t)rtcp->length)
         rtcp->counter = 0;
@@ -139,6 +139,13 @@
 #define SRTP_SALT_LONGTEXT N_( \
     "Secure RTP requires a (non-secret) master salt value.")
 
+#define FANOUT_TEXT N_("Fan-out to sessions")
+#define FANOUT_LONGTEXT N_( \
+    "Send the stream to the destinations listed by the \"rtp-fanout\" " \
+    "variable of the input, each with its own SSRC and sequence numbers. " \
+    "This is used by the VLM to share one live input between the sessions " \
+    "of a VoD media." )
+
 static const char *const ppsz_protos[] = {
     "dccp", "sctp", "tcp", "udp", "udplite",
 };
@@ -209,6 +216,9 @@ vlc_module_begin();
     add_bool( SOUT_CFG_PREFIX "mp4a-latm", 0, NULL, RFC3016_TEXT,
                  RFC3016_LONGTEXT, false );
 
+    add_bool( SOUT_CFG_PREFIX "fanout", false, NULL, FANOUT_TEXT,
+              FANOUT_LONGTEXT, true );
+
     set_callbacks( Open, Close );
 vlc_module_end();
 
@@ -219,7 +229,7 @@ static const char *const ppsz_sout_options[] = {
     "dst", "name", "port", "port-audio", "port-video", "*sdp", "ttl", "mux",
     "sap", "description", "url", "email", "phone",
     "proto", "rtcp-mux", "key", "salt",
-    "mp4a-latm", NULL
+    "mp4a-latm", "fanout", NULL
 };
 
 static sout_stream_id_t *Add ( sout_stream_t *, es_format_t * );
@@ -240,6 +250,11 @@ static int SapSetup( sout_stream_t *p_stream );
 static int FileSetup( sout_stream_t *p_stream );
 static int HttpSetup( sout_stream_t *p_stream, const vlc_url_t * );
 
+static int  FanoutCallback( vlc_object_t *, char const *,
+                            vlc_value_t, vlc_value_t, void * );
+static void FanoutUpdate( sout_stream_t *, const char * );
+static void FanoutAddId( sout_stream_t *, sout_stream_id_t * );
+
 struct sout_stream_sys_t
 {
     /* SDP */
@@ -261,6 +276,12 @@ struct sout_stream_sys_t
     /* RTSP */
     rtsp_stream_t *rtsp;
 
+    /* Sessions of the input "rtp-fanout" variable */
+    vlc_object_t    *p_fanout;
+    vlc_mutex_t      lock_fanout;
+    int              i_fanout;
+    struct rtp_fanout_t **fanout;
+
     /* */
     char     *psz_destination;
     uint8_t   proto;
@@ -287,12 +308,35 @@ struct sout_stream_sys_t
 
 typedef int (*pf_rtp_packetizer_t)( sout_stream_id_t *, block_t * );
 
+typedef struct rtp_fanout_t
+{
+    char     *psz_name;
+    char     *psz_dst;
+    uint16_t  i_port;
+    uint16_t  i_port_audio;
+    uint16_t  i_port_video;
+    bool      b_seen;
+} rtp_fanout_t;
+
 typedef struct rtp_sink_t
 {
     int rtp_fd;
     rtcp_sender_t *rtcp;
+    /* Fan-out sinks rewrite the SSRC and sequence number of each packet */
+    const rtp_fanout_t *fanout;
+    uint16_t seq_delta;
+    uint8_t  ssrc[4];
+    /* Statistics */
+    uint64_t i_packets;
+    uint64_t i_bytes;
+    uint64_t i_dropped;
 } rtp_sink_t;
 
+/* HMAC-SHA1 authentication tag length, reserved after each packet */
+#define SRTP_TAG_LEN 10
+/* Maximum number of packets sent in one go */
+#define RTP_BATCH_MAX 64
+
 struct sout_stream_id_t
 {
     VLC_COMMON_MEMBERS
@@ -339,6 +383,7 @@ static int Open( vlc_object_t *p_this )
     config_chain_t      *p_cfg = NULL;
     char                *psz;
     bool          b_rtsp = false;
+    bool          b_fanout;
 
     config_ChainParse( p_stream, SOUT_CFG_PREFIX,
                        ppsz_sout_options, p_stream->p_cfg );
@@ -421,7 +466,15 @@ static int Open( vlc_object_t *p_this )
     free (psz);
     var_Create (p_this, "dccp-service", VLC_VAR_STRING);
 
-    if( ( p_sys->psz_destination == NULL ) && !b_rtsp )
+    b_fanout = var_GetBool( p_stream, SOUT_CFG_PREFIX "fanout" );
+    if( b_fanout && p_sys->proto != IPPROTO_UDP
+                 && p_sys->proto != IPPROTO_UDPLITE )
+    {
+        msg_Warn( p_stream, "fan-out is only supported over datagrams" );
+        b_fanout = false;
+    }
+
+    if( ( p_sys->psz_destination == NULL ) && !b_rtsp && !b_fanout )
     {
         msg_Err( p_stream, "missing destination and not in RTSP mode" );
         free( p_sys );
@@ -457,6 +510,10 @@ static int Open( vlc_object_t *p_this )
 
     vlc_mutex_init( &p_sys->lock_sdp );
     vlc_mutex_init( &p_sys->lock_es );
+    vlc_mutex_init( &p_sys->lock_fanout );
+    p_sys->p_fanout = NULL;
+    p_sys->i_fanout = 0;
+    p_sys->fanout = NULL;
 
     psz = var_GetNonEmptyString( p_stream, SOUT_CFG_PREFIX "mux" );
     if( psz != NULL )
@@ -472,6 +529,7 @@ static int Open( vlc_object_t *p_this )
             free( psz );
             vlc_mutex_destroy( &p_sys->lock_sdp );
             vlc_mutex_destroy( &p_sys->lock_es );
+            vlc_mutex_destroy( &p_sys->lock_fanout );
             free( p_sys );
             return VLC_EGENERIC;
         }
@@ -486,6 +544,7 @@ static int Open( vlc_object_t *p_this )
             sout_AccessOutDelete( p_sys->p_grab );
             vlc_mutex_destroy( &p_sys->lock_sdp );
             vlc_mutex_destroy( &p_sys->lock_es );
+            vlc_mutex_destroy( &p_sys->lock_fanout );
             free( p_sys );
             return VLC_EGENERIC;
         }
@@ -497,6 +556,7 @@ static int Open( vlc_object_t *p_this )
             sout_AccessOutDelete( p_sys->p_grab );
             vlc_mutex_destroy( &p_sys->lock_sdp );
             vlc_mutex_destroy( &p_sys->lock_es );
+            vlc_mutex_destroy( &p_sys->lock_fanout );
             free( p_sys );
             return VLC_EGENERIC;
         }
@@ -544,6 +604,23 @@ static int Open( vlc_object_t *p_this )
         free( psz );
     }
 
+    /* The destinations are set by the VLM on the input, maybe before the
+     * stream output is opened */
+    if( b_fanout )
+        p_sys->p_fanout = vlc_object_find( p_stream, VLC_OBJECT_INPUT,
+                                           FIND_PARENT );
+    if( p_sys->p_fanout != NULL )
+    {
+        var_Create( p_sys->p_fanout, "rtp-fanout", VLC_VAR_STRING );
+        var_AddCallback( p_sys->p_fanout, "rtp-fanout", FanoutCallback,
+                         p_stream );
+        psz = var_GetString( p_sys->p_fanout, "rtp-fanout" );
+        FanoutUpdate( p_stream, psz );
+        free( psz );
+    }
+    else if( b_fanout )
+        msg_Warn( p_stream, "no input to fan out" );
+
     /* update p_sout->i_out_pace_nocontrol */
     p_stream->p_sout->i_out_pace_nocontrol++;
 
@@ -561,6 +638,16 @@ static void Close( vlc_object_t * p_this )
     /* update p_sout->i_out_pace_nocontrol */
     p_stream->p_sout->i_out_pace_nocontrol--;
 
+    if( p_sys->p_fanout != NULL )
+    {
+        var_DelCallback( p_sys->p_fanout, "rtp-fanout", FanoutCallback,
+                         p_stream );
+        var_Destroy( p_sys->p_fanout, "rtp-fanout" );
+        vlc_object_release( p_sys->p_fanout );
+        p_sys->p_fanout = NULL;
+        FanoutUpdate( p_stream, "" );
+    }
+
     if( p_sys->p_mux )
     {
         assert( p_sys->i_es == 1 );
@@ -584,6 +671,7 @@ static void Close( vlc_object_t * p_this )
 
     vlc_mutex_destroy( &p_sys->lock_sdp );
     vlc_mutex_destroy( &p_sys->lock_es );
+    vlc_mutex_destroy( &p_sys->lock_fanout );
 
     if( p_sys->p_httpd_file )
         httpd_FileDelete( p_sys->p_httpd_file );
@@ -929,7 +1017,7 @@ static sout_stream_id_t *Add( sout_stream_t *p_stream, es_format_t *p_fmt )
     char *key = var_CreateGetNonEmptyString (p_stream, SOUT_CFG_PREFIX"key");
     if (key)
     {
-        id->srtp = srtp_create (SRTP_ENCR_AES_CM, SRTP_AUTH_HMAC_SHA1, 10,
+        id->srtp = srtp_create (SRTP_ENCR_AES_CM, SRTP_AUTH_HMAC_SHA1, SRTP_TAG_LEN,
                                    SRTP_PRF_AES_CM, SRTP_RCC_MODE1);
         if (id->srtp == NULL)
         {
@@ -1239,9 +1327,12 @@ static sout_stream_id_t *Add( sout_stream_t *p_stream, es_format_t *p_fmt )
         goto error;
 
     /* Update p_sys context */
+    vlc_mutex_lock( &p_sys->lock_fanout );
     vlc_mutex_lock( &p_sys->lock_es );
     TAB_APPEND( p_sys->i_es, p_sys->es, id );
     vlc_mutex_unlock( &p_sys->lock_es );
+    FanoutAddId( p_stream, id );
+    vlc_mutex_unlock( &p_sys->lock_fanout );
 
     psz_sdp = SDPGenerate( p_stream, NULL );
 
@@ -1275,9 +1366,11 @@ static int Del( sout_stream_t *p_stream, sout_stream_id_t *id )
         block_FifoRelease( id->p_fifo );
     }
 
+    vlc_mutex_lock( &p_sys->lock_fanout );
     vlc_mutex_lock( &p_sys->lock_es );
     TAB_REMOVE( p_sys->i_es, p_sys->es, id );
     vlc_mutex_unlock( &p_sys->lock_es );
+    vlc_mutex_unlock( &p_sys->lock_fanout );
 
     /* Release port */
     if( id->i_port == var_GetInteger( p_stream, "port-audio" ) )
@@ -1289,6 +1382,9 @@ static int Del( sout_stream_t *p_stream, sout_stream_id_t *id )
 
     if( id->rtsp_id )
         RtspDelId( p_sys->rtsp, id->rtsp_id );
+    for( int i = id->sinkc - 1; i >= 0; i-- )
+        if( id->sinkv[i].fanout != NULL )
+            rtp_del_sink( id, id->sinkv[i].rtp_fd );
     if( id->sinkc > 0 )
         rtp_del_sink( id, id->sinkv[0].rtp_fd ); /* sink for explicit dst= */
     if( id->listen_fd != NULL )
@@ -1431,8 +1527,6 @@ static int  HttpCallback( httpd_file_sys_t *p_args,
 /****************************************************************************
  * RTP send
  ****************************************************************************/
-static void* ThreadSend( vlc_object_t *p_this )
-{
 #ifdef WIN32
 # define ECONNREFUSED WSAECONNREFUSED
 # define ENOPROTOOPT  WSAENOPROTOOPT
@@ -1443,79 +1537,207 @@ static void* ThreadSend( vlc_object_t *p_this )
 # define EAGAIN       WSAEWOULDBLOCK
 # define EWOULDBLOCK  WSAEWOULDBLOCK
 #endif
+
+/* Soft errors (e.g. ICMP) are reported for an earlier packet: the current
+ * one was not sent and is tried again. Transient errors drop the packet.
+ * Any other error kills the sink. */
+static bool IsSoftError( int err )
+{
+    switch( err )
+    {
+        case ECONNREFUSED: /* Port unreachable */
+        case ENOPROTOOPT:
+#ifdef EPROTO
+        case EPROTO:       /* Protocol unreachable */
+#endif
+        case EHOSTUNREACH: /* Host unreachable */
+        case ENETUNREACH:  /* Network unreachable */
+        case ENETDOWN:     /* Entire network down */
+            return true;
+    }
+    return false;
+}
+
+static bool IsTransientError( int err )
+{
+    switch( err )
+    {
+        case ENOMEM: /* out of socket buffers */
+        case ENOBUFS:
+        case EAGAIN:
+#if (EAGAIN != EWOULDBLOCK)
+        case EWOULDBLOCK:
+#endif
+            return true;
+    }
+    return false;
+}
+
+/**
+ * Sends a batch of packets to one sink.
+ * @return false if the sink is dead
+ */
+static bool SendSink( sout_stream_id_t *id, rtp_sink_t *sink,
+                      block_t *const *pktv, unsigned pktc )
+{
+    /* Fan-out sinks have their own SSRC and sequence numbers, but the
+     * header cannot be changed once authenticated by SRTP */
+    const bool b_rewrite = sink->fanout != NULL && id->srtp == NULL;
+    uint8_t hdrv[pktc][12];
+    unsigned i_sent = 0;
+    uint64_t i_bytes = 0;
+
+    for( unsigned i = 0; i < pktc; i++ )
+    {
+        memcpy( hdrv[i], pktv[i]->p_buffer, 12 );
+        if( b_rewrite )
+        {
+            SetWBE( hdrv[i] + 2, GetWBE( hdrv[i] + 2 ) + sink->seq_delta );
+            memcpy( hdrv[i] + 8, sink->ssrc, 4 );
+        }
+    }
+
+#ifdef HAVE_SENDMMSG
+    /* The header and the payload are gathered, so that each sink sees its
+     * own header without copying the packets. */
+    struct iovec iov[pktc][2];
+    struct mmsghdr msgv[pktc];
+
+    memset( msgv, 0, sizeof( msgv ) );
+    for( unsigned i = 0; i < pktc; i++ )
+    {
+        iov[i][0].iov_base = hdrv[i];
+        iov[i][0].iov_len = 12;
+        iov[i][1].iov_base = pktv[i]->p_buffer + 12;
+        iov[i][1].iov_len = pktv[i]->i_buffer - 12;
+        msgv[i].msg_hdr.msg_iov = iov[i];
+        msgv[i].msg_hdr.msg_iovlen = 2;
+    }
+
+    for( unsigned i = 0; i < pktc; )
+    {
+        int val = sendmmsg( sink->rtp_fd, msgv + i, pktc - i, 0 );
+        if( val > 0 )
+        {
+            for( int j = 0; j < val; j++ )
+                i_bytes += pktv[i + j]->i_buffer;
+            i_sent += val;
+            i += val;
+            continue;
+        }
+
+        int err = net_errno;
+        if( IsSoftError( err ) &&
+            sendmsg( sink->rtp_fd, &msgv[i].msg_hdr, 0 ) >= 0 )
+        {
+            i_bytes += pktv[i]->i_buffer;
+            i_sent++;
+        }
+        else if( IsSoftError( err ) || IsTransientError( err ) )
+            sink->i_dropped++;
+        else
+            return false;
+        i++;
+    }
+#else
+    for( unsigned i = 0; i < pktc; i++ )
+    {
+        uint8_t *p = pktv[i]->p_buffer;
+        const size_t len = pktv[i]->i_buffer;
+        uint8_t orig[12];
+        ssize_t val;
+
+        memcpy( orig, p, 12 );
+        memcpy( p, hdrv[i], 12 );
+        val = send( sink->rtp_fd, p, len, 0 );
+        if( val < 0 && IsSoftError( net_errno ) )
+            val = send( sink->rtp_fd, p, len, 0 );
+        memcpy( p, orig, 12 );
+
+        if( val >= 0 )
+        {
+            i_bytes += len;
+            i_sent++;
+        }
+        else if( IsTransientError( net_errno ) || IsSoftError( net_errno ) )
+            sink->i_dropped++;
+        else
+            return false;
+    }
+#endif
+
+    sink->i_packets += i_sent;
+    sink->i_bytes += i_bytes;
+    if( !id->srtp && i_sent > 0 ) /* FIXME: SRTCP support */
+        SendRTCP( sink->rtcp, hdrv[pktc - 1], i_sent, i_bytes );
+    return true;
+}
+
+static void* ThreadSend( vlc_object_t *p_this )
+{
     sout_stream_id_t *id = (sout_stream_id_t *)p_this;
     unsigned i_caching = id->i_caching;
 
     while( vlc_object_alive (id) )
     {
+        block_t *pktv[RTP_BATCH_MAX];
+        unsigned pktc = 0;
         block_t *out = block_FifoGet( id->p_fifo );
         if( out == NULL )
             continue; /* Forced wakeup */
 
-        if( id->srtp )
-        {   /* FIXME: this is awfully inefficient */
-            size_t len = out->i_buffer;
-            out = block_Realloc( out, 0, len + 10 );
-            out->i_buffer = len;
+        mwait( out->i_dts + i_caching );
 
-            int val = srtp_send( id->srtp, out->p_buffer, &len, len + 10 );
-            if( val )
-            {
-                errno = val;
-                msg_Dbg( id, "SRTP sending error: %m" );
-                block_Release( out );
-                continue;
+        /* The packets due by now (e.g. the rest of a video frame) are sent
+         * together */
+        mtime_t now = mdate();
+        for( ;; )
+        {
+            if( id->srtp )
+            {   /* Packets are allocated with room for the tag */
+                size_t len = out->i_buffer;
+                int val = srtp_send( id->srtp, out->p_buffer, &len,
+                                     len + SRTP_TAG_LEN );
+                if( val )
+                {
+                    errno = val;
+                    msg_Dbg( id, "SRTP sending error: %m" );
+                    block_Release( out );
+                    out = NULL;
+                }
+                else
+                    out->i_buffer = len;
             }
-            out->i_buffer = len;
-        }
+            if( out != NULL )
+                pktv[pktc++] = out;
 
-        mtime_t  i_date = out->i_dts + i_caching;
-        ssize_t  len = out->i_buffer;
+            if( pktc >= RTP_BATCH_MAX || block_FifoCount( id->p_fifo ) == 0 )
+                break;
+            out = block_FifoShow( id->p_fifo );
+            if( out->i_dts + i_caching > now )
+                break;
+            out = block_FifoGet( id->p_fifo );
+        }
 
-        mwait( i_date );
+        if( pktc > 0 )
+        {
+            vlc_mutex_lock( &id->lock_sink );
+            unsigned deadc = 0; /* How many dead sockets? */
+            int deadv[id->sinkc]; /* Dead sockets list */
 
-        vlc_mutex_lock( &id->lock_sink );
-        unsigned deadc = 0; /* How many dead sockets? */
-        int deadv[id->sinkc]; /* Dead sockets list */
+            for( int i = 0; i < id->sinkc; i++ )
+                if( !SendSink( id, &id->sinkv[i], pktv, pktc ) )
+                    deadv[deadc++] = id->sinkv[i].rtp_fd;
+            vlc_mutex_unlock( &id->lock_sink );
 
-        for( int i = 0; i < id->sinkc; i++ )
-        {
-            if( !id->srtp ) /* FIXME: SRTCP support */
-                SendRTCP( id->sinkv[i].rtcp, out );
+            for( unsigned i = 0; i < pktc; i++ )
+                block_Release( pktv[i] );
 
-            if( send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 ) >= 0 )
-                continue;
-            switch( net_errno )
+            for( unsigned i = 0; i < deadc; i++ )
             {
-                /* Soft errors (e.g. ICMP): */
-                case ECONNREFUSED: /* Port unreachable */
-                case ENOPROTOOPT:
-#ifdef EPROTO
-                case EPROTO:       /* Protocol unreachable */
-#endif
-                case EHOSTUNREACH: /* Host unreachable */
-                case ENETUNREACH:  /* Network unreachable */
-                case ENETDOWN:     /* Entire network down */
-                    send( id->sinkv[i].rtp_fd, out->p_buffer, len, 0 );
-                /* Transient congestion: */
-                case ENOMEM: /* out of socket buffers */
-                case ENOBUFS:
-                case EAGAIN:
-#if (EAGAIN != EWOULDBLOCK)
-                case EWOULDBLOCK:
-#endif
-                    continue;
+                msg_Dbg( id, "removing socket %d", deadv[i] );
+                rtp_del_sink( id, deadv[i] );
             }
-
-            deadv[deadc++] = id->sinkv[i].rtp_fd;
-        }
-        vlc_mutex_unlock( &id->lock_sink );
-        block_Release( out );
-
-        for( unsigned i = 0; i < deadc; i++ )
-        {
-            msg_Dbg( id, "removing socket %d", deadv[i] );
-            rtp_del_sink( id, deadv[i] );
         }
 
         /* Hopefully we won't overflow the SO_MAXCONN accept queue */
@@ -1533,7 +1755,10 @@ static void* ThreadSend( vlc_object_t *p_this )
 
 int rtp_add_sink( sout_stream_id_t *id, int fd, bool rtcp_mux )
 {
-    rtp_sink_t sink = { fd, NULL };
+    rtp_sink_t sink;
+
+    memset( &sink, 0, sizeof( sink ) );
+    sink.rtp_fd = fd;
     sink.rtcp = OpenRTCP( VLC_OBJECT( id->p_stream ), fd, IPPROTO_UDP,
                           rtcp_mux );
     if( sink.rtcp == NULL )
@@ -1547,7 +1772,10 @@ int rtp_add_sink( sout_stream_id_t *id, int fd, bool rtcp_mux )
 
 void rtp_del_sink( sout_stream_id_t *id, int fd )
 {
-    rtp_sink_t sink = { fd, NULL };
+    rtp_sink_t sink;
+
+    memset( &sink, 0, sizeof( sink ) );
+    sink.rtp_fd = fd;
 
     /* NOTE: must be safe to use if fd is not included */
     vlc_mutex_lock( &id->lock_sink );
@@ -1562,10 +1790,223 @@ void rtp_del_sink( sout_stream_id_t *id, int fd )
     }
     vlc_mutex_unlock( &id->lock_sink );
 
+    msg_Dbg( id, "socket %d: %"PRIu64" packets (%"PRIu64" bytes) sent, "
+             "%"PRIu64" dropped", fd, sink.i_packets, sink.i_bytes,
+             sink.i_dropped );
     CloseRTCP( sink.rtcp );
     net_Close( sink.rtp_fd );
 }
 
+/*****************************************************************************
+ * Fan-out: one sink per session listed in the "rtp-fanout" input variable.
+ * Each line of the list is "<session>\t<destination>", the destination
+ * being written like the RTP stream output, e.g.
+ * rtp{dst=192.168.0.2,port-video=1234,port-audio=1236}.
+ *****************************************************************************/
+static int FanoutCallback( vlc_object_t *p_this, char const *psz_var,
+                           vlc_value_t oldval, vlc_value_t newval,
+                           void *p_data )
+{
+    VLC_UNUSED(p_this); VLC_UNUSED(psz_var); VLC_UNUSED(oldval);
+    FanoutUpdate( (sout_stream_t *)p_data, newval.psz_string );
+    return VLC_SUCCESS;
+}
+
+static rtp_fanout_t *FanoutNew( const char *psz_name, const char *psz_chain )
+{
+    rtp_fanout_t *p_fanout;
+    config_chain_t *p_cfg = NULL, *p;
+    char *psz_module;
+
+    free( config_ChainCreate( &psz_module, &p_cfg, psz_chain ) );
+    if( psz_module == NULL || strcmp( psz_module, "rtp" ) )
+    {
+        free( psz_module );
+        config_ChainDestroy( p_cfg );
+        return NULL;
+    }
+    free( psz_module );
+
+    p_fanout = calloc( 1, sizeof( *p_fanout ) );
+    if( p_fanout == NULL )
+    {
+        config_ChainDestroy( p_cfg );
+        return NULL;
+    }
+    for( p = p_cfg; p != NULL; p = p->p_next )
+    {
+        if( p->psz_value == NULL )
+            continue;
+        if( !strcmp( p->psz_name, "dst" ) )
+        {
+            free( p_fanout->psz_dst );
+            p_fanout->psz_dst = strdup( p->psz_value );
+        }
+        else if( !strcmp( p->psz_name, "port" ) )
+            p_fanout->i_port = atoi( p->psz_value );
+        else if( !strcmp( p->psz_name, "port-audio" ) )
+            p_fanout->i_port_audio = atoi( p->psz_value );
+        else if( !strcmp( p->psz_name, "port-video" ) )
+            p_fanout->i_port_video = atoi( p->psz_value );
+    }
+    config_ChainDestroy( p_cfg );
+
+    p_fanout->psz_name = strdup( psz_name );
+    if( p_fanout->psz_name == NULL || p_fanout->psz_dst == NULL )
+    {
+        free( p_fanout->psz_name );
+        free( p_fanout->psz_dst );
+        free( p_fanout );
+        return NULL;
+    }
+    return p_fanout;
+}
+
+/* Opens the sink of a session for an ES; lock_fanout must be held */
+static void FanoutAddSink( sout_stream_t *p_stream, sout_stream_id_t *id,
+                           const rtp_fanout_t *p_fanout )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    int i_port, fd;
+
+    if( p_sys->p_mux != NULL )
+        i_port = p_fanout->i_port;
+    else if( id->i_cat == AUDIO_ES )
+        i_port = p_fanout->i_port_audio;
+    else if( id->i_cat == VIDEO_ES )
+        i_port = p_fanout->i_port_video;
+    else
+        i_port = 0;
+    if( i_port <= 0 )
+        return; /* Not requested by this session */
+
+    fd = net_ConnectDgram( p_stream, p_fanout->psz_dst, i_port,
+                           p_sys->i_ttl > 0 ? p_sys->i_ttl : -1, p_sys->proto );
+    if( fd == -1 )
+    {
+        msg_Err( p_stream, "cannot create RTP socket for session %s",
+                 p_fanout->psz_name );
+        return;
+    }
+
+    rtp_sink_t sink;
+
+    memset( &sink, 0, sizeof( sink ) );
+    sink.rtp_fd = fd;
+    sink.fanout = p_fanout;
+    sink.seq_delta = rand() & 0xffff;
+    for( int i = 0; i < 4; i++ )
+        sink.ssrc[i] = rand() & 0xff;
+    sink.rtcp = OpenRTCP( VLC_OBJECT( p_stream ), fd, IPPROTO_UDP,
+                          p_sys->rtcp_mux );
+    if( sink.rtcp == NULL )
+        msg_Err( id, "RTCP failed!" );
+
+    vlc_mutex_lock( &id->lock_sink );
+    INSERT_ELEM( id->sinkv, id->sinkc, id->sinkc, sink );
+    vlc_mutex_unlock( &id->lock_sink );
+}
+
+static void FanoutDelSinks( sout_stream_t *p_stream,
+                            const rtp_fanout_t *p_fanout )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    vlc_mutex_lock( &p_sys->lock_es );
+    for( int i = 0; i < p_sys->i_es; i++ )
+    {
+        sout_stream_id_t *id = p_sys->es[i];
+        int fd = -1;
+
+        vlc_mutex_lock( &id->lock_sink );
+        for( int j = 0; j < id->sinkc; j++ )
+            if( id->sinkv[j].fanout == p_fanout )
+                fd = id->sinkv[j].rtp_fd;
+        vlc_mutex_unlock( &id->lock_sink );
+
+        if( fd != -1 )
+            rtp_del_sink( id, fd );
+    }
+    vlc_mutex_unlock( &p_sys->lock_es );
+}
+
+/* Opens the sinks of all sessions for a new ES; lock_fanout must be held */
+static void FanoutAddId( sout_stream_t *p_stream, sout_stream_id_t *id )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+
+    for( int i = 0; i < p_sys->i_fanout; i++ )
+        FanoutAddSink( p_stream, id, p_sys->fanout[i] );
+}
+
+static void FanoutUpdate( sout_stream_t *p_stream, const char *psz_list )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    char *psz_dup = strdup( psz_list ? psz_list : "" );
+    char *psz_line, *psz_next;
+
+    if( psz_dup == NULL )
+        return;
+
+    vlc_mutex_lock( &p_sys->lock_fanout );
+    for( int i = 0; i < p_sys->i_fanout; i++ )
+        p_sys->fanout[i]->b_seen = false;
+
+    /* Add the new sessions */
+    for( psz_line = psz_dup; psz_line != NULL; psz_line = psz_next )
+    {
+        char *psz_chain;
+        rtp_fanout_t *p_fanout = NULL;
+
+        psz_next = strchr( psz_line, '\n' );
+        if( psz_next != NULL )
+            *psz_next++ = '\0';
+        psz_chain = strchr( psz_line, '\t' );
+        if( psz_chain == NULL )
+            continue;
+        *psz_chain++ = '\0';
+
+        for( int i = 0; i < p_sys->i_fanout; i++ )
+            if( !strcmp( p_sys->fanout[i]->psz_name, psz_line ) )
+                p_fanout = p_sys->fanout[i];
+        if( p_fanout == NULL )
+        {
+            p_fanout = FanoutNew( psz_line, psz_chain );
+            if( p_fanout == NULL )
+            {
+                msg_Warn( p_stream, "invalid destination for session %s: %s",
+                          psz_line, psz_chain );
+                continue;
+            }
+            msg_Dbg( p_stream, "adding session %s", psz_line );
+            TAB_APPEND( p_sys->i_fanout, p_sys->fanout, p_fanout );
+
+            vlc_mutex_lock( &p_sys->lock_es );
+            for( int i = 0; i < p_sys->i_es; i++ )
+                FanoutAddSink( p_stream, p_sys->es[i], p_fanout );
+            vlc_mutex_unlock( &p_sys->lock_es );
+        }
+        p_fanout->b_seen = true;
+    }
+
+    /* Remove the old ones */
+    for( int i = p_sys->i_fanout - 1; i >= 0; i-- )
+    {
+        rtp_fanout_t *p_fanout = p_sys->fanout[i];
+
+        if( p_fanout->b_seen )
+            continue;
+        msg_Dbg( p_stream, "removing session %s", p_fanout->psz_name );
+        FanoutDelSinks( p_stream, p_fanout );
+        REMOVE_ELEM( p_sys->fanout, p_sys->i_fanout, i );
+        free( p_fanout->psz_name );
+        free( p_fanout->psz_dst );
+        free( p_fanout );
+    }
+    vlc_mutex_unlock( &p_sys->lock_fanout );
+    free( psz_dup );
+}
+
 uint16_t rtp_get_seq( const sout_stream_id_t *id )
 {
     /* This will return values for the next packet.
@@ -1617,6 +2058,19 @@ void rtp_packetize_send( sout_stream_id_t *id, block_t *out )
     block_FifoPut( id->p_fifo, out );
 }
 
+/**
+ * Allocates a packet of up to len bytes, with room for the SRTP
+ * authentication tag so that the packet can be protected in place.
+ */
+block_t *rtp_packetize_alloc( const sout_stream_id_t *id, size_t len )
+{
+    block_t *out = block_Alloc( len + ( id->srtp ? SRTP_TAG_LEN : 0 ) );
+
+    if( out != NULL )
+        out->i_buffer = len;
+    return out;
+}
+
 /**
  * @return configured max RTP payload size (including payload type-specific
  * headers, excluding RTP and transport headers)
@@ -1699,7 +2153,7 @@ static ssize_t AccessOutGrabberWriteBuffer( sout_stream_t *p_stream,
         if( p_sys->packet == NULL )
         {
             /* allocate a new packet */
-            p_sys->packet = block_New( p_stream, id->i_mtu );
+            p_sys->packet = rtp_packetize_alloc( id, id->i_mtu );
             rtp_packetize_common( id, p_sys->packet, 1, i_dts );
             p_sys->packet->i_dts = i_dts;
             p_sys->packet->i_length = p_buffer->i_length / i_packet;
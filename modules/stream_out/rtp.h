@@ -45,6 +45,7 @@ unsigned rtp_get_num( const sout_stream_id_t *id );
 void rtp_packetize_common (sout_stream_id_t *id, block_t *out,
                            int b_marker, int64_t i_pts);
 void rtp_packetize_send (sout_stream_id_t *id, block_t *out);
+block_t *rtp_packetize_alloc (const sout_stream_id_t *id, size_t len);
 size_t rtp_mtu (const sout_stream_id_t *id);
 
 int rtp_packetize_mpa  (sout_stream_id_t *, block_t *);
@@ -64,4 +65,5 @@ typedef struct rtcp_sender_t rtcp_sender_t;
 rtcp_sender_t *OpenRTCP (vlc_object_t *obj, int rtp_fd, int proto,
                          bool mux);
 void CloseRTCP (rtcp_sender_t *rtcp);
-void SendRTCP (rtcp_sender_t *restrict rtcp, const block_t *rtp);
+void SendRTCP (rtcp_sender_t *restrict rtcp, const uint8_t *rtp_header,
+               unsigned packets, size_t bytes);
@@ -42,6 +42,7 @@
 #include <vlc_filter.h>
 #include <vlc_osd.h>
 #include <vlc_es.h>
+#include <vlc_jobs.h>
 
 #include <math.h>
 
@@ -138,6 +139,16 @@
 #define HP_LONGTEXT N_( \
     "Runs the optional encoder thread at the OUTPUT priority instead of " \
     "VIDEO." )
+#define POOL_TEXT N_("Use the shared worker threads")
+#define POOL_LONGTEXT N_( \
+    "Encodes the video on the worker threads shared by all the streams " \
+    "(see \"worker-threads\") instead of a thread of its own. This keeps " \
+    "the number of threads bounded when many streams are transcoded at " \
+    "once." )
+#define PRIORITY_TEXT N_("Worker priority")
+#define PRIORITY_LONGTEXT N_( \
+    "When the worker threads are busy, the pictures of the transcoders " \
+    "with the highest priority are encoded first." )
 
 #define ASYNC_TEXT N_("Synchronise on audio track")
 #define ASYNC_LONGTEXT N_( \
@@ -234,6 +245,10 @@ vlc_module_begin();
                  THREADS_LONGTEXT, true );
     add_bool( SOUT_CFG_PREFIX "high-priority", 0, NULL, HP_TEXT, HP_LONGTEXT,
               true );
+    add_bool( SOUT_CFG_PREFIX "pool", false, NULL, POOL_TEXT, POOL_LONGTEXT,
+              true );
+    add_integer( SOUT_CFG_PREFIX "priority", 0, NULL, PRIORITY_TEXT,
+                 PRIORITY_LONGTEXT, true );
 
 vlc_module_end();
 
@@ -243,7 +258,7 @@ static const char *const ppsz_sout_options[] = {
     "deinterlace-module", "threads", "hurry-up", "aenc", "acodec", "ab",
     "afilter", "samplerate", "channels", "senc", "scodec", "soverlay",
     "sfilter", "osd", "audio-sync", "high-priority", "maxwidth", "maxheight",
-    NULL
+    "pool", "priority", NULL
 };
 
 /*****************************************************************************
@@ -287,6 +302,8 @@ static int  transcode_osd_process( sout_stream_t *, sout_stream_id_t *,
                                    block_t *, block_t ** );
 
 static void* EncoderThread( vlc_object_t * p_this );
+static void  EncoderJob( void * );
+static void  EncoderFlush( sout_stream_sys_t * );
 
 static const int pi_channels_maps[6] =
 {
@@ -341,6 +358,9 @@ struct sout_stream_sys_t
     config_chain_t  *p_deinterlace_cfg;
     int             i_threads;
     bool            b_high_priority;
+    bool            b_pool;
+    int             i_priority;
+    job_queue_t     *p_jobs;
     bool            b_hurry_up;
 
     char            *psz_vf2;
@@ -531,6 +551,10 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_threads = val.i_int;
     var_Get( p_stream, SOUT_CFG_PREFIX "high-priority", &val );
     p_sys->b_high_priority = val.b_bool;
+    p_sys->b_pool = var_GetBool( p_stream, SOUT_CFG_PREFIX "pool" );
+    p_sys->i_priority = var_GetInteger( p_stream, SOUT_CFG_PREFIX "priority" );
+    if( p_sys->b_pool && p_sys->i_threads < 1 )
+        p_sys->i_threads = 1;
 
     if( p_sys->i_vcodec )
     {
@@ -1558,7 +1582,8 @@ static int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_t *id )
     id->p_encoder->fmt_in.video.i_frame_rate = ENC_FRAMERATE;
     id->p_encoder->fmt_in.video.i_frame_rate_base = ENC_FRAMERATE_BASE;
 
-    id->p_encoder->i_threads = p_sys->i_threads;
+    /* The worker threads are already one per CPU */
+    id->p_encoder->i_threads = p_sys->b_pool ? 0 : p_sys->i_threads;
     id->p_encoder->p_cfg = p_sys->p_video_cfg;
 
     id->p_encoder->p_module =
@@ -1589,6 +1614,8 @@ static int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_t *id )
     {
         int i_priority = p_sys->b_high_priority ? VLC_THREAD_PRIORITY_OUTPUT :
                            VLC_THREAD_PRIORITY_VIDEO;
+        bool b_error;
+
         p_sys->id_video = id;
         vlc_mutex_init( &p_sys->lock_out );
         vlc_cond_init( p_stream, &p_sys->cond );
@@ -1597,8 +1624,16 @@ static int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_t *id )
         p_sys->i_last_pic = 0;
         p_sys->p_buffers = NULL;
         p_sys->b_die = p_sys->b_error = 0;
-        if( vlc_thread_create( p_sys, "encoder", EncoderThread, i_priority,
-                               false ) )
+        if( p_sys->b_pool )
+        {
+            /* One job per picture, run in order */
+            p_sys->p_jobs = job_queue_New( p_stream, p_sys->i_priority, 1 );
+            b_error = p_sys->p_jobs == NULL;
+        }
+        else
+            b_error = vlc_thread_create( p_sys, "encoder", EncoderThread,
+                                         i_priority, false );
+        if( b_error )
         {
             msg_Err( p_stream, "cannot spawn encoder thread" );
             module_Unneed( id->p_decoder, id->p_decoder->p_module );
@@ -1819,11 +1854,19 @@ static void transcode_video_close( sout_stream_t *p_stream,
 
     if( p_stream->p_sys->i_threads >= 1 )
     {
-        vlc_mutex_lock( &p_stream->p_sys->lock_out );
-        vlc_object_kill( p_stream->p_sys );
-        vlc_cond_signal( &p_stream->p_sys->cond );
-        vlc_mutex_unlock( &p_stream->p_sys->lock_out );
-        vlc_thread_join( p_stream->p_sys );
+        if( p_stream->p_sys->b_pool )
+        {
+            job_queue_Delete( p_stream->p_sys->p_jobs );
+            EncoderFlush( p_stream->p_sys );
+        }
+        else
+        {
+            vlc_mutex_lock( &p_stream->p_sys->lock_out );
+            vlc_object_kill( p_stream->p_sys );
+            vlc_cond_signal( &p_stream->p_sys->cond );
+            vlc_mutex_unlock( &p_stream->p_sys->lock_out );
+            vlc_thread_join( p_stream->p_sys );
+        }
         vlc_mutex_destroy( &p_stream->p_sys->lock_out );
         vlc_cond_destroy( &p_stream->p_sys->cond );
     }
@@ -2118,22 +2161,65 @@ static int transcode_video_process( sout_stream_t *p_stream,
             }
             vlc_cond_signal( &p_sys->cond );
             vlc_mutex_unlock( &p_sys->lock_out );
+
+            if( p_sys->b_pool )
+            {
+                /* The picture should be encoded before the next one comes */
+                const video_format_t *p_fmt = &id->p_encoder->fmt_in.video;
+                mtime_t i_deadline = mdate() + ( p_fmt->i_frame_rate > 0 ?
+                    INT64_C(1000000) * p_fmt->i_frame_rate_base /
+                    p_fmt->i_frame_rate : 40000 );
+
+                job_queue_Submit( p_sys->p_jobs, EncoderJob, p_sys,
+                                  i_deadline );
+                if( p_pic2 != NULL )
+                    job_queue_Submit( p_sys->p_jobs, EncoderJob, p_sys,
+                                      i_deadline );
+            }
         }
     }
 
     return VLC_SUCCESS;
 }
 
+static void EncoderEncode( sout_stream_sys_t *p_sys, picture_t *p_pic )
+{
+    sout_stream_id_t *id = p_sys->id_video;
+    block_t *p_block;
+
+    video_timer_start( id->p_encoder );
+    p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
+    video_timer_stop( id->p_encoder );
+
+    vlc_mutex_lock( &p_sys->lock_out );
+    block_ChainAppend( &p_sys->p_buffers, p_block );
+
+    vlc_mutex_unlock( &p_sys->lock_out );
+    p_pic->pf_release( p_pic );
+}
+
+/* Releases what the encoder left behind */
+static void EncoderFlush( sout_stream_sys_t *p_sys )
+{
+    picture_t *p_pic;
+
+    while( p_sys->i_last_pic != p_sys->i_first_pic )
+    {
+        p_pic = p_sys->pp_pics[p_sys->i_first_pic++];
+        p_sys->i_first_pic %= PICTURE_RING_SIZE;
+        p_pic->pf_release( p_pic );
+    }
+    block_ChainRelease( p_sys->p_buffers );
+    p_sys->p_buffers = NULL;
+}
+
 static void* EncoderThread( vlc_object_t* p_this )
 {
     sout_stream_sys_t *p_sys = (sout_stream_sys_t*)p_this;
-    sout_stream_id_t *id = p_sys->id_video;
     picture_t *p_pic;
 
     while( vlc_object_alive (p_sys) && !p_sys->b_error )
     {
-        block_t *p_block;
-
         vlc_mutex_lock( &p_sys->lock_out );
         while( p_sys->i_last_pic == p_sys->i_first_pic )
         {
@@ -2150,26 +2236,30 @@ static void* EncoderThread( vlc_object_t* p_this )
         p_sys->i_first_pic %= PICTURE_RING_SIZE;
         vlc_mutex_unlock( &p_sys->lock_out );
 
-        video_timer_start( id->p_encoder );
-        p_block = id->p_encoder->pf_encode_video( id->p_encoder, p_pic );
-        video_timer_stop( id->p_encoder );
+        EncoderEncode( p_sys, p_pic );
+    }
 
-        vlc_mutex_lock( &p_sys->lock_out );
-        block_ChainAppend( &p_sys->p_buffers, p_block );
+    EncoderFlush( p_sys );
+    return NULL;
+}
 
-        vlc_mutex_unlock( &p_sys->lock_out );
-        p_pic->pf_release( p_pic );
-    }
+/* Encodes the oldest queued picture on a worker thread */
+static void EncoderJob( void *p_data )
+{
+    sout_stream_sys_t *p_sys = p_data;
+    picture_t *p_pic;
 
-    while( p_sys->i_last_pic != p_sys->i_first_pic )
+    vlc_mutex_lock( &p_sys->lock_out );
+    if( p_sys->i_last_pic == p_sys->i_first_pic )
     {
-        p_pic = p_sys->pp_pics[p_sys->i_first_pic++];
-        p_sys->i_first_pic %= PICTURE_RING_SIZE;
-        p_pic->pf_release( p_pic );
+        vlc_mutex_unlock( &p_sys->lock_out );
+        return;
     }
-    block_ChainRelease( p_sys->p_buffers );
+    p_pic = p_sys->pp_pics[p_sys->i_first_pic++];
+    p_sys->i_first_pic %= PICTURE_RING_SIZE;
+    vlc_mutex_unlock( &p_sys->lock_out );
 
-    return NULL;
+    EncoderEncode( p_sys, p_pic );
 }
 
 struct picture_sys_t
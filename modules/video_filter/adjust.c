@@ -119,8 +119,19 @@ struct filter_sys_t
     double     f_saturation;
     double     f_gamma;
     bool b_brightness_threshold;
+    filter_slices_t *p_slices;
 };
 
+/* What the slices of a picture need */
+typedef struct
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    int pi_luma[256];
+    int i_sat, i_sin, i_cos, i_x, i_y;
+    int i_y_offset, i_u_offset, i_v_offset; /* packed YUV only */
+} adjust_slice_t;
+
 /*****************************************************************************
  * Create: allocates adjust video filter
  *****************************************************************************/
@@ -180,6 +191,8 @@ static int Create( vlc_object_t *p_this )
     var_AddCallback( p_filter, "brightness-threshold",
                                              AdjustCallback, p_sys );
 
+    p_sys->p_slices = filter_SlicesNew( p_filter );
+
     return VLC_SUCCESS;
 }
 
@@ -189,95 +202,38 @@ static int Create( vlc_object_t *p_this )
 static void Destroy( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
+    filter_SlicesDelete( p_filter->p_sys->p_slices );
     free( p_filter->p_sys );
 }
 
 /*****************************************************************************
  * Run the filter on a Planar YUV picture
  *****************************************************************************/
-static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
+static void PlanarSlice( void *p_data, int i_slice, int i_slices )
 {
-    int pi_luma[256];
-    int pi_gamma[256];
-
-    picture_t *p_outpic;
+    adjust_slice_t *p_ctx = p_data;
+    picture_t *p_pic = p_ctx->p_pic, *p_outpic = p_ctx->p_outpic;
+    const int *pi_luma = p_ctx->pi_luma;
+    const int i_sat = p_ctx->i_sat, i_sin = p_ctx->i_sin, i_cos = p_ctx->i_cos;
+    const int i_x = p_ctx->i_x, i_y = p_ctx->i_y;
     uint8_t *p_in, *p_in_v, *p_in_end, *p_line_end;
     uint8_t *p_out, *p_out_v;
-
-    bool b_thres;
-    double  f_hue;
-    double  f_gamma;
-    int32_t i_cont, i_lum;
-    int i_sat, i_sin, i_cos, i_x, i_y;
-    int i;
-
-    filter_sys_t *p_sys = p_filter->p_sys;
-
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    /* Getvariables */
-    i_cont = (int)( p_sys->f_contrast * 255 );
-    i_lum = (int)( (p_sys->f_brightness - 1.0)*255 );
-    f_hue = (float)( p_sys->i_hue * M_PI / 180 );
-    i_sat = (int)( p_sys->f_saturation * 256 );
-    f_gamma = 1.0 / p_sys->f_gamma;
-    b_thres = p_sys->b_brightness_threshold;
-
-    /*
-     * Threshold mode drops out everything about luma, contrast and gamma.
-     */
-    if( b_thres != true )
-    {
-
-        /* Contrast is a fast but kludged function, so I put this gap to be
-         * cleaner :) */
-        i_lum += 128 - i_cont / 2;
-
-        /* Fill the gamma lookup table */
-        for( i = 0 ; i < 256 ; i++ )
-        {
-          pi_gamma[ i ] = clip_uint8_vlc( pow(i / 255.0, f_gamma) * 255.0);
-        }
-
-        /* Fill the luma lookup table */
-        for( i = 0 ; i < 256 ; i++ )
-        {
-            pi_luma[ i ] = pi_gamma[clip_uint8_vlc( i_lum + i_cont * i / 256)];
-        }
-    }
-    else
-    {
-        /*
-         * We get luma as threshold value: the higher it is, the darker is
-         * the image. Should I reverse this?
-         */
-        for( i = 0 ; i < 256 ; i++ )
-        {
-            pi_luma[ i ] = (i < i_lum) ? 0 : 255;
-        }
-
-        /*
-         * Desaturates image to avoid that strange yellow halo...
-         */
-        i_sat = 0;
-    }
+    int i_first, i_last;
 
     /*
      * Do the Y plane
      */
 
-    p_in = p_pic->p[Y_PLANE].p_pixels;
-    p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-                      * p_pic->p[Y_PLANE].i_pitch - 8;
+    filter_SliceLines( p_pic->p[Y_PLANE].i_visible_lines, i_slice, i_slices,
+                       &i_first, &i_last );
 
-    p_out = p_outpic->p[Y_PLANE].p_pixels;
+    p_in = p_pic->p[Y_PLANE].p_pixels
+             + i_first * p_pic->p[Y_PLANE].i_pitch;
+    p_in_end = p_pic->p[Y_PLANE].p_pixels
+                 + i_last * p_pic->p[Y_PLANE].i_pitch - 8;
+
+    p_out = p_outpic->p[Y_PLANE].p_pixels
+              + i_first * p_outpic->p[Y_PLANE].i_pitch;
 
     for( ; p_in < p_in_end ; )
     {
@@ -309,19 +265,20 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
      * Do the U and V planes
      */
 
-    p_in = p_pic->p[U_PLANE].p_pixels;
-    p_in_v = p_pic->p[V_PLANE].p_pixels;
-    p_in_end = p_in + p_pic->p[U_PLANE].i_visible_lines
-                      * p_pic->p[U_PLANE].i_pitch - 8;
-
-    p_out = p_outpic->p[U_PLANE].p_pixels;
-    p_out_v = p_outpic->p[V_PLANE].p_pixels;
+    filter_SliceLines( p_pic->p[U_PLANE].i_visible_lines, i_slice, i_slices,
+                       &i_first, &i_last );
 
-    i_sin = sin(f_hue) * 256;
-    i_cos = cos(f_hue) * 256;
+    p_in = p_pic->p[U_PLANE].p_pixels
+             + i_first * p_pic->p[U_PLANE].i_pitch;
+    p_in_v = p_pic->p[V_PLANE].p_pixels
+               + i_first * p_pic->p[V_PLANE].i_pitch;
+    p_in_end = p_pic->p[U_PLANE].p_pixels
+                 + i_last * p_pic->p[U_PLANE].i_pitch - 8;
 
-    i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
-    i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
+    p_out = p_outpic->p[U_PLANE].p_pixels
+              + i_first * p_outpic->p[U_PLANE].i_pitch;
+    p_out_v = p_outpic->p[V_PLANE].p_pixels
+                + i_first * p_outpic->p[V_PLANE].i_pitch;
 
     if ( i_sat > 256 )
     {
@@ -406,55 +363,30 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
 #undef WRITE_UV
     }
 
-    return CopyInfoAndRelease( p_outpic, p_pic );
 }
 
-/*****************************************************************************
- * Run the filter on a Packed YUV picture
- *****************************************************************************/
-static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
+static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
 {
-    int pi_luma[256];
     int pi_gamma[256];
+    adjust_slice_t ctx;
+    int *pi_luma = ctx.pi_luma;
 
     picture_t *p_outpic;
-    uint8_t *p_in, *p_in_v, *p_in_end, *p_line_end;
-    uint8_t *p_out, *p_out_v;
-    int i_y_offset, i_u_offset, i_v_offset;
-
-    int i_lines, i_visible_lines, i_pitch, i_visible_pitch;
 
     bool b_thres;
     double  f_hue;
     double  f_gamma;
     int32_t i_cont, i_lum;
-    int i_sat, i_sin, i_cos, i_x, i_y;
+    int i_sat;
     int i;
 
     filter_sys_t *p_sys = p_filter->p_sys;
 
     if( !p_pic ) return NULL;
 
-    i_lines = p_pic->p->i_lines;
-    i_visible_lines = p_pic->p->i_visible_lines;
-    i_pitch = p_pic->p->i_pitch;
-    i_visible_pitch = p_pic->p->i_visible_pitch;
-
-    if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
-                             &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
-    {
-        msg_Warn( p_filter, "Unsupported input chroma (%4s)",
-                  (char*)&(p_pic->format.i_chroma) );
-
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    p_outpic = p_filter->pf_vout_buffer_new( p_filter );
+    p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
     {
-        msg_Warn( p_filter, "can't get output picture" );
-
         picture_Release( p_pic );
         return NULL;
     }
@@ -506,14 +438,51 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
         i_sat = 0;
     }
 
+    ctx.i_sin = sin(f_hue) * 256;
+    ctx.i_cos = cos(f_hue) * 256;
+
+    ctx.i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
+    ctx.i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
+
+    ctx.p_pic = p_pic;
+    ctx.p_outpic = p_outpic;
+    ctx.i_sat = i_sat;
+    filter_SlicesRun( p_sys->p_slices, PlanarSlice, &ctx );
+
+    return CopyInfoAndRelease( p_outpic, p_pic );
+}
+
+/*****************************************************************************
+ * Run the filter on a Packed YUV picture
+ *****************************************************************************/
+static void PackedSlice( void *p_data, int i_slice, int i_slices )
+{
+    adjust_slice_t *p_ctx = p_data;
+    picture_t *p_pic = p_ctx->p_pic, *p_outpic = p_ctx->p_outpic;
+    const int *pi_luma = p_ctx->pi_luma;
+    const int i_sat = p_ctx->i_sat, i_sin = p_ctx->i_sin, i_cos = p_ctx->i_cos;
+    const int i_x = p_ctx->i_x, i_y = p_ctx->i_y;
+    uint8_t *p_in, *p_in_v, *p_in_end, *p_line_end;
+    uint8_t *p_out, *p_out_v;
+    int i_first, i_last;
+    const int i_y_offset = p_ctx->i_y_offset;
+    const int i_u_offset = p_ctx->i_u_offset;
+    const int i_v_offset = p_ctx->i_v_offset;
+    const int i_visible_lines = p_pic->p->i_visible_lines;
+    const int i_pitch = p_pic->p->i_pitch;
+    const int i_visible_pitch = p_pic->p->i_visible_pitch;
+
     /*
      * Do the Y plane
      */
 
-    p_in = p_pic->p->p_pixels + i_y_offset;
-    p_in_end = p_in + p_pic->p->i_visible_lines * p_pic->p->i_pitch - 8 * 4;
+    filter_SliceLines( i_visible_lines, i_slice, i_slices,
+                       &i_first, &i_last );
 
-    p_out = p_outpic->p->p_pixels + i_y_offset;
+    p_in = p_pic->p->p_pixels + i_first * i_pitch + i_y_offset;
+    p_in_end = p_pic->p->p_pixels + i_last * i_pitch + i_y_offset - 8 * 4;
+
+    p_out = p_outpic->p->p_pixels + i_first * i_pitch + i_y_offset;
 
     for( ; p_in < p_in_end ; )
     {
@@ -547,18 +516,12 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
      * Do the U and V planes
      */
 
-    p_in = p_pic->p->p_pixels + i_u_offset;
-    p_in_v = p_pic->p->p_pixels + i_v_offset;
-    p_in_end = p_in + i_visible_lines * i_pitch - 8 * 4;
-
-    p_out = p_outpic->p->p_pixels + i_u_offset;
-    p_out_v = p_outpic->p->p_pixels + i_v_offset;
+    p_in = p_pic->p->p_pixels + i_first * i_pitch + i_u_offset;
+    p_in_v = p_pic->p->p_pixels + i_first * i_pitch + i_v_offset;
+    p_in_end = p_pic->p->p_pixels + i_last * i_pitch + i_u_offset - 8 * 4;
 
-    i_sin = sin(f_hue) * 256;
-    i_cos = cos(f_hue) * 256;
-
-    i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
-    i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
+    p_out = p_outpic->p->p_pixels + i_first * i_pitch + i_u_offset;
+    p_out_v = p_outpic->p->p_pixels + i_first * i_pitch + i_v_offset;
 
     if ( i_sat > 256 )
     {
@@ -639,6 +602,108 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
 #undef WRITE_UV
     }
 
+}
+
+static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
+{
+    int pi_gamma[256];
+    adjust_slice_t ctx;
+    int *pi_luma = ctx.pi_luma;
+
+    picture_t *p_outpic;
+    int i_y_offset, i_u_offset, i_v_offset;
+
+    bool b_thres;
+    double  f_hue;
+    double  f_gamma;
+    int32_t i_cont, i_lum;
+    int i_sat;
+    int i;
+
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( !p_pic ) return NULL;
+
+    if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
+                             &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
+    {
+        msg_Warn( p_filter, "Unsupported input chroma (%4s)",
+                  (char*)&(p_pic->format.i_chroma) );
+
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    p_outpic = p_filter->pf_vout_buffer_new( p_filter );
+    if( !p_outpic )
+    {
+        msg_Warn( p_filter, "can't get output picture" );
+
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    /* Getvariables */
+    i_cont = (int)( p_sys->f_contrast * 255 );
+    i_lum = (int)( (p_sys->f_brightness - 1.0)*255 );
+    f_hue = (float)( p_sys->i_hue * M_PI / 180 );
+    i_sat = (int)( p_sys->f_saturation * 256 );
+    f_gamma = 1.0 / p_sys->f_gamma;
+    b_thres = p_sys->b_brightness_threshold;
+
+    /*
+     * Threshold mode drops out everything about luma, contrast and gamma.
+     */
+    if( b_thres != true )
+    {
+
+        /* Contrast is a fast but kludged function, so I put this gap to be
+         * cleaner :) */
+        i_lum += 128 - i_cont / 2;
+
+        /* Fill the gamma lookup table */
+        for( i = 0 ; i < 256 ; i++ )
+        {
+          pi_gamma[ i ] = clip_uint8_vlc( pow(i / 255.0, f_gamma) * 255.0);
+        }
+
+        /* Fill the luma lookup table */
+        for( i = 0 ; i < 256 ; i++ )
+        {
+            pi_luma[ i ] = pi_gamma[clip_uint8_vlc( i_lum + i_cont * i / 256)];
+        }
+    }
+    else
+    {
+        /*
+         * We get luma as threshold value: the higher it is, the darker is
+         * the image. Should I reverse this?
+         */
+        for( i = 0 ; i < 256 ; i++ )
+        {
+            pi_luma[ i ] = (i < i_lum) ? 0 : 255;
+        }
+
+        /*
+         * Desaturates image to avoid that strange yellow halo...
+         */
+        i_sat = 0;
+    }
+
+    ctx.i_sin = sin(f_hue) * 256;
+    ctx.i_cos = cos(f_hue) * 256;
+
+    ctx.i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
+    ctx.i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
+
+    ctx.p_pic = p_pic;
+    ctx.p_outpic = p_outpic;
+    ctx.i_sat = i_sat;
+    ctx.i_y_offset = i_y_offset;
+    ctx.i_u_offset = i_u_offset;
+    ctx.i_v_offset = i_v_offset;
+    filter_SlicesRun( p_sys->p_slices, PackedSlice, &ctx );
+
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
 
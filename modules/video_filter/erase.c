@@ -45,6 +45,7 @@ static int  Create    ( vlc_object_t * );
 static void Destroy   ( vlc_object_t * );
 
 static picture_t *Filter( filter_t *, picture_t * );
+static void CopySlice( void *, int, int );
 static void FilterErase( filter_t *, picture_t *, picture_t * );
 static int EraseCallback( vlc_object_t *, char const *,
                           vlc_value_t, vlc_value_t, void * );
@@ -90,9 +91,16 @@ struct filter_sys_t
     int i_x;
     int i_y;
     picture_t *p_mask;
+    filter_slices_t *p_slices;
     vlc_mutex_t lock;
 };
 
+typedef struct
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+} erase_slice_t;
+
 static void LoadMask( filter_t *p_filter, const char *psz_filename )
 {
     image_handler_t *p_image;
@@ -174,6 +182,7 @@ static int Create( vlc_object_t *p_this )
     var_AddCallback( p_filter, CFG_PREFIX "mask", EraseCallback, p_sys );
 
     vlc_mutex_init( &p_sys->lock );
+    p_sys->p_slices = filter_SlicesNew( p_filter );
 
     return VLC_SUCCESS;
 }
@@ -189,6 +198,7 @@ static void Destroy( vlc_object_t *p_this )
         picture_Release( p_sys->p_mask );
 
     vlc_mutex_destroy( &p_sys->lock );
+    filter_SlicesDelete( p_sys->p_slices );
 
     free( p_filter->p_sys );
 }
@@ -209,12 +219,37 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         return NULL;
     }
 
-    /* Here */
+    /* Copy the original picture in slices, then erase the (small) masked
+     * area on this thread: its interpolation runs from line to line */
+    erase_slice_t ctx = { p_pic, p_outpic };
+    filter_SlicesRun( p_filter->p_sys->p_slices, CopySlice, &ctx );
     FilterErase( p_filter, p_pic, p_outpic );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
 
+/*****************************************************************************
+ * CopySlice
+ *****************************************************************************/
+static void CopySlice( void *p_data, int i_slice, int i_slices )
+{
+    erase_slice_t *p_ctx = p_data;
+    int i_plane;
+
+    for( i_plane = 0; i_plane < p_ctx->p_pic->i_planes; i_plane++ )
+    {
+        const plane_t *p_in = &p_ctx->p_pic->p[i_plane];
+        plane_t *p_out = &p_ctx->p_outpic->p[i_plane];
+        int i_first, i_last;
+
+        filter_SliceLines( p_in->i_lines, i_slice, i_slices,
+                           &i_first, &i_last );
+        vlc_memcpy( &p_out->p_pixels[i_first * p_in->i_pitch],
+                    &p_in->p_pixels[i_first * p_in->i_pitch],
+                    p_in->i_pitch * ( i_last - i_first ) );
+    }
+}
+
 /*****************************************************************************
  * FilterErase
  *****************************************************************************/
@@ -234,10 +269,8 @@ static void FilterErase( filter_t *p_filter, picture_t *p_inpic,
         const int i_pitch = p_inpic->p[i_plane].i_pitch;
         const int i_2pitch = i_pitch<<1;
         const int i_visible_pitch = p_inpic->p[i_plane].i_visible_pitch;
-        const int i_lines = p_inpic->p[i_plane].i_lines;
         const int i_visible_lines = p_inpic->p[i_plane].i_visible_lines;
 
-        uint8_t *p_inpix = p_inpic->p[i_plane].p_pixels;
         uint8_t *p_outpix = p_outpic->p[i_plane].p_pixels;
         uint8_t *p_mask = p_sys->p_mask->A_PIXELS;
 
@@ -264,9 +297,6 @@ static void FilterErase( filter_t *p_filter, picture_t *p_inpic,
         i_height = __MIN( i_visible_lines - i_y, i_height );
         i_width  = __MIN( i_visible_pitch - i_x, i_width  );
 
-        /* Copy original pixel buffer */
-        vlc_memcpy( p_outpix, p_inpix, i_pitch * i_lines );
-
         /* Horizontal linear interpolation of masked areas */
         p_outpix = p_outpic->p[i_plane].p_pixels + i_y*i_pitch + i_x;
         for( y = 0; y < i_height;
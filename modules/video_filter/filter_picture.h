@@ -94,3 +94,13 @@ static inline picture_t *CopyInfoAndRelease( picture_t *p_outpic, picture_t *p_i
 
     return p_outpic;
 }
+
+/*****************************************************************************
+ * Pseudo-random numbers in [0, 32767] for filters running in slices, which
+ * cannot share the rand() state. Seed with rand() from the filter thread.
+ *****************************************************************************/
+static inline int SliceRand( unsigned *pi_seed )
+{
+    *pi_seed = *pi_seed * 1103515245 + 12345;
+    return (*pi_seed >> 16) & 0x7fff;
+}
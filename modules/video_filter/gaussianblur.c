@@ -94,8 +94,18 @@ struct filter_sys_t
     type_t *pt_distribution;
     type_t *pt_buffer;
     type_t *pt_scale;
+
+    filter_slices_t *p_slices;
 };
 
+typedef struct
+{
+    filter_t *p_filter;
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    int i_plane;
+} blur_slice_t;
+
 static void gaussianblur_InitDistribution( filter_sys_t *p_sys )
 {
     double f_sigma = p_sys->f_sigma;
@@ -166,6 +176,7 @@ static int Create( vlc_object_t *p_this )
 
     p_filter->p_sys->pt_buffer = NULL;
     p_filter->p_sys->pt_scale = NULL;
+    p_filter->p_sys->p_slices = filter_SlicesNew( p_filter );
 
     return VLC_SUCCESS;
 }
@@ -174,6 +185,7 @@ static void Destroy( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
+    filter_SlicesDelete( p_filter->p_sys->p_slices );
     free( p_filter->p_sys->pt_distribution );
     free( p_filter->p_sys->pt_buffer );
     free( p_filter->p_sys->pt_scale );
@@ -181,13 +193,100 @@ static void Destroy( vlc_object_t *p_this )
     free( p_filter->p_sys );
 }
 
+/* Horizontal pass, from the picture to pt_buffer */
+static void BlurLinesSlice( void *p_data, int i_slice, int i_slices )
+{
+    blur_slice_t *p_ctx = p_data;
+    filter_sys_t *p_sys = p_ctx->p_filter->p_sys;
+    const int i_plane = p_ctx->i_plane;
+    const int i_dim = p_sys->i_dim;
+    const uint8_t *p_in = p_ctx->p_pic->p[i_plane].p_pixels;
+    type_t *pt_buffer = p_sys->pt_buffer;
+    const type_t *pt_distribution = p_sys->pt_distribution;
+
+    const plane_t *p_plane = &p_ctx->p_pic->p[i_plane];
+    const plane_t *p_luma = &p_ctx->p_pic->p[Y_PLANE];
+
+    const int i_visible_lines = p_plane->i_visible_lines;
+    const int i_visible_pitch = p_plane->i_visible_pitch;
+    const int i_pitch = p_plane->i_pitch;
+
+    int i_line, i_col, i_last;
+    const int x_factor = p_luma->i_visible_pitch/i_visible_pitch-1;
+
+    filter_SliceLines( i_visible_lines, i_slice, i_slices, &i_line, &i_last );
+
+    for( ; i_line < i_last ; i_line++ )
+    {
+        for( i_col = 0; i_col < i_visible_pitch ; i_col++ )
+        {
+            type_t t_value = 0;
+            int x;
+            const int c = i_line*i_pitch+i_col;
+            for( x = __MAX( -i_dim, -i_col*(x_factor+1) );
+                 x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
+                 x++ )
+            {
+                t_value += pt_distribution[x+i_dim] *
+                           p_in[c+(x>>x_factor)];
+            }
+            pt_buffer[c] = t_value;
+        }
+    }
+}
+
+/* Vertical pass, from pt_buffer to the output picture */
+static void BlurColumnsSlice( void *p_data, int i_slice, int i_slices )
+{
+    blur_slice_t *p_ctx = p_data;
+    filter_sys_t *p_sys = p_ctx->p_filter->p_sys;
+    const int i_plane = p_ctx->i_plane;
+    const int i_dim = p_sys->i_dim;
+    uint8_t *p_out = p_ctx->p_outpic->p[i_plane].p_pixels;
+    const type_t *pt_scale = p_sys->pt_scale;
+    const type_t *pt_buffer = p_sys->pt_buffer;
+    const type_t *pt_distribution = p_sys->pt_distribution;
+
+    const plane_t *p_plane = &p_ctx->p_pic->p[i_plane];
+    const plane_t *p_luma = &p_ctx->p_pic->p[Y_PLANE];
+
+    const int i_visible_lines = p_plane->i_visible_lines;
+    const int i_visible_pitch = p_plane->i_visible_pitch;
+    const int i_pitch = p_plane->i_pitch;
+
+    int i_line, i_col, i_last;
+    const int x_factor = p_luma->i_visible_pitch/i_visible_pitch-1;
+    const int y_factor = p_luma->i_visible_lines/i_visible_lines-1;
+
+    filter_SliceLines( i_visible_lines, i_slice, i_slices, &i_line, &i_last );
+
+    for( ; i_line < i_last ; i_line++ )
+    {
+        for( i_col = 0; i_col < i_visible_pitch ; i_col++ )
+        {
+            type_t t_value = 0;
+            int y;
+            const int c = i_line*i_pitch+i_col;
+            for( y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
+                 y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
+                 y++ )
+            {
+                t_value += pt_distribution[y+i_dim] *
+                           pt_buffer[c+(y>>y_factor)*i_pitch];
+            }
+
+            const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_pitch<<x_factor)+(i_col<<x_factor)];
+            p_out[c] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
+        }
+    }
+}
+
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
     int i_plane;
     const int i_dim = p_sys->i_dim;
-    type_t *pt_buffer;
     type_t *pt_scale;
     const type_t *pt_distribution = p_sys->pt_distribution;
 
@@ -207,7 +306,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                                         sizeof( type_t ) );
     }
 
-    pt_buffer = p_sys->pt_buffer;
     if( !p_sys->pt_scale )
     {
         const int i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
@@ -242,57 +340,13 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         }
     }
 
-    pt_scale = p_sys->pt_scale;
     for( i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
     {
+        blur_slice_t ctx = { p_filter, p_pic, p_outpic, i_plane };
 
-        uint8_t *p_in = p_pic->p[i_plane].p_pixels;
-        uint8_t *p_out = p_outpic->p[i_plane].p_pixels;
-
-        const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
-        const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
-        const int i_pitch = p_pic->p[i_plane].i_pitch;
-
-        int i_line, i_col;
-        const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
-        const int y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1;
-
-        for( i_line = 0 ; i_line < i_visible_lines ; i_line++ )
-        {
-            for( i_col = 0; i_col < i_visible_pitch ; i_col++ )
-            {
-                type_t t_value = 0;
-                int x;
-                const int c = i_line*i_pitch+i_col;
-                for( x = __MAX( -i_dim, -i_col*(x_factor+1) );
-                     x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
-                     x++ )
-                {
-                    t_value += pt_distribution[x+i_dim] *
-                               p_in[c+(x>>x_factor)];
-                }
-                pt_buffer[c] = t_value;
-            }
-        }
-        for( i_line = 0 ; i_line < i_visible_lines ; i_line++ )
-        {
-            for( i_col = 0; i_col < i_visible_pitch ; i_col++ )
-            {
-                type_t t_value = 0;
-                int y;
-                const int c = i_line*i_pitch+i_col;
-                for( y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
-                     y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
-                     y++ )
-                {
-                    t_value += pt_distribution[y+i_dim] *
-                               pt_buffer[c+(y>>y_factor)*i_pitch];
-                }
-
-                const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_pitch<<x_factor)+(i_col<<x_factor)];
-                p_out[c] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
-            }
-        }
+        /* Every line of pt_buffer must be done before the columns */
+        filter_SlicesRun( p_sys->p_slices, BlurLinesSlice, &ctx );
+        filter_SlicesRun( p_sys->p_slices, BlurColumnsSlice, &ctx );
     }
 
     return CopyInfoAndRelease( p_outpic, p_pic );
@@ -62,8 +62,17 @@ vlc_module_end();
 struct filter_sys_t
 {
     int *p_noise;
+    filter_slices_t *p_slices;
 };
 
+typedef struct
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    int *p_noise;
+    unsigned pi_seed[FILTER_SLICES_MAX];
+} grain_slice_t;
+
 static int Create( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
@@ -87,6 +96,7 @@ static int Create( vlc_object_t *p_this )
     p_filter->pf_video_filter = Filter;
 
     p_filter->p_sys->p_noise = NULL;
+    p_filter->p_sys->p_slices = filter_SlicesNew( p_filter );
 
     return VLC_SUCCESS;
 }
@@ -94,24 +104,40 @@ static int Create( vlc_object_t *p_this )
 static void Destroy( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
+    filter_SlicesDelete( p_filter->p_sys->p_slices );
     free( p_filter->p_sys->p_noise );
     free( p_filter->p_sys );
 }
 
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void NoiseSlice( void *p_data, int i_slice, int i_slices )
 {
-    picture_t *p_outpic;
-    filter_sys_t *p_sys = p_filter->p_sys;
-    int i_index;
+    grain_slice_t *p_ctx = p_data;
+    const plane_t *p_plane = &p_ctx->p_pic->p[Y_PLANE];
 
-    if( !p_pic ) return NULL;
+    const int i_num_cols = p_plane->i_visible_pitch;
+    const int i_pitch = p_plane->i_pitch;
+    unsigned *pi_seed = &p_ctx->pi_seed[i_slice];
+    int *p_noise = p_ctx->p_noise;
 
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
+    int i_line, i_col, i_last;
+
+    filter_SliceLines( p_plane->i_visible_lines, i_slice, i_slices,
+                       &i_line, &i_last );
+
+    for( ; i_line < i_last; i_line++ )
     {
-        picture_Release( p_pic );
-        return NULL;
+        for( i_col = 0; i_col < i_num_cols; i_col++ )
+        {
+            p_noise[i_line*i_pitch+i_col] = ((SliceRand( pi_seed )&0x1f)-0x0f);
+        }
     }
+}
+
+static void GrainSlice( void *p_data, int i_slice, int i_slices )
+{
+    grain_slice_t *p_ctx = p_data;
+    picture_t *p_pic = p_ctx->p_pic, *p_outpic = p_ctx->p_outpic;
+    int i_index;
 
     {
         uint8_t *p_in = p_pic->p[Y_PLANE].p_pixels;
@@ -121,24 +147,15 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         const int i_num_cols = p_pic->p[Y_PLANE].i_visible_pitch;
         const int i_pitch = p_pic->p[Y_PLANE].i_pitch;
 
-        int i_line, i_col;
+        int *p_noise = p_ctx->p_noise;
+        int i_line, i_col, i_last;
 
-        int *p_noise = p_sys->p_noise;
-        if( !p_noise )
-        {
-            p_noise = p_sys->p_noise =
-                (int*)malloc(i_pitch*i_num_lines*sizeof(int));
-        }
+        filter_SliceLines( i_num_lines - 4, i_slice, i_slices,
+                           &i_line, &i_last );
+        i_line += 2;
+        i_last += 2;
 
-        for( i_line = 0; i_line < i_num_lines; i_line++ )
-        {
-            for( i_col = 0; i_col < i_num_cols; i_col++ )
-            {
-                p_noise[i_line*i_pitch+i_col] = ((rand()&0x1f)-0x0f);
-            }
-        }
-
-        for( i_line = 2/*0*/ ; i_line < i_num_lines-2/**/; i_line++ )
+        for( ; i_line < i_last; i_line++ )
         {
             for( i_col = 2/*0*/; i_col < i_num_cols/2; i_col++ )
             {
@@ -191,12 +208,53 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         uint8_t *p_in = p_pic->p[i_index].p_pixels;
         uint8_t *p_out = p_outpic->p[i_index].p_pixels;
 
-        const int i_lines = p_pic->p[i_index].i_lines;
         const int i_pitch = p_pic->p[i_index].i_pitch;
+        int i_first, i_last;
+
+        filter_SliceLines( p_pic->p[i_index].i_lines, i_slice, i_slices,
+                           &i_first, &i_last );
+        vlc_memcpy( p_out + i_first * i_pitch, p_in + i_first * i_pitch,
+                    (i_last - i_first) * i_pitch );
+    }
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    grain_slice_t ctx;
+
+    if( !p_pic ) return NULL;
 
-        vlc_memcpy( p_out, p_in, i_lines * i_pitch );
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
 
+    if( !p_sys->p_noise )
+    {
+        p_sys->p_noise = (int*)malloc( p_pic->p[Y_PLANE].i_pitch
+                                       * p_pic->p[Y_PLANE].i_visible_lines
+                                       * sizeof(int) );
+        if( !p_sys->p_noise )
+        {
+            picture_Release( p_outpic );
+            picture_Release( p_pic );
+            return NULL;
+        }
     }
 
+    ctx.p_pic = p_pic;
+    ctx.p_outpic = p_outpic;
+    ctx.p_noise = p_sys->p_noise;
+    for( int i = 0; i < FILTER_SLICES_MAX; i++ )
+        ctx.pi_seed[i] = rand();
+
+    /* The grain of a line depends on the noise of the lines around it */
+    filter_SlicesRun( p_sys->p_slices, NoiseSlice, &ctx );
+    filter_SlicesRun( p_sys->p_slices, GrainSlice, &ctx );
+
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
@@ -65,8 +65,16 @@ vlc_module_end();
  *****************************************************************************/
 struct filter_sys_t
 {
+    filter_slices_t *p_slices;
 };
 
+typedef struct
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    int i_planes;
+} invert_slice_t;
+
 /*****************************************************************************
  * Create: allocates Invert video thread output method
  *****************************************************************************
@@ -81,6 +89,7 @@ static int Create( vlc_object_t *p_this )
     if( p_filter->p_sys == NULL )
         return VLC_ENOMEM;
 
+    p_filter->p_sys->p_slices = filter_SlicesNew( p_filter );
     p_filter->pf_video_filter = Filter;
 
     return VLC_SUCCESS;
@@ -95,6 +104,7 @@ static void Destroy( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
+    filter_SlicesDelete( p_filter->p_sys->p_slices );
     free( p_filter->p_sys );
 }
 
@@ -105,44 +115,27 @@ static void Destroy( vlc_object_t *p_this )
  * until it is displayed and switch the two rendering buffers, preparing next
  * frame.
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void FilterSlice( void *p_data, int i_slice, int i_slices )
 {
-    picture_t *p_outpic;
+    invert_slice_t *p_ctx = p_data;
+    picture_t *p_pic = p_ctx->p_pic, *p_outpic = p_ctx->p_outpic;
     int i_index;
-    int i_planes;
-
-    if( !p_pic ) return NULL;
 
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        msg_Warn( p_filter, "can't get output picture" );
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    if( p_pic->format.i_chroma == VLC_FOURCC('Y','U','V','A') )
-    {
-        /* We don't want to invert the alpha plane */
-        i_planes = p_pic->i_planes - 1;
-        vlc_memcpy(
-            p_outpic->p[A_PLANE].p_pixels, p_pic->p[A_PLANE].p_pixels,
-            p_pic->p[A_PLANE].i_pitch *  p_pic->p[A_PLANE].i_lines );
-    }
-    else
-    {
-        i_planes = p_pic->i_planes;
-    }
-
-    for( i_index = 0 ; i_index < i_planes ; i_index++ )
+    for( i_index = 0 ; i_index < p_ctx->i_planes ; i_index++ )
     {
         uint8_t *p_in, *p_in_end, *p_line_end, *p_out;
+        int i_first, i_last;
+
+        filter_SliceLines( p_pic->p[i_index].i_visible_lines,
+                           i_slice, i_slices, &i_first, &i_last );
 
-        p_in = p_pic->p[i_index].p_pixels;
-        p_in_end = p_in + p_pic->p[i_index].i_visible_lines
-                           * p_pic->p[i_index].i_pitch;
+        p_in = p_pic->p[i_index].p_pixels
+                 + i_first * p_pic->p[i_index].i_pitch;
+        p_in_end = p_pic->p[i_index].p_pixels
+                     + i_last * p_pic->p[i_index].i_pitch;
 
-        p_out = p_outpic->p[i_index].p_pixels;
+        p_out = p_outpic->p[i_index].p_pixels
+                  + i_first * p_outpic->p[i_index].i_pitch;
 
         for( ; p_in < p_in_end ; )
         {
@@ -177,6 +170,38 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                      - p_outpic->p[i_index].i_visible_pitch;
         }
     }
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+    int i_planes;
+
+    if( !p_pic ) return NULL;
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        msg_Warn( p_filter, "can't get output picture" );
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    if( p_pic->format.i_chroma == VLC_FOURCC('Y','U','V','A') )
+    {
+        /* We don't want to invert the alpha plane */
+        i_planes = p_pic->i_planes - 1;
+        vlc_memcpy(
+            p_outpic->p[A_PLANE].p_pixels, p_pic->p[A_PLANE].p_pixels,
+            p_pic->p[A_PLANE].i_pitch *  p_pic->p[A_PLANE].i_lines );
+    }
+    else
+    {
+        i_planes = p_pic->i_planes;
+    }
+
+    invert_slice_t ctx = { p_pic, p_outpic, i_planes };
+    filter_SlicesRun( p_filter->p_sys->p_slices, FilterSlice, &ctx );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
@@ -53,6 +53,30 @@ static subpicture_t *Filter ( filter_t *, mtime_t );
 static int MosaicCallback   ( vlc_object_t *, char const *, vlc_value_t,
                               vlc_value_t, void * );
 
+/*****************************************************************************
+ * mosaic_tile_t : a picture of the mosaic
+ *****************************************************************************
+ * The converted pictures are kept from one frame to the next, and are used
+ * again as long as their source picture does not change.
+ *****************************************************************************/
+typedef struct
+{
+    bridged_es_t *p_es;         /* only used as a key */
+    bool b_used;                /* shown in the current frame */
+
+    /* Current frame */
+    picture_t *p_source;        /* to be converted */
+    picture_t *p_picture;       /* to be shown */
+    video_format_t fmt_in, fmt_out;
+    int i_real_index, i_row, i_col;
+    int i_alpha, i_x, i_y;
+
+    /* Last conversion; p_cached is never dereferenced */
+    const picture_t *p_cached;
+    mtime_t i_cached_date;
+    picture_t *p_converted;
+} mosaic_tile_t;
+
 /*****************************************************************************
  * filter_sys_t : filter descriptor
  *****************************************************************************/
@@ -61,7 +85,11 @@ struct filter_sys_t
     vlc_mutex_t lock;         /* Internal filter lock */
     vlc_mutex_t *p_lock;      /* Pointer to mosaic bridge lock */
 
-    image_handler_t *p_image;
+    image_handler_t *pp_image[FILTER_SLICES_MAX]; /* one per slice */
+    filter_slices_t *p_slices;
+
+    mosaic_tile_t **pp_tiles;
+    int i_tiles;
 
     int i_position;           /* Mosaic positioning method */
     bool b_ar;          /* Do we keep the aspect ratio ? */
@@ -276,6 +304,46 @@ static void __mosaic_ParseSetOffsets( vlc_object_t *p_this,
     }
 }
 
+/*****************************************************************************
+ * Tiles
+ *****************************************************************************/
+static mosaic_tile_t *TileGet( filter_sys_t *p_sys, bridged_es_t *p_es )
+{
+    mosaic_tile_t *p_tile;
+    int i;
+
+    for( i = 0; i < p_sys->i_tiles; i++ )
+    {
+        if( p_sys->pp_tiles[i]->p_es == p_es )
+            return p_sys->pp_tiles[i];
+    }
+
+    p_tile = malloc( sizeof( mosaic_tile_t ) );
+    if( p_tile == NULL )
+        return NULL;
+    memset( p_tile, 0, sizeof( mosaic_tile_t ) );
+    p_tile->p_es = p_es;
+    TAB_APPEND( p_sys->i_tiles, p_sys->pp_tiles, p_tile );
+    return p_tile;
+}
+
+static void TileDelete( mosaic_tile_t *p_tile )
+{
+    if( p_tile->p_source )
+        picture_Release( p_tile->p_source );
+    if( p_tile->p_picture )
+        picture_Release( p_tile->p_picture );
+    if( p_tile->p_converted )
+        picture_Release( p_tile->p_converted );
+    free( p_tile );
+}
+
+static bool SameFormat( const video_format_t *a, const video_format_t *b )
+{
+    return a->i_chroma == b->i_chroma && a->i_width == b->i_width
+        && a->i_height == b->i_height;
+}
+
 /*****************************************************************************
  * CreateFiler: allocate mosaic video filter
  *****************************************************************************/
@@ -339,10 +407,11 @@ static int CreateFilter( vlc_object_t *p_this )
 
     p_sys->b_keep = var_CreateGetBoolCommand( p_filter,
                                               CFG_PREFIX "keep-picture" );
-    if ( !p_sys->b_keep )
-    {
-        p_sys->p_image = image_HandlerCreate( p_filter );
-    }
+    /* The image handlers are created by the slices which need them */
+    for( i_index = 0; i_index < FILTER_SLICES_MAX; i_index++ )
+        p_sys->pp_image[i_index] = NULL;
+    p_sys->p_slices = filter_SlicesNew( p_filter );
+    TAB_INIT( p_sys->i_tiles, p_sys->pp_tiles );
 
     p_sys->i_order_length = 0;
     p_sys->ppsz_order = NULL;
@@ -390,13 +459,33 @@ static void DestroyFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t*)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
+    bridge_t *p_bridge;
     int i_index;
 
     vlc_mutex_lock( &p_sys->lock );
 
-    if( !p_sys->b_keep )
+    /* Let the bridges send pictures of their own size again */
+    vlc_mutex_lock( p_sys->p_lock );
+    p_bridge = GetBridge( p_filter );
+    if( p_bridge != NULL )
+    {
+        for( i_index = 0; i_index < p_bridge->i_es_num; i_index++ )
+        {
+            p_bridge->pp_es[i_index]->i_tile_width = 0;
+            p_bridge->pp_es[i_index]->i_tile_height = 0;
+        }
+    }
+    vlc_mutex_unlock( p_sys->p_lock );
+
+    for( i_index = 0; i_index < p_sys->i_tiles; i_index++ )
+        TileDelete( p_sys->pp_tiles[i_index] );
+    TAB_CLEAN( p_sys->i_tiles, p_sys->pp_tiles );
+
+    filter_SlicesDelete( p_sys->p_slices );
+    for( i_index = 0; i_index < FILTER_SLICES_MAX; i_index++ )
     {
-        image_HandlerDelete( p_sys->p_image );
+        if( p_sys->pp_image[i_index] )
+            image_HandlerDelete( p_sys->pp_image[i_index] );
     }
 
     if( p_sys->i_order_length )
@@ -429,6 +518,34 @@ static void MosaicReleasePicture( picture_t *p_picture )
     picture_Release( p_original_pic );
 }
 
+/* Converts the source pictures of every i_slices-th tile, starting with the
+ * i_slice-th one. Each slice has its own image handler, as they keep their
+ * converter from one call to the next. */
+static void ConvertSlice( void *p_data, int i_slice, int i_slices )
+{
+    filter_t *p_filter = p_data;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    int i, i_source = 0;
+
+    for( i = 0; i < p_sys->i_tiles; i++ )
+    {
+        mosaic_tile_t *p_tile = p_sys->pp_tiles[i];
+
+        if( p_tile->p_source == NULL )
+            continue;
+        if( i_source++ % i_slices != i_slice )
+            continue;
+
+        if( p_sys->pp_image[i_slice] == NULL )
+            p_sys->pp_image[i_slice] = image_HandlerCreate( p_filter );
+        if( p_sys->pp_image[i_slice] == NULL )
+            continue;
+        p_tile->p_picture = image_Convert( p_sys->pp_image[i_slice],
+                                           p_tile->p_source,
+                                           &p_tile->fmt_in, &p_tile->fmt_out );
+    }
+}
+
 /*****************************************************************************
  * Filter
  *****************************************************************************/
@@ -441,6 +558,7 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
 
     int i_index, i_real_index, i_row, i_col;
     int i_greatest_real_index_used = p_sys->i_order_length - 1;
+    int i_convert = 0;
 
     unsigned int col_inner_width, row_inner_height;
 
@@ -526,11 +644,15 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
 
     i_real_index = 0;
 
+    for ( i_index = 0; i_index < p_sys->i_tiles; i_index++ )
+        p_sys->pp_tiles[i_index]->b_used = false;
+
+    /* Pick the pictures to show, and what has to be converted */
     for ( i_index = 0; i_index < p_bridge->i_es_num; i_index++ )
     {
         bridged_es_t *p_es = p_bridge->pp_es[i_index];
+        mosaic_tile_t *p_tile;
         video_format_t fmt_in, fmt_out;
-        picture_t *p_converted;
 
         memset( &fmt_in, 0, sizeof( video_format_t ) );
         memset( &fmt_out, 0, sizeof( video_format_t ) );
@@ -590,88 +712,149 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
         i_row = ( i_real_index / p_sys->i_cols ) % p_sys->i_rows;
         i_col = i_real_index % p_sys->i_cols ;
 
+        fmt_in.i_chroma = p_es->p_picture->format.i_chroma;
+        fmt_in.i_height = p_es->p_picture->format.i_height;
+        fmt_in.i_width = p_es->p_picture->format.i_width;
+
         if ( !p_sys->b_keep )
         {
-            /* Convert the images */
-            fmt_in.i_chroma = p_es->p_picture->format.i_chroma;
-            fmt_in.i_height = p_es->p_picture->format.i_height;
-            fmt_in.i_width = p_es->p_picture->format.i_width;
-
             if( fmt_in.i_chroma == VLC_FOURCC('Y','U','V','A') ||
                 fmt_in.i_chroma == VLC_FOURCC('R','G','B','A') )
                 fmt_out.i_chroma = VLC_FOURCC('Y','U','V','A');
             else
                 fmt_out.i_chroma = VLC_FOURCC('I','4','2','0');
-            fmt_out.i_width = col_inner_width;
-            fmt_out.i_height = row_inner_height;
+            mosaic_TileSize( col_inner_width, row_inner_height, p_sys->b_ar,
+                             fmt_in.i_width, fmt_in.i_height,
+                             &fmt_out.i_width, &fmt_out.i_height );
+
+            /* The bridge will scale the next pictures itself */
+            p_es->i_tile_width = col_inner_width;
+            p_es->i_tile_height = row_inner_height;
+            p_es->b_tile_ar = p_sys->b_ar;
+        }
+        else
+        {
+            fmt_out = fmt_in;
+            p_es->i_tile_width = p_es->i_tile_height = 0;
+        }
+        fmt_out.i_visible_width = fmt_out.i_width;
+        fmt_out.i_visible_height = fmt_out.i_height;
 
-            if( p_sys->b_ar ) /* keep aspect ratio */
-            {
-                if( (float)fmt_out.i_width / (float)fmt_out.i_height
-                      > (float)fmt_in.i_width / (float)fmt_in.i_height )
-                {
-                    fmt_out.i_width = ( fmt_out.i_height * fmt_in.i_width )
-                                         / fmt_in.i_height;
-                }
-                else
-                {
-                    fmt_out.i_height = ( fmt_out.i_width * fmt_in.i_height )
-                                        / fmt_in.i_width;
-                }
-             }
+        p_tile = TileGet( p_sys, p_es );
+        if( p_tile == NULL )
+            continue;
+        p_tile->b_used = true;
+        p_tile->fmt_in = fmt_in;
+        p_tile->fmt_out = fmt_out;
+        p_tile->i_real_index = i_real_index;
+        p_tile->i_row = i_row;
+        p_tile->i_col = i_col;
+        p_tile->i_alpha = p_es->i_alpha;
+        p_tile->i_x = p_es->i_x;
+        p_tile->i_y = p_es->i_y;
+
+        if( SameFormat( &fmt_in, &fmt_out ) )
+        {
+            /* Already in shape (kept, or scaled by the bridge) */
+            p_tile->p_picture = p_es->p_picture;
+            picture_Yield( p_tile->p_picture );
+        }
+        else if( p_tile->p_converted != NULL
+              && p_tile->p_cached == p_es->p_picture
+              && p_tile->i_cached_date == p_es->p_picture->date
+              && SameFormat( &p_tile->p_converted->format, &fmt_out ) )
+        {
+            /* Same as last time */
+            p_tile->p_picture = p_tile->p_converted;
+            picture_Yield( p_tile->p_picture );
+        }
+        else
+        {
+            p_tile->p_source = p_es->p_picture;
+            picture_Yield( p_tile->p_source );
+            i_convert++;
+        }
+    }
+
+    vlc_mutex_unlock( p_sys->p_lock );
+
+    for ( i_index = p_sys->i_tiles - 1; i_index >= 0; i_index-- )
+    {
+        mosaic_tile_t *p_tile = p_sys->pp_tiles[i_index];
+
+        if( !p_tile->b_used )
+        {
+            TAB_REMOVE( p_sys->i_tiles, p_sys->pp_tiles, p_tile );
+            TileDelete( p_tile );
+        }
+    }
 
-            fmt_out.i_visible_width = fmt_out.i_width;
-            fmt_out.i_visible_height = fmt_out.i_height;
+    /* Convert the images, without blocking the bridges */
+    if( i_convert > 0 )
+        filter_SlicesRun( p_sys->p_slices, ConvertSlice, p_filter );
 
-            p_converted = image_Convert( p_sys->p_image, p_es->p_picture,
-                                         &fmt_in, &fmt_out );
-            if( !p_converted )
+    for ( i_index = 0; i_index < p_sys->i_tiles; i_index++ )
+    {
+        mosaic_tile_t *p_tile = p_sys->pp_tiles[i_index];
+        video_format_t fmt_out = p_tile->fmt_out;
+
+        if( p_tile->p_source != NULL )
+        {
+            if( p_tile->p_picture != NULL )
+            {
+                if( p_tile->p_converted != NULL )
+                    picture_Release( p_tile->p_converted );
+                p_tile->p_converted = p_tile->p_picture;
+                picture_Yield( p_tile->p_converted );
+                p_tile->p_cached = p_tile->p_source;
+                p_tile->i_cached_date = p_tile->p_source->date;
+            }
+            else
             {
                 msg_Warn( p_filter,
                            "image resizing and chroma conversion failed" );
-                continue;
             }
+            picture_Release( p_tile->p_source );
+            p_tile->p_source = NULL;
         }
-        else
+
+        if( p_tile->p_picture == NULL )
+            continue;
+        if( p_spu == NULL )
         {
-            p_converted = p_es->p_picture;
-            picture_Yield( p_converted );
-            fmt_in.i_width = fmt_out.i_width = p_converted->format.i_width;
-            fmt_in.i_height = fmt_out.i_height = p_converted->format.i_height;
-            fmt_in.i_chroma = fmt_out.i_chroma = p_converted->format.i_chroma;
-            fmt_out.i_visible_width = fmt_out.i_width;
-            fmt_out.i_visible_height = fmt_out.i_height;
+            picture_Release( p_tile->p_picture );
+            p_tile->p_picture = NULL;
+            continue;
         }
 
         p_region = p_spu->pf_make_region( VLC_OBJECT(p_filter), &fmt_out,
-                                          p_converted );
+                                          p_tile->p_picture );
         if( !p_region )
         {
             msg_Err( p_filter, "cannot allocate SPU region" );
             p_filter->pf_sub_buffer_del( p_filter, p_spu );
-            vlc_mutex_unlock( &p_sys->lock );
-            vlc_mutex_unlock( p_sys->p_lock );
-            return p_spu;
+            p_spu = NULL;
+            picture_Release( p_tile->p_picture );
+            p_tile->p_picture = NULL;
+            continue;
         }
 
         /* HACK ALERT: let's fix the pointers to avoid picture duplication.
          * This is necessary because p_region->picture is not a pointer
          * as it ought to be. */
-        if( !p_sys->b_keep )
-        {
-            free( p_converted );
-        }
-        else
-        {
-            /* Keep a pointer to the original picture (and its refcount...). */
-            p_region->picture.p_sys = (picture_sys_t *)p_converted;
-            p_region->picture.pf_release = MosaicReleasePicture;
-        }
+        /* Keep a pointer to the original picture (and its refcount...). */
+        p_region->picture.p_sys = (picture_sys_t *)p_tile->p_picture;
+        p_region->picture.pf_release = MosaicReleasePicture;
+        p_tile->p_picture = NULL;
+
+        i_real_index = p_tile->i_real_index;
+        i_row = p_tile->i_row;
+        i_col = p_tile->i_col;
 
-        if( p_es->i_x >= 0 && p_es->i_y >= 0 )
+        if( p_tile->i_x >= 0 && p_tile->i_y >= 0 )
         {
-            p_region->i_x = p_es->i_x;
-            p_region->i_y = p_es->i_y;
+            p_region->i_x = p_tile->i_x;
+            p_region->i_y = p_tile->i_y;
         }
         else if( p_sys->i_position == position_offsets )
         {
@@ -717,7 +900,7 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
             }
         }
         p_region->i_align = p_sys->i_align;
-        p_region->i_alpha = p_es->i_alpha;
+        p_region->i_alpha = p_tile->i_alpha;
 
         if( p_region_prev == NULL )
         {
@@ -731,7 +914,6 @@ static subpicture_t *Filter( filter_t *p_filter, mtime_t date )
         p_region_prev = p_region;
     }
 
-    vlc_mutex_unlock( p_sys->p_lock );
     vlc_mutex_unlock( &p_sys->lock );
 
     return p_spu;
@@ -927,10 +1109,6 @@ static int MosaicCallback( vlc_object_t *p_this, char const *psz_var,
     {
         vlc_mutex_lock( &p_sys->lock );
         p_sys->b_keep = newval.b_bool;
-        if ( !p_sys->b_keep && !p_sys->p_image )
-        {
-            p_sys->p_image = image_HandlerCreate( p_this );
-        }
         vlc_mutex_unlock( &p_sys->lock );
     }
 
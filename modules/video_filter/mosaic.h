@@ -33,6 +33,12 @@ typedef struct bridged_es_t
     int i_alpha;
     int i_x;
     int i_y;
+
+    /* Tile set by the mosaic filter, so that the bridge can scale its
+     * pictures to it (0 if unknown) */
+    unsigned int i_tile_width;
+    unsigned int i_tile_height;
+    bool b_tile_ar;
 } bridged_es_t;
 
 typedef struct bridge_t
@@ -41,6 +47,27 @@ typedef struct bridge_t
     int i_es_num;
 } bridge_t;
 
+/* Size of a picture of i_width x i_height once fitted in a tile */
+static inline void mosaic_TileSize( unsigned int i_tile_width,
+                                    unsigned int i_tile_height, bool b_ar,
+                                    unsigned int i_width,
+                                    unsigned int i_height,
+                                    unsigned int *pi_width,
+                                    unsigned int *pi_height )
+{
+    *pi_width = i_tile_width;
+    *pi_height = i_tile_height;
+
+    if( b_ar ) /* keep aspect ratio */
+    {
+        if( (float)i_tile_width / (float)i_tile_height
+              > (float)i_width / (float)i_height )
+            *pi_width = ( i_tile_height * i_width ) / i_height;
+        else
+            *pi_height = ( i_tile_width * i_height ) / i_width;
+    }
+}
+
 #define GetBridge(a) __GetBridge( VLC_OBJECT(a) )
 static bridge_t *__GetBridge( vlc_object_t *p_object )
 {
@@ -69,8 +69,16 @@ vlc_module_end();
 struct filter_sys_t
 {
     mtime_t last_date;
+    filter_slices_t *p_slices;
 };
 
+typedef struct
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    unsigned pi_seed[FILTER_SLICES_MAX];
+} noise_slice_t;
+
 /*****************************************************************************
  * Create: allocates Distort video thread output method
  *****************************************************************************
@@ -88,6 +96,7 @@ static int Create( vlc_object_t *p_this )
     p_filter->pf_video_filter = Filter;
 
     p_filter->p_sys->last_date = 0;
+    p_filter->p_sys->p_slices = filter_SlicesNew( p_filter );
 
     return VLC_SUCCESS;
 }
@@ -100,6 +109,7 @@ static int Create( vlc_object_t *p_this )
 static void Destroy( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
+    filter_SlicesDelete( p_filter->p_sys->p_slices );
     free( p_filter->p_sys );
 }
 
@@ -110,39 +120,29 @@ static void Destroy( vlc_object_t *p_this )
  * until it is displayed and switch the two rendering buffers, preparing next
  * frame.
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void FilterSlice( void *p_data, int i_slice, int i_slices )
 {
-    picture_t *p_outpic;
-    filter_sys_t *p_sys = p_filter->p_sys;
+    noise_slice_t *p_ctx = p_data;
+    picture_t *p_pic = p_ctx->p_pic, *p_outpic = p_ctx->p_outpic;
+    unsigned *pi_seed = &p_ctx->pi_seed[i_slice];
     int i_index;
-    mtime_t new_date = mdate();
-
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        msg_Warn( p_filter, "can't get output picture" );
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    p_sys->last_date = new_date;
 
     for( i_index = 0 ; i_index < p_pic->i_planes ; i_index++ )
     {
         uint8_t *p_in = p_pic->p[i_index].p_pixels;
         uint8_t *p_out = p_outpic->p[i_index].p_pixels;
 
-        const int i_num_lines = p_pic->p[i_index].i_visible_lines;
         const int i_num_cols = p_pic->p[i_index].i_visible_pitch;
         const int i_pitch = p_pic->p[i_index].i_pitch;
 
-        int i_line, i_col;
+        int i_line, i_col, i_last;
 
-        for( i_line = 0 ; i_line < i_num_lines ; i_line++ )
+        filter_SliceLines( p_pic->p[i_index].i_visible_lines,
+                           i_slice, i_slices, &i_line, &i_last );
+
+        for( ; i_line < i_last ; i_line++ )
         {
-            if( rand()%8 )
+            if( SliceRand( pi_seed )%8 )
             {
                 /* line isn't noisy */
                 vlc_memcpy( p_out+i_line*i_pitch, p_in+i_line*i_pitch,
@@ -151,22 +151,50 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             else
             {
                 /* this line is noisy */
-                int noise_level = rand()%8+2;
+                int noise_level = SliceRand( pi_seed )%8+2;
                 for( i_col = 0; i_col < i_num_cols ; i_col++ )
                 {
-                    if( rand()%noise_level )
+                    if( SliceRand( pi_seed )%noise_level )
                     {
                         p_out[i_line*i_pitch+i_col] =
                             p_in[i_line*i_pitch+i_col];
                     }
                     else
                     {
-                        p_out[i_line*i_pitch+i_col] = (rand()%3)*0x7f;
+                        p_out[i_line*i_pitch+i_col] =
+                            (SliceRand( pi_seed )%3)*0x7f;
                     }
                 }
             }
         }
     }
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    noise_slice_t ctx;
+    mtime_t new_date = mdate();
+
+    if( !p_pic ) return NULL;
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        msg_Warn( p_filter, "can't get output picture" );
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    p_sys->last_date = new_date;
+
+    /* Each slice draws from its own seed, rand() is not reentrant */
+    ctx.p_pic = p_pic;
+    ctx.p_outpic = p_outpic;
+    for( int i = 0; i < FILTER_SLICES_MAX; i++ )
+        ctx.pi_seed[i] = rand();
+    filter_SlicesRun( p_sys->p_slices, FilterSlice, &ctx );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
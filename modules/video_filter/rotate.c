@@ -89,8 +89,18 @@ struct filter_sys_t
     int     i_angle;
     int     i_cos;
     int     i_sin;
+
+    filter_slices_t *p_slices;
 };
 
+typedef struct
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    int i_sin, i_cos;
+    int i_y_offset, i_u_offset, i_v_offset; /* packed YUV only */
+} rotate_slice_t;
+
 static inline void cache_trigo( int i_angle, int *i_sin, int *i_cos )
 {
     const double f_angle = (((double)i_angle)*M_PI)/1800.;
@@ -147,6 +157,8 @@ static int Create( vlc_object_t *p_this )
 
     cache_trigo( p_sys->i_angle, &p_sys->i_sin, &p_sys->i_cos );
 
+    p_sys->p_slices = filter_SlicesNew( p_filter );
+
     return VLC_SUCCESS;
 }
 
@@ -157,27 +169,19 @@ static void Destroy( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
+    filter_SlicesDelete( p_filter->p_sys->p_slices );
     free( p_filter->p_sys );
 }
 
 /*****************************************************************************
  *
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void FilterSlice( void *p_data, int i_slice, int i_slices )
 {
-    picture_t *p_outpic;
-    filter_sys_t *p_sys = p_filter->p_sys;
+    rotate_slice_t *p_ctx = p_data;
+    picture_t *p_pic = p_ctx->p_pic, *p_outpic = p_ctx->p_outpic;
     int i_plane;
-    const int i_sin = p_sys->i_sin, i_cos = p_sys->i_cos;
-
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
+    const int i_sin = p_ctx->i_sin, i_cos = p_ctx->i_cos;
 
     for( i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
     {
@@ -192,10 +196,15 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         const int i_line_center = i_visible_lines>>1;
         const int i_col_center  = i_visible_pitch>>1;
 
+        int i_first, i_last;
+        filter_SliceLines( i_visible_lines, i_slice, i_slices,
+                           &i_first, &i_last );
+
         const uint8_t *p_in = p_pic->p[i_plane].p_pixels;
-        uint8_t *p_out = p_outpic->p[i_plane].p_pixels;
+        uint8_t *p_out = p_outpic->p[i_plane].p_pixels + i_first * i_pitch;
         uint8_t *p_outendline = p_out + i_visible_pitch;
-        const uint8_t *p_outend = p_out + i_visible_lines * i_pitch;
+        const uint8_t *p_outend = p_outpic->p[i_plane].p_pixels
+                                    + i_last * i_pitch;
 
         const uint8_t black_pixel = ( i_plane == Y_PLANE ) ? 0x00 : 0x80;
 
@@ -205,6 +214,10 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                              - i_sin * i_col_center + (1<<11) );
         int i_col_orig0 =    i_sin * i_line_center / i_aspect
                            - i_cos * i_col_center + (1<<11);
+        /* Skip the lines of the previous slices: each line moves the
+         * origin by (i_cos, -i_sin) / i_aspect */
+        i_line_orig0 += i_first * ( i_line_next + i_sin * i_visible_pitch );
+        i_col_orig0 += i_first * ( i_col_next + i_cos * i_visible_pitch );
         for( ; p_outendline < p_outend;
              p_out += i_hidden_pitch, p_outendline += i_pitch,
              i_line_orig0 += i_line_next, i_col_orig0 += i_col_next )
@@ -277,32 +290,16 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             }
         }
     }
-
-    return CopyInfoAndRelease( p_outpic, p_pic );
 }
 
-/*****************************************************************************
- *
- *****************************************************************************/
-static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
-    const int i_sin = p_sys->i_sin, i_cos = p_sys->i_cos;
+    rotate_slice_t ctx;
 
     if( !p_pic ) return NULL;
 
-    int i_u_offset, i_v_offset, i_y_offset;
-
-    if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
-                             &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
-    {
-        msg_Warn( p_filter, "Unsupported input chroma (%4s)",
-                  (char*)&(p_pic->format.i_chroma) );
-        picture_Release( p_pic );
-        return NULL;
-    }
-
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
     {
@@ -310,6 +307,27 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
         return NULL;
     }
 
+    ctx.p_pic = p_pic;
+    ctx.p_outpic = p_outpic;
+    ctx.i_sin = p_sys->i_sin;
+    ctx.i_cos = p_sys->i_cos;
+    filter_SlicesRun( p_sys->p_slices, FilterSlice, &ctx );
+
+    return CopyInfoAndRelease( p_outpic, p_pic );
+}
+
+/*****************************************************************************
+ *
+ *****************************************************************************/
+static void FilterPackedSlice( void *p_data, int i_slice, int i_slices )
+{
+    rotate_slice_t *p_ctx = p_data;
+    picture_t *p_pic = p_ctx->p_pic, *p_outpic = p_ctx->p_outpic;
+    const int i_sin = p_ctx->i_sin, i_cos = p_ctx->i_cos;
+    const int i_y_offset = p_ctx->i_y_offset;
+    const int i_u_offset = p_ctx->i_u_offset;
+    const int i_v_offset = p_ctx->i_v_offset;
+
     const uint8_t *p_in   = p_pic->p->p_pixels+i_y_offset;
     const uint8_t *p_in_u = p_pic->p->p_pixels+i_u_offset;
     const uint8_t *p_in_v = p_pic->p->p_pixels+i_v_offset;
@@ -325,8 +343,9 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
     const int i_line_center = i_visible_lines>>1;
     const int i_col_center  = i_visible_pitch>>1;
 
-    int i_col, i_line;
-    for( i_line = 0; i_line < i_visible_lines; i_line++ )
+    int i_col, i_line, i_last;
+    filter_SliceLines( i_visible_lines, i_slice, i_slices, &i_line, &i_last );
+    for( ; i_line < i_last; i_line++ )
     {
         for( i_col = 0; i_col < i_visible_pitch; i_col++ )
         {
@@ -376,6 +395,42 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
             }
         }
     }
+}
+
+static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+    filter_sys_t *p_sys = p_filter->p_sys;
+    rotate_slice_t ctx;
+
+    if( !p_pic ) return NULL;
+
+    int i_u_offset, i_v_offset, i_y_offset;
+
+    if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
+                             &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
+    {
+        msg_Warn( p_filter, "Unsupported input chroma (%4s)",
+                  (char*)&(p_pic->format.i_chroma) );
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    ctx.p_pic = p_pic;
+    ctx.p_outpic = p_outpic;
+    ctx.i_sin = p_sys->i_sin;
+    ctx.i_cos = p_sys->i_cos;
+    ctx.i_y_offset = i_y_offset;
+    ctx.i_u_offset = i_u_offset;
+    ctx.i_v_offset = i_v_offset;
+    filter_SlicesRun( p_sys->p_slices, FilterPackedSlice, &ctx );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
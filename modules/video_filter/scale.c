@@ -1,6 +1,7 @@
 /*****************************************************************************
- * resize.c: video scaling module for YUVP/A, I420 and RGBA pictures
- *  Uses the low quality "nearest neighbour" algorithm.
+ * resize.c: video scaling module for YUVP/A, planar YUV and RGBA pictures
+ *  Uses the low quality "nearest neighbour" algorithm for YUVP and RGBA,
+ *  and separable bilinear, bicubic or area filters for planar YUV.
  *****************************************************************************
  * Copyright (C) 2003-2007 the VideoLAN team
  * $Id$
@@ -35,6 +36,56 @@
 #include <vlc_vout.h>
 #include "vlc_filter.h"
 
+#include <math.h>
+
+#if defined(MODULE_NAME_IS_scale_sse2)
+#   include <emmintrin.h>
+#   define SCALE_ALIGN 8 /* 16 bytes of coefficients */
+#else
+#   define SCALE_ALIGN 1
+#endif
+
+enum
+{
+    SCALE_NEAREST,
+    SCALE_BILINEAR,
+    SCALE_BICUBIC,
+    SCALE_AREA,
+};
+
+/* The coefficients are 2.14 fixed point, and the horizontally scaled
+ * lines are kept in 16 bits with 6 bits of decimals. */
+#define COEF_BITS 14
+#define LINE_BITS 6
+
+/*****************************************************************************
+ * scale_table_t: coefficients of a one dimension scaling
+ *****************************************************************************/
+typedef struct
+{
+    int      i_dst;      /* output pixels */
+    int      i_taps;     /* input pixels per output pixel */
+    int      i_stride;   /* coefficients per output pixel (i_taps, padded) */
+    int      i_safe;     /* output pixels which may read i_stride inputs */
+    int     *pi_first;   /* first input pixel of each output pixel */
+    int16_t *pi_coef;
+} scale_table_t;
+
+typedef struct
+{
+    int i_src_width, i_src_height;
+    int i_dst_width, i_dst_height;
+    scale_table_t h, v;
+} scale_plane_t;
+
+/* Per slice work area: a ring of horizontally scaled lines, as many as
+ * the vertical filter needs at once */
+typedef struct
+{
+    int16_t        *p_ring;
+    const int16_t **pp_lines;
+} scale_work_t;
+
 /*****************************************************************************
  * filter_sys_t : filter descriptor
  *****************************************************************************/
@@ -42,8 +93,24 @@ struct filter_sys_t
 {
     es_format_t fmt_in;
     es_format_t fmt_out;
+
+    int i_mode;
+    filter_slices_t *p_slices;
+
+    int i_planes;
+    scale_plane_t p_planes[VOUT_MAX_PLANES];
+    int i_ring_pitch;
+    int i_ring_lines;
+    scale_work_t p_work[FILTER_SLICES_MAX];
 };
 
+typedef struct
+{
+    filter_sys_t *p_sys;
+    picture_t *p_pic;
+    picture_t *p_pic_dst;
+} scale_slice_t;
+
 /****************************************************************************
  * Local prototypes
  ****************************************************************************/
@@ -51,16 +118,63 @@ static int  OpenFilter ( vlc_object_t * );
 static void CloseFilter( vlc_object_t * );
 
 static picture_t *Filter( filter_t *, picture_t * );
+static void FilterNearest( filter_t *, picture_t *, picture_t * );
+static int  TablesUpdate( filter_sys_t *, picture_t *, picture_t * );
+static void TablesClean( filter_sys_t * );
+static void ScaleSlice( void *, int, int );
 
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
+#define MODE_TEXT N_("Scaling mode")
+#define MODE_LONGTEXT N_("Interpolation used to scale planar YUV pictures. " \
+    "Other pictures are always scaled with the nearest neighbour.")
+
+#if !defined(MODULE_NAME_IS_scale_sse2)
+static const int pi_mode_values[] =
+    { SCALE_NEAREST, SCALE_BILINEAR, SCALE_BICUBIC, SCALE_AREA };
+#endif
+static const char *const ppsz_mode_descriptions[] =
+    { N_("Nearest neighbour (bad quality)"), N_("Bilinear"),
+      N_("Bicubic (good quality)"), N_("Area") };
+
 vlc_module_begin();
+#if defined(MODULE_NAME_IS_scale_sse2)
+    set_description( N_("SSE2 video scaling filter") );
+    set_capability( "video filter2", 20 );
+    add_requirement( SSE2 );
+#else
     set_description( N_("Video scaling filter") );
     set_capability( "video filter2", 10 );
+    set_category( CAT_VIDEO );
+    set_subcategory( SUBCAT_VIDEO_VFILTER );
+    /* shared with the SSE2 version */
+    add_integer( "scale-mode", SCALE_BILINEAR, NULL,
+                 MODE_TEXT, MODE_LONGTEXT, true );
+        change_integer_list( pi_mode_values, ppsz_mode_descriptions, NULL );
+#endif
     set_callbacks( OpenFilter, CloseFilter );
 vlc_module_end();
 
+static bool IsPlanarYUV( vlc_fourcc_t i_chroma )
+{
+    switch( i_chroma )
+    {
+        case VLC_FOURCC('I','4','2','0'):
+        case VLC_FOURCC('I','Y','U','V'):
+        case VLC_FOURCC('J','4','2','0'):
+        case VLC_FOURCC('Y','V','1','2'):
+        case VLC_FOURCC('I','4','2','2'):
+        case VLC_FOURCC('J','4','2','2'):
+        case VLC_FOURCC('I','4','4','4'):
+        case VLC_FOURCC('J','4','4','4'):
+        case VLC_FOURCC('Y','U','V','A'):
+            return true;
+        default:
+            return false;
+    }
+}
+
 /*****************************************************************************
  * OpenFilter: probe the filter and return score
  *****************************************************************************/
@@ -70,11 +184,9 @@ static int OpenFilter( vlc_object_t *p_this )
     filter_sys_t *p_sys;
 
     if( ( p_filter->fmt_in.video.i_chroma != VLC_FOURCC('Y','U','V','P') &&
-          p_filter->fmt_in.video.i_chroma != VLC_FOURCC('Y','U','V','A') &&
-          p_filter->fmt_in.video.i_chroma != VLC_FOURCC('I','4','2','0') &&
-          p_filter->fmt_in.video.i_chroma != VLC_FOURCC('Y','V','1','2') &&
           p_filter->fmt_in.video.i_chroma != VLC_FOURCC('R','V','3','2') &&
-          p_filter->fmt_in.video.i_chroma != VLC_FOURCC('R','G','B','A') ) ||
+          p_filter->fmt_in.video.i_chroma != VLC_FOURCC('R','G','B','A') &&
+          !IsPlanarYUV( p_filter->fmt_in.video.i_chroma ) ) ||
         p_filter->fmt_in.video.i_chroma != p_filter->fmt_out.video.i_chroma )
     {
         return VLC_EGENERIC;
@@ -85,11 +197,23 @@ static int OpenFilter( vlc_object_t *p_this )
           (filter_sys_t *)malloc(sizeof(filter_sys_t)) ) == NULL )
         return VLC_ENOMEM;
 
+    p_sys->i_mode = var_CreateGetInteger( p_filter, "scale-mode" );
+    if( p_sys->i_mode < SCALE_NEAREST || p_sys->i_mode > SCALE_AREA ||
+        !IsPlanarYUV( p_filter->fmt_in.video.i_chroma ) )
+        p_sys->i_mode = SCALE_NEAREST;
+    p_sys->p_slices = NULL;
+    if( p_sys->i_mode != SCALE_NEAREST )
+        p_sys->p_slices = filter_SlicesNew( p_filter );
+    p_sys->i_planes = 0;
+    p_sys->i_ring_pitch = p_sys->i_ring_lines = 0;
+    memset( p_sys->p_work, 0, sizeof( p_sys->p_work ) );
+
     p_filter->pf_video_filter = Filter;
 
-    msg_Dbg( p_filter, "%ix%i -> %ix%i", p_filter->fmt_in.video.i_width,
+    msg_Dbg( p_filter, "%ix%i -> %ix%i (%s)", p_filter->fmt_in.video.i_width,
              p_filter->fmt_in.video.i_height, p_filter->fmt_out.video.i_width,
-             p_filter->fmt_out.video.i_height );
+             p_filter->fmt_out.video.i_height,
+             ppsz_mode_descriptions[p_sys->i_mode] );
 
     return VLC_SUCCESS;
 }
@@ -102,16 +226,382 @@ static void CloseFilter( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t*)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    filter_SlicesDelete( p_sys->p_slices );
+    TablesClean( p_sys );
     free( p_sys );
 }
 
+/*****************************************************************************
+ * Coefficient tables
+ *****************************************************************************/
+static double Kernel( int i_mode, double f_x )
+{
+    f_x = fabs( f_x );
+    if( i_mode == SCALE_BILINEAR )
+        return f_x < 1. ? 1. - f_x : 0.;
+
+    /* Keys' cubic convolution, a = -0.5 */
+    if( f_x < 1. )
+        return ( 1.5 * f_x - 2.5 ) * f_x * f_x + 1.;
+    if( f_x < 2. )
+        return ( ( -0.5 * f_x + 2.5 ) * f_x - 4. ) * f_x + 2.;
+    return 0.;
+}
+
+static void TableClean( scale_table_t *p_table )
+{
+    free( p_table->pi_first );
+    free( p_table->pi_coef );
+    p_table->pi_first = NULL;
+    p_table->pi_coef = NULL;
+}
+
+/* When downscaling, the kernel is stretched to cover all the input pixels
+ * (so that there is no aliasing), and the number of taps grows with it.
+ * The taps falling off the picture are folded on its edge pixels. */
+static int TableInit( scale_table_t *p_table, int i_mode,
+                      int i_src, int i_dst, int i_align )
+{
+    const double f_scale = (double)i_src / i_dst;
+    const double f_stretch = f_scale > 1. ? f_scale : 1.;
+    const double f_support = ( i_mode == SCALE_BICUBIC ? 2. : 1. ) * f_stretch;
+    int i_window, x;
+    double *pf_weight;
+
+    if( i_mode == SCALE_AREA )
+        i_window = ceil( f_scale ) + 1;
+    else
+        i_window = ceil( 2. * f_support );
+
+    p_table->i_dst = i_dst;
+    p_table->i_taps = __MIN( i_window, i_src );
+    p_table->i_stride = ( p_table->i_taps + i_align - 1 ) / i_align * i_align;
+    p_table->i_safe = 0;
+    p_table->pi_first = malloc( i_dst * sizeof( int ) );
+    p_table->pi_coef = calloc( i_dst * p_table->i_stride, sizeof( int16_t ) );
+    pf_weight = malloc( p_table->i_taps * sizeof( double ) );
+    if( !p_table->pi_first || !p_table->pi_coef || !pf_weight )
+    {
+        TableClean( p_table );
+        free( pf_weight );
+        return VLC_ENOMEM;
+    }
+
+    for( x = 0; x < i_dst; x++ )
+    {
+        int16_t *pi_coef = &p_table->pi_coef[x * p_table->i_stride];
+        const double f_center = ( x + .5 ) * f_scale - .5;
+        double f_total = 0.;
+        int i_left, i_first, i_sum, i_max, t;
+
+        if( i_mode == SCALE_AREA )
+            i_left = floor( x * f_scale );
+        else
+            i_left = floor( f_center - f_support ) + 1;
+        i_first = __MIN( __MAX( i_left, 0 ), i_src - p_table->i_taps );
+        p_table->pi_first[x] = i_first;
+
+        for( t = 0; t < p_table->i_taps; t++ )
+            pf_weight[t] = 0.;
+        for( t = 0; t < i_window; t++ )
+        {
+            const int j = i_left + t;
+            double f_weight;
+
+            if( i_mode == SCALE_AREA )
+            {
+                /* Overlap of the input pixel with the output one */
+                const double f_start = __MAX( j, x * f_scale );
+                const double f_end = __MIN( j + 1, ( x + 1 ) * f_scale );
+                f_weight = f_end > f_start ? f_end - f_start : 0.;
+            }
+            else
+                f_weight = Kernel( i_mode, ( j - f_center ) / f_stretch );
+            pf_weight[__MIN( __MAX( j, 0 ), i_src - 1 ) - i_first] += f_weight;
+            f_total += f_weight;
+        }
+
+        /* Normalize, and give the rounding error to the main tap */
+        i_sum = 0;
+        i_max = 0;
+        for( t = 0; t < p_table->i_taps; t++ )
+        {
+            pi_coef[t] = floor( pf_weight[t] / f_total
+                                * ( 1 << COEF_BITS ) + .5 );
+            i_sum += pi_coef[t];
+            if( pi_coef[t] > pi_coef[i_max] )
+                i_max = t;
+        }
+        pi_coef[i_max] += ( 1 << COEF_BITS ) - i_sum;
+
+        if( i_first + p_table->i_stride <= i_src )
+            p_table->i_safe = x + 1;
+    }
+    free( pf_weight );
+    return VLC_SUCCESS;
+}
+
+static void TablesClean( filter_sys_t *p_sys )
+{
+    int i;
+
+    for( i = 0; i < p_sys->i_planes; i++ )
+    {
+        TableClean( &p_sys->p_planes[i].h );
+        TableClean( &p_sys->p_planes[i].v );
+    }
+    p_sys->i_planes = 0;
+    for( i = 0; i < FILTER_SLICES_MAX; i++ )
+    {
+        free( p_sys->p_work[i].p_ring );
+        free( p_sys->p_work[i].pp_lines );
+        p_sys->p_work[i].p_ring = NULL;
+        p_sys->p_work[i].pp_lines = NULL;
+    }
+}
+
+/* (Re)computes the tables when the size of the planes changes */
+static int TablesUpdate( filter_sys_t *p_sys, picture_t *p_pic,
+                         picture_t *p_pic_dst )
+{
+    int i, i_slices;
+
+    if( p_sys->i_planes == p_pic->i_planes )
+    {
+        for( i = 0; i < p_sys->i_planes; i++ )
+        {
+            const scale_plane_t *p_plane = &p_sys->p_planes[i];
+
+            if( p_plane->i_src_width != p_pic->p[i].i_visible_pitch ||
+                p_plane->i_src_height != p_pic->p[i].i_visible_lines ||
+                p_plane->i_dst_width != p_pic_dst->p[i].i_visible_pitch ||
+                p_plane->i_dst_height != p_pic_dst->p[i].i_visible_lines )
+                break;
+        }
+        if( i == p_sys->i_planes )
+            return VLC_SUCCESS;
+    }
+
+    TablesClean( p_sys );
+    p_sys->i_ring_pitch = p_sys->i_ring_lines = 0;
+    for( i = 0; i < p_pic->i_planes; i++ )
+    {
+        scale_plane_t *p_plane = &p_sys->p_planes[i];
+
+        p_plane->i_src_width = p_pic->p[i].i_visible_pitch;
+        p_plane->i_src_height = p_pic->p[i].i_visible_lines;
+        p_plane->i_dst_width = p_pic_dst->p[i].i_visible_pitch;
+        p_plane->i_dst_height = p_pic_dst->p[i].i_visible_lines;
+        if( p_plane->i_src_width <= 0 || p_plane->i_src_height <= 0 ||
+            p_plane->i_dst_width <= 0 || p_plane->i_dst_height <= 0 )
+            goto error;
+
+        if( TableInit( &p_plane->h, p_sys->i_mode, p_plane->i_src_width,
+                       p_plane->i_dst_width, SCALE_ALIGN ) )
+            goto error;
+        if( TableInit( &p_plane->v, p_sys->i_mode, p_plane->i_src_height,
+                       p_plane->i_dst_height, 1 ) )
+        {
+            TableClean( &p_plane->h );
+            goto error;
+        }
+        p_sys->i_planes++;
+
+        p_sys->i_ring_pitch = __MAX( p_sys->i_ring_pitch,
+                                     ( p_plane->i_dst_width + 7 ) & ~7 );
+        p_sys->i_ring_lines = __MAX( p_sys->i_ring_lines,
+                                     p_plane->v.i_taps );
+    }
+
+    i_slices = p_sys->p_slices ? FILTER_SLICES_MAX : 1;
+    for( i = 0; i < i_slices; i++ )
+    {
+        scale_work_t *p_work = &p_sys->p_work[i];
+
+        p_work->p_ring = malloc( p_sys->i_ring_lines * p_sys->i_ring_pitch
+                                 * sizeof( int16_t ) );
+        p_work->pp_lines = malloc( p_sys->i_ring_lines
+                                   * sizeof( const int16_t * ) );
+        if( !p_work->p_ring || !p_work->pp_lines )
+            goto error;
+    }
+    return VLC_SUCCESS;
+
+error:
+    /* Do not leave recorded sizes behind: the next picture must retry */
+    TablesClean( p_sys );
+    return VLC_EGENERIC;
+}
+
+/*****************************************************************************
+ * Row kernels
+ *****************************************************************************/
+static void ScaleLine( const scale_table_t *p_table,
+                       const uint8_t *p_src, int16_t *p_dst )
+{
+    int x = 0;
+
+#if defined(MODULE_NAME_IS_scale_sse2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32( 1 << ( COEF_BITS - LINE_BITS - 1 ) );
+
+    /* 4 output pixels at a time, with 8 taps per multiply-add */
+    for( ; x + 4 <= p_table->i_safe; x += 4 )
+    {
+        __m128i p_sum[4], lo, hi;
+        int i;
+
+        for( i = 0; i < 4; i++ )
+        {
+            const uint8_t *p_in = &p_src[p_table->pi_first[x + i]];
+            const int16_t *pi_coef =
+                &p_table->pi_coef[( x + i ) * p_table->i_stride];
+            __m128i sum = _mm_setzero_si128();
+            int t;
+
+            for( t = 0; t < p_table->i_stride; t += 8 )
+            {
+                __m128i in = _mm_loadl_epi64( (const __m128i *)&p_in[t] );
+                in = _mm_unpacklo_epi8( in, zero );
+                sum = _mm_add_epi32( sum, _mm_madd_epi16( in,
+                          _mm_loadu_si128( (const __m128i *)&pi_coef[t] ) ) );
+            }
+            p_sum[i] = sum;
+        }
+
+        /* Transpose and add up the partial sums */
+        lo = _mm_add_epi32( _mm_unpacklo_epi32( p_sum[0], p_sum[1] ),
+                            _mm_unpackhi_epi32( p_sum[0], p_sum[1] ) );
+        hi = _mm_add_epi32( _mm_unpacklo_epi32( p_sum[2], p_sum[3] ),
+                            _mm_unpackhi_epi32( p_sum[2], p_sum[3] ) );
+        lo = _mm_add_epi32( _mm_unpacklo_epi64( lo, hi ),
+                            _mm_unpackhi_epi64( lo, hi ) );
+        lo = _mm_srai_epi32( _mm_add_epi32( lo, round ),
+                             COEF_BITS - LINE_BITS );
+        _mm_storel_epi64( (__m128i *)&p_dst[x], _mm_packs_epi32( lo, lo ) );
+    }
+#endif
+
+    for( ; x < p_table->i_dst; x++ )
+    {
+        const uint8_t *p_in = &p_src[p_table->pi_first[x]];
+        const int16_t *pi_coef = &p_table->pi_coef[x * p_table->i_stride];
+        int i_sum = 0, t;
+
+        for( t = 0; t < p_table->i_taps; t++ )
+            i_sum += p_in[t] * pi_coef[t];
+        p_dst[x] = ( i_sum + ( 1 << ( COEF_BITS - LINE_BITS - 1 ) ) )
+                       >> ( COEF_BITS - LINE_BITS );
+    }
+}
+
+static void ScaleColumns( const int16_t *const *pp_lines,
+                          const int16_t *pi_coef, int i_taps,
+                          uint8_t *p_dst, int i_width )
+{
+    const int i_shift = COEF_BITS + LINE_BITS;
+    int x = 0;
+
+#if defined(MODULE_NAME_IS_scale_sse2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32( 1 << ( i_shift - 1 ) );
+
+    /* 8 output pixels at a time, with 2 taps per multiply-add */
+    for( ; x + 8 <= i_width; x += 8 )
+    {
+        __m128i lo = round, hi = round;
+        int t;
+
+        for( t = 0; t < i_taps; t += 2 )
+        {
+            const bool b_pair = t + 1 < i_taps;
+            const __m128i a =
+                _mm_loadu_si128( (const __m128i *)&pp_lines[t][x] );
+            const __m128i b = b_pair ?
+                _mm_loadu_si128( (const __m128i *)&pp_lines[t + 1][x] ) : zero;
+            const __m128i coef = _mm_set1_epi32( (int)(
+                ( (uint32_t)(uint16_t)( b_pair ? pi_coef[t + 1] : 0 ) << 16 )
+                | (uint16_t)pi_coef[t] ) );
+
+            lo = _mm_add_epi32( lo,
+                     _mm_madd_epi16( _mm_unpacklo_epi16( a, b ), coef ) );
+            hi = _mm_add_epi32( hi,
+                     _mm_madd_epi16( _mm_unpackhi_epi16( a, b ), coef ) );
+        }
+        lo = _mm_packs_epi32( _mm_srai_epi32( lo, i_shift ),
+                              _mm_srai_epi32( hi, i_shift ) );
+        _mm_storel_epi64( (__m128i *)&p_dst[x], _mm_packus_epi16( lo, zero ) );
+    }
+#endif
+
+    for( ; x < i_width; x++ )
+    {
+        int i_sum = 1 << ( i_shift - 1 ), t;
+
+        for( t = 0; t < i_taps; t++ )
+            i_sum += pp_lines[t][x] * pi_coef[t];
+        i_sum >>= i_shift;
+        p_dst[x] = i_sum < 0 ? 0 : i_sum > 255 ? 255 : i_sum;
+    }
+}
+
+/*****************************************************************************
+ * ScaleSlice: scales the lines of a slice of each plane
+ *****************************************************************************
+ * The input lines are scaled horizontally once into the ring, then the
+ * output lines are computed from the ring. Neighbouring slices scale a few
+ * input lines twice.
+ *****************************************************************************/
+static void ScaleSlice( void *p_data, int i_slice, int i_slices )
+{
+    scale_slice_t *p_ctx = p_data;
+    filter_sys_t *p_sys = p_ctx->p_sys;
+    scale_work_t *p_work = &p_sys->p_work[i_slice];
+    int i_plane;
+
+    for( i_plane = 0; i_plane < p_sys->i_planes; i_plane++ )
+    {
+        const scale_plane_t *p_plane = &p_sys->p_planes[i_plane];
+        const plane_t *p_src = &p_ctx->p_pic->p[i_plane];
+        const plane_t *p_dst = &p_ctx->p_pic_dst->p[i_plane];
+        const int i_taps = p_plane->v.i_taps;
+        int i_next = 0; /* next input line to scale horizontally */
+        int y, i_last;
+
+        filter_SliceLines( p_plane->i_dst_height, i_slice, i_slices,
+                           &y, &i_last );
+        for( ; y < i_last; y++ )
+        {
+            const int i_first = p_plane->v.pi_first[y];
+            int t;
+
+            if( i_next < i_first )
+                i_next = i_first;
+            for( ; i_next < i_first + i_taps; i_next++ )
+                ScaleLine( &p_plane->h,
+                           &p_src->p_pixels[i_next * p_src->i_pitch],
+                           &p_work->p_ring[( i_next % i_taps )
+                                           * p_sys->i_ring_pitch] );
+
+            for( t = 0; t < i_taps; t++ )
+                p_work->pp_lines[t] =
+                    &p_work->p_ring[( ( i_first + t ) % i_taps )
+                                    * p_sys->i_ring_pitch];
+            ScaleColumns( p_work->pp_lines,
+                          &p_plane->v.pi_coef[y * p_plane->v.i_stride],
+                          i_taps, &p_dst->p_pixels[y * p_dst->i_pitch],
+                          p_plane->i_dst_width );
+        }
+    }
+}
+
 /****************************************************************************
  * Filter: the whole thing
  ****************************************************************************/
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
+    filter_sys_t *p_sys = p_filter->p_sys;
     picture_t *p_pic_dst;
-    int i_plane;
 
     if( !p_pic ) return NULL;
 
@@ -131,6 +621,28 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         return NULL;
     }
 
+    if( p_sys->i_mode != SCALE_NEAREST &&
+        TablesUpdate( p_sys, p_pic, p_pic_dst ) == VLC_SUCCESS )
+    {
+        scale_slice_t ctx = { p_sys, p_pic, p_pic_dst };
+        filter_SlicesRun( p_sys->p_slices, ScaleSlice, &ctx );
+    }
+    else
+        FilterNearest( p_filter, p_pic, p_pic_dst );
+
+    picture_CopyProperties( p_pic_dst, p_pic );
+    picture_Release( p_pic );
+    return p_pic_dst;
+}
+
+/****************************************************************************
+ * FilterNearest: nearest neighbour scaling
+ ****************************************************************************/
+static void FilterNearest( filter_t *p_filter, picture_t *p_pic,
+                           picture_t *p_pic_dst )
+{
+    int i_plane;
+
     if( p_filter->fmt_in.video.i_chroma != VLC_FOURCC('R','G','B','A') &&
         p_filter->fmt_in.video.i_chroma != VLC_FOURCC('R','V','3','2') )
     {
@@ -222,8 +734,4 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             }
         }
     }
-
-    picture_CopyProperties( p_pic_dst, p_pic );
-    picture_Release( p_pic );
-    return p_pic_dst;
 }
@@ -89,8 +89,16 @@ struct filter_sys_t
 {
     float f_sigma;
     int tab_precalc[512];
+    filter_slices_t *p_slices;
 };
 
+typedef struct
+{
+    filter_sys_t *p_sys;
+    picture_t *p_pic;
+    picture_t *p_outpic;
+} sharpen_slice_t;
+
 /*****************************************************************************
  * clip: avoid negative value and value > 255
  *****************************************************************************/
@@ -135,6 +143,8 @@ static int Create( vlc_object_t *p_this )
 
     init_precalc_table(p_filter->p_sys);
 
+    p_filter->p_sys->p_slices = filter_SlicesNew( p_filter );
+
     return VLC_SUCCESS;
 }
 
@@ -147,6 +157,7 @@ static int Create( vlc_object_t *p_this )
 static void Destroy( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
+    filter_SlicesDelete( p_filter->p_sys->p_slices );
     free( p_filter->p_sys );
 }
 
@@ -157,42 +168,26 @@ static void Destroy( vlc_object_t *p_this )
  * until it is displayed and switch the two rendering buffers, preparing next
  * frame.
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void FilterSlice( void *p_data, int i_slice, int i_slices )
 {
-    picture_t *p_outpic;
-    int i, j;
-    uint8_t *p_src = NULL;
-    uint8_t *p_out = NULL;
+    sharpen_slice_t *p_ctx = p_data;
+    picture_t *p_pic = p_ctx->p_pic, *p_outpic = p_ctx->p_outpic;
+    const int *tab_precalc = p_ctx->p_sys->tab_precalc;
+    int i, j, i_last;
+    uint8_t *p_src = p_pic->p[Y_PLANE].p_pixels;
+    uint8_t *p_out = p_outpic->p[Y_PLANE].p_pixels;
     int i_src_pitch;
     int pix;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
 
-    if( !p_pic ) return NULL;
-    if( !p_filter ) return NULL;
-    if( !p_filter->p_sys ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    /* process the Y plane */
-    p_src = p_pic->p[Y_PLANE].p_pixels;
-    p_out = p_outpic->p[Y_PLANE].p_pixels;
-    if( !p_src || !p_out )
-    {
-        msg_Warn( p_filter, "can't get Y plane" );
-        picture_Release( p_pic );
-        return NULL;
-    }
-
     i_src_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
 
+    filter_SliceLines( p_pic->p[Y_PLANE].i_visible_lines, i_slice, i_slices,
+                       &i, &i_last );
+
     /* perform convolution only on Y plane. Avoid border line. */
-    for( i = 0; i < p_pic->p[Y_PLANE].i_visible_lines; i++ )
+    for( ; i < i_last; i++ )
     {
         if( (i == 0) || (i == p_pic->p[Y_PLANE].i_visible_lines - 1) )
         {
@@ -220,17 +215,47 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
         pix = pix >= 0 ? clip(pix) : -clip(pix * -1);
         p_out[i * i_src_pitch + j] = clip( p_src[i * i_src_pitch + j] +
-            p_filter->p_sys->tab_precalc[pix + 256] );
+            tab_precalc[pix + 256] );
         }
     }
 
+    for( int i_plane = U_PLANE; i_plane <= V_PLANE; i_plane++ )
+    {
+        const int i_pitch = p_outpic->p[i_plane].i_pitch;
+
+        filter_SliceLines( p_outpic->p[i_plane].i_lines, i_slice, i_slices,
+                           &i, &i_last );
+        vlc_memcpy( p_outpic->p[i_plane].p_pixels + i * i_pitch,
+                    p_pic->p[i_plane].p_pixels + i * i_pitch,
+                    (i_last - i) * i_pitch );
+    }
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+
+    if( !p_pic ) return NULL;
+    if( !p_filter ) return NULL;
+    if( !p_filter->p_sys ) return NULL;
 
-    vlc_memcpy( p_outpic->p[U_PLANE].p_pixels, p_pic->p[U_PLANE].p_pixels,
-                p_outpic->p[U_PLANE].i_lines * p_outpic->p[U_PLANE].i_pitch );
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
 
-    vlc_memcpy( p_outpic->p[V_PLANE].p_pixels, p_pic->p[V_PLANE].p_pixels,
-                p_outpic->p[V_PLANE].i_lines * p_outpic->p[V_PLANE].i_pitch );
+    /* process the Y plane */
+    if( !p_pic->p[Y_PLANE].p_pixels || !p_outpic->p[Y_PLANE].p_pixels )
+    {
+        msg_Warn( p_filter, "can't get Y plane" );
+        picture_Release( p_pic );
+        return NULL;
+    }
 
+    sharpen_slice_t ctx = { p_filter->p_sys, p_pic, p_outpic };
+    filter_SlicesRun( p_filter->p_sys->p_slices, FilterSlice, &ctx );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
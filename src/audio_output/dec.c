@@ -346,11 +346,9 @@ int aout_DecPlay( aout_instance_t * p_aout, aout_input_t * p_input,
                   p_buffer->start_date - mdate());
         if( p_input->p_input_thread )
         {
-            vlc_mutex_lock( &p_input->p_input_thread->p->counters.counters_lock);
             stats_UpdateInteger( p_aout,
                            p_input->p_input_thread->p->counters.p_lost_abuffers,
                            1, NULL );
-            vlc_mutex_unlock( &p_input->p_input_thread->p->counters.counters_lock);
         }
         aout_BufferFree( p_buffer );
         return -1;
@@ -402,11 +400,9 @@ int aout_DecPlay( aout_instance_t * p_aout, aout_input_t * p_input,
     aout_MixerRun( p_aout );
     if( p_input->p_input_thread )
     {
-        vlc_mutex_lock( &p_input->p_input_thread->p->counters.counters_lock);
         stats_UpdateInteger( p_aout,
                              p_input->p_input_thread->p->counters.p_played_abuffers,
                              1, NULL );
-        vlc_mutex_unlock( &p_input->p_input_thread->p->counters.counters_lock);
     }
     aout_unlock_mixer( p_aout );
 
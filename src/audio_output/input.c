@@ -753,9 +753,7 @@ static void inputDrop( aout_instance_t *p_aout, aout_input_t *p_input, aout_buff
     if( !p_input->p_input_thread )
         return;
 
-    vlc_mutex_lock( &p_input->p_input_thread->p->counters.counters_lock);
     stats_UpdateInteger( p_aout, p_input->p_input_thread->p->counters.p_lost_abuffers, 1, NULL );
-    vlc_mutex_unlock( &p_input->p_input_thread->p->counters.counters_lock);
 }
 
 static void inputResamplingStop( aout_input_t *p_input )
@@ -152,6 +152,7 @@ int __config_LoadCmdLine( vlc_object_t *p_this, int *pi_argc,
 
         if( !p_parser->i_config_items )
             continue;
+        module_LoadConfig( p_parser );
 
         for( p_item = p_parser->p_config, p_end = p_item + p_parser->confsize;
              p_item < p_end;
@@ -434,6 +434,7 @@ module_config_t *config_FindConfig( vlc_object_t *p_this, const char *psz_name )
          continue;
         if( !p_parser->i_config_items )
             continue;
+        module_LoadConfig( p_parser );
 
         for( p_item = p_parser->p_config, p_end = p_item + p_parser->confsize;
              p_item < p_end;
@@ -464,29 +465,35 @@ module_config_t *config_FindConfig( vlc_object_t *p_this, const char *psz_name )
  *****************************************************************************/
 void config_Free( module_t *p_module )
 {
+    /* Strings of a configuration from the plugins cache are not ours */
+    const bool b_owned = !p_module->b_config_mapped;
     int i;
 
     for (size_t j = 0; j < p_module->confsize; j++)
     {
         module_config_t *p_item = p_module->p_config + j;
 
-        free( p_item->psz_type );
-        free( p_item->psz_name );
-        free( p_item->psz_text );
-        free( p_item->psz_longtext );
-        free( p_item->psz_oldname );
+        if( b_owned )
+        {
+            free( p_item->psz_type );
+            free( p_item->psz_name );
+            free( p_item->psz_text );
+            free( p_item->psz_longtext );
+            free( p_item->psz_oldname );
+        }
 
         if (IsConfigStringType (p_item->i_type))
         {
             free (p_item->value.psz);
-            free (p_item->orig.psz);
+            if( b_owned )
+                free (p_item->orig.psz);
             free (p_item->saved.psz);
         }
 
-        if( p_item->ppsz_list )
+        if( p_item->ppsz_list && b_owned )
             for( i = 0; i < p_item->i_list; i++ )
                 free( p_item->ppsz_list[i] );
-        if( p_item->ppsz_list_text )
+        if( p_item->ppsz_list_text && b_owned )
             for( i = 0; i < p_item->i_list; i++ )
                 free( p_item->ppsz_list_text[i] );
         free( p_item->ppsz_list );
@@ -495,10 +502,9 @@ void config_Free( module_t *p_module )
 
         if( p_item->i_action )
         {
-            for( i = 0; i < p_item->i_action; i++ )
-            {
-                free( p_item->ppsz_action_text[i] );
-            }
+            if( b_owned )
+                for( i = 0; i < p_item->i_action; i++ )
+                    free( p_item->ppsz_action_text[i] );
             free( p_item->ppf_action );
             free( p_item->ppsz_action_text );
         }
@@ -559,6 +565,8 @@ void __config_ResetAll( vlc_object_t *p_this )
     {
         p_module = (module_t *)p_list->p_values[i_index].p_object ;
         if( p_module->b_submodule ) continue;
+        /* Untouched configurations are still at their default values */
+        if( !module_HasConfig( p_module ) ) continue;
 
         for (size_t i = 0; i < p_module->confsize; i++ )
         {
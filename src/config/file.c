@@ -223,6 +223,7 @@ int __config_LoadConfigFile( vlc_object_t *p_this, const char *psz_module_name )
                      && (m->i_config_items > 0)) /* ignore config-less modules */
                     {
                         module = m;
+                        module_LoadConfig (module);
                         if (psz_module_name != NULL)
                             msg_Dbg (p_this,
                                      "loading config for module \"%s\"",
@@ -551,6 +552,7 @@ static int SaveConfigFile( vlc_object_t *p_this, const char *psz_module_name,
 
         if( !p_parser->i_config_items )
             continue;
+        module_LoadConfig( p_parser );
 
         if( psz_module_name )
             msg_Dbg( p_this, "saving config for module \"%s\"",
@@ -681,6 +683,8 @@ int config_AutoSaveConfigFile( vlc_object_t *p_this )
         module_config_t *p_item, *p_end;
 
         if( !p_parser->i_config_items ) continue;
+        /* A configuration which was never loaded cannot have changed */
+        if( !module_HasConfig( p_parser ) ) continue;
 
         for( p_item = p_parser->p_config, p_end = p_item + p_parser->confsize;
              p_item < p_end;
@@ -214,7 +214,7 @@ static void preparse_if_needed( libvlc_media_t *p_md )
     /* XXX: need some locking here */
     if (!p_md->b_preparsed)
     {
-        playlist_PreparseEnqueue(
+        playlist_PreparseEnqueueVisible(
                 libvlc_priv (p_md->p_libvlc_instance->p_libvlc_int)->p_playlist,
                 p_md->p_input_item );
         p_md->b_preparsed = true;
@@ -560,6 +560,86 @@ libvlc_media_is_preparsed( libvlc_media_t * p_md,
     return input_item_IsPreparsed( p_md->p_input_item );
 }
 
+/**************************************************************************
+ * Get statistics of media object.
+ **************************************************************************/
+int
+libvlc_media_get_stats( libvlc_media_t * p_md,
+                                   libvlc_media_stats_t * p_stats,
+                                   libvlc_exception_t * p_e )
+{
+    input_stats_t *p_is;
+
+    if( !p_md || !p_md->p_input_item )
+    {
+        libvlc_exception_raise( p_e, "No input item" );
+        return false;
+    }
+
+    vlc_mutex_lock( &p_md->p_input_item->lock );
+    p_is = p_md->p_input_item->p_stats;
+    if( p_is == NULL )
+    {
+        vlc_mutex_unlock( &p_md->p_input_item->lock );
+        return false;
+    }
+
+    vlc_mutex_lock( &p_is->lock );
+    p_stats->i_read_bytes = p_is->i_read_bytes;
+    p_stats->f_input_bitrate = p_is->f_input_bitrate * 1000;
+    p_stats->i_demux_read_packets = p_is->i_demux_read_packets;
+    p_stats->i_demux_read_bytes = p_is->i_demux_read_bytes;
+    p_stats->f_demux_bitrate = p_is->f_demux_bitrate * 1000;
+    p_stats->i_decoded_video = p_is->i_decoded_video;
+    p_stats->i_decoded_audio = p_is->i_decoded_audio;
+    p_stats->i_displayed_pictures = p_is->i_displayed_pictures;
+    p_stats->i_lost_pictures = p_is->i_lost_pictures;
+    p_stats->i_played_abuffers = p_is->i_played_abuffers;
+    p_stats->i_lost_abuffers = p_is->i_lost_abuffers;
+    p_stats->i_sent_packets = p_is->i_sent_packets;
+    p_stats->i_sent_bytes = p_is->i_sent_bytes;
+    p_stats->f_send_bitrate = p_is->f_send_bitrate * 1000;
+    vlc_mutex_unlock( &p_is->lock );
+    vlc_mutex_unlock( &p_md->p_input_item->lock );
+
+    return true;
+}
+
+/**************************************************************************
+ * Save thumbnails of media object.
+ **************************************************************************/
+int
+libvlc_media_save_thumbnails( libvlc_media_t * p_md,
+                              const char * psz_filepath,
+                              unsigned int i_count,
+                              unsigned int i_width,
+                              unsigned int i_height,
+                              libvlc_exception_t * p_e )
+{
+    int i_ret;
+
+    if( !p_md || !p_md->p_input_item )
+    {
+        libvlc_exception_raise( p_e, "No input item" );
+        return 0;
+    }
+    if( !psz_filepath )
+    {
+        libvlc_exception_raise( p_e, "filepath is null" );
+        return 0;
+    }
+
+    i_ret = input_Thumbnails( p_md->p_libvlc_instance->p_libvlc_int,
+                              p_md->p_input_item, psz_filepath,
+                              i_count, i_width, i_height );
+    if( i_ret < 0 )
+    {
+        libvlc_exception_raise( p_e, "Cannot open media" );
+        return 0;
+    }
+    return i_ret;
+}
+
 /**************************************************************************
  * Sets media descriptor's user_data. user_data is specialized data 
  * accessed by the host application, VLC.framework uses it as a pointer to 
@@ -73,26 +73,26 @@ int input_vaControl( input_thread_t *p_input, int i_query, va_list args )
     {
         case INPUT_GET_POSITION:
             pf = (double*)va_arg( args, double * );
-            *pf = var_GetFloat( p_input, "position" );
+            *pf = var_GetFloatByHandle( p_input->p->vars.p_position );
             return VLC_SUCCESS;
 
         case INPUT_SET_POSITION:
             f = (double)va_arg( args, double );
-            return var_SetFloat( p_input, "position", f );
+            return var_SetFloatByHandle( p_input->p->vars.p_position, f );
 
         case INPUT_GET_LENGTH:
             pi_64 = (int64_t*)va_arg( args, int64_t * );
-            *pi_64 = var_GetTime( p_input, "length" );
+            *pi_64 = var_GetTimeByHandle( p_input->p->vars.p_length );
             return VLC_SUCCESS;
 
         case INPUT_GET_TIME:
             pi_64 = (int64_t*)va_arg( args, int64_t * );
-            *pi_64 = var_GetTime( p_input, "time" );
+            *pi_64 = var_GetTimeByHandle( p_input->p->vars.p_time );
             return VLC_SUCCESS;
 
         case INPUT_SET_TIME:
             i_64 = (int64_t)va_arg( args, int64_t );
-            return var_SetTime( p_input, "time", i_64 );
+            return var_SetTimeByHandle( p_input->p->vars.p_time, i_64 );
 
         case INPUT_GET_RATE:
             pi_int = (int*)va_arg( args, int * );
@@ -297,19 +297,8 @@ int input_vaControl( input_thread_t *p_input, int i_query, va_list args )
 
             if( !psz_name ) return VLC_EGENERIC;
 
-            vlc_mutex_lock( &p_input->p->input.p_item->lock );
-            if( p_input->p->input.p_item->psz_name )
-                free( p_input->p->input.p_item->psz_name );
-            p_input->p->input.p_item->psz_name = strdup( psz_name );
-            vlc_mutex_unlock( &p_input->p->input.p_item->lock );
-
-            if( !p_input->b_preparsing )
-            {
-                vlc_event_t event;
-                event.type = vlc_InputItemNameChanged;
-                event.u.input_item_name_changed.new_name = psz_name;
-                vlc_event_send( &p_input->p->input.p_item->event_manager, &event );
-            }
+            /* Also while preparsing, so that the search index sees it */
+            input_item_SetName( p_input->p->input.p_item, psz_name );
             return VLC_SUCCESS;
         }
 
@@ -625,8 +625,11 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
     input_thread_t  *p_input = p_dec->p_owner->p_input;
     const int       i_rate = p_block->i_rate;
     aout_buffer_t   *p_aout_buf;
+    mtime_t         i_start;
 
-    while( (p_aout_buf = p_dec->pf_decode_audio( p_dec, &p_block )) )
+    for( i_start = mdate();
+         (p_aout_buf = p_dec->pf_decode_audio( p_dec, &p_block )) != NULL;
+         i_start = mdate() )
     {
         aout_instance_t *p_aout = p_dec->p_owner->p_aout;
         aout_input_t    *p_aout_input = p_dec->p_owner->p_aout_input;
@@ -639,9 +642,9 @@ static void DecoderDecodeAudio( decoder_t *p_dec, block_t *p_block )
                 block_Release( p_block );
             break;
         }
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
         stats_UpdateInteger( p_dec, p_input->p->counters.p_decoded_audio, 1, NULL );
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+        stats_UpdateHistogram( p_dec, p_input->p->counters.p_decode_time,
+                               mdate() - i_start );
 
         if( p_aout_buf->start_date < p_dec->p_owner->i_preroll_end )
         {
@@ -837,8 +840,11 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
 {
     input_thread_t *p_input = p_dec->p_owner->p_input;
     picture_t      *p_pic;
+    mtime_t        i_start;
 
-    while( (p_pic = p_dec->pf_decode_video( p_dec, &p_block )) )
+    for( i_start = mdate();
+         (p_pic = p_dec->pf_decode_video( p_dec, &p_block )) != NULL;
+         i_start = mdate() )
     {
         vout_thread_t  *p_vout = p_dec->p_owner->p_vout;
         if( p_dec->b_die )
@@ -850,9 +856,9 @@ static void DecoderDecodeVideo( decoder_t *p_dec, block_t *p_block )
             break;
         }
 
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
         stats_UpdateInteger( p_dec, p_input->p->counters.p_decoded_video, 1, NULL );
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+        stats_UpdateHistogram( p_dec, p_input->p->counters.p_decode_time,
+                               mdate() - i_start );
 
         if( p_pic->date < p_dec->p_owner->i_preroll_end )
         {
@@ -1072,9 +1078,7 @@ static int DecoderDecode( decoder_t *p_dec, block_t *p_block )
 
         while( (p_spu = p_dec->pf_decode_sub( p_dec, p_block ? &p_block : NULL ) ) )
         {
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
             stats_UpdateInteger( p_dec, p_input->p->counters.p_decoded_sub, 1, NULL );
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
 
             p_vout = vlc_object_find( p_dec, VLC_OBJECT_VOUT, FIND_ANYWHERE );
             if( p_vout && p_sys->p_spu_vout == p_vout )
@@ -445,7 +445,7 @@ static void EsOutESVarUpdateGeneric( es_out_t *out, int i_id, es_format_t *fmt,
         val.i_int = i_id;
         var_Change( p_input, psz_var, VLC_VAR_DELCHOICE, &val, NULL );
 
-        var_SetBool( p_sys->p_input, "intf-change", true );
+        input_SendIntfChange( p_sys->p_input );
         return;
     }
 
@@ -498,7 +498,7 @@ static void EsOutESVarUpdateGeneric( es_out_t *out, int i_id, es_format_t *fmt,
             var_SetInteger( p_sys->p_input, "teletext-es", i_id );
     }
 
-    var_SetBool( p_sys->p_input, "intf-change", true );
+    input_SendIntfChange( p_sys->p_input );
 }
 
 static void EsOutESVarUpdate( es_out_t *out, es_out_id_t *es,
@@ -572,7 +572,7 @@ static void EsOutProgramSelect( es_out_t *out, es_out_pgrm_t *p_pgrm )
     input_item_SetPublisher( p_input->p->input.p_item,
                              p_pgrm->psz_publisher );
 
-    var_SetBool( p_sys->p_input, "intf-change", true );
+    input_SendIntfChange( p_sys->p_input );
 }
 
 /* EsOutAddProgram:
@@ -610,7 +610,7 @@ static es_out_pgrm_t *EsOutProgramAdd( es_out_t *out, int i_group )
     }
     else
     {
-        var_SetBool( p_sys->p_input, "intf-change", true );
+        input_SendIntfChange( p_sys->p_input );
     }
     return p_pgrm;
 }
@@ -661,7 +661,7 @@ static int EsOutProgramDel( es_out_t *out, int i_group )
     val.i_int = i_group;
     var_Change( p_input, "program", VLC_VAR_DELCHOICE, &val, NULL );
 
-    var_SetBool( p_sys->p_input, "intf-change", true );
+    input_SendIntfChange( p_sys->p_input );
 
     return VLC_SUCCESS;
 }
@@ -1120,7 +1120,7 @@ static void EsSelect( es_out_t *out, es_out_id_t *es )
     val.i_int = es->i_id;
     var_Change( p_input, psz_var, VLC_VAR_SETVALUE, &val, NULL );
 
-    var_SetBool( p_sys->p_input, "intf-change", true );
+    input_SendIntfChange( p_sys->p_input );
 }
 
 static void EsUnselect( es_out_t *out, es_out_id_t *es, bool b_update )
@@ -1160,7 +1160,7 @@ static void EsUnselect( es_out_t *out, es_out_id_t *es, bool b_update )
                 val.i_int = -1;
                 var_Change( p_input, "spu-es", VLC_VAR_SETVALUE, &val, NULL );
                 if( !b_update )
-                    var_SetBool( p_sys->p_input, "intf-change", true );
+                    input_SendIntfChange( p_sys->p_input );
             }
             EsOutDel( out, es->pp_cc_es[i] );
 
@@ -1189,7 +1189,7 @@ static void EsUnselect( es_out_t *out, es_out_id_t *es, bool b_update )
     val.i_int = -1;
     var_Change( p_input, psz_var, VLC_VAR_SETVALUE, &val, NULL );
 
-    var_SetBool( p_sys->p_input, "intf-change", true );
+    input_SendIntfChange( p_sys->p_input );
 }
 
 /**
@@ -1388,12 +1388,12 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
 
     if( libvlc_stats (p_input) )
     {
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
         stats_UpdateInteger( p_input, p_input->p->counters.p_demux_read,
                              p_block->i_buffer, &i_total );
+        stats_UpdateInteger( p_input, p_input->p->counters.p_demux_packets,
+                             1, NULL );
         stats_UpdateFloat( p_input , p_input->p->counters.p_demux_bitrate,
                            (float)i_total, NULL );
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
     }
 
     /* Mark preroll blocks */
@@ -1489,7 +1489,7 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
             b_cc_new = true;
         }
         if( b_cc_new )
-            var_SetBool( p_sys->p_input, "intf-change", true );
+            input_SendIntfChange( p_sys->p_input );
     }
     else
     {
@@ -1613,7 +1613,7 @@ static int EsOutControl( es_out_t *out, int i_query, va_list args )
             p_sys->b_active = b;
             /* Needed ? */
             if( b )
-                var_SetBool( p_sys->p_input, "intf-change", true );
+                input_SendIntfChange( p_sys->p_input );
             return VLC_SUCCESS;
         }
 
@@ -343,6 +343,12 @@ static void Destructor( input_thread_t * p_input )
 
     vlc_mutex_destroy( &p_input->p->counters.counters_lock );
 
+    var_Release( priv->vars.p_position );
+    var_Release( priv->vars.p_time );
+    var_Release( priv->vars.p_length );
+    if( priv->vars.p_intf_change )
+        var_Release( priv->vars.p_intf_change );
+
     vlc_mutex_destroy( &priv->lock_control );
     free( priv );
 
@@ -740,23 +746,23 @@ static void MainLoop( input_thread_t *p_input )
                                  DEMUX_GET_POSITION, &f_pos ) )
             {
                 val.f_float = (float)f_pos;
-                var_Change( p_input, "position", VLC_VAR_SETVALUE, &val, NULL );
+                var_SetValueByHandle( p_input->p->vars.p_position, val );
             }
             if( !demux_Control( p_input->p->input.p_demux,
                                  DEMUX_GET_TIME, &i_time ) )
             {
                 p_input->i_time = i_time;
                 val.i_time = i_time;
-                var_Change( p_input, "time", VLC_VAR_SETVALUE, &val, NULL );
+                var_SetValueByHandle( p_input->p->vars.p_time, val );
 
             }
             if( !demux_Control( p_input->p->input.p_demux,
                                  DEMUX_GET_LENGTH, &i_length ) )
             {
                 vlc_value_t old_val;
-                var_Get( p_input, "length", &old_val );
+                var_GetByHandle( p_input->p->vars.p_length, &old_val );
                 val.i_time = i_length;
-                var_Change( p_input, "length", VLC_VAR_SETVALUE, &val, NULL );
+                var_SetValueByHandle( p_input->p->vars.p_length, val );
 
                 if( old_val.i_time != val.i_time )
                 {
@@ -764,7 +770,7 @@ static void MainLoop( input_thread_t *p_input )
                 }
             }
 
-            var_SetBool( p_input, "intf-change", true );
+            input_SendIntfChange( p_input );
             i_intf_update = mdate() + INT64_C(150000);
         }
         /* 150ms * 8 = ~ 1 second */
@@ -782,6 +788,7 @@ static void MainLoop( input_thread_t *p_input )
     vlc_object_detach( p_wait_demux );
     value.i_time = -1;
     var_Set( p_wait_demux, "demuxing", value );
+    vlc_object_kill( p_wait_demux );
     vlc_object_release( p_wait_demux );
 }
 
@@ -797,6 +804,7 @@ static void InitStatistics( input_thread_t * p_input )
         INIT_COUNTER( read_bytes, INTEGER, COUNTER );
         INIT_COUNTER( read_packets, INTEGER, COUNTER );
         INIT_COUNTER( demux_read, INTEGER, COUNTER );
+        INIT_COUNTER( demux_packets, INTEGER, COUNTER );
         INIT_COUNTER( input_bitrate, FLOAT, DERIVATIVE );
         INIT_COUNTER( demux_bitrate, FLOAT, DERIVATIVE );
         INIT_COUNTER( played_abuffers, INTEGER, COUNTER );
@@ -806,6 +814,8 @@ static void InitStatistics( input_thread_t * p_input )
         INIT_COUNTER( decoded_audio, INTEGER, COUNTER );
         INIT_COUNTER( decoded_video, INTEGER, COUNTER );
         INIT_COUNTER( decoded_sub, INTEGER, COUNTER );
+        INIT_COUNTER( decode_time, TIME, HISTOGRAM );
+        INIT_COUNTER( picture_lateness, TIME, HISTOGRAM );
         p_input->p->counters.p_sout_send_bitrate = NULL;
         p_input->p->counters.p_sout_sent_packets = NULL;
         p_input->p->counters.p_sout_sent_bytes = NULL;
@@ -1249,6 +1259,7 @@ error:
         EXIT_COUNTER( read_bytes );
         EXIT_COUNTER( read_packets );
         EXIT_COUNTER( demux_read );
+        EXIT_COUNTER( demux_packets );
         EXIT_COUNTER( input_bitrate );
         EXIT_COUNTER( demux_bitrate );
         EXIT_COUNTER( played_abuffers );
@@ -1258,6 +1269,8 @@ error:
         EXIT_COUNTER( decoded_audio );
         EXIT_COUNTER( decoded_video );
         EXIT_COUNTER( decoded_sub );
+        EXIT_COUNTER( decode_time );
+        EXIT_COUNTER( picture_lateness );
 
         if( p_input->p->p_sout )
         {
@@ -1339,6 +1352,7 @@ static void End( input_thread_t * p_input )
             CL_CO( read_bytes );
             CL_CO( read_packets );
             CL_CO( demux_read );
+            CL_CO( demux_packets );
             CL_CO( input_bitrate );
             CL_CO( demux_bitrate );
             CL_CO( played_abuffers );
@@ -1348,6 +1362,8 @@ static void End( input_thread_t * p_input )
             CL_CO( decoded_audio) ;
             CL_CO( decoded_video );
             CL_CO( decoded_sub) ;
+            CL_CO( decode_time );
+            CL_CO( picture_lateness );
         }
 
         /* Close optional stream output instance */
@@ -2951,7 +2967,11 @@ static void* WaitDemuxThread( vlc_object_t *p_this )
    var_Set( p_this, "demuxing", value  );
    b_stop_responding = TRUE;
   }
-  msleep( 1*1000000 );
+  /* Sleep for a second, unless the input is done */
+  vlc_object_lock( p_this );
+  if( vlc_object_alive( p_this ) )
+      vlc_object_timedwait( p_this, mdate() + 1*1000000 );
+  vlc_object_unlock( p_this );
  }
  return NULL;
 }
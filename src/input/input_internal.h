@@ -128,6 +128,7 @@ struct input_thread_private_t
         counter_t *p_read_bytes;
         counter_t *p_input_bitrate;
         counter_t *p_demux_read;
+        counter_t *p_demux_packets;
         counter_t *p_demux_bitrate;
         counter_t *p_decoded_audio;
         counter_t *p_decoded_video;
@@ -139,9 +140,20 @@ struct input_thread_private_t
         counter_t *p_lost_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
+        counter_t *p_decode_time;
+        counter_t *p_picture_lateness;
         vlc_mutex_t counters_lock;
     } counters;
 
+    /* Handles of the variables which the input thread updates all the time;
+     * p_intf_change is NULL while preparsing */
+    struct {
+        variable_t *p_position;
+        variable_t *p_time;
+        variable_t *p_length;
+        variable_t *p_intf_change;
+    } vars;
+
     /* Buffer of pending actions */
     vlc_mutex_t lock_control;
     int i_control;
@@ -421,6 +433,13 @@ static inline void input_ChangeState( input_thread_t *p_input, int state )
     input_ChangeStateWithVarCallback( p_input, state, true );
 }
 
+/* Tells the interfaces that something changed, through "intf-change" */
+static inline void input_SendIntfChange( input_thread_t *p_input )
+{
+    if( p_input->p->vars.p_intf_change )
+        var_SetBoolByHandle( p_input->p->vars.p_intf_change, true );
+}
+
 
 /* Access */
 
@@ -182,8 +182,17 @@ void input_item_CopyOptions( input_item_t *p_parent,
 
 void input_item_SetName( input_item_t *p_item, const char *psz_name )
 {
+    vlc_event_t event;
+
+    vlc_mutex_lock( &p_item->lock );
     free( p_item->psz_name );
     p_item->psz_name = strdup( psz_name );
+    vlc_mutex_unlock( &p_item->lock );
+
+    /* Notify interested third parties */
+    event.type = vlc_InputItemNameChanged;
+    event.u.input_item_name_changed.new_name = psz_name;
+    vlc_event_send( &p_item->event_manager, &event );
 }
 
 /* This won't hold the item, but can tell to interested third parties
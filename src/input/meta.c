@@ -99,29 +99,46 @@ int input_ArtFind( playlist_t *p_playlist, input_item_t *p_item )
     /* If we already checked this album in this session, skip */
     if( psz_artist && psz_album )
     {
+        bool b_searched = false, b_found = false;
+        char *psz_arturl = NULL;
+
+        /* The albums are recorded by the fetchers running at the same time */
+        PL_LOCK;
         FOREACH_ARRAY( playlist_album_t album, p_playlist->p_fetcher->albums )
             if( !strcmp( album.psz_artist, psz_artist ) &&
                 !strcmp( album.psz_album, psz_album ) )
             {
-                msg_Dbg( p_playlist, " %s - %s has already been searched",
-                         psz_artist, psz_album );
-        /* TODO-fenrir if we cache art filename too, we can go faster */
-                free( psz_artist );
-                free( psz_album );
-                if( album.b_found )
-                {
-                    if( !strncmp( album.psz_arturl, "file://", 7 ) )
-                        input_item_SetArtURL( p_item, album.psz_arturl );
-                    else /* Actually get URL from cache */
-                        input_FindArtInCache( p_playlist, p_item );
-                    return 0;
-                }
-                else
-                {
-                    return VLC_EGENERIC;
-                }
+                b_searched = true;
+                b_found = album.b_found;
+                if( album.psz_arturl )
+                    psz_arturl = strdup( album.psz_arturl );
+                break;
             }
         FOREACH_END();
+        PL_UNLOCK;
+
+        if( b_searched )
+        {
+            msg_Dbg( p_playlist, " %s - %s has already been searched",
+                     psz_artist, psz_album );
+    /* TODO-fenrir if we cache art filename too, we can go faster */
+            free( psz_artist );
+            free( psz_album );
+            if( b_found )
+            {
+                if( psz_arturl && !strncmp( psz_arturl, "file://", 7 ) )
+                    input_item_SetArtURL( p_item, psz_arturl );
+                else /* Actually get URL from cache */
+                    input_FindArtInCache( p_playlist, p_item );
+                free( psz_arturl );
+                return 0;
+            }
+            else
+            {
+                free( psz_arturl );
+                return VLC_EGENERIC;
+            }
+        }
     }
     free( psz_artist );
     free( psz_album );
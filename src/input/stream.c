@@ -1883,13 +1883,11 @@ static int AReadStream( stream_t *s, void *p_read, unsigned int i_read )
             vlc_object_kill( s );
         if( p_input )
         {
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
             stats_UpdateInteger( s, p_input->p->counters.p_read_bytes, i_read,
                              &i_total );
             stats_UpdateFloat( s, p_input->p->counters.p_input_bitrate,
                            (float)i_total, NULL );
             stats_UpdateInteger( s, p_input->p->counters.p_read_packets, 1, NULL );
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
         }
         return i_read;
     }
@@ -1923,12 +1921,10 @@ static int AReadStream( stream_t *s, void *p_read, unsigned int i_read )
     /* Update read bytes in input */
     if( p_input )
     {
-        vlc_mutex_lock( &p_input->p->counters.counters_lock );
         stats_UpdateInteger( s, p_input->p->counters.p_read_bytes, i_read, &i_total );
         stats_UpdateFloat( s, p_input->p->counters.p_input_bitrate,
                        (float)i_total, NULL );
         stats_UpdateInteger( s, p_input->p->counters.p_read_packets, 1, NULL );
-        vlc_mutex_unlock( &p_input->p->counters.counters_lock );
     }
     return i_read;
 }
@@ -1954,13 +1950,11 @@ static block_t *AReadBlock( stream_t *s, bool *pb_eof )
         if( pb_eof ) *pb_eof = p_access->info.b_eof;
         if( p_input && p_block && libvlc_stats (p_access) )
         {
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
             stats_UpdateInteger( s, p_input->p->counters.p_read_bytes,
                                  p_block->i_buffer, &i_total );
             stats_UpdateFloat( s, p_input->p->counters.p_input_bitrate,
                               (float)i_total, NULL );
             stats_UpdateInteger( s, p_input->p->counters.p_read_packets, 1, NULL );
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
         }
         return p_block;
     }
@@ -1995,14 +1989,12 @@ static block_t *AReadBlock( stream_t *s, bool *pb_eof )
     {
         if( p_input )
         {
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
             stats_UpdateInteger( s, p_input->p->counters.p_read_bytes,
                                  p_block->i_buffer, &i_total );
             stats_UpdateFloat( s, p_input->p->counters.p_input_bitrate,
                               (float)i_total, NULL );
             stats_UpdateInteger( s, p_input->p->counters.p_read_packets,
                                  1 , NULL);
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
         }
     }
     return p_block;
@@ -0,0 +1,512 @@
+/*****************************************************************************
+ * thumbnail.c: key frame thumbnails of an input item
+ *****************************************************************************
+ * Copyright (C) 2009 the VideoLAN team
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_es_out.h>
+#include <vlc_codec.h>
+#include <vlc_vout.h>
+#include <vlc_image.h>
+
+#include "input_internal.h"
+
+/* The thumbnails are taken without an input thread: the demuxer is driven
+ * directly, with an es_out that only keeps the first video ES. After each
+ * seek, the blocks go to a new decoder (and packetizer) until it outputs a
+ * picture; the frames that are known not to be key frames are dropped,
+ * and avcodec is told to skip them too. */
+
+/* Give up when a demuxer has not shown any video after that many calls */
+#define THUMBNAIL_MAX_DEMUX_NO_VIDEO 1000
+
+typedef struct
+{
+    es_format_t fmt;
+    bool        b_selected;
+} thumbnail_es_t;
+
+typedef struct
+{
+    es_out_t       out;             /* must be the first member */
+    vlc_object_t   *p_parent;
+
+    int            i_es;
+    thumbnail_es_t **pp_es;
+    thumbnail_es_t *p_video;        /* the ES the thumbnails are taken from */
+    decoder_t      *p_packetizer;
+    decoder_t      *p_dec;
+    bool           b_error;
+
+    picture_t      *p_pic;          /* first picture since the last seek */
+} thumbnail_t;
+
+/*****************************************************************************
+ * Decoder
+ *****************************************************************************/
+static picture_t *video_new_buffer( decoder_t *p_dec )
+{
+    p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
+    return picture_New( p_dec->fmt_out.video.i_chroma,
+                        p_dec->fmt_out.video.i_width,
+                        p_dec->fmt_out.video.i_height,
+                        p_dec->fmt_out.video.i_aspect );
+}
+
+static void video_del_buffer( decoder_t *p_dec, picture_t *p_pic )
+{
+    (void)p_dec;
+    picture_Release( p_pic );
+}
+
+static void video_link_picture( decoder_t *p_dec, picture_t *p_pic )
+{
+    (void)p_dec;
+    picture_Yield( p_pic );
+}
+
+static void video_unlink_picture( decoder_t *p_dec, picture_t *p_pic )
+{
+    (void)p_dec;
+    picture_Release( p_pic );
+}
+
+static void DeleteDecoder( decoder_t *p_dec )
+{
+    vlc_object_detach( p_dec );
+
+    if( p_dec->p_module ) module_Unneed( p_dec, p_dec->p_module );
+
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+
+    vlc_object_release( p_dec );
+}
+
+static decoder_t *CreateDecoder( vlc_object_t *p_this, const es_format_t *fmt,
+                                 bool b_packetizer )
+{
+    decoder_t *p_dec;
+
+    p_dec = vlc_object_create( p_this, VLC_OBJECT_DECODER );
+    if( p_dec == NULL )
+        return NULL;
+
+    p_dec->p_module = NULL;
+    es_format_Copy( &p_dec->fmt_in, fmt );
+    es_format_Init( &p_dec->fmt_out, UNKNOWN_ES, 0 );
+    p_dec->b_pace_control = true;
+
+    p_dec->pf_vout_buffer_new = video_new_buffer;
+    p_dec->pf_vout_buffer_del = video_del_buffer;
+    p_dec->pf_picture_link    = video_link_picture;
+    p_dec->pf_picture_unlink  = video_unlink_picture;
+
+    vlc_object_attach( p_dec, p_this );
+
+    if( b_packetizer )
+    {
+        p_dec->p_module = module_Need( p_dec, "packetizer", "$packetizer", 0 );
+    }
+    else
+    {
+        /* Only the key frames are wanted (2 is AVDISCARD_NONKEY) */
+        var_Create( p_dec, "ffmpeg-skip-frame", VLC_VAR_INTEGER );
+        var_SetInteger( p_dec, "ffmpeg-skip-frame", 2 );
+        p_dec->p_module = module_Need( p_dec, "decoder", "$codec", 0 );
+    }
+    if( !p_dec->p_module )
+    {
+        msg_Err( p_this, "no suitable %s module for fourcc `%4.4s'",
+                 b_packetizer ? "packetizer" : "decoder",
+                 (char *)&p_dec->fmt_in.i_codec );
+        DeleteDecoder( p_dec );
+        return NULL;
+    }
+    return p_dec;
+}
+
+/* Forgets everything about the previous position */
+static void ThumbnailFlush( thumbnail_t *p_thumb )
+{
+    if( p_thumb->p_pic )
+    {
+        picture_Release( p_thumb->p_pic );
+        p_thumb->p_pic = NULL;
+    }
+    if( p_thumb->p_dec )
+    {
+        DeleteDecoder( p_thumb->p_dec );
+        p_thumb->p_dec = NULL;
+    }
+    if( p_thumb->p_packetizer )
+    {
+        DeleteDecoder( p_thumb->p_packetizer );
+        p_thumb->p_packetizer = NULL;
+    }
+}
+
+static void ThumbnailDecode( thumbnail_t *p_thumb, block_t *p_block )
+{
+    picture_t *p_pic;
+
+    /* Skip the frames the demuxer or the packetizer flagged as not key */
+    if( p_thumb->p_pic || p_thumb->b_error ||
+        ( p_block->i_flags & ( BLOCK_FLAG_TYPE_P | BLOCK_FLAG_TYPE_B |
+                               BLOCK_FLAG_TYPE_PB ) ) )
+    {
+        block_Release( p_block );
+        return;
+    }
+
+    if( !p_thumb->p_dec )
+    {
+        p_thumb->p_dec =
+            CreateDecoder( p_thumb->p_parent,
+                           p_thumb->p_packetizer ?
+                               &p_thumb->p_packetizer->fmt_out :
+                               &p_thumb->p_video->fmt, false );
+        if( !p_thumb->p_dec )
+        {
+            p_thumb->b_error = true;
+            block_Release( p_block );
+            return;
+        }
+    }
+
+    while( ( p_pic = p_thumb->p_dec->pf_decode_video( p_thumb->p_dec,
+                                                      &p_block ) ) )
+    {
+        if( p_thumb->p_pic )
+            picture_Release( p_pic );
+        else
+            p_thumb->p_pic = p_pic;
+    }
+}
+
+/*****************************************************************************
+ * ES out
+ *****************************************************************************/
+static es_out_id_t *EsOutAdd( es_out_t *out, es_format_t *p_fmt )
+{
+    thumbnail_t *p_thumb = (thumbnail_t *)out;
+    thumbnail_es_t *p_es = malloc( sizeof( *p_es ) );
+
+    if( !p_es )
+        return NULL;
+    es_format_Copy( &p_es->fmt, p_fmt );
+    p_es->b_selected = p_fmt->i_cat == VIDEO_ES && !p_thumb->p_video;
+    if( p_es->b_selected )
+        p_thumb->p_video = p_es;
+    TAB_APPEND( p_thumb->i_es, p_thumb->pp_es, p_es );
+    return (es_out_id_t *)p_es;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *id )
+{
+    thumbnail_t *p_thumb = (thumbnail_t *)out;
+    thumbnail_es_t *p_es = (thumbnail_es_t *)id;
+
+    if( p_es == p_thumb->p_video )
+    {
+        ThumbnailFlush( p_thumb );
+        p_thumb->p_video = NULL;
+    }
+    TAB_REMOVE( p_thumb->i_es, p_thumb->pp_es, p_es );
+    es_format_Clean( &p_es->fmt );
+    free( p_es );
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    thumbnail_t *p_thumb = (thumbnail_t *)out;
+    thumbnail_es_t *p_es = (thumbnail_es_t *)id;
+    decoder_t *p_packetizer;
+    block_t *p_out;
+
+    if( !p_es->b_selected || p_thumb->p_pic || p_thumb->b_error )
+    {
+        block_Release( p_block );
+        return VLC_SUCCESS;
+    }
+
+    if( p_es->fmt.b_packetized )
+    {
+        ThumbnailDecode( p_thumb, p_block );
+        return VLC_SUCCESS;
+    }
+
+    if( !p_thumb->p_packetizer )
+    {
+        p_thumb->p_packetizer = CreateDecoder( p_thumb->p_parent,
+                                               &p_es->fmt, true );
+        if( !p_thumb->p_packetizer )
+        {
+            p_thumb->b_error = true;
+            block_Release( p_block );
+            return VLC_EGENERIC;
+        }
+    }
+    p_packetizer = p_thumb->p_packetizer;
+
+    while( ( p_out = p_packetizer->pf_packetize( p_packetizer, &p_block ) ) )
+    {
+        while( p_out )
+        {
+            block_t *p_next = p_out->p_next;
+
+            p_out->p_next = NULL;
+            ThumbnailDecode( p_thumb, p_out );
+            p_out = p_next;
+        }
+    }
+    return VLC_SUCCESS;
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    thumbnail_es_t *p_es;
+    (void)out;
+
+    switch( i_query )
+    {
+        case ES_OUT_GET_ES_STATE:
+            p_es = (thumbnail_es_t *)va_arg( args, es_out_id_t * );
+            *va_arg( args, bool * ) = p_es->b_selected;
+            return VLC_SUCCESS;
+
+        case ES_OUT_GET_ACTIVE:
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+
+        case ES_OUT_GET_MODE:
+            *va_arg( args, int * ) = ES_OUT_MODE_AUTO;
+            return VLC_SUCCESS;
+
+        case ES_OUT_GET_TS:
+        {
+            int64_t i_ts = va_arg( args, int64_t );
+            *va_arg( args, int64_t * ) = i_ts;
+            return VLC_SUCCESS;
+        }
+
+        case ES_OUT_GET_GROUP:
+            *va_arg( args, int * ) = 0;
+            return VLC_SUCCESS;
+
+        case ES_OUT_SET_ES:
+        case ES_OUT_SET_DEFAULT:
+        case ES_OUT_SET_ES_STATE:
+        case ES_OUT_SET_GROUP:
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_GROUP_PCR:
+        case ES_OUT_RESET_PCR:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+        case ES_OUT_SET_GROUP_META:
+        case ES_OUT_SET_GROUP_EPG:
+        case ES_OUT_DEL_GROUP:
+            return VLC_SUCCESS;
+
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+/*****************************************************************************
+ * Thumbnails
+ *****************************************************************************/
+
+/* With several thumbnails, their number goes before the extension */
+static char *ThumbnailName( const char *psz_path, unsigned i, unsigned i_count )
+{
+    const char *psz_ext = strrchr( psz_path, '.' );
+    const char *psz_sep = strrchr( psz_path, DIR_SEP_CHAR );
+    char *psz_name;
+
+    if( i_count <= 1 )
+        return strdup( psz_path );
+    if( !psz_ext || ( psz_sep && psz_sep > psz_ext ) )
+        psz_ext = psz_path + strlen( psz_path );
+    if( asprintf( &psz_name, "%.*s-%05u%s", (int)(psz_ext - psz_path),
+                  psz_path, i + 1, psz_ext ) == -1 )
+        return NULL;
+    return psz_name;
+}
+
+static int ThumbnailWrite( thumbnail_t *p_thumb, image_handler_t *p_image,
+                           const char *psz_name,
+                           unsigned i_width, unsigned i_height )
+{
+    video_format_t fmt_in = p_thumb->p_dec->fmt_out.video;
+    video_format_t fmt_out;
+
+    fmt_in.i_chroma = p_thumb->p_pic->format.i_chroma;
+    if( !fmt_in.i_aspect && fmt_in.i_height )
+        fmt_in.i_aspect = VOUT_ASPECT_FACTOR * fmt_in.i_width /
+                          fmt_in.i_height;
+
+    /* Keep the aspect ratio if only one dimension is given */
+    memset( &fmt_out, 0, sizeof( fmt_out ) );
+    fmt_out.i_width = i_width;
+    fmt_out.i_height = i_height;
+    if( fmt_in.i_aspect )
+    {
+        if( !i_height && i_width )
+            fmt_out.i_height = (uint64_t)i_width * VOUT_ASPECT_FACTOR /
+                               fmt_in.i_aspect;
+        if( !i_width && i_height )
+            fmt_out.i_width = (uint64_t)i_height * fmt_in.i_aspect /
+                              VOUT_ASPECT_FACTOR;
+    }
+    if( !fmt_out.i_width || !fmt_out.i_height )
+    {
+        fmt_out.i_width = fmt_in.i_width;
+        fmt_out.i_height = fmt_in.i_height;
+    }
+
+    return image_WriteUrl( p_image, p_thumb->p_pic, &fmt_in, &fmt_out,
+                           psz_name );
+}
+
+/**
+ * Saves thumbnails of an input item, at i_count evenly spaced positions.
+ * The item is opened once; at each position, only the first key frame is
+ * decoded. The pictures are scaled and encoded by the same image handler.
+ *
+ * \param psz_path name of the image file, whose extension gives the format;
+ * with several thumbnails, their number (from 1) is added before the
+ * extension
+ * \param i_width width of the thumbnails, 0 to follow the aspect ratio
+ * \param i_height height of the thumbnails, 0 to follow the aspect ratio
+ * \return the number of thumbnails written, or a negative error code if
+ * the item could not be opened
+ */
+int __input_Thumbnails( vlc_object_t *p_parent, input_item_t *p_item,
+                        const char *psz_path, unsigned i_count,
+                        unsigned i_width, unsigned i_height )
+{
+    thumbnail_t thumb;
+    image_handler_t *p_image;
+    demux_t *p_demux;
+    stream_t *p_stream;
+    const char *psz_access, *psz_demux;
+    char *psz_uri, *psz_dup, *psz_demux_path;
+    int64_t i_length;
+    int i_done = 0;
+
+    psz_uri = input_item_GetURI( p_item );
+    if( !psz_uri )
+        return VLC_ENOMEM;
+    psz_dup = strdup( psz_uri );
+    if( !psz_dup )
+    {
+        free( psz_uri );
+        return VLC_ENOMEM;
+    }
+    input_SplitMRL( &psz_access, &psz_demux, &psz_demux_path, psz_dup );
+
+    memset( &thumb, 0, sizeof( thumb ) );
+    thumb.out.pf_add = EsOutAdd;
+    thumb.out.pf_send = EsOutSend;
+    thumb.out.pf_del = EsOutDel;
+    thumb.out.pf_control = EsOutControl;
+    thumb.out.b_sout = false;
+    thumb.out.p_sys = NULL;
+    thumb.p_parent = p_parent;
+    TAB_INIT( thumb.i_es, thumb.pp_es );
+
+    p_stream = stream_UrlNew( p_parent, psz_uri );
+    if( !p_stream )
+    {
+        msg_Err( p_parent, "cannot open %s", psz_uri );
+        free( psz_dup );
+        free( psz_uri );
+        return VLC_EGENERIC;
+    }
+    p_demux = demux_New( p_parent, psz_access, psz_demux, psz_demux_path,
+                         p_stream, &thumb.out, false );
+    if( !p_demux )
+    {
+        msg_Err( p_parent, "cannot demux %s", psz_uri );
+        stream_Delete( p_stream );
+        free( psz_dup );
+        free( psz_uri );
+        return VLC_EGENERIC;
+    }
+
+    if( demux_Control( p_demux, DEMUX_GET_LENGTH, &i_length ) )
+        i_length = 0;
+    p_image = image_HandlerCreate( p_parent );
+
+    for( unsigned i = 0; p_image && i < i_count; i++ )
+    {
+        const double f_pos = ( 2. * i + 1. ) / ( 2. * i_count );
+        int i_demux = 0, i_ret;
+        char *psz_name;
+
+        ThumbnailFlush( &thumb );
+        if( i_length > 0 )
+            i_ret = demux_Control( p_demux, DEMUX_SET_TIME,
+                                   (int64_t)( f_pos * i_length ) );
+        else
+            i_ret = demux_Control( p_demux, DEMUX_SET_POSITION, f_pos );
+        if( i_ret && i > 0 )
+        {
+            msg_Warn( p_parent, "cannot seek in %s", psz_uri );
+            break;
+        }
+
+        while( !thumb.p_pic && !thumb.b_error &&
+               vlc_object_alive( p_parent ) &&
+               ( thumb.p_video || i_demux++ < THUMBNAIL_MAX_DEMUX_NO_VIDEO ) &&
+               demux_Demux( p_demux ) > 0 );
+        if( !thumb.p_pic )
+        {
+            msg_Warn( p_parent, "no picture decoded from %s", psz_uri );
+            break;
+        }
+
+        psz_name = ThumbnailName( psz_path, i, i_count );
+        if( !psz_name ||
+            ThumbnailWrite( &thumb, p_image, psz_name,
+                            i_width, i_height ) != VLC_SUCCESS )
+        {
+            free( psz_name );
+            break;
+        }
+        msg_Dbg( p_parent, "thumbnail of %s saved to %s", psz_uri, psz_name );
+        free( psz_name );
+        i_done++;
+    }
+
+    ThumbnailFlush( &thumb );
+    if( p_image )
+        image_HandlerDelete( p_image );
+    demux_Delete( p_demux );
+    stream_Delete( p_stream );
+    while( thumb.i_es > 0 )
+        EsOutDel( &thumb.out, (es_out_id_t *)thumb.pp_es[0] );
+    free( psz_dup );
+    free( psz_uri );
+    return i_done;
+}
@@ -231,6 +231,13 @@ void input_ControlVarInit ( input_thread_t *p_input )
         var_SetBool( p_input, "intf-change-vout", true );
     }
 
+    /* Handles for the variables updated by the input thread, released by
+     * the input destructor */
+    p_input->p->vars.p_position = var_Hold( p_input, "position" );
+    p_input->p->vars.p_time = var_Hold( p_input, "time" );
+    p_input->p->vars.p_length = var_Hold( p_input, "length" );
+    p_input->p->vars.p_intf_change = var_Hold( p_input, "intf-change" );
+
     /* Add all callbacks
      * XXX we put callback only in non preparsing mode. We need to create the variable
      * unless someone want to check all var_Get/var_Change return value ... */
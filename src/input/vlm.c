@@ -64,6 +64,7 @@
 static void vlm_Destructor( vlm_t *p_vlm );
 static void* Manage( vlc_object_t * );
 static int vlm_MediaVodControl( void *, vod_media_t *, const char *, int, va_list );
+static vlm_media_instance_sys_t *vlm_ControlMediaInstanceGetByName( vlm_media_sys_t *, const char * );
 
 /*****************************************************************************
  * vlm_New:
@@ -219,10 +220,130 @@ int64_t vlm_Date(void)
 /*****************************************************************************
  *
  *****************************************************************************/
+#define VLM_VOD_SHARED "shared"
+
+static bool vlm_MediaVodIsShared( vlm_media_sys_t *p_media )
+{
+    for( int i = 0; i < p_media->cfg.i_option; i++ )
+        if( !strcmp( p_media->cfg.ppsz_option[i], "vod-shared" ) )
+            return true;
+    return false;
+}
+
+static int vlm_MediaVodSessionFind( vlm_media_sys_t *p_media,
+                                    const char *psz_id )
+{
+    const size_t i_len = strlen( psz_id );
+
+    for( int i = 0; i < p_media->i_vod_session; i++ )
+        if( !strncmp( p_media->vod_session[i], psz_id, i_len ) &&
+            p_media->vod_session[i][i_len] == '\t' )
+            return i;
+    return -1;
+}
+
+/* Starts, updates or stops the instance shared by the RTSP sessions:
+ * its RTP output fans out to the sessions listed in "rtp-fanout" */
+static int vlm_MediaVodSharedUpdate( vlm_t *vlm, vlm_media_sys_t *p_media )
+{
+    vlm_media_instance_sys_t *p_instance;
+    char *psz_output, *psz_list;
+    size_t i_list = 1;
+    int i_ret;
+
+    if( p_media->i_vod_session <= 0 )
+    {
+        if( !vlm_ControlMediaInstanceGetByName( p_media, VLM_VOD_SHARED ) )
+            return VLC_SUCCESS;
+        return vlm_ControlInternal( vlm, VLM_STOP_MEDIA_INSTANCE,
+                                    p_media->cfg.id, VLM_VOD_SHARED );
+    }
+
+    /* The sessions only differ by their destinations: use the muxer of
+     * the first one */
+    config_chain_t *p_cfg = NULL;
+    const char *psz_mux = NULL;
+    char *psz_module;
+
+    free( config_ChainCreate( &psz_module, &p_cfg,
+                              strchr( p_media->vod_session[0], '\t' ) + 1 ) );
+    free( psz_module );
+    for( config_chain_t *p = p_cfg; p != NULL; p = p->p_next )
+        if( !strcmp( p->psz_name, "mux" ) && p->psz_value )
+            psz_mux = p->psz_value;
+    i_ret = asprintf( &psz_output, "rtp{fanout%s%s}", psz_mux ? ",mux=" : "",
+                      psz_mux ? psz_mux : "" );
+    config_ChainDestroy( p_cfg );
+    if( i_ret == -1 )
+        return VLC_ENOMEM;
+    i_ret = vlm_ControlInternal( vlm, VLM_START_MEDIA_VOD_INSTANCE,
+                                 p_media->cfg.id, VLM_VOD_SHARED, 0,
+                                 psz_output );
+    free( psz_output );
+    if( i_ret )
+        return i_ret;
+
+    p_instance = vlm_ControlMediaInstanceGetByName( p_media, VLM_VOD_SHARED );
+    if( !p_instance || !p_instance->p_input )
+        return VLC_EGENERIC;
+
+    for( int i = 0; i < p_media->i_vod_session; i++ )
+        i_list += strlen( p_media->vod_session[i] ) + 1;
+    psz_list = malloc( i_list );
+    if( !psz_list )
+        return VLC_ENOMEM;
+    *psz_list = '\0';
+    for( int i = 0; i < p_media->i_vod_session; i++ )
+    {
+        strcat( psz_list, p_media->vod_session[i] );
+        strcat( psz_list, "\n" );
+    }
+
+    if( var_Type( p_instance->p_input, "rtp-fanout" ) == 0 )
+        var_Create( p_instance->p_input, "rtp-fanout", VLC_VAR_STRING );
+    var_SetString( p_instance->p_input, "rtp-fanout", psz_list );
+    free( psz_list );
+    return VLC_SUCCESS;
+}
+
+static int vlm_MediaVodSharedControl( vlm_t *vlm, vlm_media_sys_t *p_media,
+                                      const char *psz_id, int i_query,
+                                      const char *psz_output )
+{
+    int i_session = vlm_MediaVodSessionFind( p_media, psz_id );
+    char *psz_session;
+
+    switch( i_query )
+    {
+    case VOD_MEDIA_PLAY:
+        if( i_session >= 0 )
+            return VLC_SUCCESS;
+        if( asprintf( &psz_session, "%s\t%s", psz_id, psz_output ) == -1 )
+            return VLC_ENOMEM;
+        TAB_APPEND( p_media->i_vod_session, p_media->vod_session,
+                    psz_session );
+        return vlm_MediaVodSharedUpdate( vlm, p_media );
+
+    case VOD_MEDIA_STOP:
+        if( i_session < 0 )
+            return VLC_EGENERIC;
+        psz_session = p_media->vod_session[i_session];
+        TAB_REMOVE( p_media->i_vod_session, p_media->vod_session,
+                    psz_session );
+        free( psz_session );
+        return vlm_MediaVodSharedUpdate( vlm, p_media );
+
+    default:
+        /* Sessions cannot pause or seek a shared source */
+        return VLC_EGENERIC;
+    }
+}
+
 static int vlm_MediaVodControl( void *p_private, vod_media_t *p_vod_media,
                                 const char *psz_id, int i_query, va_list args )
 {
     vlm_t *vlm = (vlm_t *)p_private;
+    vlm_media_sys_t *p_media = NULL;
     int i, i_ret;
     const char *psz;
     int64_t id;
@@ -237,7 +358,8 @@ static int vlm_MediaVodControl( void *p_private, vod_media_t *p_vod_media,
     {
         if( p_vod_media == vlm->media[i]->vod.p_media )
         {
-            id = vlm->media[i]->cfg.id;
+            p_media = vlm->media[i];
+            id = p_media->cfg.id;
             break;
         }
     }
@@ -247,6 +369,30 @@ static int vlm_MediaVodControl( void *p_private, vod_media_t *p_vod_media,
         return VLC_EGENERIC;
     }
 
+    /* Only RTP outputs can be fanned out, raw UDP sessions get their own
+     * instance */
+    if( psz_id && vlm_MediaVodIsShared( p_media ) )
+    {
+        bool b_shared = vlm_MediaVodSessionFind( p_media, psz_id ) >= 0;
+        va_list args_copy;
+
+        psz = NULL;
+        if( i_query == VOD_MEDIA_PLAY )
+        {
+            va_copy( args_copy, args );
+            psz = (const char *)va_arg( args_copy, const char * );
+            va_end( args_copy );
+            b_shared = b_shared || ( psz && !strncmp( psz, "rtp{", 4 ) );
+        }
+        if( b_shared )
+        {
+            i_ret = vlm_MediaVodSharedControl( vlm, p_media, psz_id,
+                                               i_query, psz );
+            vlc_mutex_unlock( &vlm->lock );
+            return i_ret;
+        }
+    }
+
     switch( i_query )
     {
     case VOD_MEDIA_PLAY:
@@ -642,6 +788,7 @@ static int vlm_ControlMediaAdd( vlm_t *p_vlm, vlm_media_t *p_cfg, int64_t *p_id
 
     p_media->vod.p_media = NULL;
     TAB_INIT( p_media->i_instance, p_media->instance );
+    TAB_INIT( p_media->i_vod_session, p_media->vod_session );
 
     /* */
     TAB_APPEND( p_vlm->i_media, p_vlm->media, p_media );
@@ -662,6 +809,13 @@ static int vlm_ControlMediaDel( vlm_t *p_vlm, int64_t id )
     while( p_media->i_instance > 0 )
         vlm_ControlInternal( p_vlm, VLM_STOP_MEDIA_INSTANCE, id, p_media->instance[0]->psz_name );
 
+    while( p_media->i_vod_session > 0 )
+    {
+        char *psz_session = p_media->vod_session[0];
+        TAB_REMOVE( p_media->i_vod_session, p_media->vod_session, psz_session );
+        free( psz_session );
+    }
+
     if( p_media->cfg.b_vod )
     {
         p_media->cfg.b_enabled = false;
@@ -831,6 +985,8 @@ static int vlm_ControlMediaInstanceStart( vlm_t *p_vlm, int64_t id, const char *
                 p_instance->b_sout_keep = true;
             else if( !strcmp( p_cfg->ppsz_option[i], "nosout-keep" ) || !strcmp( p_cfg->ppsz_option[i], "no-sout-keep" ) )
                 p_instance->b_sout_keep = false;
+            else if( !strcmp( p_cfg->ppsz_option[i], "vod-shared" ) )
+                ;
             else
                 input_item_AddOption( p_instance->p_item, p_cfg->ppsz_option[i] );
         }
@@ -58,6 +58,11 @@ typedef struct
         vod_media_t *p_media;
     } vod;
 
+    /* RTSP sessions fed by the shared instance ("vod-shared" option),
+     * as "<session>\t<output>" */
+    int                      i_vod_session;
+    char                     **vod_session;
+
     /* actual input instances */
     int                      i_instance;
     vlm_media_instance_sys_t **instance;
@@ -985,6 +985,12 @@ static const char *const ppsz_clock_descriptions[] =
     "the correct demuxer is not automatically detected. You should not "\
     "set this as a global option unless you really know what you are doing." )
 
+#define INDEX_CACHE_TEXT N_("Cache seek indexes")
+#define INDEX_CACHE_LONGTEXT N_( \
+    "Keep the seek index that some demultiplexers have to build by " \
+    "scanning local files without one, so that the next openings of the " \
+    "same files do not have to scan them again." )
+
 #define RT_PRIORITY_TEXT N_("Allow real-time priority")
 #define RT_PRIORITY_LONGTEXT N_( \
     "Running VLC in real-time priority will allow for much more precise " \
@@ -1003,6 +1009,11 @@ static const char *const ppsz_clock_descriptions[] =
 #define MINIMIZE_THREADS_LONGTEXT N_( \
      "This option minimizes the number of threads needed to run VLC.")
 
+#define WORKER_THREADS_TEXT N_("Worker threads")
+#define WORKER_THREADS_LONGTEXT N_( \
+     "Number of threads shared by the modules which run background jobs, " \
+     "such as the transcoders. 0 means one per CPU (at least two).")
+
 #define USE_STREAM_IMMEDIATE N_("(Experimental) Don't do caching at the access level.")
 #define USE_STREAM_IMMEDIATE_LONGTEXT N_( \
      "This option is useful if you want to lower the latency when " \
@@ -1104,6 +1115,16 @@ static const char *const ppsz_clock_descriptions[] =
     "Automatically preparse files added to the playlist " \
     "(to retrieve some metadata)." )
 
+#define PREPARSE_THREADS_TEXT N_( "Preparsed files at once" )
+#define PREPARSE_THREADS_LONGTEXT N_( \
+    "How many files can be preparsed at the same time, on the worker " \
+    "threads. 0 means as many as there are worker threads, but one." )
+
+#define FETCH_THREADS_TEXT N_( "Fetched album arts at once" )
+#define FETCH_THREADS_LONGTEXT N_( \
+    "How many album arts can be fetched at the same time, on the worker " \
+    "threads. 0 means as many as there are worker threads, but one." )
+
 #define ALBUM_ART_TEXT N_( "Album art policy" )
 #define ALBUM_ART_LONGTEXT N_( \
     "Choose how album art will be downloaded." )
@@ -1754,6 +1775,8 @@ vlc_module_begin();
     set_subcategory( SUBCAT_INPUT_DEMUX );
     add_module( "demux", "demux", NULL, NULL, DEMUX_TEXT,
                 DEMUX_LONGTEXT, true );
+    add_bool( "index-cache", true, NULL, INDEX_CACHE_TEXT,
+              INDEX_CACHE_LONGTEXT, true );
     set_subcategory( SUBCAT_INPUT_VCODEC );
     set_subcategory( SUBCAT_INPUT_ACODEC );
     set_subcategory( SUBCAT_INPUT_SCODEC );
@@ -1856,6 +1879,8 @@ vlc_module_begin();
     add_bool( "minimize-threads", 0, NULL, MINIMIZE_THREADS_TEXT,
               MINIMIZE_THREADS_LONGTEXT, true );
         change_need_restart();
+    add_integer( "worker-threads", 0, NULL, WORKER_THREADS_TEXT,
+                 WORKER_THREADS_LONGTEXT, true );
 
     add_bool( "use-stream-immediate", false, NULL,
                USE_STREAM_IMMEDIATE, USE_STREAM_IMMEDIATE_LONGTEXT, true );
@@ -1921,6 +1946,12 @@ vlc_module_begin();
 
     add_bool( "auto-preparse", true, NULL, PREPARSE_TEXT,
               PREPARSE_LONGTEXT, false );
+    add_integer( "preparse-threads", 0, NULL, PREPARSE_THREADS_TEXT,
+                 PREPARSE_THREADS_LONGTEXT, true );
+        change_need_restart();
+    add_integer( "fetch-threads", 2, NULL, FETCH_THREADS_TEXT,
+                 FETCH_THREADS_LONGTEXT, true );
+        change_need_restart();
 
     add_integer( "album-art", ALBUM_ART_WHEN_ASKED, NULL, ALBUM_ART_TEXT,
                  ALBUM_ART_LONGTEXT, false );
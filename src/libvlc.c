@@ -675,6 +675,7 @@ int libvlc_InternalInit( libvlc_int_t *p_libvlc, int i_argc,
      * Output messages that may still be in the queue
      */
     msg_Flush( p_libvlc );
+    msg_Defer( p_libvlc );
 
     if( !config_GetInt( p_libvlc, "fpu" ) )
         cpu_flags &= ~CPU_CAPABILITY_FPU;
@@ -1426,7 +1427,7 @@ static void Usage( libvlc_int_t *p_this, char const *psz_module_name )
         module_t *p_parser = (module_t *)p_list->p_values[i_index].p_object;
         module_config_t *p_item = NULL;
         module_config_t *p_section = NULL;
-        module_config_t *p_end = p_parser->p_config + p_parser->confsize;
+        module_config_t *p_end;
 
         if( psz_module_name && strcmp( psz_module_name,
                                        p_parser->psz_object_name ) )
@@ -1447,6 +1448,8 @@ static void Usage( libvlc_int_t *p_this, char const *psz_module_name )
         {
             continue;
         }
+        module_LoadConfig( p_parser );
+        p_end = p_parser->p_config + p_parser->confsize;
 
         b_help_module = !strcmp( "help", p_parser->psz_object_name );
         /* Ugly hack to make sure that the help options always come first
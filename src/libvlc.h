@@ -90,9 +90,14 @@ typedef struct msg_bank_t
 {
     vlc_mutex_t             lock;
     msg_queue_t             queue;
+
+    /* Deferred formatting */
+    vlc_object_t           *p_consumer; /**< thread draining message rings */
+    bool                    b_deferred; /**< whether rings are in use */
 } msg_bank_t;
 
 void msg_Create  (libvlc_int_t *);
+void msg_Defer   (libvlc_int_t *);
 void msg_Flush   (libvlc_int_t *);
 void msg_Destroy (libvlc_int_t *);
 
@@ -114,6 +119,13 @@ const char* msg_StackMsg ( void );
 extern vlc_threadvar_t msg_context_global_key;
 void msg_StackDestroy (void *);
 
+/** Per-thread lock-free rings of unformatted messages.
+ *  Like the stack context, they are set up by vlc_threads_init. */
+extern vlc_threadvar_t msg_ring_global_key;
+void msg_RingsInit (void);
+void msg_RingsEnd (void);
+void msg_RingRelease (void *);
+
 /*
  * Unicode stuff
  */
@@ -168,9 +180,11 @@ libvlc_global_data_t *vlc_global (void);
 struct vlc_object_internals_t
 {
     /* Object variables */
-    variable_t *    p_vars;
+    variable_t **   pp_vars;
     vlc_mutex_t     var_lock;
+    vlc_cond_t      var_wait; /* signaled when callbacks return */
     int             i_vars;
+    int             i_var_waiters;
 
     /* Thread properties, if any */
     vlc_thread_t    thread_id;
@@ -241,6 +255,7 @@ typedef struct libvlc_priv_t
     vlm_t             *p_vlm;  ///< the VLM singleton (or NULL)
     interaction_t     *p_interaction;    ///< interface interaction object
     httpd_t           *p_httpd; ///< HTTP daemon (src/network/httpd.c)
+    struct job_pool_t *p_jobs; ///< worker threads (src/misc/jobs.c)
 
     /* Private playlist data (FIXME - playlist_t is too public...) */
     sout_instance_t   *p_sout; ///< kept sout instance (for playlist)
@@ -43,6 +43,13 @@
 #include <sys/sysctl.h>
 #endif
 
+#ifdef HAVE_UNISTD_H
+#   include <unistd.h>
+#endif
+#if defined( WIN32 ) || defined( UNDER_CE )
+#   include <windows.h>
+#endif
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -360,6 +367,25 @@ unsigned vlc_CPU (void)
     return cpu_flags;
 }
 
+/*****************************************************************************
+ * vlc_GetCPUCount: get the number of processors available
+ ****************************************************************************/
+unsigned vlc_GetCPUCount (void)
+{
+#if defined( WIN32 ) || defined( UNDER_CE )
+    SYSTEM_INFO info;
+
+    GetSystemInfo (&info);
+    return info.dwNumberOfProcessors;
+#elif defined( _SC_NPROCESSORS_ONLN )
+    long count = sysconf (_SC_NPROCESSORS_ONLN);
+
+    return (count > 0) ? count : 1;
+#else
+    return 1;
+#endif
+}
+
 static vlc_memcpy_t pf_vlc_memcpy = memcpy;
 static vlc_memset_t pf_vlc_memset = memset;
 
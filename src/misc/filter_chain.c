@@ -29,6 +29,8 @@
 #include <vlc_arrays.h>
 #include <libvlc.h>
 
+typedef struct chain_pool_t chain_pool_t;
+
 struct filter_chain_t
 {
     vlc_object_t *p_this; /* Parent object */
@@ -43,6 +45,12 @@ struct filter_chain_t
     int (* pf_buffer_allocation_init)( filter_t *, void *p_data ); /* Callback called once filter allocation has succeeded to initialize the filter's buffer allocation callbacks. This function is responsible for setting p_owner if needed. */
     void (* pf_buffer_allocation_clear)( filter_t * ); /* Callback called on filter removal from chain to clean up buffer allocation callbacks data (ie p_owner) */
     void *p_buffer_allocation_data; /* Data for pf_buffer_allocation_init */
+
+    /* Recycled pictures for the filters but the last, one pool per format */
+    int i_pools;
+    chain_pool_t **pp_pools;
+    unsigned i_pictures_allocated;
+    unsigned i_pictures_recycled;
 };
 
 /**
@@ -55,6 +63,7 @@ static int filter_chain_DeleteFilterInternal( filter_chain_t *, filter_t * );
 static int UpdateBufferFunctions( filter_chain_t * );
 static picture_t *VideoBufferNew( filter_t * );
 static void VideoBufferDelete( filter_t *, picture_t * );
+static void ChainPoolsClear( filter_chain_t * );
 
 /**
  * Filter chain initialisation
@@ -85,6 +94,10 @@ filter_chain_t *__filter_chain_New( vlc_object_t *p_this,
     p_chain->pf_buffer_allocation_clear = pf_buffer_allocation_clear;
     p_chain->p_buffer_allocation_data = p_buffer_allocation_data;
 
+    TAB_INIT( p_chain->i_pools, p_chain->pp_pools );
+    p_chain->i_pictures_allocated = 0;
+    p_chain->i_pictures_recycled = 0;
+
     return p_chain;
 }
 
@@ -97,6 +110,7 @@ void filter_chain_Delete( filter_chain_t *p_chain )
         filter_chain_DeleteFilterInternal( p_chain,
                                    (filter_t*)p_chain->filters.pp_elems[0] );
     vlc_array_clear( &p_chain->filters );
+    ChainPoolsClear( p_chain );
     free( p_chain->psz_capability );
     es_format_Clean( &p_chain->fmt_in );
     es_format_Clean( &p_chain->fmt_out );
@@ -111,6 +125,7 @@ void filter_chain_Reset( filter_chain_t *p_chain, const es_format_t *p_fmt_in,
     while( p_chain->filters.i_count )
         filter_chain_DeleteFilterInternal( p_chain,
                                    (filter_t*)p_chain->filters.pp_elems[0] );
+    ChainPoolsClear( p_chain );
     if( p_fmt_in )
     {
         es_format_Clean( &p_chain->fmt_in );
@@ -279,7 +294,8 @@ static int filter_chain_DeleteFilterInternal( filter_chain_t *p_chain,
              p_filter->psz_object_name, p_filter );
 
     /* Destroy the filter object */
-    if( p_chain->pf_buffer_allocation_clear )
+    if( p_chain->pf_buffer_allocation_clear &&
+        p_filter->pf_vout_buffer_new != VideoBufferNew )
         p_chain->pf_buffer_allocation_clear( p_filter );
     vlc_object_detach( p_filter );
     if( p_filter->p_module )
@@ -432,6 +448,7 @@ static int UpdateBufferFunctions( filter_chain_t *p_chain )
                     p_chain->pf_buffer_allocation_clear( p_filter );
                 p_filter->pf_vout_buffer_new = VideoBufferNew;
                 p_filter->pf_vout_buffer_del = VideoBufferDelete;
+                p_filter->p_owner = (filter_owner_sys_t *)p_chain;
             }
         }
         if( p_chain->filters.i_count >= 1 )
@@ -450,13 +467,185 @@ static int UpdateBufferFunctions( filter_chain_t *p_chain )
     return VLC_SUCCESS;
 }
 
+/**
+ * Picture pools
+ *
+ * Each pool keeps the released pictures of one format so that the next
+ * VideoBufferNew() does not need to allocate. A pool is referenced by its
+ * chain and by each of its pictures in use, as the pictures may well be
+ * released after the chain was reset.
+ */
+struct chain_pool_t
+{
+    vlc_mutex_t lock;
+    unsigned i_refcount;
+    bool b_detached; /* the chain does not use this pool anymore */
+
+    vlc_fourcc_t i_chroma;
+    int i_width;
+    int i_height;
+    int i_aspect;
+
+    picture_t *p_free; /* released pictures, linked with p_next */
+};
+
+typedef struct
+{
+    picture_t picture; /* must be first */
+    picture_t model; /* the picture as allocated */
+    chain_pool_t *p_pool;
+} chain_picture_t;
+
+static void ChainPoolRelease( chain_pool_t *p_pool )
+{
+    /* Called with the pool lock */
+    if( --p_pool->i_refcount > 0 )
+    {
+        vlc_mutex_unlock( &p_pool->lock );
+        return;
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+    vlc_mutex_destroy( &p_pool->lock );
+    free( p_pool );
+}
+
+static void ChainPictureDelete( picture_t *p_picture )
+{
+    free( p_picture->p_data_orig );
+    free( p_picture );
+}
+
+static void ChainPictureRelease( picture_t *p_picture )
+{
+    chain_pool_t *p_pool = ((chain_picture_t *)p_picture)->p_pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    if( --p_picture->i_refcount > 0 )
+    {
+        vlc_mutex_unlock( &p_pool->lock );
+        return;
+    }
+    if( p_pool->b_detached )
+    {
+        ChainPictureDelete( p_picture );
+    }
+    else
+    {
+        p_picture->p_next = p_pool->p_free;
+        p_pool->p_free = p_picture;
+    }
+    ChainPoolRelease( p_pool );
+}
+
+static picture_t *ChainPoolGet( filter_chain_t *p_chain, chain_pool_t *p_pool )
+{
+    chain_picture_t *p_cpic;
+
+    vlc_mutex_lock( &p_pool->lock );
+    p_cpic = (chain_picture_t *)p_pool->p_free;
+    if( p_cpic )
+    {
+        p_pool->p_free = p_cpic->picture.p_next;
+        p_pool->i_refcount++;
+        vlc_mutex_unlock( &p_pool->lock );
+
+        /* Undo whatever the previous user did to the picture */
+        p_cpic->picture = p_cpic->model;
+        p_chain->i_pictures_recycled++;
+        return &p_cpic->picture;
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+
+    p_cpic = calloc( 1, sizeof( *p_cpic ) );
+    if( !p_cpic )
+        return NULL;
+    if( vout_AllocatePicture( p_chain->p_this, &p_cpic->model,
+                              p_pool->i_chroma, p_pool->i_width,
+                              p_pool->i_height, p_pool->i_aspect ) )
+    {
+        free( p_cpic );
+        return NULL;
+    }
+    p_cpic->model.i_refcount = 1;
+    p_cpic->model.pf_release = ChainPictureRelease;
+    p_cpic->model.i_status = RESERVED_PICTURE;
+    p_cpic->p_pool = p_pool;
+    p_cpic->picture = p_cpic->model;
+
+    vlc_mutex_lock( &p_pool->lock );
+    p_pool->i_refcount++;
+    vlc_mutex_unlock( &p_pool->lock );
+
+    p_chain->i_pictures_allocated++;
+    return &p_cpic->picture;
+}
+
+static chain_pool_t *ChainPoolFind( filter_chain_t *p_chain,
+                                    const video_format_t *p_fmt )
+{
+    chain_pool_t *p_pool;
+
+    for( int i = 0; i < p_chain->i_pools; i++ )
+    {
+        p_pool = p_chain->pp_pools[i];
+        if( p_pool->i_chroma == p_fmt->i_chroma &&
+            p_pool->i_width == (int)p_fmt->i_width &&
+            p_pool->i_height == (int)p_fmt->i_height &&
+            p_pool->i_aspect == (int)p_fmt->i_aspect )
+            return p_pool;
+    }
+
+    p_pool = malloc( sizeof( *p_pool ) );
+    if( !p_pool )
+        return NULL;
+    vlc_mutex_init( &p_pool->lock );
+    p_pool->i_refcount = 1;
+    p_pool->b_detached = false;
+    p_pool->i_chroma = p_fmt->i_chroma;
+    p_pool->i_width = p_fmt->i_width;
+    p_pool->i_height = p_fmt->i_height;
+    p_pool->i_aspect = p_fmt->i_aspect;
+    p_pool->p_free = NULL;
+    TAB_APPEND( p_chain->i_pools, p_chain->pp_pools, p_pool );
+    return p_pool;
+}
+
+/**
+ * Detaches the chain from its pools. The pictures still in use will be
+ * destroyed when released.
+ */
+static void ChainPoolsClear( filter_chain_t *p_chain )
+{
+    if( p_chain->i_pictures_allocated > 0 )
+        msg_Dbg( p_chain->p_this, "%u pictures allocated, %u recycled",
+                 p_chain->i_pictures_allocated,
+                 p_chain->i_pictures_recycled );
+    p_chain->i_pictures_allocated = 0;
+    p_chain->i_pictures_recycled = 0;
+
+    for( int i = 0; i < p_chain->i_pools; i++ )
+    {
+        chain_pool_t *p_pool = p_chain->pp_pools[i];
+        picture_t *p_picture;
+
+        vlc_mutex_lock( &p_pool->lock );
+        p_pool->b_detached = true;
+        while( ( p_picture = p_pool->p_free ) != NULL )
+        {
+            p_pool->p_free = p_picture->p_next;
+            ChainPictureDelete( p_picture );
+        }
+        ChainPoolRelease( p_pool );
+    }
+    TAB_CLEAN( p_chain->i_pools, p_chain->pp_pools );
+}
+
 static picture_t *VideoBufferNew( filter_t *p_filter )
 {
-    const video_format_t *p_fmt = &p_filter->fmt_out.video;
+    filter_chain_t *p_chain = (filter_chain_t *)p_filter->p_owner;
+    chain_pool_t *p_pool = ChainPoolFind( p_chain, &p_filter->fmt_out.video );
+    picture_t *p_picture = p_pool ? ChainPoolGet( p_chain, p_pool ) : NULL;
 
-    picture_t *p_picture = picture_New( p_fmt->i_chroma,
-                                        p_fmt->i_width, p_fmt->i_height,
-                                        p_fmt->i_aspect );
     if( !p_picture )
         msg_Err( p_filter, "Failed to allocate picture\n" );
     return p_picture;
@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * filter_slices.c : run video filters on bands of rows in parallel
+ *****************************************************************************
+ * Copyright (C) 2009 the VideoLAN team
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_jobs.h>
+
+#include <assert.h>
+
+/* The slices of a run are not bound to a job: the calling thread and the
+ * workers all take the next slice left until there is none. So the call
+ * does not depend on a worker being free (it could be run by a worker
+ * itself), and jobs left in the queue after a run are harmless. */
+struct filter_slices_t
+{
+    job_queue_t *p_jobs;
+    int         i_slices;
+
+    vlc_mutex_t lock;
+    vlc_cond_t  done;
+    unsigned    i_queued;   /* submitted jobs not started yet */
+
+    void        (*pf_slice)( void *, int, int );
+    void        *p_data;
+    int         i_next;     /* next slice to run */
+    int         i_done;     /* slices finished */
+};
+
+/* Runs the slices left, called with the lock */
+static void SlicesRun( filter_slices_t *p_slices )
+{
+    while( p_slices->i_next < p_slices->i_slices )
+    {
+        int i_slice = p_slices->i_next++;
+
+        vlc_mutex_unlock( &p_slices->lock );
+        p_slices->pf_slice( p_slices->p_data, i_slice, p_slices->i_slices );
+        vlc_mutex_lock( &p_slices->lock );
+
+        if( ++p_slices->i_done == p_slices->i_slices )
+            vlc_cond_signal( &p_slices->done );
+    }
+}
+
+static void SlicesJob( void *p_data )
+{
+    filter_slices_t *p_slices = p_data;
+
+    vlc_mutex_lock( &p_slices->lock );
+    p_slices->i_queued--;
+    SlicesRun( p_slices );
+    vlc_mutex_unlock( &p_slices->lock );
+}
+
+filter_slices_t *filter_SlicesNew( filter_t *p_filter )
+{
+    int i_slices = config_GetInt( p_filter, "worker-threads" );
+    filter_slices_t *p_slices;
+
+    if( i_slices <= 0 )
+        i_slices = vlc_GetCPUCount();
+    if( i_slices > FILTER_SLICES_MAX )
+        i_slices = FILTER_SLICES_MAX;
+    if( i_slices <= 1 )
+        return NULL; /* filter_SlicesRun() will do everything at once */
+
+    p_slices = malloc( sizeof( *p_slices ) );
+    if( !p_slices )
+        return NULL;
+
+    /* Above the default priority: the rest of the pipeline waits for us */
+    p_slices->p_jobs = job_queue_New( p_filter, 1, 0 );
+    if( !p_slices->p_jobs )
+    {
+        free( p_slices );
+        return NULL;
+    }
+    p_slices->i_slices = i_slices;
+    vlc_mutex_init( &p_slices->lock );
+    vlc_cond_init( p_filter, &p_slices->done );
+    p_slices->i_queued = 0;
+    p_slices->pf_slice = NULL;
+    p_slices->p_data = NULL;
+    p_slices->i_next = p_slices->i_done = i_slices;
+
+    msg_Dbg( p_filter, "filtering in %d slices", i_slices );
+    return p_slices;
+}
+
+void filter_SlicesDelete( filter_slices_t *p_slices )
+{
+    if( !p_slices )
+        return;
+
+    job_queue_Delete( p_slices->p_jobs );
+    vlc_cond_destroy( &p_slices->done );
+    vlc_mutex_destroy( &p_slices->lock );
+    free( p_slices );
+}
+
+void filter_SlicesRun( filter_slices_t *p_slices,
+                       void (*pf_slice)( void *, int, int ), void *p_data )
+{
+    if( !p_slices )
+    {
+        pf_slice( p_data, 0, 1 );
+        return;
+    }
+
+    vlc_mutex_lock( &p_slices->lock );
+    assert( p_slices->i_done == p_slices->i_slices );
+    p_slices->pf_slice = pf_slice;
+    p_slices->p_data = p_data;
+    p_slices->i_next = p_slices->i_done = 0;
+
+    /* The calling thread takes its share too */
+    while( p_slices->i_queued < (unsigned)p_slices->i_slices - 1 )
+    {
+        if( job_queue_Submit( p_slices->p_jobs, SlicesJob, p_slices, 0 ) )
+            break;
+        p_slices->i_queued++;
+    }
+
+    SlicesRun( p_slices );
+    while( p_slices->i_done < p_slices->i_slices )
+        vlc_cond_wait( &p_slices->done, &p_slices->lock );
+    vlc_mutex_unlock( &p_slices->lock );
+}
@@ -0,0 +1,378 @@
+/*****************************************************************************
+ * jobs.c: shared pool of worker threads
+ *****************************************************************************
+ * Copyright (C) 2009 the VideoLAN team
+ * $Id$
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_jobs.h>
+
+#include <assert.h>
+
+#include "libvlc.h"
+
+/*****************************************************************************
+ * Local structures
+ *****************************************************************************/
+typedef struct job_t job_t;
+typedef struct job_pool_t job_pool_t;
+
+struct job_t
+{
+    job_t       *p_next;
+    void        (*pf_run)( void * );
+    void        *p_data;
+    mtime_t     i_deadline;
+    uint64_t    i_seq;
+};
+
+struct job_queue_t
+{
+    job_pool_t   *p_pool;
+    vlc_object_t *p_owner;      /* for the messages */
+
+    int          i_priority;
+    unsigned     i_parallel;
+    unsigned     i_running;
+
+    job_t        *p_first;
+    job_t        **pp_last;
+    vlc_cond_t   idle;          /* signaled when the last job is done */
+
+    unsigned     i_done;
+    unsigned     i_late;
+};
+
+typedef struct
+{
+    VLC_COMMON_MEMBERS
+    job_pool_t *p_pool;
+} job_worker_t;
+
+/* There is one pool per instance, created with its first queue and
+ * destroyed with its last one, under the "jobs" mutex. Everything else is
+ * protected by the pool lock. */
+struct job_pool_t
+{
+    vlc_mutex_t  lock;
+    vlc_cond_t   wait;          /* workers waiting for a job */
+    bool         b_exit;
+    uint64_t     i_seq;
+
+    int          i_queues;
+    job_queue_t  **pp_queues;
+
+    int          i_workers;
+    job_worker_t **pp_workers;
+    int          i_low;         /* workers running negative priority jobs */
+};
+
+static void *WorkerThread( vlc_object_t * );
+
+/*****************************************************************************
+ * Pool creation and destruction
+ *****************************************************************************/
+static void PoolDelete( job_pool_t *p_pool )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    p_pool->b_exit = true;
+    for( int i = 0; i < p_pool->i_workers; i++ )
+        vlc_cond_signal( &p_pool->wait );
+    vlc_mutex_unlock( &p_pool->lock );
+
+    for( int i = 0; i < p_pool->i_workers; i++ )
+    {
+        vlc_thread_join( p_pool->pp_workers[i] );
+        vlc_object_release( p_pool->pp_workers[i] );
+    }
+    free( p_pool->pp_workers );
+
+    assert( p_pool->i_queues == 0 );
+    free( p_pool->pp_queues );
+    vlc_cond_destroy( &p_pool->wait );
+    vlc_mutex_destroy( &p_pool->lock );
+    free( p_pool );
+}
+
+static job_pool_t *PoolNew( vlc_object_t *p_this )
+{
+    vlc_object_t *p_root = VLC_OBJECT(p_this->p_libvlc);
+    int i_threads = config_GetInt( p_this, "worker-threads" );
+    job_pool_t *p_pool;
+
+    /* At least two, so that one is left when the other runs a negative
+     * priority job (see PoolPick()) */
+    if( i_threads <= 0 )
+        i_threads = __MAX( vlc_GetCPUCount(), 2 );
+
+    p_pool = malloc( sizeof( *p_pool ) );
+    if( !p_pool )
+        return NULL;
+    vlc_mutex_init( &p_pool->lock );
+    vlc_cond_init( p_root, &p_pool->wait );
+    p_pool->b_exit = false;
+    p_pool->i_seq = 0;
+    TAB_INIT( p_pool->i_queues, p_pool->pp_queues );
+    TAB_INIT( p_pool->i_workers, p_pool->pp_workers );
+    p_pool->i_low = 0;
+
+    for( int i = 0; i < i_threads; i++ )
+    {
+        job_worker_t *p_worker =
+            vlc_custom_create( p_root, sizeof( *p_worker ),
+                               VLC_OBJECT_GENERIC, "job worker" );
+        if( !p_worker )
+            break;
+        p_worker->p_pool = p_pool;
+        if( vlc_thread_create( p_worker, "job worker", WorkerThread,
+                               VLC_THREAD_PRIORITY_VIDEO, false ) )
+        {
+            vlc_object_release( p_worker );
+            break;
+        }
+        TAB_APPEND( p_pool->i_workers, p_pool->pp_workers, p_worker );
+    }
+
+    if( p_pool->i_workers == 0 )
+    {
+        msg_Err( p_this, "cannot create any worker thread" );
+        PoolDelete( p_pool );
+        return NULL;
+    }
+    msg_Dbg( p_this, "started %d worker threads", p_pool->i_workers );
+    return p_pool;
+}
+
+/*****************************************************************************
+ * Scheduling
+ *****************************************************************************/
+
+/* Returns non-zero if the first job of a should run before that of b */
+static int QueueBefore( const job_queue_t *a, const job_queue_t *b )
+{
+    const job_t *p_a = a->p_first, *p_b = b->p_first;
+
+    if( a->i_priority != b->i_priority )
+        return a->i_priority > b->i_priority;
+    if( p_a->i_deadline != p_b->i_deadline )
+    {
+        if( p_a->i_deadline == 0 || p_b->i_deadline == 0 )
+            return p_b->i_deadline == 0;
+        return p_a->i_deadline < p_b->i_deadline;
+    }
+    return p_a->i_seq < p_b->i_seq;
+}
+
+/* Finds the queue to serve next; called with the pool lock */
+static job_queue_t *PoolPick( job_pool_t *p_pool )
+{
+    job_queue_t *p_best = NULL;
+
+    for( int i = 0; i < p_pool->i_queues; i++ )
+    {
+        job_queue_t *p_queue = p_pool->pp_queues[i];
+
+        if( !p_queue->p_first ||
+            ( p_queue->i_parallel > 0 &&
+              p_queue->i_running >= p_queue->i_parallel ) )
+            continue;
+        /* Negative priority jobs may block for long (preparsing, network
+         * fetches): they never get the last worker, so that they cannot
+         * starve the other queues */
+        if( p_queue->i_priority < 0 && p_pool->i_workers > 1 &&
+            p_pool->i_low >= p_pool->i_workers - 1 )
+            continue;
+        if( !p_best || QueueBefore( p_queue, p_best ) )
+            p_best = p_queue;
+    }
+    return p_best;
+}
+
+static void *WorkerThread( vlc_object_t *p_this )
+{
+    job_pool_t *p_pool = ((job_worker_t *)p_this)->p_pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    for( ;; )
+    {
+        job_queue_t *p_queue;
+        job_t *p_job;
+        bool b_low;
+
+        while( !p_pool->b_exit && !( p_queue = PoolPick( p_pool ) ) )
+            vlc_cond_wait( &p_pool->wait, &p_pool->lock );
+        if( p_pool->b_exit )
+            break;
+
+        p_job = p_queue->p_first;
+        p_queue->p_first = p_job->p_next;
+        if( !p_queue->p_first )
+            p_queue->pp_last = &p_queue->p_first;
+        p_queue->i_running++;
+        b_low = p_queue->i_priority < 0;
+        if( b_low )
+            p_pool->i_low++;
+        if( p_job->i_deadline > 0 && mdate() > p_job->i_deadline )
+            p_queue->i_late++;
+        vlc_mutex_unlock( &p_pool->lock );
+
+        p_job->pf_run( p_job->p_data );
+        free( p_job );
+
+        vlc_mutex_lock( &p_pool->lock );
+        p_queue->i_running--;
+        if( b_low )
+            p_pool->i_low--;
+        p_queue->i_done++;
+        if( !p_queue->i_running && !p_queue->p_first )
+            vlc_cond_signal( &p_queue->idle );
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+    return NULL;
+}
+
+/*****************************************************************************
+ * Job queues
+ *****************************************************************************/
+job_queue_t *__job_queue_New( vlc_object_t *p_this, int i_priority,
+                              unsigned i_parallel )
+{
+    libvlc_priv_t *p_priv = libvlc_priv( p_this->p_libvlc );
+    vlc_mutex_t *lock = var_AcquireMutex( "jobs" );
+    job_queue_t *p_queue = malloc( sizeof( *p_queue ) );
+    job_pool_t *p_pool;
+
+    if( !p_queue )
+        goto error;
+    if( !p_priv->p_jobs )
+    {
+        p_priv->p_jobs = PoolNew( p_this );
+        if( !p_priv->p_jobs )
+            goto error;
+    }
+
+    p_pool = p_priv->p_jobs;
+    p_queue->p_pool = p_pool;
+    p_queue->p_owner = p_this;
+    p_queue->i_priority = i_priority;
+    p_queue->i_parallel = i_parallel;
+    p_queue->i_running = 0;
+    p_queue->p_first = NULL;
+    p_queue->pp_last = &p_queue->p_first;
+    vlc_cond_init( p_this, &p_queue->idle );
+    p_queue->i_done = p_queue->i_late = 0;
+
+    vlc_mutex_lock( &p_pool->lock );
+    TAB_APPEND( p_pool->i_queues, p_pool->pp_queues, p_queue );
+    vlc_mutex_unlock( &p_pool->lock );
+    vlc_mutex_unlock( lock );
+    return p_queue;
+
+error:
+    vlc_mutex_unlock( lock );
+    free( p_queue );
+    return NULL;
+}
+
+void job_queue_Delete( job_queue_t *p_queue )
+{
+    libvlc_priv_t *p_priv = libvlc_priv( p_queue->p_owner->p_libvlc );
+    job_pool_t *p_pool = p_queue->p_pool;
+    vlc_mutex_t *lock;
+    job_t *p_job;
+
+    /* The pool outlives the queue as long as it is registered, so the
+     * running jobs are waited for without the "jobs" mutex, which would
+     * block the other queues meanwhile */
+    vlc_mutex_lock( &p_pool->lock );
+    p_job = p_queue->p_first;
+    p_queue->p_first = NULL;
+    p_queue->pp_last = &p_queue->p_first;
+    while( p_queue->i_running > 0 )
+        vlc_cond_wait( &p_queue->idle, &p_pool->lock );
+    vlc_mutex_unlock( &p_pool->lock );
+
+    if( p_queue->i_late > 0 )
+        msg_Dbg( p_queue->p_owner, "%u of %u jobs started past their "
+                 "deadline", p_queue->i_late, p_queue->i_done );
+    while( p_job )
+    {
+        job_t *p_next = p_job->p_next;
+        free( p_job );
+        p_job = p_next;
+    }
+
+    lock = var_AcquireMutex( "jobs" );
+    vlc_mutex_lock( &p_pool->lock );
+    TAB_REMOVE( p_pool->i_queues, p_pool->pp_queues, p_queue );
+    vlc_mutex_unlock( &p_pool->lock );
+    vlc_cond_destroy( &p_queue->idle );
+    free( p_queue );
+
+    if( p_pool->i_queues == 0 )
+    {
+        PoolDelete( p_pool );
+        p_priv->p_jobs = NULL;
+    }
+    vlc_mutex_unlock( lock );
+}
+
+int job_queue_Submit( job_queue_t *p_queue, void (*pf_run)( void * ),
+                      void *p_data, mtime_t i_deadline )
+{
+    job_pool_t *p_pool = p_queue->p_pool;
+    job_t *p_job = malloc( sizeof( *p_job ) );
+
+    if( !p_job )
+        return VLC_ENOMEM;
+    p_job->p_next = NULL;
+    p_job->pf_run = pf_run;
+    p_job->p_data = p_data;
+    p_job->i_deadline = i_deadline;
+
+    vlc_mutex_lock( &p_pool->lock );
+    p_job->i_seq = p_pool->i_seq++;
+    *p_queue->pp_last = p_job;
+    p_queue->pp_last = &p_job->p_next;
+    vlc_cond_signal( &p_pool->wait );
+    vlc_mutex_unlock( &p_pool->lock );
+    return VLC_SUCCESS;
+}
+
+void job_queue_Wait( job_queue_t *p_queue )
+{
+    job_pool_t *p_pool = p_queue->p_pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    while( p_queue->p_first || p_queue->i_running > 0 )
+        vlc_cond_wait( &p_queue->idle, &p_pool->lock );
+    vlc_mutex_unlock( &p_pool->lock );
+}
+
+void job_queue_SetPriority( job_queue_t *p_queue, int i_priority )
+{
+    job_pool_t *p_pool = p_queue->p_pool;
+
+    vlc_mutex_lock( &p_pool->lock );
+    p_queue->i_priority = i_priority;
+    vlc_mutex_unlock( &p_pool->lock );
+}
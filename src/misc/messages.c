@@ -74,9 +74,77 @@
  * Local prototypes
  *****************************************************************************/
 static void QueueMsg ( vlc_object_t *, int, const char *,
-                       const char *, va_list );
+                       const char *, va_list, bool );
+static bool DeferMsg ( vlc_object_t *, int, const char *,
+                       const char *, va_list, bool );
+static void DispatchMsg ( libvlc_priv_t *, int, int, const char *,
+                          const char *, char *, char *, mtime_t );
+static void DrainRings ( void );
+static void *ConsumerThread ( vlc_object_t * );
 static void FlushMsg ( msg_queue_t * );
-static void PrintMsg ( vlc_object_t *, msg_item_t * );
+static void PrintMsg ( libvlc_priv_t *, msg_item_t * );
+static bool IsVisible ( libvlc_priv_t *, int );
+static char *GetHeader ( vlc_object_t * );
+
+/*****************************************************************************
+ * Deferred messages
+ *****************************************************************************
+ * Each thread owns a single-producer ring of unformatted messages: the format
+ * string pointer and a copy of its arguments (strings are copied into the
+ * record). Rings are drained by the message consumer thread of each LibVLC
+ * instance, which formats the messages and hands them to the message queue
+ * and its subscribers. Producers never take a lock except when creating their
+ * ring, and messages that cannot be stored that way are formatted by the
+ * producer itself and still go through the ring to keep ordering.
+ *****************************************************************************/
+#define MSG_MAX_ARGS  12
+#define MSG_POOL_SIZE 192
+
+typedef union
+{
+    intmax_t    i;
+    uintmax_t   u;
+    double      f;
+    const void *p;
+    size_t      s;                   /**< offset of a copied string in pool */
+} msg_arg_t;
+
+#define MSG_NULL_STRING ((size_t)-1)
+
+typedef struct
+{
+    libvlc_priv_t *priv;
+    int            i_type;
+    int            i_object_id;
+    const char    *psz_object_type;
+    const char    *psz_format;         /**< NULL if psz_msg is preformatted */
+    char          *psz_msg;
+    char          *psz_header;
+    mtime_t        date;
+    int            i_errno;
+    unsigned       i_args;
+    msg_arg_t      args[MSG_MAX_ARGS];
+    size_t         i_pool;
+    char           psz_module[32];
+    char           pool[MSG_POOL_SIZE];
+} msg_record_t;
+
+typedef struct msg_ring_t msg_ring_t;
+struct msg_ring_t
+{
+    msg_ring_t       *p_next;
+    volatile unsigned i_head;           /**< first pending record (consumer) */
+    volatile unsigned i_tail;           /**< first free record (producer) */
+    volatile unsigned i_dropped;        /**< records lost to a full ring */
+    unsigned          i_dropped_seen;
+    volatile bool     b_orphan;         /**< the owner thread has exited */
+    msg_record_t      records[VLC_MSG_RINGSIZE];
+};
+
+/* All rings, protected by rings_lock. Holding rings_lock also makes the
+ * holder the single consumer of every ring. */
+static vlc_mutex_t rings_lock;
+static msg_ring_t *p_rings = NULL;
 
 /**
  * Initialize messages queues
@@ -92,6 +160,8 @@ void msg_Create (libvlc_int_t *p_libvlc)
     QUEUE.i_stop = 0;
     QUEUE.i_sub = 0;
     QUEUE.pp_sub = 0;
+    priv->msg_bank.p_consumer = NULL;
+    priv->msg_bank.b_deferred = false;
 
 #ifdef UNDER_CE
     QUEUE.logfile =
@@ -102,12 +172,48 @@ void msg_Create (libvlc_int_t *p_libvlc)
 #endif
 }
 
+/**
+ * Start deferred message formatting
+ *
+ * From now on, messages are stored unformatted in per-thread rings and
+ * formatted by a dedicated consumer thread. This needs the configuration,
+ * so it cannot be done by msg_Create().
+ */
+void msg_Defer (libvlc_int_t *p_libvlc)
+{
+    libvlc_priv_t *priv = libvlc_priv (p_libvlc);
+    vlc_object_t *p_consumer;
+
+    if( priv->msg_bank.p_consumer != NULL )
+        return;
+
+    p_consumer = vlc_custom_create( VLC_OBJECT(p_libvlc),
+                                    sizeof( *p_consumer ),
+                                    VLC_OBJECT_GENERIC, "message consumer" );
+    if( p_consumer == NULL )
+        return;
+
+    if( vlc_thread_create( p_consumer, "message consumer", ConsumerThread,
+                           VLC_THREAD_PRIORITY_LOW, false ) )
+    {
+        vlc_object_release( p_consumer );
+        return;
+    }
+
+    priv->msg_bank.p_consumer = p_consumer;
+    barrier();
+    priv->msg_bank.b_deferred = true;
+}
+
 /**
  * Flush all message queues
  */
 void msg_Flush (libvlc_int_t *p_libvlc)
 {
     libvlc_priv_t *priv = libvlc_priv (p_libvlc);
+
+    DrainRings();
+
     vlc_mutex_lock( &QUEUE.lock );
     FlushMsg( &QUEUE );
     vlc_mutex_unlock( &QUEUE.lock );
@@ -123,6 +229,19 @@ void msg_Flush (libvlc_int_t *p_libvlc)
 void msg_Destroy (libvlc_int_t *p_libvlc)
 {
     libvlc_priv_t *priv = libvlc_priv (p_libvlc);
+    vlc_object_t *p_consumer = priv->msg_bank.p_consumer;
+
+    /* Go back to synchronous messages, then format whatever is pending */
+    priv->msg_bank.b_deferred = false;
+    barrier();
+    if( p_consumer )
+    {
+        vlc_object_kill( p_consumer );
+        vlc_thread_join( p_consumer );
+        vlc_object_release( p_consumer );
+        priv->msg_bank.p_consumer = NULL;
+    }
+    DrainRings();
 
     if( QUEUE.i_sub )
         msg_Err( p_libvlc, "stale interface subscribers" );
@@ -196,14 +315,16 @@ void __msg_Generic( vlc_object_t *p_this, int i_type, const char *psz_module,
     va_list args;
 
     va_start( args, psz_format );
-    QueueMsg( p_this, i_type, psz_module, psz_format, args );
+    QueueMsg( p_this, i_type, psz_module, psz_format, args, true );
     va_end( args );
 }
 
+/* The format may be built by the caller and freed right after the call
+ * (or belong to a library which gets unloaded), so it is never kept. */
 void __msg_GenericVa( vlc_object_t *p_this, int i_type, const char *psz_module,
                       const char *psz_format, va_list args )
 {
-    QueueMsg( p_this, i_type, psz_module, psz_format, args );
+    QueueMsg( p_this, i_type, psz_module, psz_format, args, false );
 }
 
 /* Generic functions used when variadic macros are not available. */
@@ -212,7 +333,7 @@ void __msg_GenericVa( vlc_object_t *p_this, int i_type, const char *psz_module,
     { \
         va_list args; \
         va_start( args, psz_format ); \
-        QueueMsg( p_this, FN_TYPE, "unknown", psz_format, args ); \
+        QueueMsg( p_this, FN_TYPE, "unknown", psz_format, args, true ); \
         va_end( args ); \
     } \
     struct _
@@ -235,42 +356,17 @@ DECLARE_MSG_FN( __msg_Warn, VLC_MSG_WARN );
  */
 DECLARE_MSG_FN( __msg_Dbg,  VLC_MSG_DBG );
 
+#ifndef __GLIBC__
 /**
- * Add a message to a queue
+ * Expand %m to strerror(i_errno) - only once
  *
- * This function provides basic functionnalities to other msg_* functions.
- * It adds a message to a queue (after having printed all stored messages if it
- * is full). If the message can't be converted to string in memory, it issues
- * a warning.
+ * buf must have room for strlen( psz_format ) + 2001 bytes.
  */
-static void QueueMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
-                      const char *psz_format, va_list _args )
+static void ExpandErrno( char *buf, const char *psz_format, int i_errno )
 {
-    assert (p_this);
-    libvlc_priv_t *priv = libvlc_priv (p_this->p_libvlc);
-    int         i_header_size;             /* Size of the additionnal header */
-    vlc_object_t *p_obj;
-    char *       psz_str = NULL;                 /* formatted message string */
-    char *       psz_header = NULL;
-    va_list      args;
-    msg_item_t * p_item = NULL;                        /* pointer to message */
-    msg_item_t   item;                    /* message in case of a full queue */
-    msg_queue_t *p_queue;
-
-#if !defined(HAVE_VASPRINTF) || defined(__APPLE__) || defined(SYS_BEOS)
-    int          i_size = strlen(psz_format) + INTF_MAX_MSG_SIZE;
-#endif
-
-    if( p_this->i_flags & OBJECT_FLAGS_QUIET ||
-        (p_this->i_flags & OBJECT_FLAGS_NODBG && i_type == VLC_MSG_DBG) )
-        return;
+    char *ptr = buf;
 
-#ifndef __GLIBC__
-    /* Expand %m to strerror(errno) - only once */
-    char buf[strlen( psz_format ) + 2001], *ptr;
     strcpy( buf, psz_format );
-    ptr = (char*)buf;
-    psz_format = (const char*) buf;
 
     for( ;; )
     {
@@ -284,7 +380,7 @@ static void QueueMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
             size_t errlen;
 
 #ifndef WIN32
-            strerror_r( errno, errbuf, 1001 );
+            strerror_r( i_errno, errbuf, 1001 );
 #else
             int sockerr = WSAGetLastError( );
             if( sockerr )
@@ -294,7 +390,7 @@ static void QueueMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
             }
             if ((sockerr == 0)
              || (strcmp ("Unknown network stack error", errbuf) == 0))
-                strncpy( errbuf, strerror( errno ), 1001 );
+                strncpy( errbuf, strerror( i_errno ), 1001 );
 #endif
             errbuf[1000] = 0;
 
@@ -319,6 +415,57 @@ static void QueueMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
         if( *ptr )
             ptr++; /* ...and skip it */
     }
+}
+#endif
+
+/**
+ * Add a message to a queue
+ *
+ * This function provides basic functionnalities to other msg_* functions.
+ * Messages that nobody would see at the current verbosity are dropped before
+ * any work is done. Once the consumer thread is running, the message is
+ * stored unformatted in the calling thread's ring. Otherwise, it is
+ * formatted and added to the queue right away (after having printed all
+ * stored messages if it is full). If the message can't be converted to
+ * string in memory, it issues a warning.
+ *
+ * \param b_static whether psz_format remains valid after the call, so that
+ * formatting can be deferred
+ */
+static void QueueMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
+                      const char *psz_format, va_list _args, bool b_static )
+{
+    assert (p_this);
+    libvlc_priv_t *priv = libvlc_priv (p_this->p_libvlc);
+    char *       psz_str = NULL;                 /* formatted message string */
+    va_list      args;
+
+#if !defined(HAVE_VASPRINTF) || defined(__APPLE__) || defined(SYS_BEOS)
+    int          i_size = strlen(psz_format) + INTF_MAX_MSG_SIZE;
+#endif
+
+    if( p_this->i_flags & OBJECT_FLAGS_QUIET ||
+        (p_this->i_flags & OBJECT_FLAGS_NODBG && i_type == VLC_MSG_DBG) )
+        return;
+
+    /* Nobody will print it, and no interface will ever read it */
+    if( QUEUE.i_sub == 0 && !IsVisible( priv, i_type ) )
+        return;
+
+    if( priv->msg_bank.b_deferred )
+    {
+        vlc_va_copy( args, _args );
+        bool b_queued = DeferMsg( p_this, i_type, psz_module,
+                                  psz_format, args, b_static );
+        va_end( args );
+        if( b_queued )
+            return;
+    }
+
+#ifndef __GLIBC__
+    char buf[strlen( psz_format ) + 2001];
+    ExpandErrno( buf, psz_format, errno );
+    psz_format = buf;
 #endif
 
     /* Convert message to string  */
@@ -355,8 +502,25 @@ static void QueueMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
         return;
     }
 
-    i_header_size = 0;
-    p_obj = p_this;
+#if !defined(HAVE_VASPRINTF) || defined(__APPLE__) || defined(SYS_BEOS)
+    vlc_va_copy( args, _args );
+    vsnprintf( psz_str, i_size, psz_format, args );
+    va_end( args );
+    psz_str[ i_size - 1 ] = 0; /* Just in case */
+#endif
+
+    DispatchMsg( priv, i_type, p_this->i_object_id, p_this->psz_object_type,
+                 psz_module, psz_str, GetHeader( p_this ), mdate() );
+}
+
+/**
+ * Build the message header of an object from its own and its parents'
+ */
+static char *GetHeader( vlc_object_t *p_obj )
+{
+    int          i_header_size = 0;        /* Size of the additionnal header */
+    char *       psz_header = NULL;
+
     while( p_obj != NULL )
     {
         char *psz_old = NULL;
@@ -380,13 +544,21 @@ static void QueueMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
         free( psz_old );
         p_obj = p_obj->p_parent;
     }
+    return psz_header;
+}
 
-#if !defined(HAVE_VASPRINTF) || defined(__APPLE__) || defined(SYS_BEOS)
-    vlc_va_copy( args, _args );
-    vsnprintf( psz_str, i_size, psz_format, args );
-    va_end( args );
-    psz_str[ i_size - 1 ] = 0; /* Just in case */
-#endif
+/**
+ * Add a formatted message to the queue of a LibVLC instance
+ *
+ * This takes ownership of psz_str and psz_header.
+ */
+static void DispatchMsg( libvlc_priv_t *priv, int i_type, int i_object_id,
+                         const char *psz_object_type, const char *psz_module,
+                         char *psz_str, char *psz_header, mtime_t date )
+{
+    msg_item_t * p_item = NULL;                        /* pointer to message */
+    msg_item_t   item;                    /* message in case of a full queue */
+    msg_queue_t *p_queue;
 
     LOCK_BANK;
     p_queue = &QUEUE;
@@ -421,13 +593,14 @@ static void QueueMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
             p_queue->i_stop = (p_queue->i_stop + 1) % VLC_MSG_QSIZE;
 
             p_item->i_type =        VLC_MSG_WARN;
-            p_item->i_object_id =   p_this->i_object_id;
-            p_item->psz_object_type = p_this->psz_object_type;
+            p_item->i_object_id =   i_object_id;
+            p_item->psz_object_type = psz_object_type;
             p_item->psz_module =    strdup( "message" );
             p_item->psz_msg =       strdup( "message queue overflowed" );
             p_item->psz_header =    NULL;
+            p_item->date =          date;
 
-            PrintMsg( p_this, p_item );
+            PrintMsg( priv, p_item );
             /* We print from a dummy item */
             p_item = &item;
         }
@@ -442,13 +615,14 @@ static void QueueMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
 
     /* Fill message information fields */
     p_item->i_type =        i_type;
-    p_item->i_object_id =   p_this->i_object_id;
-    p_item->psz_object_type = p_this->psz_object_type;
+    p_item->i_object_id =   i_object_id;
+    p_item->psz_object_type = psz_object_type;
     p_item->psz_module =    strdup( psz_module );
     p_item->psz_msg =       psz_str;
     p_item->psz_header =    psz_header;
+    p_item->date =          date;
 
-    PrintMsg( p_this, p_item );
+    PrintMsg( priv, p_item );
 
     if( p_queue->b_overflow )
     {
@@ -461,6 +635,615 @@ static void QueueMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
     UNLOCK_BANK;
 }
 
+/*****************************************************************************
+ * Conversion specifications
+ *****************************************************************************
+ * Deferred messages only support the printf() subset that VLC uses: no
+ * positional arguments, no %n, no wide characters and no long double.
+ *****************************************************************************/
+typedef struct
+{
+    const char *psz_flags;                     /**< first character of flags */
+    size_t      i_flags;
+    const char *psz_length;                 /**< first length modifier char */
+    size_t      i_length;
+    const char *psz_end;            /**< first character after the specifier */
+    char        i_conv;
+    bool        b_star_width;
+    bool        b_star_prec;
+    int         i_width;                                /**< -1 if unset */
+    int         i_prec;                                 /**< -1 if unset */
+} msg_spec_t;
+
+/* Parses the conversion specification following a '%' character */
+static bool ParseSpec( const char *psz, msg_spec_t *p_spec )
+{
+    p_spec->psz_flags = psz;
+    while( *psz && strchr( "-+ #0'", *psz ) != NULL )
+        psz++;
+    p_spec->i_flags = psz - p_spec->psz_flags;
+
+    p_spec->b_star_width = p_spec->b_star_prec = false;
+    p_spec->i_width = p_spec->i_prec = -1;
+    if( *psz == '*' )
+    {
+        p_spec->b_star_width = true;
+        psz++;
+    }
+    else if( *psz >= '0' && *psz <= '9' )
+    {
+        p_spec->i_width = strtol( psz, (char **)&psz, 10 );
+        if( *psz == '$' )
+            return false; /* positional argument */
+    }
+
+    if( *psz == '.' )
+    {
+        psz++;
+        if( *psz == '*' )
+        {
+            p_spec->b_star_prec = true;
+            psz++;
+        }
+        else
+            p_spec->i_prec = strtol( psz, (char **)&psz, 10 );
+    }
+
+    p_spec->psz_length = psz;
+    while( *psz && strchr( "hljzt", *psz ) != NULL )
+        psz++;
+    p_spec->i_length = psz - p_spec->psz_length;
+    if( p_spec->i_length > 2 )
+        return false;
+
+    p_spec->i_conv = *psz;
+    if( p_spec->i_conv == '\0'
+     || strchr( "diouxXcspeEfFgGaAm%", p_spec->i_conv ) == NULL )
+        return false;
+    if( p_spec->i_length && strchr( "csp", p_spec->i_conv ) != NULL )
+        return false; /* wide characters */
+    p_spec->psz_end = psz + 1;
+    return true;
+}
+
+/* Whether the length modifier of an integer conversion is s */
+static inline bool IsLength( const msg_spec_t *p_spec, const char *s )
+{
+    return p_spec->i_length == strlen( s )
+        && !strncmp( p_spec->psz_length, s, p_spec->i_length );
+}
+
+/**
+ * Copy the arguments of a message into a ring record
+ */
+static bool CaptureArgs( msg_record_t *p_rec, const char *psz_format,
+                         va_list args )
+{
+    msg_spec_t spec;
+
+    p_rec->i_args = 0;
+    p_rec->i_pool = 0;
+
+    for( const char *psz = strchr( psz_format, '%' ); psz != NULL;
+         psz = strchr( spec.psz_end, '%' ) )
+    {
+        if( !ParseSpec( psz + 1, &spec ) )
+            return false;
+        if( spec.i_conv == '%' )
+            continue;
+        if( spec.i_conv == 'm' )
+        {
+#ifdef __GLIBC__
+            continue;
+#else
+            return false; /* preformatted, with %m expanded */
+#endif
+        }
+
+        if( p_rec->i_args + spec.b_star_width + spec.b_star_prec
+              + 1 > MSG_MAX_ARGS )
+            return false;
+        if( spec.b_star_width )
+            p_rec->args[p_rec->i_args++].i = va_arg( args, int );
+        if( spec.b_star_prec )
+        {
+            spec.i_prec = va_arg( args, int );
+            p_rec->args[p_rec->i_args++].i = spec.i_prec;
+        }
+
+        msg_arg_t *p_arg = &p_rec->args[p_rec->i_args++];
+        switch( spec.i_conv )
+        {
+            case 'd': case 'i':
+                if( IsLength( &spec, "l" ) )
+                    p_arg->i = va_arg( args, long );
+                else if( IsLength( &spec, "ll" ) )
+                    p_arg->i = va_arg( args, long long );
+                else if( IsLength( &spec, "j" ) )
+                    p_arg->i = va_arg( args, intmax_t );
+                else if( IsLength( &spec, "z" ) )
+                    p_arg->i = va_arg( args, size_t );
+                else if( IsLength( &spec, "t" ) )
+                    p_arg->i = va_arg( args, ptrdiff_t );
+                else
+                    p_arg->i = va_arg( args, int );
+                break;
+
+            case 'o': case 'u': case 'x': case 'X':
+                if( IsLength( &spec, "l" ) )
+                    p_arg->u = va_arg( args, unsigned long );
+                else if( IsLength( &spec, "ll" ) )
+                    p_arg->u = va_arg( args, unsigned long long );
+                else if( IsLength( &spec, "j" ) )
+                    p_arg->u = va_arg( args, uintmax_t );
+                else if( IsLength( &spec, "z" ) )
+                    p_arg->u = va_arg( args, size_t );
+                else if( IsLength( &spec, "t" ) )
+                    p_arg->u = va_arg( args, ptrdiff_t );
+                else
+                    p_arg->u = va_arg( args, unsigned );
+                break;
+
+            case 'c':
+                p_arg->i = va_arg( args, int );
+                break;
+
+            case 'p':
+                p_arg->p = va_arg( args, void * );
+                break;
+
+            case 's':
+            {
+                const char *psz_arg = va_arg( args, const char * );
+                size_t i_len;
+
+                if( psz_arg == NULL )
+                {
+                    p_arg->s = MSG_NULL_STRING;
+                    break;
+                }
+                if( spec.i_prec >= 0 )
+                {
+                    const char *psz_nul = memchr( psz_arg, 0, spec.i_prec );
+                    i_len = psz_nul ? (size_t)(psz_nul - psz_arg)
+                                    : (size_t)spec.i_prec;
+                }
+                else
+                    i_len = strlen( psz_arg );
+
+                if( i_len >= MSG_POOL_SIZE - p_rec->i_pool )
+                    return false;
+                memcpy( p_rec->pool + p_rec->i_pool, psz_arg, i_len );
+                p_rec->pool[p_rec->i_pool + i_len] = '\0';
+                p_arg->s = p_rec->i_pool;
+                p_rec->i_pool += i_len + 1;
+                break;
+            }
+
+            default: /* floating point */
+                if( spec.i_length )
+                    return false;
+                p_arg->f = va_arg( args, double );
+                break;
+        }
+    }
+    return true;
+}
+
+/* Appends formatted text to a growing buffer */
+static bool AppendFormat( char **ppsz, size_t *pi_len, size_t *pi_max,
+                          const char *psz_format, ... )
+{
+    va_list args;
+    int i_ret;
+
+    for( ;; )
+    {
+        va_start( args, psz_format );
+        i_ret = vsnprintf( *ppsz + *pi_len, *pi_max - *pi_len,
+                           psz_format, args );
+        va_end( args );
+        if( i_ret < 0 )
+            return false;
+        if( (size_t)i_ret < *pi_max - *pi_len )
+            break;
+
+        size_t i_max = *pi_len + i_ret + 1 + 64;
+        char *psz_new = realloc( *ppsz, i_max );
+        if( psz_new == NULL )
+            return false;
+        *ppsz = psz_new;
+        *pi_max = i_max;
+    }
+    *pi_len += i_ret;
+    return true;
+}
+
+/**
+ * Format a deferred message from its format string and copied arguments
+ */
+static char *FormatRecord( const msg_record_t *p_rec )
+{
+    size_t i_len = 0, i_max = 256;
+    char *psz = malloc( i_max );
+    const char *psz_format = p_rec->psz_format;
+    unsigned i_arg = 0;
+    msg_spec_t spec;
+
+    if( psz == NULL )
+        return NULL;
+    psz[0] = '\0';
+
+    for( ;; )
+    {
+        const char *psz_pct = strchr( psz_format, '%' );
+        int i_lit = psz_pct ? psz_pct - psz_format : (int)strlen( psz_format );
+
+        if( i_lit > 0
+         && !AppendFormat( &psz, &i_len, &i_max, "%.*s", i_lit, psz_format ) )
+            goto error;
+        if( psz_pct == NULL )
+            break;
+
+        ParseSpec( psz_pct + 1, &spec ); /* already checked by CaptureArgs */
+        psz_format = spec.psz_end;
+
+        if( spec.i_conv == '%' )
+        {
+            if( !AppendFormat( &psz, &i_len, &i_max, "%%" ) )
+                goto error;
+            continue;
+        }
+        if( spec.i_conv == 'm' )
+        {
+            errno = p_rec->i_errno;
+            if( !AppendFormat( &psz, &i_len, &i_max, "%m" ) )
+                goto error;
+            continue;
+        }
+
+        /* Rebuild the specification with the star arguments resolved */
+        char psz_spec[64], *p = psz_spec;
+        int i_width = spec.i_width, i_prec = spec.i_prec;
+
+        if( spec.b_star_width )
+            i_width = p_rec->args[i_arg++].i;
+        if( spec.b_star_prec )
+            i_prec = p_rec->args[i_arg++].i;
+
+        *p++ = '%';
+        memcpy( p, spec.psz_flags, spec.i_flags );
+        p += spec.i_flags;
+        if( i_width < 0 && spec.b_star_width )
+        {
+            *p++ = '-';
+            i_width = -i_width;
+        }
+        if( i_width >= 0 )
+            p += sprintf( p, "%d", i_width );
+        if( i_prec >= 0 )
+            p += sprintf( p, ".%d", i_prec );
+        memcpy( p, spec.psz_length, spec.i_length );
+        p += spec.i_length;
+        *p++ = spec.i_conv;
+        *p = '\0';
+
+        const msg_arg_t *p_arg = &p_rec->args[i_arg++];
+        bool b_ok;
+        switch( spec.i_conv )
+        {
+            case 'd': case 'i':
+                if( IsLength( &spec, "l" ) )
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         (long)p_arg->i );
+                else if( IsLength( &spec, "ll" ) )
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         (long long)p_arg->i );
+                else if( IsLength( &spec, "j" ) )
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         p_arg->i );
+                else if( IsLength( &spec, "z" ) )
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         (size_t)p_arg->i );
+                else if( IsLength( &spec, "t" ) )
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         (ptrdiff_t)p_arg->i );
+                else
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         (int)p_arg->i );
+                break;
+
+            case 'o': case 'u': case 'x': case 'X':
+                if( IsLength( &spec, "l" ) )
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         (unsigned long)p_arg->u );
+                else if( IsLength( &spec, "ll" ) )
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         (unsigned long long)p_arg->u );
+                else if( IsLength( &spec, "j" ) )
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         p_arg->u );
+                else if( IsLength( &spec, "z" ) )
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         (size_t)p_arg->u );
+                else if( IsLength( &spec, "t" ) )
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         (ptrdiff_t)p_arg->u );
+                else
+                    b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                         (unsigned)p_arg->u );
+                break;
+
+            case 'c':
+                b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                     (int)p_arg->i );
+                break;
+
+            case 'p':
+                b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                     p_arg->p );
+                break;
+
+            case 's':
+                b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                     p_arg->s == MSG_NULL_STRING ? "(null)"
+                                                  : p_rec->pool + p_arg->s );
+                break;
+
+            default:
+                b_ok = AppendFormat( &psz, &i_len, &i_max, psz_spec,
+                                     p_arg->f );
+                break;
+        }
+        if( !b_ok )
+            goto error;
+    }
+    return psz;
+
+error:
+    free( psz );
+    return NULL;
+}
+
+/**
+ * Get the message ring of the calling thread, creating it if needed
+ */
+static msg_ring_t *GetRing( void )
+{
+    msg_ring_t *p_ring = vlc_threadvar_get( &msg_ring_global_key );
+    if( p_ring != NULL )
+        return p_ring;
+
+    p_ring = malloc( sizeof( *p_ring ) );
+    if( p_ring == NULL )
+        return NULL;
+    p_ring->i_head = p_ring->i_tail = 0;
+    p_ring->i_dropped = p_ring->i_dropped_seen = 0;
+    p_ring->b_orphan = false;
+
+    vlc_mutex_lock( &rings_lock );
+    p_ring->p_next = p_rings;
+    p_rings = p_ring;
+    vlc_mutex_unlock( &rings_lock );
+
+    vlc_threadvar_set( &msg_ring_global_key, p_ring );
+    return p_ring;
+}
+
+/**
+ * Store a message in the ring of the calling thread
+ *
+ * \return false if the message must be dispatched synchronously
+ */
+static bool DeferMsg( vlc_object_t *p_this, int i_type, const char *psz_module,
+                      const char *psz_format, va_list args, bool b_static )
+{
+    libvlc_priv_t *priv = libvlc_priv (p_this->p_libvlc);
+    int i_errno = errno;
+    msg_ring_t *p_ring = GetRing();
+
+    if( p_ring == NULL )
+        return false;
+
+    unsigned i_tail = p_ring->i_tail;
+    unsigned i_used = i_tail - p_ring->i_head;
+
+    if( i_used >= VLC_MSG_RINGSIZE )
+    {
+        /* The consumer is late: lose the message, it will tell */
+        p_ring->i_dropped++;
+        return true;
+    }
+
+    msg_record_t *p_rec = &p_ring->records[i_tail & (VLC_MSG_RINGSIZE - 1)];
+    va_list args_copy;
+
+    p_rec->priv = priv;
+    p_rec->i_type = i_type;
+    p_rec->i_object_id = p_this->i_object_id;
+    p_rec->psz_object_type = p_this->psz_object_type;
+    p_rec->psz_header = GetHeader( p_this );
+    p_rec->date = mdate();
+    p_rec->i_errno = i_errno;
+    strncpy( p_rec->psz_module, psz_module, sizeof( p_rec->psz_module ) );
+    p_rec->psz_module[sizeof( p_rec->psz_module ) - 1] = '\0';
+
+    bool b_captured = false;
+    if( b_static )
+    {
+        vlc_va_copy( args_copy, args );
+        b_captured = CaptureArgs( p_rec, psz_format, args_copy );
+        va_end( args_copy );
+    }
+
+    if( b_captured )
+    {
+        p_rec->psz_format = psz_format;
+        p_rec->psz_msg = NULL;
+    }
+    else
+    {
+        /* Transient or unsupported format, or too many arguments: format
+         * it right now */
+#ifndef __GLIBC__
+        char buf[strlen( psz_format ) + 2001];
+        ExpandErrno( buf, psz_format, i_errno );
+        psz_format = buf;
+#endif
+        p_rec->psz_format = NULL;
+        errno = i_errno;
+        if( vasprintf( &p_rec->psz_msg, psz_format, args ) == -1 )
+        {
+            free( p_rec->psz_header );
+            errno = i_errno;
+            return false;
+        }
+    }
+
+    /* Publish the record */
+    barrier();
+    p_ring->i_tail = i_tail + 1;
+
+    /* Wake the consumer up early if the ring is filling up */
+    if( i_used == VLC_MSG_RINGSIZE / 2 && priv->msg_bank.p_consumer )
+        vlc_object_signal( priv->msg_bank.p_consumer );
+
+    errno = i_errno;
+    return true;
+}
+
+/**
+ * Format and dispatch all pending records of all rings
+ *
+ * Records from different threads are dispatched in date order.
+ */
+static void DrainRings( void )
+{
+    vlc_mutex_lock( &rings_lock );
+
+    for( ;; )
+    {
+        msg_ring_t *p_first = NULL;
+        msg_record_t *p_rec = NULL;
+
+        for( msg_ring_t *p_ring = p_rings; p_ring; p_ring = p_ring->p_next )
+        {
+            if( p_ring->i_head == p_ring->i_tail )
+                continue;
+            barrier();
+
+            msg_record_t *p_head =
+                &p_ring->records[p_ring->i_head & (VLC_MSG_RINGSIZE - 1)];
+            if( p_rec == NULL || p_head->date < p_rec->date )
+            {
+                p_first = p_ring;
+                p_rec = p_head;
+            }
+        }
+        if( p_first == NULL )
+            break;
+
+        char *psz_msg = p_rec->psz_format ? FormatRecord( p_rec )
+                                          : p_rec->psz_msg;
+        if( psz_msg != NULL )
+            DispatchMsg( p_rec->priv, p_rec->i_type, p_rec->i_object_id,
+                         p_rec->psz_object_type, p_rec->psz_module,
+                         psz_msg, p_rec->psz_header, p_rec->date );
+        else
+            free( p_rec->psz_header );
+
+        if( p_first->i_dropped != p_first->i_dropped_seen )
+        {
+            unsigned i_dropped = p_first->i_dropped;
+            char *psz_warn;
+
+            if( asprintf( &psz_warn, "%u message(s) lost, ring overflowed",
+                          i_dropped - p_first->i_dropped_seen ) != -1 )
+                DispatchMsg( p_rec->priv, VLC_MSG_WARN, p_rec->i_object_id,
+                             p_rec->psz_object_type, "message",
+                             psz_warn, NULL, p_rec->date );
+            p_first->i_dropped_seen = i_dropped;
+        }
+
+        /* Release the record to the producer */
+        barrier();
+        p_first->i_head++;
+    }
+
+    /* Free the rings of the threads that have exited */
+    for( msg_ring_t **pp_ring = &p_rings; *pp_ring != NULL; )
+    {
+        msg_ring_t *p_ring = *pp_ring;
+
+        if( p_ring->b_orphan && p_ring->i_head == p_ring->i_tail )
+        {
+            *pp_ring = p_ring->p_next;
+            free( p_ring );
+        }
+        else
+            pp_ring = &p_ring->p_next;
+    }
+
+    vlc_mutex_unlock( &rings_lock );
+}
+
+/*****************************************************************************
+ * ConsumerThread: format pending messages in the background
+ *****************************************************************************/
+static void *ConsumerThread( vlc_object_t *p_this )
+{
+    vlc_object_lock( p_this );
+    while( vlc_object_alive( p_this ) )
+    {
+        vlc_object_unlock( p_this );
+        DrainRings();
+        vlc_object_lock( p_this );
+
+        if( vlc_object_alive( p_this ) )
+            vlc_object_timedwait( p_this, mdate() + VLC_MSG_CONSUMER_PERIOD );
+    }
+    vlc_object_unlock( p_this );
+    return NULL;
+}
+
+/**
+ * Initialize the message rings
+ * This is called once by vlc_threads_init().
+ */
+void msg_RingsInit( void )
+{
+    vlc_mutex_init( &rings_lock );
+    p_rings = NULL;
+}
+
+/**
+ * Destroy the message rings
+ * This is called once by vlc_threads_end(), when no instance is left.
+ */
+void msg_RingsEnd( void )
+{
+    while( p_rings != NULL )
+    {
+        msg_ring_t *p_ring = p_rings;
+
+        p_rings = p_ring->p_next;
+        free( p_ring );
+    }
+    vlc_mutex_destroy( &rings_lock );
+}
+
+/**
+ * Thread-local variable destructor of the message rings
+ */
+void msg_RingRelease( void *data )
+{
+    msg_ring_t *p_ring = data;
+
+    /* The ring is freed by the consumer once it is empty */
+    barrier();
+    p_ring->b_orphan = true;
+}
+
 /* following functions are local */
 
 /*****************************************************************************
@@ -511,7 +1294,7 @@ static void FlushMsg ( msg_queue_t *p_queue )
  *****************************************************************************
  * Print a message to stderr, with colour formatting if needed.
  *****************************************************************************/
-static void PrintMsg ( vlc_object_t * p_this, msg_item_t * p_item )
+static void PrintMsg ( libvlc_priv_t *priv, msg_item_t * p_item )
 {
 #   define COL(x)  "\033[" #x ";1m"
 #   define RED     COL(31)
@@ -526,24 +1309,10 @@ static void PrintMsg ( vlc_object_t * p_this, msg_item_t * p_item )
     static const char ppsz_type[4][9] = { "", " error", " warning", " debug" };
     static const char ppsz_color[4][8] = { WHITE, RED, YELLOW, GRAY };
     const char *psz_object;
-    libvlc_priv_t *priv = libvlc_priv (p_this->p_libvlc);
     int i_type = p_item->i_type;
 
-    switch( i_type )
-    {
-        case VLC_MSG_ERR:
-            if( priv->i_verbose < 0 ) return;
-            break;
-        case VLC_MSG_INFO:
-            if( priv->i_verbose < 0 ) return;
-            break;
-        case VLC_MSG_WARN:
-            if( priv->i_verbose < 1 ) return;
-            break;
-        case VLC_MSG_DBG:
-            if( priv->i_verbose < 2 ) return;
-            break;
-    }
+    if( !IsVisible( priv, i_type ) )
+        return;
 
     psz_object = p_item->psz_object_type;
 
@@ -602,6 +1371,24 @@ static void PrintMsg ( vlc_object_t * p_this, msg_item_t * p_item )
 #endif
 }
 
+/*****************************************************************************
+ * IsVisible: whether a message type is printed at the current verbosity
+ *****************************************************************************/
+static bool IsVisible( libvlc_priv_t *priv, int i_type )
+{
+    switch( i_type )
+    {
+        case VLC_MSG_ERR:
+        case VLC_MSG_INFO:
+            return priv->i_verbose >= 0;
+        case VLC_MSG_WARN:
+            return priv->i_verbose >= 1;
+        case VLC_MSG_DBG:
+            return priv->i_verbose >= 2;
+    }
+    return true;
+}
+
 static msg_context_t* GetContext(void)
 {
     msg_context_t *p_ctx = vlc_threadvar_get( &msg_context_global_key );
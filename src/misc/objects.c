@@ -134,9 +134,9 @@ void *__vlc_custom_create( vlc_object_t *p_this, size_t i_size,
         p_new->i_flags = p_this->i_flags
             & (OBJECT_FLAGS_NODBG|OBJECT_FLAGS_QUIET|OBJECT_FLAGS_NOINTERACT);
 
-    p_priv->p_vars = calloc( sizeof( variable_t ), 16 );
+    p_priv->pp_vars = calloc( sizeof( variable_t * ), 16 );
 
-    if( !p_priv->p_vars )
+    if( !p_priv->pp_vars )
     {
         free( p_priv );
         return NULL;
@@ -180,6 +180,7 @@ void *__vlc_custom_create( vlc_object_t *p_this, size_t i_size,
     vlc_mutex_init( &p_priv->lock );
     vlc_cond_init( p_new, &p_priv->wait );
     vlc_mutex_init( &p_priv->var_lock );
+    vlc_cond_init( p_new, &p_priv->var_wait );
     vlc_spin_init( &p_priv->spin );
     p_priv->pipes[0] = p_priv->pipes[1] = -1;
 
@@ -320,10 +321,11 @@ static void vlc_object_destroy( vlc_object_t *p_this )
      * no memmove calls have to be done. */
     while( p_priv->i_vars )
     {
-        var_Destroy( p_this, p_priv->p_vars[p_priv->i_vars - 1].psz_name );
+        var_Destroy( p_this, p_priv->pp_vars[p_priv->i_vars - 1]->psz_name );
     }
 
-    free( p_priv->p_vars );
+    free( p_priv->pp_vars );
+    vlc_cond_destroy( &p_priv->var_wait );
     vlc_mutex_destroy( &p_priv->var_lock );
 
     free( p_this->psz_header );
@@ -1071,7 +1073,7 @@ static int DumpCommand( vlc_object_t *p_this, char const *psz_cmd,
                 printf( " `-o No variables\n" );
             for( i = 0; i < vlc_internals( p_object )->i_vars; i++ )
             {
-                variable_t *p_var = vlc_internals( p_object )->p_vars + i;
+                variable_t *p_var = vlc_internals( p_object )->pp_vars[i];
 
                 const char *psz_type = "unknown";
                 switch( p_var->i_type & VLC_VAR_TYPE )
@@ -40,8 +40,122 @@
 static int CounterUpdate( vlc_object_t *p_this,
                           counter_t *p_counter,
                           vlc_value_t val, vlc_value_t * );
+static int CounterUpdateLocked( vlc_object_t *p_this,
+                                counter_t *p_counter,
+                                vlc_value_t val, vlc_value_t * );
 static void TimerDump( vlc_object_t *p_this, counter_t *p_counter, bool);
 
+/*****************************************************************************
+ * Sharded accumulators
+ *****************************************************************************
+ * Integer counters and histograms are split into shards, each on its own
+ * cache line. A thread always updates the same shard with an atomic add, and
+ * readers sum all the shards, so updates never take a lock (except on the
+ * targets without 64-bit atomic operations).
+ *****************************************************************************/
+#define STATS_SHARDS 16
+#define STATS_CACHE_LINE 64
+
+typedef struct
+{
+    int64_t  i_value;               /* sum of the updates (or samples) */
+    uint64_t i_count;               /* number of samples (histograms) */
+    uint64_t pi_buckets[STATS_HISTOGRAM_BUCKETS];
+} stats_shard_t;
+
+/* The shards are 64-bit: only use the atomic builtins on targets which
+ * have a native 64-bit compare-and-swap (not on ppc32, ARMv5, i486...) */
+#if defined (__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+# define STATS_ATOMIC 1
+#endif
+
+static inline bool IsSharded( const counter_t *p_counter )
+{
+    return p_counter->i_compute_type == STATS_HISTOGRAM
+        || ( p_counter->i_compute_type == STATS_COUNTER
+             && p_counter->i_type == VLC_VAR_INTEGER );
+}
+
+static inline size_t ShardSize( const counter_t *p_counter )
+{
+    size_t i_size = p_counter->i_compute_type == STATS_HISTOGRAM
+                  ? sizeof( stats_shard_t ) : sizeof( int64_t );
+    return (i_size + STATS_CACHE_LINE - 1) & ~(STATS_CACHE_LINE - 1);
+}
+
+static inline stats_shard_t *GetShard( const counter_t *p_counter,
+                                       unsigned i_shard )
+{
+    uintptr_t i_base = ((uintptr_t)p_counter->p_shards + STATS_CACHE_LINE - 1)
+                       & ~(uintptr_t)(STATS_CACHE_LINE - 1);
+    return (stats_shard_t *)(i_base + i_shard * ShardSize( p_counter ));
+}
+
+/* Shard of the calling thread */
+static inline unsigned ShardIndex( void )
+{
+    uint64_t i_id;
+#if defined( LIBVLC_USE_PTHREAD )
+    union { pthread_t th; uint64_t i; } v = { .i = 0 };
+    v.th = pthread_self();
+    i_id = v.i;
+#elif defined( WIN32 )
+    i_id = GetCurrentThreadId();
+#else
+    i_id = 0;
+#endif
+    /* Thread handles are aligned: mix the upper bits in */
+    i_id ^= i_id >> 17;
+    return (uint32_t)(i_id * UINT64_C(0x9E3779B97F4A7C15) >> 32)
+           % STATS_SHARDS;
+}
+
+static inline void ShardAdd( counter_t *p_counter, void *p, int64_t i )
+{
+#ifdef STATS_ATOMIC
+    (void)p_counter;
+    __sync_fetch_and_add( (int64_t *)p, i );
+#else
+    vlc_mutex_lock( &p_counter->lock );
+    *(int64_t *)p += i;
+    vlc_mutex_unlock( &p_counter->lock );
+#endif
+}
+
+static inline int64_t ShardRead( counter_t *p_counter, void *p )
+{
+#ifdef STATS_ATOMIC
+    (void)p_counter;
+    return __sync_fetch_and_add( (int64_t *)p, 0 );
+#else
+    int64_t i;
+    vlc_mutex_lock( &p_counter->lock );
+    i = *(int64_t *)p;
+    vlc_mutex_unlock( &p_counter->lock );
+    return i;
+#endif
+}
+
+static int64_t ShardSum( counter_t *p_counter )
+{
+    int64_t i_sum = 0;
+    for( unsigned i = 0; i < STATS_SHARDS; i++ )
+        i_sum += ShardRead( p_counter, &GetShard( p_counter, i )->i_value );
+    return i_sum;
+}
+
+/* Histogram bucket of a value: 0 below 1, then one bucket per power of 2 */
+static inline unsigned HistogramBucket( mtime_t i_value )
+{
+    unsigned i_bucket = 0;
+    while( i_value > 0 && i_bucket < STATS_HISTOGRAM_BUCKETS - 1 )
+    {
+        i_value >>= 1;
+        i_bucket++;
+    }
+    return i_bucket;
+}
+
 /*****************************************************************************
  * Exported functions
  *****************************************************************************/
@@ -72,6 +186,22 @@ counter_t * __stats_CounterCreate( vlc_object_t *p_this,
     p_counter->update_interval = 0;
     p_counter->last_update = 0;
 
+    vlc_mutex_init( &p_counter->lock );
+    p_counter->p_shards = NULL;
+    if( IsSharded( p_counter ) )
+    {
+        size_t i_size = STATS_SHARDS * ShardSize( p_counter )
+                      + STATS_CACHE_LINE - 1;
+        p_counter->p_shards = malloc( i_size );
+        if( !p_counter->p_shards )
+        {
+            vlc_mutex_destroy( &p_counter->lock );
+            free( p_counter );
+            return NULL;
+        }
+        memset( p_counter->p_shards, 0, i_size );
+    }
+
     return p_counter;
 }
 
@@ -98,12 +228,30 @@ int __stats_Update( vlc_object_t *p_this, counter_t *p_counter,
  */
 int __stats_Get( vlc_object_t *p_this, counter_t *p_counter, vlc_value_t *val )
 {
-    if( !libvlc_stats (p_this) || !p_counter || p_counter->i_samples == 0 )
+    if( !libvlc_stats (p_this) || !p_counter )
     {
         val->i_int = val->f_float = 0.0;
         return VLC_EGENERIC;
     }
 
+    if( IsSharded( p_counter ) )
+    {
+        /* Histograms: total of the samples */
+        if( p_counter->i_compute_type == STATS_HISTOGRAM )
+            val->i_time = ShardSum( p_counter );
+        else
+            val->i_int = ShardSum( p_counter );
+        return VLC_SUCCESS;
+    }
+
+    vlc_mutex_lock( &p_counter->lock );
+    if( p_counter->i_samples == 0 )
+    {
+        vlc_mutex_unlock( &p_counter->lock );
+        val->i_int = val->f_float = 0.0;
+        return VLC_EGENERIC;
+    }
+
     switch( p_counter->i_compute_type )
     {
     case STATS_LAST:
@@ -116,6 +264,7 @@ int __stats_Get( vlc_object_t *p_this, counter_t *p_counter, vlc_value_t *val )
         /* Not ready yet */
         if( p_counter->i_samples < 2 )
         {
+            vlc_mutex_unlock( &p_counter->lock );
             val->i_int = 0; val->f_float = 0.0;
             return VLC_EGENERIC;
         }
@@ -137,7 +286,35 @@ int __stats_Get( vlc_object_t *p_this, counter_t *p_counter, vlc_value_t *val )
         }
         break;
     }
-    return VLC_SUCCESS;;
+    vlc_mutex_unlock( &p_counter->lock );
+    return VLC_SUCCESS;
+}
+
+/** Get a snapshot of a histogram counter
+ * \param p_this an object
+ * \param p_counter the counter, created with STATS_HISTOGRAM
+ * \param p_histogram a pointer to the snapshot to fill
+ * \return an error code
+ */
+int __stats_GetHistogram( vlc_object_t *p_this, counter_t *p_counter,
+                          stats_histogram_t *p_histogram )
+{
+    memset( p_histogram, 0, sizeof( *p_histogram ) );
+    if( !libvlc_stats (p_this) || !p_counter
+     || p_counter->i_compute_type != STATS_HISTOGRAM )
+        return VLC_EGENERIC;
+
+    for( unsigned i = 0; i < STATS_SHARDS; i++ )
+    {
+        stats_shard_t *p_shard = GetShard( p_counter, i );
+
+        p_histogram->i_sum += ShardRead( p_counter, &p_shard->i_value );
+        p_histogram->i_count += ShardRead( p_counter, &p_shard->i_count );
+        for( unsigned j = 0; j < STATS_HISTOGRAM_BUCKETS; j++ )
+            p_histogram->pi_buckets[j] +=
+                ShardRead( p_counter, &p_shard->pi_buckets[j] );
+    }
+    return VLC_SUCCESS;
 }
 
 input_stats_t *stats_NewInputStats( input_thread_t *p_input )
@@ -171,6 +348,8 @@ void stats_ComputeInputStats( input_thread_t *p_input, input_stats_t *p_stats )
                     &p_stats->f_input_bitrate );
     stats_GetInteger( p_input, p_input->p->counters.p_demux_read,
                       &p_stats->i_demux_read_bytes );
+    stats_GetInteger( p_input, p_input->p->counters.p_demux_packets,
+                      &p_stats->i_demux_read_packets );
     stats_GetFloat( p_input, p_input->p->counters.p_demux_bitrate,
                     &p_stats->f_demux_bitrate );
 
@@ -203,6 +382,12 @@ void stats_ComputeInputStats( input_thread_t *p_input, input_stats_t *p_stats )
     stats_GetInteger( p_input, p_input->p->counters.p_lost_pictures,
                       &p_stats->i_lost_pictures );
 
+    /* Latencies */
+    stats_GetHistogram( p_input, p_input->p->counters.p_decode_time,
+                        &p_stats->decode_time );
+    stats_GetHistogram( p_input, p_input->p->counters.p_picture_lateness,
+                        &p_stats->picture_lateness );
+
     vlc_mutex_unlock( &p_stats->lock );
     vlc_mutex_unlock( &p_input->p->counters.counters_lock );
 }
@@ -219,6 +404,9 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
     p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
      = 0;
+    memset( &p_stats->decode_time, 0, sizeof( p_stats->decode_time ) );
+    memset( &p_stats->picture_lateness, 0,
+            sizeof( p_stats->picture_lateness ) );
     vlc_mutex_unlock( &p_stats->lock );
 }
 
@@ -434,6 +622,8 @@ void stats_CounterClean( counter_t *p_c )
             free( p_s );
             i--;
         }
+        vlc_mutex_destroy( &p_c->lock );
+        free( p_c->p_shards );
         free( p_c->psz_name );
         free( p_c );
     }
@@ -447,7 +637,8 @@ void stats_CounterClean( counter_t *p_c )
 /**
  * Update a statistics counter, according to its type
  * If needed, perform a bit of computation (derivative, mostly)
- * This function must be entered with stats handler lock
+ * Sharded counters are updated without locking, the others under the
+ * counter lock.
  * \param p_counter the counter to update
  * \param val the "new" value
  * \return an error code
@@ -455,6 +646,36 @@ void stats_CounterClean( counter_t *p_c )
 static int CounterUpdate( vlc_object_t *p_handler,
                           counter_t *p_counter,
                           vlc_value_t val, vlc_value_t *new_val )
+{
+    if( IsSharded( p_counter ) )
+    {
+        stats_shard_t *p_shard = GetShard( p_counter, ShardIndex() );
+
+        if( p_counter->i_compute_type == STATS_HISTOGRAM )
+        {
+            ShardAdd( p_counter, &p_shard->i_value, val.i_time );
+            ShardAdd( p_counter, &p_shard->i_count, 1 );
+            ShardAdd( p_counter,
+                      &p_shard->pi_buckets[HistogramBucket( val.i_time )], 1 );
+            return VLC_SUCCESS;
+        }
+
+        ShardAdd( p_counter, &p_shard->i_value, val.i_int );
+        if( new_val )
+            new_val->i_int = ShardSum( p_counter );
+        return VLC_SUCCESS;
+    }
+
+    int i_ret;
+    vlc_mutex_lock( &p_counter->lock );
+    i_ret = CounterUpdateLocked( p_handler, p_counter, val, new_val );
+    vlc_mutex_unlock( &p_counter->lock );
+    return i_ret;
+}
+
+static int CounterUpdateLocked( vlc_object_t *p_handler,
+                                counter_t *p_counter,
+                                vlc_value_t val, vlc_value_t *new_val )
 {
     switch( p_counter->i_compute_type )
     {
@@ -78,6 +78,7 @@ vlc_object_t *vlc_threadobj (void)
 #endif
 
 vlc_threadvar_t msg_context_global_key;
+vlc_threadvar_t msg_ring_global_key;
 
 #if defined(LIBVLC_USE_PTHREAD)
 static inline unsigned long vlc_threadid (void)
@@ -177,6 +178,8 @@ int vlc_threads_init( void )
         vlc_threadvar_create( &thread_object_key, NULL );
 #endif
         vlc_threadvar_create( &msg_context_global_key, msg_StackDestroy );
+        vlc_threadvar_create( &msg_ring_global_key, msg_RingRelease );
+        msg_RingsInit();
     }
     i_initializations++;
 
@@ -206,6 +209,8 @@ void vlc_threads_end( void )
     if( i_initializations == 1 )
     {
         vlc_object_release( p_root );
+        msg_RingsEnd();
+        vlc_threadvar_delete( &msg_ring_global_key );
         vlc_threadvar_delete( &msg_context_global_key );
 #ifndef NDEBUG
         vlc_threadvar_delete( &thread_object_key );
@@ -139,16 +139,112 @@ static void FreeList( vlc_value_t *p_val )
  *****************************************************************************/
 static int      GetUnused   ( vlc_object_t *, const char * );
 static uint32_t HashString  ( const char * );
-static int      Insert      ( variable_t *, int, const char * );
-static int      InsertInner ( variable_t *, int, uint32_t );
-static int      Lookup      ( variable_t *, int, const char * );
-static int      LookupInner ( variable_t *, int, uint32_t );
+static int      Insert      ( variable_t **, int, const char * );
+static int      InsertInner ( variable_t **, int, uint32_t );
+static int      Lookup      ( variable_t **, int, const char * );
+static int      LookupInner ( variable_t **, int, uint32_t );
 
 static void     CheckValue  ( variable_t *, vlc_value_t * );
+static void     TriggerCallbacks( vlc_object_t *, variable_t *,
+                                  vlc_value_t, vlc_value_t );
 
 static int      InheritValue( vlc_object_t *, const char *, vlc_value_t *,
                               int );
 
+/*****************************************************************************
+ * Numeric values
+ *****************************************************************************
+ * Boolean, integer, float and time values all fit in the first 64 bits of
+ * the vlc_value_t. Where 64-bits atomic operations are available, these are
+ * read and written atomically, so that handles can get them without taking
+ * the variables lock.
+ *****************************************************************************/
+#if defined (__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8)
+# define VAR_ATOMIC 1
+#endif
+
+static inline bool IsNumeric( int i_type )
+{
+    switch( i_type & VLC_VAR_TYPE )
+    {
+        case VLC_VAR_BOOL:
+        case VLC_VAR_INTEGER:
+        case VLC_VAR_HOTKEY:
+        case VLC_VAR_FLOAT:
+        case VLC_VAR_TIME:
+            return true;
+    }
+    return false;
+}
+
+static inline vlc_value_t LoadValue( variable_t *p_var )
+{
+#ifdef VAR_ATOMIC
+    if( p_var->b_numeric )
+    {
+        vlc_value_t val;
+        val.i_time = __sync_fetch_and_add( &p_var->val.i_time, 0 );
+        return val;
+    }
+#endif
+    return p_var->val;
+}
+
+static inline void StoreValue( variable_t *p_var, vlc_value_t val )
+{
+#ifdef VAR_ATOMIC
+    if( p_var->b_numeric )
+    {
+        int64_t i_old;
+        do
+            i_old = p_var->val.i_time;
+        while( !__sync_bool_compare_and_swap( &p_var->val.i_time, i_old,
+                                              val.i_time ) );
+        return;
+    }
+#endif
+    p_var->val = val;
+}
+
+/* Gets a numeric value without looking the variable up nor taking the lock,
+ * where it is read atomically. Returns false if the caller has to take the
+ * slow path. */
+static bool LoadQuick( variable_t *p_var, vlc_value_t *p_val )
+{
+#ifdef VAR_ATOMIC
+    if( p_var->b_numeric )
+    {
+        *p_val = LoadValue( p_var );
+        return true;
+    }
+#else
+    (void)p_var; (void)p_val;
+#endif
+    return false;
+}
+
+/* Sets a numeric value without looking the variable up, if nothing else
+ * has to be done. Returns false if the caller has to take the slow path. */
+static bool StoreQuick( variable_t *p_var, vlc_value_t val, bool b_callbacks )
+{
+    vlc_object_internals_t *p_priv;
+    bool b_quick;
+
+    if( !p_var->b_numeric )
+        return false;
+
+    /* The flags and the callbacks are changed under the lock */
+    p_priv = vlc_internals( p_var->p_obj );
+    vlc_mutex_lock( &p_priv->var_lock );
+    b_quick = !( p_var->i_type & (VLC_VAR_HASMIN|VLC_VAR_HASMAX
+                                  |VLC_VAR_HASSTEP|VLC_VAR_HASCHOICE) )
+           && !( b_callbacks && p_var->i_entries );
+    if( b_quick )
+        StoreValue( p_var, val );
+    vlc_mutex_unlock( &p_priv->var_lock );
+    return b_quick;
+}
+
 /**
  * Initialize a vlc variable
  *
@@ -175,46 +271,57 @@ int __var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
      * duplicate the lookups. It's not that serious, but if anyone finds some
      * time to rework Insert() so that only one lookup has to be done, feel
      * free to do so. */
-    i_new = Lookup( p_priv->p_vars, p_priv->i_vars, psz_name );
+    i_new = Lookup( p_priv->pp_vars, p_priv->i_vars, psz_name );
 
     if( i_new >= 0 )
     {
         /* If the types differ, variable creation failed. */
-        if( (i_type & ~(VLC_VAR_DOINHERIT|VLC_VAR_ISCOMMAND)) != p_priv->p_vars[i_new].i_type )
+        if( (i_type & ~(VLC_VAR_DOINHERIT|VLC_VAR_ISCOMMAND)) != p_priv->pp_vars[i_new]->i_type )
         {
             vlc_mutex_unlock( &p_priv->var_lock );
             return VLC_EBADVAR;
         }
 
-        p_priv->p_vars[i_new].i_usage++;
+        p_priv->pp_vars[i_new]->i_usage++;
         if( i_type & VLC_VAR_ISCOMMAND )
-            p_priv->p_vars[i_new].i_type |= VLC_VAR_ISCOMMAND;
+            p_priv->pp_vars[i_new]->i_type |= VLC_VAR_ISCOMMAND;
         vlc_mutex_unlock( &p_priv->var_lock );
         return VLC_SUCCESS;
     }
 
-    i_new = Insert( p_priv->p_vars, p_priv->i_vars, psz_name );
+    /* The variables are allocated one by one, so that they do not move
+     * when others are created or destroyed: handles point to them. */
+    p_var = malloc( sizeof(*p_var) );
+    if( p_var == NULL )
+    {
+        vlc_mutex_unlock( &p_priv->var_lock );
+        return VLC_ENOMEM;
+    }
+
+    i_new = Insert( p_priv->pp_vars, p_priv->i_vars, psz_name );
 
     if( (p_priv->i_vars & 15) == 15 )
     {
-        p_priv->p_vars = realloc( p_priv->p_vars,
-                                  (p_priv->i_vars+17) * sizeof(variable_t) );
+        p_priv->pp_vars = realloc( p_priv->pp_vars,
+                                   (p_priv->i_vars+17) * sizeof(variable_t *) );
     }
 
-    memmove( p_priv->p_vars + i_new + 1,
-             p_priv->p_vars + i_new,
-             (p_priv->i_vars - i_new) * sizeof(variable_t) );
+    memmove( p_priv->pp_vars + i_new + 1,
+             p_priv->pp_vars + i_new,
+             (p_priv->i_vars - i_new) * sizeof(variable_t *) );
 
     p_priv->i_vars++;
 
-    p_var = &p_priv->p_vars[i_new];
+    p_priv->pp_vars[i_new] = p_var;
     memset( p_var, 0, sizeof(*p_var) );
 
+    p_var->p_obj = p_this;
     p_var->i_hash = HashString( psz_name );
     p_var->psz_name = strdup( psz_name );
     p_var->psz_text = NULL;
 
     p_var->i_type = i_type & ~VLC_VAR_DOINHERIT;
+    p_var->b_numeric = IsNumeric( i_type );
     memset( &p_var->val, 0, sizeof(vlc_value_t) );
 
     p_var->pf_dup = DupDummy;
@@ -228,7 +335,7 @@ int __var_Create( vlc_object_t *p_this, const char *psz_name, int i_type )
     p_var->choices_text.i_count = 0;
     p_var->choices_text.p_values = NULL;
 
-    p_var->b_incallback = false;
+    p_var->i_incallback = 0;
     p_var->i_entries = 0;
     p_var->p_entries = NULL;
 
@@ -342,7 +449,7 @@ int __var_Destroy( vlc_object_t *p_this, const char *psz_name )
         return i_var;
     }
 
-    p_var = &p_priv->p_vars[i_var];
+    p_var = p_priv->pp_vars[i_var];
 
     if( p_var->i_usage > 1 )
     {
@@ -374,15 +481,16 @@ int __var_Destroy( vlc_object_t *p_this, const char *psz_name )
 
     free( p_var->psz_name );
     free( p_var->psz_text );
+    free( p_var );
 
-    memmove( p_priv->p_vars + i_var,
-             p_priv->p_vars + i_var + 1,
-             (p_priv->i_vars - i_var - 1) * sizeof(variable_t) );
+    memmove( p_priv->pp_vars + i_var,
+             p_priv->pp_vars + i_var + 1,
+             (p_priv->i_vars - i_var - 1) * sizeof(variable_t *) );
 
     if( (p_priv->i_vars & 15) == 0 )
     {
-        p_priv->p_vars = realloc( p_priv->p_vars,
-                          (p_priv->i_vars) * sizeof( variable_t ) );
+        p_priv->pp_vars = realloc( p_priv->pp_vars,
+                          (p_priv->i_vars) * sizeof( variable_t * ) );
     }
 
     p_priv->i_vars--;
@@ -412,7 +520,7 @@ int __var_Change( vlc_object_t *p_this, const char *psz_name,
     vlc_refcheck( p_this );
     vlc_mutex_lock( &p_priv->var_lock );
 
-    i_var = Lookup( p_priv->p_vars, p_priv->i_vars, psz_name );
+    i_var = Lookup( p_priv->pp_vars, p_priv->i_vars, psz_name );
 
     if( i_var < 0 )
     {
@@ -420,7 +528,7 @@ int __var_Change( vlc_object_t *p_this, const char *psz_name,
         return VLC_ENOVAR;
     }
 
-    p_var = &p_priv->p_vars[i_var];
+    p_var = p_priv->pp_vars[i_var];
 
     switch( i_action )
     {
@@ -562,11 +670,11 @@ int __var_Change( vlc_object_t *p_this, const char *psz_name,
             /* Duplicate data if needed */
             p_var->pf_dup( p_val );
             /* Backup needed stuff */
-            oldval = p_var->val;
+            oldval = LoadValue( p_var );
             /* Check boundaries and list */
             CheckValue( p_var, p_val );
             /* Set the variable */
-            p_var->val = *p_val;
+            StoreValue( p_var, *p_val );
             /* Free data if needed */
             p_var->pf_free( &oldval );
             break;
@@ -642,55 +750,27 @@ int __var_Change( vlc_object_t *p_this, const char *psz_name,
                     /* Duplicate already done */
 
                     /* Backup needed stuff */
-                    oldval = p_var->val;
+                    oldval = LoadValue( p_var );
                     /* Check boundaries and list */
                     CheckValue( p_var, &val );
                     /* Set the variable */
-                    p_var->val = val;
+                    StoreValue( p_var, val );
                     /* Free data if needed */
                     p_var->pf_free( &oldval );
                 }
 
                 if( p_val )
                 {
-                    *p_val = p_var->val;
+                    *p_val = LoadValue( p_var );
                     p_var->pf_dup( p_val );
                 }
             }
             break;
         case VLC_VAR_TRIGGER_CALLBACKS:
+            if( p_var->i_entries )
             {
-                /* Deal with callbacks. Tell we're in a callback, release the lock,
-                 * call stored functions, retake the lock. */
-                if( p_var->i_entries )
-                {
-                    int i_var;
-                    int i_entries = p_var->i_entries;
-                    callback_entry_t *p_entries = p_var->p_entries;
-
-                    p_var->b_incallback = true;
-                    vlc_mutex_unlock( &p_priv->var_lock );
-
-                    /* The real calls */
-                    for( ; i_entries-- ; )
-                    {
-                        p_entries[i_entries].pf_callback( p_this, psz_name, p_var->val, p_var->val,
-                                                          p_entries[i_entries].p_data );
-                    }
-
-                    vlc_mutex_lock( &p_priv->var_lock );
-
-                    i_var = Lookup( p_priv->p_vars, p_priv->i_vars, psz_name );
-                    if( i_var < 0 )
-                    {
-                        msg_Err( p_this, "variable %s has disappeared", psz_name );
-                        vlc_mutex_unlock( &p_priv->var_lock );
-                        return VLC_ENOVAR;
-                    }
-
-                    p_var = &p_priv->p_vars[i_var];
-                    p_var->b_incallback = false;
-                }
+                oldval = LoadValue( p_var );
+                TriggerCallbacks( p_this, p_var, oldval, oldval );
             }
             break;
 
@@ -721,7 +801,7 @@ int __var_Type( vlc_object_t *p_this, const char *psz_name )
 
     vlc_mutex_lock( &p_priv->var_lock );
 
-    i_var = Lookup( p_priv->p_vars, p_priv->i_vars, psz_name );
+    i_var = Lookup( p_priv->pp_vars, p_priv->i_vars, psz_name );
 
     if( i_var < 0 )
     {
@@ -729,7 +809,7 @@ int __var_Type( vlc_object_t *p_this, const char *psz_name )
         return 0;
     }
 
-    i_type = p_priv->p_vars[i_var].i_type;
+    i_type = p_priv->pp_vars[i_var]->i_type;
 
     vlc_mutex_unlock( &p_priv->var_lock );
 
@@ -760,51 +840,23 @@ int __var_Set( vlc_object_t *p_this, const char *psz_name, vlc_value_t val )
         return i_var;
     }
 
-    p_var = &p_priv->p_vars[i_var];
+    p_var = p_priv->pp_vars[i_var];
 
     /* Duplicate data if needed */
     p_var->pf_dup( &val );
 
     /* Backup needed stuff */
-    oldval = p_var->val;
+    oldval = LoadValue( p_var );
 
     /* Check boundaries and list */
     CheckValue( p_var, &val );
 
     /* Set the variable */
-    p_var->val = val;
+    StoreValue( p_var, val );
 
-    /* Deal with callbacks. Tell we're in a callback, release the lock,
-     * call stored functions, retake the lock. */
+    /* Deal with callbacks */
     if( p_var->i_entries )
-    {
-        int i_var;
-        int i_entries = p_var->i_entries;
-        callback_entry_t *p_entries = p_var->p_entries;
-
-        p_var->b_incallback = true;
-        vlc_mutex_unlock( &p_priv->var_lock );
-
-        /* The real calls */
-        for( ; i_entries-- ; )
-        {
-            p_entries[i_entries].pf_callback( p_this, psz_name, oldval, val,
-                                              p_entries[i_entries].p_data );
-        }
-
-        vlc_mutex_lock( &p_priv->var_lock );
-
-        i_var = Lookup( p_priv->p_vars, p_priv->i_vars, psz_name );
-        if( i_var < 0 )
-        {
-            msg_Err( p_this, "variable %s has disappeared", psz_name );
-            vlc_mutex_unlock( &p_priv->var_lock );
-            return VLC_ENOVAR;
-        }
-
-        p_var = &p_priv->p_vars[i_var];
-        p_var->b_incallback = false;
-    }
+        TriggerCallbacks( p_this, p_var, oldval, val );
 
     /* Free data if needed */
     p_var->pf_free( &oldval );
@@ -831,7 +883,7 @@ int __var_Get( vlc_object_t *p_this, const char *psz_name, vlc_value_t *p_val )
     vlc_refcheck( p_this );
     vlc_mutex_lock( &p_priv->var_lock );
 
-    i_var = Lookup( p_priv->p_vars, p_priv->i_vars, psz_name );
+    i_var = Lookup( p_priv->pp_vars, p_priv->i_vars, psz_name );
 
     if( i_var < 0 )
     {
@@ -839,10 +891,10 @@ int __var_Get( vlc_object_t *p_this, const char *psz_name, vlc_value_t *p_val )
         return VLC_ENOVAR;
     }
 
-    p_var = &p_priv->p_vars[i_var];
+    p_var = p_priv->pp_vars[i_var];
 
     /* Really get the variable */
-    *p_val = p_var->val;
+    *p_val = LoadValue( p_var );
 
     /* Duplicate value if needed */
     p_var->pf_dup( p_val );
@@ -852,6 +904,88 @@ int __var_Get( vlc_object_t *p_this, const char *psz_name, vlc_value_t *p_val )
     return VLC_SUCCESS;
 }
 
+/**
+ * Get a handle on a variable
+ *
+ * The variable is looked up once, and will not be destroyed until the
+ * handle is released, even if var_Destroy() is called meanwhile. Setting
+ * numeric variables through a handle only holds the variables lock for a
+ * moment, unless the variable has callbacks to run or boundaries to check,
+ * and getting them does not take it where 64-bits atomic operations exist.
+ *
+ * \param p_this The object that holds the variable
+ * \param psz_name The name of the variable
+ * \return the handle, or NULL if the variable does not exist
+ */
+variable_t *__var_Hold( vlc_object_t *p_this, const char *psz_name )
+{
+    int i_var;
+    variable_t *p_var = NULL;
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+
+    vlc_refcheck( p_this );
+    vlc_mutex_lock( &p_priv->var_lock );
+
+    i_var = Lookup( p_priv->pp_vars, p_priv->i_vars, psz_name );
+    if( i_var >= 0 )
+    {
+        p_var = p_priv->pp_vars[i_var];
+        p_var->i_usage++;
+    }
+
+    vlc_mutex_unlock( &p_priv->var_lock );
+
+    return p_var;
+}
+
+/**
+ * Release a variable handle
+ *
+ * This is the same as calling var_Destroy() on the variable; the handle
+ * must not be used afterwards.
+ */
+void var_Release( variable_t *p_var )
+{
+    /* The name is only freed with the variable, once it is not needed */
+    __var_Destroy( p_var->p_obj, p_var->psz_name );
+}
+
+/**
+ * Set a variable's value through a handle
+ *
+ * This is the same as var_Set() on the variable.
+ */
+int var_SetByHandle( variable_t *p_var, vlc_value_t val )
+{
+    if( StoreQuick( p_var, val, true ) )
+        return VLC_SUCCESS;
+    return __var_Set( p_var->p_obj, p_var->psz_name, val );
+}
+
+/**
+ * Set a variable's value through a handle, without triggering its callbacks
+ *
+ * This is the same as var_Change() with VLC_VAR_SETVALUE on the variable.
+ */
+int var_SetValueByHandle( variable_t *p_var, vlc_value_t val )
+{
+    if( StoreQuick( p_var, val, false ) )
+        return VLC_SUCCESS;
+    return __var_Change( p_var->p_obj, p_var->psz_name, VLC_VAR_SETVALUE,
+                         &val, NULL );
+}
+
+/**
+ * Get a variable's value through a handle
+ *
+ * This is the same as var_Get() on the variable.
+ */
+int var_GetByHandle( variable_t *p_var, vlc_value_t *p_val )
+{
+    if( LoadQuick( p_var, p_val ) )
+        return VLC_SUCCESS;
+    return __var_Get( p_var->p_obj, p_var->psz_name, p_val );
+}
 
 /**
  * Finds a process-wide mutex, creates it if needed, and locks it.
@@ -908,7 +1042,7 @@ int __var_AddCallback( vlc_object_t *p_this, const char *psz_name,
         return i_var;
     }
 
-    p_var = &p_priv->p_vars[i_var];
+    p_var = p_priv->pp_vars[i_var];
 
     INSERT_ELEM( p_var->p_entries,
                  p_var->i_entries,
@@ -943,7 +1077,7 @@ int __var_DelCallback( vlc_object_t *p_this, const char *psz_name,
         return i_var;
     }
 
-    p_var = &p_priv->p_vars[i_var];
+    p_var = p_priv->pp_vars[i_var];
 
     for( i_entry = p_var->i_entries ; i_entry-- ; )
     {
@@ -989,42 +1123,14 @@ int __var_TriggerCallback( vlc_object_t *p_this, const char *psz_name )
         return i_var;
     }
 
-    p_var = &p_priv->p_vars[i_var];
+    p_var = p_priv->pp_vars[i_var];
 
     /* Backup needed stuff */
-    oldval = p_var->val;
+    oldval = LoadValue( p_var );
 
-    /* Deal with callbacks. Tell we're in a callback, release the lock,
-     * call stored functions, retake the lock. */
+    /* Deal with callbacks */
     if( p_var->i_entries )
-    {
-        int i_var;
-        int i_entries = p_var->i_entries;
-        callback_entry_t *p_entries = p_var->p_entries;
-
-        p_var->b_incallback = true;
-        vlc_mutex_unlock( &p_priv->var_lock );
-
-        /* The real calls */
-        for( ; i_entries-- ; )
-        {
-            p_entries[i_entries].pf_callback( p_this, psz_name, oldval, oldval,
-                                              p_entries[i_entries].p_data );
-        }
-
-        vlc_mutex_lock( &p_priv->var_lock );
-
-        i_var = Lookup( p_priv->p_vars, p_priv->i_vars, psz_name );
-        if( i_var < 0 )
-        {
-            msg_Err( p_this, "variable %s has disappeared", psz_name );
-            vlc_mutex_unlock( &p_priv->var_lock );
-            return VLC_ENOVAR;
-        }
-
-        p_var = &p_priv->p_vars[i_var];
-        p_var->b_incallback = false;
-    }
+        TriggerCallbacks( p_this, p_var, oldval, oldval );
 
     vlc_mutex_unlock( &p_priv->var_lock );
     return VLC_SUCCESS;
@@ -1182,37 +1288,75 @@ cleanup:
 /*****************************************************************************
  * GetUnused: find an unused variable from its name
  *****************************************************************************
- * We do i_tries tries before giving up, just in case the variable is being
- * modified and called from a callback.
+ * If the variable is in a callback, we wait for the callback to return, but
+ * not forever, just in case it is the callback which is modifying the
+ * variable. Called with the variables lock.
  *****************************************************************************/
 static int GetUnused( vlc_object_t *p_this, const char *psz_name )
 {
-    int i_var, i_tries = 0;
     vlc_object_internals_t *p_priv = vlc_internals( p_this );
+    mtime_t i_deadline = mdate() + 100 * THREAD_SLEEP;
+    bool b_timeout = false;
 
     while( true )
     {
-        i_var = Lookup( p_priv->p_vars, p_priv->i_vars, psz_name );
+        int i_var = Lookup( p_priv->pp_vars, p_priv->i_vars, psz_name );
         if( i_var < 0 )
         {
             return VLC_ENOVAR;
         }
 
-        if( ! p_priv->p_vars[i_var].b_incallback )
+        if( p_priv->pp_vars[i_var]->i_incallback == 0 )
         {
             return i_var;
         }
 
-        if( i_tries++ > 100 )
+        if( b_timeout )
         {
             msg_Err( p_this, "caught in a callback deadlock? ('%s')", psz_name );
             return VLC_ETIMEOUT;
         }
 
-        vlc_mutex_unlock( &p_priv->var_lock );
-        msleep( THREAD_SLEEP );
-        vlc_mutex_lock( &p_priv->var_lock );
+        /* The variable may be destroyed while we wait, look it up again */
+        p_priv->i_var_waiters++;
+        b_timeout = vlc_cond_timedwait( &p_priv->var_wait, &p_priv->var_lock,
+                                        i_deadline ) != 0;
+        p_priv->i_var_waiters--;
+    }
+}
+
+/*****************************************************************************
+ * TriggerCallbacks: run the callbacks of a variable
+ *****************************************************************************
+ * Called with the variables lock, which is released during the calls. The
+ * variable cannot go away in the mean time, since GetUnused() waits until
+ * every thread running its callbacks (there can be several, see
+ * VLC_VAR_TRIGGER_CALLBACKS) is done before letting anyone destroy it.
+ *****************************************************************************/
+static void TriggerCallbacks( vlc_object_t *p_this, variable_t *p_var,
+                              vlc_value_t oldval, vlc_value_t newval )
+{
+    vlc_object_internals_t *p_priv = vlc_internals( p_this );
+    int i_entries = p_var->i_entries;
+    callback_entry_t *p_entries = p_var->p_entries;
+
+    p_var->i_incallback++;
+    vlc_mutex_unlock( &p_priv->var_lock );
+
+    /* The real calls */
+    for( ; i_entries-- ; )
+    {
+        p_entries[i_entries].pf_callback( p_this, p_var->psz_name,
+                                          oldval, newval,
+                                          p_entries[i_entries].p_data );
     }
+
+    vlc_mutex_lock( &p_priv->var_lock );
+    p_var->i_incallback--;
+
+    /* Wake up everyone, they may be waiting for other variables */
+    for( int i = 0; i < p_priv->i_var_waiters; i++ )
+        vlc_cond_signal( &p_priv->var_wait );
 }
 
 /*****************************************************************************
@@ -1244,26 +1388,26 @@ static uint32_t HashString( const char *psz_string )
  * to see how we handle them.
  * XXX: does this really need to be written recursively?
  *****************************************************************************/
-static int Insert( variable_t *p_vars, int i_count, const char *psz_name )
+static int Insert( variable_t **pp_vars, int i_count, const char *psz_name )
 {
     if( i_count == 0 )
     {
         return 0;
     }
 
-    return InsertInner( p_vars, i_count, HashString( psz_name ) );
+    return InsertInner( pp_vars, i_count, HashString( psz_name ) );
 }
 
-static int InsertInner( variable_t *p_vars, int i_count, uint32_t i_hash )
+static int InsertInner( variable_t **pp_vars, int i_count, uint32_t i_hash )
 {
     int i_middle;
 
-    if( i_hash <= p_vars[0].i_hash )
+    if( i_hash <= pp_vars[0]->i_hash )
     {
         return 0;
     }
 
-    if( i_hash >= p_vars[i_count - 1].i_hash )
+    if( i_hash >= pp_vars[i_count - 1]->i_hash )
     {
         return i_count;
     }
@@ -1271,15 +1415,15 @@ static int InsertInner( variable_t *p_vars, int i_count, uint32_t i_hash )
     i_middle = i_count / 2;
 
     /* We know that 0 < i_middle */
-    if( i_hash < p_vars[i_middle].i_hash )
+    if( i_hash < pp_vars[i_middle]->i_hash )
     {
-        return InsertInner( p_vars, i_middle, i_hash );
+        return InsertInner( pp_vars, i_middle, i_hash );
     }
 
     /* We know that i_middle + 1 < i_count */
-    if( i_hash > p_vars[i_middle + 1].i_hash )
+    if( i_hash > pp_vars[i_middle + 1]->i_hash )
     {
-        return i_middle + 1 + InsertInner( p_vars + i_middle + 1,
+        return i_middle + 1 + InsertInner( pp_vars + i_middle + 1,
                                            i_count - i_middle - 1,
                                            i_hash );
     }
@@ -1294,7 +1438,7 @@ static int InsertInner( variable_t *p_vars, int i_count, uint32_t i_hash )
  * possible hash collisions.
  * XXX: does this really need to be written recursively?
  *****************************************************************************/
-static int Lookup( variable_t *p_vars, int i_count, const char *psz_name )
+static int Lookup( variable_t **pp_vars, int i_count, const char *psz_name )
 {
     uint32_t i_hash;
     int i, i_pos;
@@ -1306,16 +1450,16 @@ static int Lookup( variable_t *p_vars, int i_count, const char *psz_name )
 
     i_hash = HashString( psz_name );
 
-    i_pos = LookupInner( p_vars, i_count, i_hash );
+    i_pos = LookupInner( pp_vars, i_count, i_hash );
 
     /* Hash not found */
-    if( i_hash != p_vars[i_pos].i_hash )
+    if( i_hash != pp_vars[i_pos]->i_hash )
     {
         return -1;
     }
 
     /* Hash found, entry found */
-    if( !strcmp( psz_name, p_vars[i_pos].psz_name ) )
+    if( !strcmp( psz_name, pp_vars[i_pos]->psz_name ) )
     {
         return i_pos;
     }
@@ -1323,17 +1467,17 @@ static int Lookup( variable_t *p_vars, int i_count, const char *psz_name )
     /* Hash collision! This should be very rare, but we cannot guarantee
      * it will never happen. Just do an exhaustive search amongst all
      * entries with the same hash. */
-    for( i = i_pos - 1 ; i > 0 && i_hash == p_vars[i].i_hash ; i-- )
+    for( i = i_pos - 1 ; i > 0 && i_hash == pp_vars[i]->i_hash ; i-- )
     {
-        if( !strcmp( psz_name, p_vars[i].psz_name ) )
+        if( !strcmp( psz_name, pp_vars[i]->psz_name ) )
         {
             return i;
         }
     }
 
-    for( i = i_pos + 1 ; i < i_count && i_hash == p_vars[i].i_hash ; i++ )
+    for( i = i_pos + 1 ; i < i_count && i_hash == pp_vars[i]->i_hash ; i++ )
     {
-        if( !strcmp( psz_name, p_vars[i].psz_name ) )
+        if( !strcmp( psz_name, pp_vars[i]->psz_name ) )
         {
             return i;
         }
@@ -1343,16 +1487,16 @@ static int Lookup( variable_t *p_vars, int i_count, const char *psz_name )
     return -1;
 }
 
-static int LookupInner( variable_t *p_vars, int i_count, uint32_t i_hash )
+static int LookupInner( variable_t **pp_vars, int i_count, uint32_t i_hash )
 {
     int i_middle;
 
-    if( i_hash <= p_vars[0].i_hash )
+    if( i_hash <= pp_vars[0]->i_hash )
     {
         return 0;
     }
 
-    if( i_hash >= p_vars[i_count-1].i_hash )
+    if( i_hash >= pp_vars[i_count-1]->i_hash )
     {
         return i_count - 1;
     }
@@ -1360,15 +1504,15 @@ static int LookupInner( variable_t *p_vars, int i_count, uint32_t i_hash )
     i_middle = i_count / 2;
 
     /* We know that 0 < i_middle */
-    if( i_hash < p_vars[i_middle].i_hash )
+    if( i_hash < pp_vars[i_middle]->i_hash )
     {
-        return LookupInner( p_vars, i_middle, i_hash );
+        return LookupInner( pp_vars, i_middle, i_hash );
     }
 
     /* We know that i_middle + 1 < i_count */
-    if( i_hash > p_vars[i_middle].i_hash )
+    if( i_hash > pp_vars[i_middle]->i_hash )
     {
-        return i_middle + LookupInner( p_vars + i_middle,
+        return i_middle + LookupInner( pp_vars + i_middle,
                                        i_count - i_middle,
                                        i_hash );
     }
@@ -1534,12 +1678,12 @@ static int InheritValue( vlc_object_t *p_this, const char *psz_name,
     /* Look for the variable */
     vlc_mutex_lock( &p_priv->var_lock );
 
-    i_var = Lookup( p_priv->p_vars, p_priv->i_vars, psz_name );
+    i_var = Lookup( p_priv->pp_vars, p_priv->i_vars, psz_name );
 
     if( i_var >= 0 )
     {
         /* We found it! */
-        p_var = &p_priv->p_vars[i_var];
+        p_var = p_priv->pp_vars[i_var];
 
         /* Really get the variable */
         *p_val = p_var->val;
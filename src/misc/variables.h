@@ -39,9 +39,12 @@ struct variable_t
     /** The variable's exported value */
     vlc_value_t  val;
 
+    vlc_object_t *p_obj;   /**< The object which holds the variable */
     char *       psz_name; /**< The variable unique name */
     uint32_t     i_hash;   /**< (almost) unique hashed value */
     int          i_type;   /**< The type of the variable */
+    bool         b_numeric; /**< Numeric type (never changes, so it can be
+                                 read without the lock) */
 
     /** The variable display name, mainly for use by the interfaces */
     char *       psz_text;
@@ -67,8 +70,8 @@ struct variable_t
     /** List of friendly names for the choices */
     vlc_list_t   choices_text;
 
-    /** Set to TRUE if the variable is in a callback */
-    bool   b_incallback;
+    /** Number of threads running the variable callbacks */
+    unsigned     i_incallback;
 
     /** Number of registered callbacks */
     int                i_entries;
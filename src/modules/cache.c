@@ -34,6 +34,7 @@
 #include <stdlib.h>                                      /* free(), strtol() */
 #include <stdio.h>                                              /* sprintf() */
 #include <string.h>                                              /* strdup() */
+#include <errno.h>
 #include <vlc_plugin.h>
 
 #ifdef HAVE_SYS_TYPES_H
@@ -75,16 +76,19 @@
 #include "modules/modules.h"
 
 
+#include "vlc_block.h"
+
+#ifdef HAVE_FCNTL_H
+#   include <fcntl.h>
+#endif
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
 #ifdef HAVE_DYNAMIC_PLUGINS
-static int    CacheLoadConfig  ( module_t *, FILE * );
-static int    CacheSaveConfig  ( module_t *, FILE * );
-
 /* Sub-version number
  * (only used to avoid breakage in dev version when cache structure changes) */
-#define CACHE_SUBVERSION_NUM 3
+#define CACHE_SUBVERSION_NUM 4
 
 /* Format string for the cache filename */
 #define CACHENAME_FORMAT \
@@ -93,6 +97,174 @@ static int    CacheSaveConfig  ( module_t *, FILE * );
 #define CACHENAME_VALUES \
     sizeof(int), sizeof(void *), *(uint8_t *)&(uint16_t){ 0xbe1e }
 
+/*
+ * The cache file starts with the same textual header as before. It is
+ * followed, at the next 8 bytes boundary, by a cache_header_t, then by the
+ * data area and the string pool.
+ *
+ * The data area only holds fixed size records. They refer to one another
+ * with offsets relative to the start of the data area, and to strings with
+ * offsets relative to the start of the pool (0 standing for NULL). Nothing
+ * depends on where the file is loaded, so it is used straight from a memory
+ * mapping, and the configuration of a module is only built when needed.
+ */
+#define CACHE_ALIGN 8
+
+typedef struct
+{
+    uint32_t i_entries;                     /**< number of cache_entry_t */
+    uint32_t i_data;                        /**< size of the data area */
+    uint32_t i_strings;                     /**< size of the string pool */
+    uint32_t i_reserved;
+} cache_header_t;
+
+/* The data area starts with the i_entries entries */
+typedef struct
+{
+    int64_t  i_time;
+    int64_t  i_size;
+    uint32_t i_file;                        /**< plugin file name */
+    uint32_t i_module;                      /**< cache_module_t, 0 if junk */
+} cache_entry_t;
+
+typedef struct
+{
+    uint32_t i_object_name;
+    uint32_t i_shortname;
+    uint32_t i_longname;
+    uint32_t i_help;
+    uint32_t i_capability;
+    uint32_t i_filename;
+    uint32_t i_shortcuts;                   /**< number of shortcuts */
+    uint32_t i_shortcut;                    /**< uint32_t[i_shortcuts] */
+    int32_t  i_score;
+    uint32_t i_cpu;
+    uint8_t  b_unloadable;
+    uint8_t  b_reentrant;
+    uint8_t  b_submodule;
+    uint8_t  b_callbacks;          /**< configuration needs plugin code */
+    uint32_t i_config_items;
+    uint32_t i_bool_items;
+    uint32_t i_confsize;
+    uint32_t i_config;                      /**< cache_config_t[i_confsize] */
+    uint32_t i_submodules;
+    uint32_t i_submodule;                   /**< cache_module_t[] */
+} cache_module_t;
+
+typedef struct
+{
+    int32_t  i_type;
+    uint32_t i_typename;
+    uint32_t i_name;
+    uint32_t i_text;
+    uint32_t i_longtext;
+    uint32_t i_oldname;
+    uint32_t i_orig_psz;                    /**< default of string items */
+    module_nvalue_t orig;                   /**< default of other items */
+    module_nvalue_t min;
+    module_nvalue_t max;
+    int32_t  i_list;
+    uint32_t i_list_psz;                    /**< uint32_t[i_list] or 0 */
+    uint32_t i_list_text;                   /**< uint32_t[i_list] or 0 */
+    uint32_t i_list_int;                    /**< int32_t[i_list] or 0 */
+    int32_t  i_action;
+    uint32_t i_action_text;                 /**< uint32_t[i_action] */
+    int8_t   i_short;
+    uint8_t  b_advanced;
+    uint8_t  b_internal;
+    uint8_t  b_restart;
+    uint8_t  b_removed;
+    uint8_t  b_autosave;
+    uint8_t  b_unsaveable;
+    uint8_t  b_safe;
+} cache_config_t;
+
+typedef struct
+{
+    const uint8_t *p_data;
+    size_t         i_data;
+    const char    *p_strings;
+    size_t         i_strings;
+} cache_map_t;
+
+static bool CacheCheckModule( const cache_map_t *, uint32_t, bool );
+static module_t *CacheLoadModule( vlc_object_t *, const cache_map_t *,
+                                  const cache_module_t *, module_t * );
+
+#define CACHE_RECORD( map, type, off ) \
+    ((const type *)((map)->p_data + (off)))
+
+static inline const char *CacheString( const char *p_strings, uint32_t i_off )
+{
+    return i_off ? p_strings + i_off : NULL;
+}
+
+static inline char *CacheDupString( const cache_map_t *p_map, uint32_t i_off )
+{
+    return i_off ? strdup( p_map->p_strings + i_off ) : NULL;
+}
+
+/*****************************************************************************
+ * CacheCheckHeader: validates the header of a cache file
+ *****************************************************************************
+ * Returns the position of the cache_header_t, or 0 if the file is not usable.
+ *****************************************************************************/
+static size_t CacheCheckHeader( vlc_object_t *p_this,
+                                const uint8_t *p, size_t i_size )
+{
+    static const char psz_magic[] = "cache " COPYRIGHT_MESSAGE;
+    uint32_t i_file_size, i_marker;
+    char p_lang[6];
+    size_t i_pos;
+
+    /* Check the file size */
+    if( i_size < sizeof(i_file_size) )
+    {
+        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
+                  "(too short)" );
+        return 0;
+    }
+    memcpy( &i_file_size, p, sizeof(i_file_size) );
+    if( i_file_size != i_size )
+    {
+        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
+                  "(corrupted size)" );
+        return 0;
+    }
+    i_pos = sizeof(i_file_size);
+
+#define CHECK_BYTES( data, len ) \
+    if( i_size - i_pos < (len) || memcmp( p + i_pos, data, len ) ) \
+        goto error; \
+    i_pos += (len)
+
+    /* Check the file is a plugins cache */
+    CHECK_BYTES( psz_magic, sizeof(psz_magic) - 1 );
+#ifdef DISTRO_VERSION
+    /* Check for distribution specific version */
+    CHECK_BYTES( DISTRO_VERSION, sizeof(DISTRO_VERSION) - 1 );
+#endif
+    /* Check Sub-version number */
+    i_marker = CACHE_SUBVERSION_NUM;
+    CHECK_BYTES( &i_marker, sizeof(i_marker) );
+    /* Check the language hasn't changed */
+    sprintf( p_lang, "%5.5s", _("C") );
+    CHECK_BYTES( p_lang, 5 );
+    /* Check header marker */
+    i_marker = i_pos;
+    CHECK_BYTES( &i_marker, sizeof(i_marker) );
+#undef CHECK_BYTES
+
+    i_pos = (i_pos + CACHE_ALIGN - 1) & ~(CACHE_ALIGN - 1);
+    if( i_pos >= i_size || i_size - i_pos < sizeof(cache_header_t) )
+        goto error;
+    return i_pos;
+
+error:
+    msg_Warn( p_this, "This doesn't look like a valid plugins cache "
+              "(corrupted header)" );
+    return 0;
+}
 
 /*****************************************************************************
  * LoadPluginsCache: loads the plugins cache file
@@ -105,14 +277,14 @@ static int    CacheSaveConfig  ( module_t *, FILE * );
 void CacheLoad( vlc_object_t *p_this )
 {
     char *psz_filename, *psz_cachedir = config_GetCacheDir();
-    FILE *file;
-    int i, j, i_size, i_read;
-    char p_cachestring[sizeof("cache " COPYRIGHT_MESSAGE)];
-    char p_cachelang[6], p_lang[6];
-    int i_cache;
-    module_cache_t **pp_cache = 0;
-    int32_t i_file_size, i_marker;
+    int fd;
+    block_t *p_block;
+    cache_header_t header;
+    cache_map_t map;
+    size_t i_pos;
+    module_cache_t **pp_cache;
     libvlc_global_data_t *p_libvlc_global = vlc_global();
+    module_bank_t *p_bank = p_libvlc_global->p_module_bank;
 
     if( !psz_cachedir ) /* XXX: this should never happen */
     {
@@ -128,7 +300,7 @@ void CacheLoad( vlc_object_t *p_this )
     }
     free( psz_cachedir );
 
-    if( p_libvlc_global->p_module_bank->b_cache_delete )
+    if( p_bank->b_cache_delete )
     {
 #if !defined( UNDER_CE )
         unlink( psz_filename );
@@ -144,8 +316,8 @@ void CacheLoad( vlc_object_t *p_this )
 
     msg_Dbg( p_this, "loading plugins cache file %s", psz_filename );
 
-    file = utf8_fopen( psz_filename, "rb" );
-    if( !file )
+    fd = utf8_open( psz_filename, O_RDONLY, 0 );
+    if( fd == -1 )
     {
         msg_Warn( p_this, "could not open plugins cache file %s for reading",
                   psz_filename );
@@ -154,313 +326,564 @@ void CacheLoad( vlc_object_t *p_this )
     }
     free( psz_filename );
 
-    /* Check the file size */
-    i_read = fread( &i_file_size, 1, sizeof(i_file_size), file );
-    if( i_read != sizeof(i_file_size) )
-    {
-        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
-                  "(too short)" );
-        fclose( file );
-        return;
-    }
-
-    fseek( file, 0, SEEK_END );
-    if( ftell( file ) != i_file_size )
-    {
-        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
-                  "(corrupted size)" );
-        fclose( file );
-        return;
-    }
-    fseek( file, sizeof(i_file_size), SEEK_SET );
-
-    /* Check the file is a plugins cache */
-    i_size = sizeof("cache " COPYRIGHT_MESSAGE) - 1;
-    i_read = fread( p_cachestring, 1, i_size, file );
-    if( i_read != i_size ||
-        memcmp( p_cachestring, "cache " COPYRIGHT_MESSAGE, i_size ) )
-    {
-        msg_Warn( p_this, "This doesn't look like a valid plugins cache" );
-        fclose( file );
-        return;
-    }
-
-#ifdef DISTRO_VERSION
-    /* Check for distribution specific version */
-    char p_distrostring[sizeof( DISTRO_VERSION )];
-    i_size = sizeof( DISTRO_VERSION ) - 1;
-    i_read = fread( p_distrostring, 1, i_size, file );
-    if( i_read != i_size ||
-        memcmp( p_distrostring, DISTRO_VERSION, i_size ) )
+    /* Mapped if possible, read in one go otherwise */
+    p_block = block_File( fd );
+    close( fd );
+    if( p_block == NULL )
     {
-        msg_Warn( p_this, "This doesn't look like a valid plugins cache" );
-        fclose( file );
+        msg_Warn( p_this, "could not read plugins cache (%m)" );
         return;
     }
-#endif
 
-    /* Check Sub-version number */
-    i_read = fread( &i_marker, 1, sizeof(i_marker), file );
-    if( i_read != sizeof(i_marker) || i_marker != CACHE_SUBVERSION_NUM )
-    {
-        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
-                  "(corrupted header)" );
-        fclose( file );
-        return;
-    }
+    i_pos = CacheCheckHeader( p_this, p_block->p_buffer, p_block->i_buffer );
+    if( i_pos == 0 )
+        goto error;
 
-    /* Check the language hasn't changed */
-    sprintf( p_lang, "%5.5s", _("C") ); i_size = 5;
-    i_read = fread( p_cachelang, 1, i_size, file );
-    if( i_read != i_size || memcmp( p_cachelang, p_lang, i_size ) )
+    memcpy( &header, p_block->p_buffer + i_pos, sizeof(header) );
+    i_pos += sizeof(header);
+    if( header.i_data > p_block->i_buffer - i_pos
+     || header.i_strings != p_block->i_buffer - i_pos - header.i_data
+     || header.i_strings == 0 /* the pool starts with a dummy byte */
+     || header.i_entries > header.i_data / sizeof(cache_entry_t) )
+        goto corrupted;
+
+    map.p_data = p_block->p_buffer + i_pos;
+    map.i_data = header.i_data;
+    map.p_strings = (const char *)map.p_data + header.i_data;
+    map.i_strings = header.i_strings;
+
+    /* Any string offset is safe once the pool is known to be terminated.
+     * The records are checked before anything gets allocated, so that a
+     * bad file is never half loaded. */
+    if( map.p_strings[map.i_strings - 1] != '\0' )
+        goto corrupted;
+    for( uint32_t i = 0; i < header.i_entries; i++ )
     {
-        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
-                  "(language changed)" );
-        fclose( file );
-        return;
-    }
+        const cache_entry_t *p_entry =
+            CACHE_RECORD( &map, cache_entry_t, i * sizeof(cache_entry_t) );
 
-    /* Check header marker */
-    i_read = fread( &i_marker, 1, sizeof(i_marker), file );
-    if( i_read != sizeof(i_marker) ||
-        i_marker != ftell( file ) - (int)sizeof(i_marker) )
-    {
-        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
-                  "(corrupted header)" );
-        fclose( file );
-        return;
+        if( p_entry->i_file == 0 || p_entry->i_file >= map.i_strings
+         || ( p_entry->i_module
+           && !CacheCheckModule( &map, p_entry->i_module, false ) ) )
+            goto corrupted;
     }
 
-    p_libvlc_global->p_module_bank->i_loaded_cache = 0;
-    if (fread( &i_cache, 1, sizeof(i_cache), file ) != sizeof(i_cache) )
+    p_bank->i_loaded_cache = 0;
+    if( header.i_entries == 0 )
     {
-        msg_Warn( p_this, "This doesn't look like a valid plugins cache "
-                  "(file too short)" );
-        fclose( file );
+        block_Release( p_block );
         return;
     }
 
-    if( i_cache )
-        pp_cache = p_libvlc_global->p_module_bank->pp_loaded_cache =
-                   malloc( i_cache * sizeof(void *) );
-
-#define LOAD_IMMEDIATE(a) \
-    if( fread( (void *)&a, sizeof(char), sizeof(a), file ) != sizeof(a) ) goto error
-#define LOAD_STRING(a) \
-{ \
-    a = NULL; \
-    if( ( fread( &i_size, sizeof(i_size), 1, file ) != 1 ) \
-     || ( i_size > 16384 ) ) \
-        goto error; \
-    if( i_size ) { \
-        char *psz = malloc( i_size ); \
-        if( fread( psz, i_size, 1, file ) != 1 ) { \
-            free( psz ); \
-            goto error; \
-        } \
-        if( psz[i_size-1] ) { \
-            free( psz ); \
-            goto error; \
-        } \
-        a = psz; \
-    } \
-}
+    pp_cache = p_bank->pp_loaded_cache =
+        malloc( header.i_entries * sizeof(void *) );
+    if( pp_cache == NULL )
+        goto error;
 
-    for( i = 0; i < i_cache; i++ )
+    for( uint32_t i = 0; i < header.i_entries; i++ )
     {
-        uint16_t i_size;
-        int i_submodules;
-
-        pp_cache[i] = malloc( sizeof(module_cache_t) );
-        p_libvlc_global->p_module_bank->i_loaded_cache++;
-
-        /* Load common info */
-        LOAD_STRING( pp_cache[i]->psz_file );
-        LOAD_IMMEDIATE( pp_cache[i]->i_time );
-        LOAD_IMMEDIATE( pp_cache[i]->i_size );
-        LOAD_IMMEDIATE( pp_cache[i]->b_junk );
-        pp_cache[i]->b_used = false;
-
-        if( pp_cache[i]->b_junk ) continue;
-
-        pp_cache[i]->p_module = vlc_module_create( p_this );
-
-        /* Load additional infos */
-        free( pp_cache[i]->p_module->psz_object_name );
-        LOAD_STRING( pp_cache[i]->p_module->psz_object_name );
-        LOAD_STRING( pp_cache[i]->p_module->psz_shortname );
-        LOAD_STRING( pp_cache[i]->p_module->psz_longname );
-        LOAD_STRING( pp_cache[i]->p_module->psz_help );
-        for( j = 0; j < MODULE_SHORTCUT_MAX; j++ )
+        const cache_entry_t *p_entry =
+            CACHE_RECORD( &map, cache_entry_t, i * sizeof(cache_entry_t) );
+        module_cache_t *p_cache = malloc( sizeof(module_cache_t) );
+
+        if( p_cache == NULL )
+            break;
+        p_cache->psz_file = CacheDupString( &map, p_entry->i_file );
+        p_cache->i_time = p_entry->i_time;
+        p_cache->i_size = p_entry->i_size;
+        p_cache->b_junk = p_entry->i_module == 0;
+        p_cache->b_used = false;
+        p_cache->b_callbacks = false;
+        p_cache->p_module = NULL;
+
+        if( !p_cache->b_junk )
         {
-            LOAD_STRING( pp_cache[i]->p_module->pp_shortcuts[j] ); // FIX
-        }
-        LOAD_STRING( pp_cache[i]->p_module->psz_capability );
-        LOAD_IMMEDIATE( pp_cache[i]->p_module->i_score );
-        LOAD_IMMEDIATE( pp_cache[i]->p_module->i_cpu );
-        LOAD_IMMEDIATE( pp_cache[i]->p_module->b_unloadable );
-        LOAD_IMMEDIATE( pp_cache[i]->p_module->b_reentrant );
-        LOAD_IMMEDIATE( pp_cache[i]->p_module->b_submodule );
+            const cache_module_t *p_rec =
+                CACHE_RECORD( &map, cache_module_t, p_entry->i_module );
 
-        /* Config stuff */
-        if( CacheLoadConfig( pp_cache[i]->p_module, file ) != VLC_SUCCESS )
-            goto error;
-
-        LOAD_STRING( pp_cache[i]->p_module->psz_filename );
-
-        LOAD_IMMEDIATE( i_submodules );
-
-        while( i_submodules-- )
-        {
-            module_t *p_module = vlc_submodule_create( pp_cache[i]->p_module );
-            free( p_module->psz_object_name );
-            LOAD_STRING( p_module->psz_object_name );
-            LOAD_STRING( p_module->psz_shortname );
-            LOAD_STRING( p_module->psz_longname );
-            LOAD_STRING( p_module->psz_help );
-            for( j = 0; j < MODULE_SHORTCUT_MAX; j++ )
+            p_cache->b_callbacks = p_rec->b_callbacks;
+            p_cache->p_module = CacheLoadModule( p_this, &map, p_rec, NULL );
+            if( p_cache->p_module == NULL )
             {
-                LOAD_STRING( p_module->pp_shortcuts[j] ); // FIX
+                free( p_cache->psz_file );
+                free( p_cache );
+                break;
             }
-            LOAD_STRING( p_module->psz_capability );
-            LOAD_IMMEDIATE( p_module->i_score );
-            LOAD_IMMEDIATE( p_module->i_cpu );
-            LOAD_IMMEDIATE( p_module->b_unloadable );
-            LOAD_IMMEDIATE( p_module->b_reentrant );
         }
+        pp_cache[p_bank->i_loaded_cache++] = p_cache;
     }
 
-    fclose( file );
+    /* The cached modules point to the mapping until the bank goes away */
+    p_bank->p_cache_block = p_block;
+    p_bank->p_cache_data = map.p_data;
+    p_bank->p_cache_strings = map.p_strings;
     return;
 
- error:
-
+corrupted:
     msg_Warn( p_this, "plugins cache not loaded (corrupted)" );
+error:
+    block_Release( p_block );
+}
 
-    /* TODO: cleanup */
-    p_libvlc_global->p_module_bank->i_loaded_cache = 0;
-
-    fclose( file );
-    return;
+/*****************************************************************************
+ * CacheCheckModule: validates the offsets of a module record
+ *****************************************************************************/
+static inline bool CacheCheckRecord( const cache_map_t *p_map, uint32_t i_off,
+                                     size_t i_count, size_t i_size )
+{
+    return i_off <= p_map->i_data && ( i_off % sizeof(uint32_t) ) == 0
+        && i_count <= ( p_map->i_data - i_off ) / i_size;
 }
 
+static bool CacheCheckStrings( const cache_map_t *p_map, uint32_t i_off,
+                               size_t i_count )
+{
+    if( !CacheCheckRecord( p_map, i_off, i_count, sizeof(uint32_t) ) )
+        return false;
+
+    const uint32_t *pi_str = CACHE_RECORD( p_map, uint32_t, i_off );
+    for( size_t i = 0; i < i_count; i++ )
+        if( pi_str[i] >= p_map->i_strings )
+            return false;
+    return true;
+}
 
-static int CacheLoadConfig( module_t *p_module, FILE *file )
+static bool CacheCheckModule( const cache_map_t *p_map, uint32_t i_off,
+                              bool b_submodule )
 {
-    uint32_t i_lines;
-    uint16_t i_size;
+    if( !CacheCheckRecord( p_map, i_off, 1, sizeof(cache_module_t) ) )
+        return false;
 
-    /* Calculate the structure length */
-    LOAD_IMMEDIATE( p_module->i_config_items );
-    LOAD_IMMEDIATE( p_module->i_bool_items );
+    const cache_module_t *p_rec = CACHE_RECORD( p_map, cache_module_t, i_off );
+    const uint32_t pi_str[] = {
+        p_rec->i_object_name, p_rec->i_shortname, p_rec->i_longname,
+        p_rec->i_help, p_rec->i_capability, p_rec->i_filename };
 
-    LOAD_IMMEDIATE( i_lines );
+    for( size_t i = 0; i < sizeof(pi_str) / sizeof(pi_str[0]); i++ )
+        if( pi_str[i] >= p_map->i_strings )
+            return false;
 
-    /* Allocate memory */
-    if (i_lines)
+    if( p_rec->i_shortcuts >= MODULE_SHORTCUT_MAX
+     || !CacheCheckStrings( p_map, p_rec->i_shortcut, p_rec->i_shortcuts ) )
+        return false;
+
+    if( b_submodule )
+        return p_rec->i_confsize == 0 && p_rec->i_submodules == 0;
+
+    if( !CacheCheckRecord( p_map, p_rec->i_config, p_rec->i_confsize,
+                           sizeof(cache_config_t) ) )
+        return false;
+
+    const cache_config_t *p_config =
+        CACHE_RECORD( p_map, cache_config_t, p_rec->i_config );
+    for( uint32_t i = 0; i < p_rec->i_confsize; i++ )
     {
-        p_module->p_config =
-            (module_config_t *)calloc( i_lines, sizeof(module_config_t) );
-        if( p_module->p_config == NULL )
-        {
-            p_module->confsize = 0;
-            return VLC_ENOMEM;
-        }
+        const cache_config_t *p_item = &p_config[i];
+
+        if( p_item->i_typename >= p_map->i_strings
+         || p_item->i_name >= p_map->i_strings
+         || p_item->i_text >= p_map->i_strings
+         || p_item->i_longtext >= p_map->i_strings
+         || p_item->i_oldname >= p_map->i_strings
+         || p_item->i_orig_psz >= p_map->i_strings
+         || p_item->i_list < 0 || p_item->i_action < 0 )
+            return false;
+        if( ( p_item->i_list_psz
+           && !CacheCheckStrings( p_map, p_item->i_list_psz, p_item->i_list ) )
+         || ( p_item->i_list_text
+           && !CacheCheckStrings( p_map, p_item->i_list_text, p_item->i_list ) )
+         || ( p_item->i_list_int
+           && !CacheCheckRecord( p_map, p_item->i_list_int, p_item->i_list,
+                                 sizeof(int32_t) ) )
+         || !CacheCheckStrings( p_map, p_item->i_action_text,
+                                p_item->i_action ) )
+            return false;
     }
-    p_module->confsize = i_lines;
 
-    /* Do the duplication job */
-    for (size_t i = 0; i < i_lines; i++ )
+    if( !CacheCheckRecord( p_map, p_rec->i_submodule, p_rec->i_submodules,
+                           sizeof(cache_module_t) ) )
+        return false;
+    for( uint32_t i = 0; i < p_rec->i_submodules; i++ )
+        if( !CacheCheckModule( p_map, p_rec->i_submodule
+                                      + i * sizeof(cache_module_t), true ) )
+            return false;
+
+    return true;
+}
+
+/*****************************************************************************
+ * CacheLoadModule: creates a module from its cache record
+ *****************************************************************************
+ * The configuration is left in the cache file until CacheLoadConfig().
+ *****************************************************************************/
+static module_t *CacheLoadModule( vlc_object_t *p_this,
+                                  const cache_map_t *p_map,
+                                  const cache_module_t *p_rec,
+                                  module_t *p_parent )
+{
+    module_t *p_module = p_parent ? vlc_submodule_create( p_parent )
+                                  : vlc_module_create( p_this );
+    const uint32_t *pi_shortcut;
+    uint32_t i;
+
+    if( p_module == NULL )
+        return NULL;
+
+    free( p_module->psz_object_name );
+    p_module->psz_object_name = CacheDupString( p_map, p_rec->i_object_name );
+    p_module->psz_shortname = CacheDupString( p_map, p_rec->i_shortname );
+    p_module->psz_longname = CacheDupString( p_map, p_rec->i_longname );
+    p_module->psz_help = CacheDupString( p_map, p_rec->i_help );
+    pi_shortcut = CACHE_RECORD( p_map, uint32_t, p_rec->i_shortcut );
+    for( i = 0; i < MODULE_SHORTCUT_MAX; i++ )
+        p_module->pp_shortcuts[i] = ( i < p_rec->i_shortcuts )
+            ? CacheDupString( p_map, pi_shortcut[i] ) : NULL;
+    p_module->psz_capability = CacheDupString( p_map, p_rec->i_capability );
+    p_module->i_score = p_rec->i_score;
+    p_module->i_cpu = p_rec->i_cpu;
+    p_module->b_unloadable = p_rec->b_unloadable;
+    p_module->b_reentrant = p_rec->b_reentrant;
+
+    if( p_parent != NULL )
+        return p_module;
+
+    p_module->b_submodule = p_rec->b_submodule;
+    p_module->i_config_items = p_rec->i_config_items;
+    p_module->i_bool_items = p_rec->i_bool_items;
+    if( p_rec->i_confsize )
+        p_module->p_config_cache = p_rec;
+    p_module->psz_filename = CacheDupString( p_map, p_rec->i_filename );
+
+    for( i = 0; i < p_rec->i_submodules; i++ )
+        CacheLoadModule( p_this, p_map,
+                         CACHE_RECORD( p_map, cache_module_t,
+                                       p_rec->i_submodule
+                                       + i * sizeof(cache_module_t) ),
+                         p_module );
+    return p_module;
+}
+
+/*****************************************************************************
+ * CacheLoadConfig: builds the configuration of a module from the cache
+ *****************************************************************************
+ * The strings are not duplicated: they stay in the cache file mapping, which
+ * lives as long as the module bank.
+ *****************************************************************************/
+void CacheLoadConfig( module_t *p_module )
+{
+    module_bank_t *p_bank = vlc_global()->p_module_bank;
+    const uint8_t *p_data = p_bank->p_cache_data;
+    const char *p_strings = p_bank->p_cache_strings;
+    const cache_module_t *p_rec;
+    const cache_config_t *p_records;
+    module_config_t *p_config;
+
+    vlc_object_lock( p_module );
+    p_rec = p_module->p_config_cache;
+    if( p_rec == NULL )
     {
-        LOAD_IMMEDIATE( p_module->p_config[i] );
+        /* Another thread was faster */
+        vlc_object_unlock( p_module );
+        return;
+    }
 
-        LOAD_STRING( p_module->p_config[i].psz_type );
-        LOAD_STRING( p_module->p_config[i].psz_name );
-        LOAD_STRING( p_module->p_config[i].psz_text );
-        LOAD_STRING( p_module->p_config[i].psz_longtext );
-        LOAD_STRING( p_module->p_config[i].psz_oldname );
-        LOAD_IMMEDIATE( p_module->p_config[i].b_removed );
+    p_records = (const cache_config_t *)(p_data + p_rec->i_config);
 
-        if (IsConfigStringType (p_module->p_config[i].i_type))
+    p_config = calloc( p_rec->i_confsize, sizeof(module_config_t) );
+    for( uint32_t i = 0; p_config != NULL && i < p_rec->i_confsize; i++ )
+    {
+        const cache_config_t *p_src = &p_records[i];
+        module_config_t *p_item = &p_config[i];
+        const uint32_t *pi_str;
+
+        p_item->i_type = p_src->i_type;
+        p_item->psz_type = (char *)CacheString( p_strings, p_src->i_typename );
+        p_item->psz_name = (char *)CacheString( p_strings, p_src->i_name );
+        p_item->i_short = p_src->i_short;
+        p_item->psz_text = (char *)CacheString( p_strings, p_src->i_text );
+        p_item->psz_longtext =
+            (char *)CacheString( p_strings, p_src->i_longtext );
+        p_item->psz_oldname =
+            (char *)CacheString( p_strings, p_src->i_oldname );
+        p_item->min = p_src->min;
+        p_item->max = p_src->max;
+
+        if (IsConfigStringType (p_item->i_type))
         {
-            LOAD_STRING (p_module->p_config[i].orig.psz);
-            p_module->p_config[i].value.psz =
-                    (p_module->p_config[i].orig.psz != NULL)
-                        ? strdup (p_module->p_config[i].orig.psz) : NULL;
-            p_module->p_config[i].saved.psz = NULL;
+            p_item->orig.psz =
+                (char *)CacheString( p_strings, p_src->i_orig_psz );
+            p_item->value.psz = (p_item->orig.psz != NULL)
+                                    ? strdup (p_item->orig.psz) : NULL;
+            p_item->saved.psz = NULL;
         }
         else
         {
-            memcpy (&p_module->p_config[i].value, &p_module->p_config[i].orig,
-                    sizeof (p_module->p_config[i].value));
-            memcpy (&p_module->p_config[i].saved, &p_module->p_config[i].orig,
-                    sizeof (p_module->p_config[i].saved));
+            if (IsConfigFloatType (p_item->i_type))
+                p_item->orig.f = p_src->orig.f;
+            else
+                p_item->orig.i = p_src->orig.i;
+            p_item->value = p_item->saved = p_item->orig;
         }
 
-        p_module->p_config[i].b_dirty = false;
-
-        p_module->p_config[i].p_lock = &(vlc_internals(p_module)->lock);
+        p_item->i_list = p_src->i_list;
+        if( p_src->i_list_psz
+         && ( p_item->ppsz_list =
+                  malloc( (p_src->i_list + 1) * sizeof(char *) ) ) )
+        {
+            pi_str = (const uint32_t *)(p_data + p_src->i_list_psz);
+            for( int j = 0; j < p_src->i_list; j++ )
+                p_item->ppsz_list[j] =
+                    (char *)CacheString( p_strings, pi_str[j] );
+            p_item->ppsz_list[p_src->i_list] = NULL;
+        }
+        if( p_src->i_list_text
+         && ( p_item->ppsz_list_text =
+                  malloc( (p_src->i_list + 1) * sizeof(char *) ) ) )
+        {
+            pi_str = (const uint32_t *)(p_data + p_src->i_list_text);
+            for( int j = 0; j < p_src->i_list; j++ )
+                p_item->ppsz_list_text[j] =
+                    (char *)CacheString( p_strings, pi_str[j] );
+            p_item->ppsz_list_text[p_src->i_list] = NULL;
+        }
+        if( p_src->i_list_int
+         && ( p_item->pi_list = malloc( (p_src->i_list + 1) * sizeof(int) ) ) )
+            memcpy( p_item->pi_list, p_data + p_src->i_list_int,
+                    p_src->i_list * sizeof(int) );
 
-        if( p_module->p_config[i].i_list )
+        if( p_src->i_action )
         {
-            if( p_module->p_config[i].ppsz_list )
-            {
-                int j;
-                p_module->p_config[i].ppsz_list =
-                    malloc( (p_module->p_config[i].i_list+1) * sizeof(char *));
-                if( p_module->p_config[i].ppsz_list )
-                {
-                    for( j = 0; j < p_module->p_config[i].i_list; j++ )
-                        LOAD_STRING( p_module->p_config[i].ppsz_list[j] );
-                    p_module->p_config[i].ppsz_list[j] = NULL;
-                }
-            }
-            if( p_module->p_config[i].ppsz_list_text )
-            {
-                int j;
-                p_module->p_config[i].ppsz_list_text =
-                    malloc( (p_module->p_config[i].i_list+1) * sizeof(char *));
-                if( p_module->p_config[i].ppsz_list_text )
-                {
-                  for( j = 0; j < p_module->p_config[i].i_list; j++ )
-                      LOAD_STRING( p_module->p_config[i].ppsz_list_text[j] );
-                  p_module->p_config[i].ppsz_list_text[j] = NULL;
-                }
-            }
-            if( p_module->p_config[i].pi_list )
+            p_item->ppf_action =
+                calloc( p_src->i_action, sizeof(vlc_callback_t) );
+            p_item->ppsz_action_text =
+                malloc( p_src->i_action * sizeof(char *) );
+            if( p_item->ppf_action && p_item->ppsz_action_text )
             {
-                p_module->p_config[i].pi_list =
-                    malloc( (p_module->p_config[i].i_list + 1) * sizeof(int) );
-                if( p_module->p_config[i].pi_list )
-                {
-                    for (int j = 0; j < p_module->p_config[i].i_list; j++)
-                        LOAD_IMMEDIATE( p_module->p_config[i].pi_list[j] );
-                }
+                p_item->i_action = p_src->i_action;
+                pi_str = (const uint32_t *)(p_data + p_src->i_action_text);
+                for( int j = 0; j < p_src->i_action; j++ )
+                    p_item->ppsz_action_text[j] =
+                        (char *)CacheString( p_strings, pi_str[j] );
             }
         }
 
-        if( p_module->p_config[i].i_action )
-        {
-            p_module->p_config[i].ppf_action =
-                malloc( p_module->p_config[i].i_action * sizeof(void *) );
-            p_module->p_config[i].ppsz_action_text =
-                malloc( p_module->p_config[i].i_action * sizeof(char *) );
+        p_item->p_lock = &(vlc_internals(p_module)->lock);
+        p_item->b_dirty = false;
+        p_item->b_advanced = p_src->b_advanced;
+        p_item->b_internal = p_src->b_internal;
+        p_item->b_restart = p_src->b_restart;
+        p_item->b_removed = p_src->b_removed;
+        p_item->b_autosave = p_src->b_autosave;
+        p_item->b_unsaveable = p_src->b_unsaveable;
+        p_item->b_safe = p_src->b_safe;
+    }
+
+    p_module->p_config = p_config;
+    p_module->b_config_mapped = true;
+    p_module->confsize = p_config ? p_rec->i_confsize : 0;
+    /* Publish the configuration: pairs with module_HasConfig() */
+    barrier();
+    p_module->p_config_cache = NULL;
+    vlc_object_unlock( p_module );
+}
+
+/*****************************************************************************
+ * Growable buffers used to build the cache file in memory
+ *****************************************************************************/
+typedef struct
+{
+    uint8_t *p;
+    size_t   i_size;
+    size_t   i_alloc;
+    bool     b_error;
+} cache_buffer_t;
 
-            for (int j = 0; j < p_module->p_config[i].i_action; j++)
+#define CACHE_BUFFER_AT( buf, type, off ) ((type *)((buf)->p + (off)))
+
+/* Returns the offset of i_len new zeroed bytes, or 0 on error */
+static uint32_t CacheReserve( cache_buffer_t *p_buf, size_t i_len,
+                              size_t i_align )
+{
+    size_t i_off = (p_buf->i_size + i_align - 1) & ~(i_align - 1);
+
+    if( p_buf->b_error || i_off + i_len > UINT32_MAX )
+        goto error;
+
+    if( i_off + i_len > p_buf->i_alloc )
+    {
+        size_t i_alloc = __MAX( 2 * p_buf->i_alloc, i_off + i_len );
+        uint8_t *p = realloc( p_buf->p, i_alloc );
+        if( p == NULL )
+            goto error;
+        p_buf->p = p;
+        p_buf->i_alloc = i_alloc;
+    }
+    memset( p_buf->p + p_buf->i_size, 0, i_off + i_len - p_buf->i_size );
+    p_buf->i_size = i_off + i_len;
+    return i_off;
+
+error:
+    p_buf->b_error = true;
+    return 0;
+}
+
+static uint32_t CacheSaveString( cache_buffer_t *p_strings, const char *psz )
+{
+    if( psz == NULL )
+        return 0;
+
+    size_t i_len = strlen( psz ) + 1;
+    uint32_t i_off = CacheReserve( p_strings, i_len, 1 );
+    if( !p_strings->b_error )
+        memcpy( p_strings->p + i_off, psz, i_len );
+    return i_off;
+}
+
+static uint32_t CacheSaveStrings( cache_buffer_t *p_data,
+                                  cache_buffer_t *p_strings,
+                                  char *const *ppsz, size_t i_count )
+{
+    uint32_t i_off = CacheReserve( p_data, i_count * sizeof(uint32_t),
+                                   CACHE_ALIGN );
+    for( size_t i = 0; i < i_count && !p_data->b_error; i++ )
+    {
+        uint32_t i_str = CacheSaveString( p_strings, ppsz[i] );
+        CACHE_BUFFER_AT( p_data, uint32_t, i_off )[i] = i_str;
+    }
+    return i_off;
+}
+
+/*****************************************************************************
+ * CacheSaveConfig: stores the configuration of a module
+ *****************************************************************************/
+static uint32_t CacheSaveConfig( cache_buffer_t *p_data,
+                                 cache_buffer_t *p_strings,
+                                 module_t *p_module, uint8_t *pb_callbacks )
+{
+    size_t i_lines = p_module->confsize;
+    uint32_t i_config = CacheReserve( p_data, i_lines * sizeof(cache_config_t),
+                                      CACHE_ALIGN );
+
+    for (size_t i = 0; i < i_lines && !p_data->b_error; i++)
+    {
+        const module_config_t *p_item = p_module->p_config + i;
+        cache_config_t rec;
+
+        memset( &rec, 0, sizeof(rec) );
+        rec.i_type = p_item->i_type;
+        rec.i_typename = CacheSaveString( p_strings, p_item->psz_type );
+        rec.i_name = CacheSaveString( p_strings, p_item->psz_name );
+        rec.i_text = CacheSaveString( p_strings, p_item->psz_text );
+        rec.i_longtext = CacheSaveString( p_strings, p_item->psz_longtext );
+        rec.i_oldname = CacheSaveString( p_strings, p_item->psz_oldname );
+        rec.i_short = p_item->i_short;
+
+        if (IsConfigStringType (p_item->i_type))
+            rec.i_orig_psz = CacheSaveString( p_strings, p_item->orig.psz );
+        else if (IsConfigFloatType (p_item->i_type))
+            rec.orig.f = p_item->orig.f;
+        else
+            rec.orig.i = p_item->orig.i;
+        rec.min = p_item->min;
+        rec.max = p_item->max;
+
+        if( p_item->i_list )
+        {
+            rec.i_list = p_item->i_list;
+            if( p_item->ppsz_list )
+                rec.i_list_psz = CacheSaveStrings( p_data, p_strings,
+                                                   p_item->ppsz_list,
+                                                   p_item->i_list );
+            if( p_item->ppsz_list_text )
+                rec.i_list_text = CacheSaveStrings( p_data, p_strings,
+                                                    p_item->ppsz_list_text,
+                                                    p_item->i_list );
+            if( p_item->pi_list )
             {
-                p_module->p_config[i].ppf_action[j] = 0;
-                LOAD_STRING( p_module->p_config[i].ppsz_action_text[j] );
+                rec.i_list_int = CacheReserve( p_data,
+                                               p_item->i_list * sizeof(int32_t),
+                                               CACHE_ALIGN );
+                if( !p_data->b_error )
+                    memcpy( p_data->p + rec.i_list_int, p_item->pi_list,
+                            p_item->i_list * sizeof(int32_t) );
             }
         }
 
-        LOAD_IMMEDIATE( p_module->p_config[i].pf_callback );
+        rec.i_action = p_item->i_action;
+        rec.i_action_text = CacheSaveStrings( p_data, p_strings,
+                                              p_item->ppsz_action_text,
+                                              p_item->i_action );
+
+        rec.b_advanced = p_item->b_advanced;
+        rec.b_internal = p_item->b_internal;
+        rec.b_restart = p_item->b_restart;
+        rec.b_removed = p_item->b_removed;
+        rec.b_autosave = p_item->b_autosave;
+        rec.b_unsaveable = p_item->b_unsaveable;
+        rec.b_safe = p_item->b_safe;
+
+        if( p_item->pf_callback || p_item->i_action
+         || p_item->pf_update_list )
+            *pb_callbacks = true;
+
+        if( !p_data->b_error )
+            memcpy( CACHE_BUFFER_AT( p_data, cache_config_t, i_config ) + i,
+                    &rec, sizeof(rec) );
     }
+    return i_config;
+}
 
-    return VLC_SUCCESS;
-
- error:
+/*****************************************************************************
+ * CacheSaveModule: stores a module in the record at offset i_rec
+ *****************************************************************************/
+static void CacheSaveModule( cache_buffer_t *p_data, cache_buffer_t *p_strings,
+                             module_t *p_module, uint32_t i_rec )
+{
+    cache_module_t rec;
+    uint32_t i;
+
+    memset( &rec, 0, sizeof(rec) );
+    rec.i_object_name = CacheSaveString( p_strings, p_module->psz_object_name );
+    rec.i_shortname = CacheSaveString( p_strings, p_module->psz_shortname );
+    rec.i_longname = CacheSaveString( p_strings, p_module->psz_longname );
+    rec.i_help = CacheSaveString( p_strings, p_module->psz_help );
+    while( rec.i_shortcuts < MODULE_SHORTCUT_MAX - 1
+        && p_module->pp_shortcuts[rec.i_shortcuts] != NULL )
+        rec.i_shortcuts++;
+    rec.i_shortcut = CacheSaveStrings( p_data, p_strings,
+                                       p_module->pp_shortcuts,
+                                       rec.i_shortcuts );
+    rec.i_capability = CacheSaveString( p_strings, p_module->psz_capability );
+    rec.i_score = p_module->i_score;
+    rec.i_cpu = p_module->i_cpu;
+    rec.b_unloadable = p_module->b_unloadable;
+    rec.b_reentrant = p_module->b_reentrant;
+    rec.b_submodule = p_module->b_submodule;
+
+    if( !p_module->b_submodule )
+    {
+        /* Config stuff */
+        module_LoadConfig( p_module );
+        rec.i_config_items = p_module->i_config_items;
+        rec.i_bool_items = p_module->i_bool_items;
+        rec.i_confsize = p_module->confsize;
+        rec.i_config = CacheSaveConfig( p_data, p_strings, p_module,
+                                        &rec.b_callbacks );
+
+        rec.i_filename = CacheSaveString( p_strings, p_module->psz_filename );
+
+        rec.i_submodules = vlc_internals( p_module )->i_children;
+        rec.i_submodule = CacheReserve( p_data,
+                                        rec.i_submodules * sizeof(rec),
+                                        CACHE_ALIGN );
+        for( i = 0; i < rec.i_submodules && !p_data->b_error; i++ )
+            CacheSaveModule( p_data, p_strings,
+                    (module_t *)vlc_internals( p_module )->pp_children[i],
+                    rec.i_submodule + i * sizeof(rec) );
+    }
 
-    return VLC_EGENERIC;
+    if( !p_data->b_error )
+        memcpy( p_data->p + i_rec, &rec, sizeof(rec) );
 }
 
 /*****************************************************************************
@@ -476,9 +899,12 @@ void CacheSave( vlc_object_t *p_this )
 
     char *psz_cachedir = config_GetCacheDir();
     FILE *file;
-    int i, j, i_cache;
+    int i, i_cache;
     module_cache_t **pp_cache;
     uint32_t i_file_size = 0;
+    cache_header_t header;
+    cache_buffer_t data = { NULL, 0, 0, false };
+    cache_buffer_t strings = { NULL, 0, 0, false };
     libvlc_global_data_t *p_libvlc_global = vlc_global();
 
     if( !psz_cachedir ) /* XXX: this should never happen */
@@ -504,6 +930,38 @@ void CacheSave( vlc_object_t *p_this )
               "%s"DIR_SEP CACHENAME_FORMAT, psz_cachedir,
               CACHENAME_VALUES );
     free( psz_cachedir );
+
+    /* Build the body first */
+    i_cache = p_libvlc_global->p_module_bank->i_cache;
+    pp_cache = p_libvlc_global->p_module_bank->pp_cache;
+
+    CacheReserve( &strings, 1, 1 ); /* so that offset 0 can mean NULL */
+    CacheReserve( &data, i_cache * sizeof(cache_entry_t), CACHE_ALIGN );
+    for( i = 0; i < i_cache && !data.b_error; i++ )
+    {
+        cache_entry_t entry;
+
+        memset( &entry, 0, sizeof(entry) );
+        entry.i_file = CacheSaveString( &strings, pp_cache[i]->psz_file );
+        entry.i_time = pp_cache[i]->i_time;
+        entry.i_size = pp_cache[i]->i_size;
+        if( !pp_cache[i]->b_junk )
+        {
+            entry.i_module = CacheReserve( &data, sizeof(cache_module_t),
+                                           CACHE_ALIGN );
+            CacheSaveModule( &data, &strings, pp_cache[i]->p_module,
+                             entry.i_module );
+        }
+        if( !data.b_error )
+            CACHE_BUFFER_AT( &data, cache_entry_t, 0 )[i] = entry;
+    }
+    if( data.b_error || strings.b_error )
+    {
+        file = NULL;
+        errno = ENOMEM;
+        goto error;
+    }
+
     msg_Dbg( p_this, "writing plugins cache %s", psz_filename );
 
     file = utf8_fopen( psz_filename, "wb" );
@@ -537,81 +995,23 @@ void CacheSave( vlc_object_t *p_this )
     if (fwrite (&i_file_size, sizeof (i_file_size), 1, file) != 1)
         goto error;
 
-    i_cache = p_libvlc_global->p_module_bank->i_cache;
-    pp_cache = p_libvlc_global->p_module_bank->pp_cache;
-
-    if (fwrite( &i_cache, sizeof (i_cache), 1, file) != 1)
-        goto error;
-
-#define SAVE_IMMEDIATE( a ) \
-    if (fwrite (&a, sizeof(a), 1, file) != 1) \
-        goto error
-#define SAVE_STRING( a ) \
-    { \
-        uint16_t i_size = (a != NULL) ? (strlen (a) + 1) : 0; \
-        if ((fwrite (&i_size, sizeof (i_size), 1, file) != 1) \
-         || (a && (fwrite (a, 1, i_size, file) != i_size))) \
-            goto error; \
-    } while(0)
-
-    for( i = 0; i < i_cache; i++ )
-    {
-        uint32_t i_submodule;
-
-        /* Save common info */
-        SAVE_STRING( pp_cache[i]->psz_file );
-        SAVE_IMMEDIATE( pp_cache[i]->i_time );
-        SAVE_IMMEDIATE( pp_cache[i]->i_size );
-        SAVE_IMMEDIATE( pp_cache[i]->b_junk );
-
-        if( pp_cache[i]->b_junk ) continue;
-
-        /* Save additional infos */
-        SAVE_STRING( pp_cache[i]->p_module->psz_object_name );
-        SAVE_STRING( pp_cache[i]->p_module->psz_shortname );
-        SAVE_STRING( pp_cache[i]->p_module->psz_longname );
-        SAVE_STRING( pp_cache[i]->p_module->psz_help );
-        for( j = 0; j < MODULE_SHORTCUT_MAX; j++ )
-        {
-            SAVE_STRING( pp_cache[i]->p_module->pp_shortcuts[j] ); // FIX
-        }
-        SAVE_STRING( pp_cache[i]->p_module->psz_capability );
-        SAVE_IMMEDIATE( pp_cache[i]->p_module->i_score );
-        SAVE_IMMEDIATE( pp_cache[i]->p_module->i_cpu );
-        SAVE_IMMEDIATE( pp_cache[i]->p_module->b_unloadable );
-        SAVE_IMMEDIATE( pp_cache[i]->p_module->b_reentrant );
-        SAVE_IMMEDIATE( pp_cache[i]->p_module->b_submodule );
-
-        /* Config stuff */
-        if (CacheSaveConfig (pp_cache[i]->p_module, file))
+    /* Padding up to the body */
+    while( ftell( file ) % CACHE_ALIGN )
+        if (fputc (0, file) == EOF)
             goto error;
 
-        SAVE_STRING( pp_cache[i]->p_module->psz_filename );
-
-        i_submodule = vlc_internals( pp_cache[i]->p_module )->i_children;
-        SAVE_IMMEDIATE( i_submodule );
-        for( i_submodule = 0;
-             i_submodule < (unsigned)vlc_internals( pp_cache[i]->p_module)->i_children;
-             i_submodule++ )
-        {
-            module_t *p_module =
-                (module_t *)vlc_internals( pp_cache[i]->p_module )->pp_children[i_submodule];
-
-            SAVE_STRING( p_module->psz_object_name );
-            SAVE_STRING( p_module->psz_shortname );
-            SAVE_STRING( p_module->psz_longname );
-            SAVE_STRING( p_module->psz_help );
-            for( j = 0; j < MODULE_SHORTCUT_MAX; j++ )
-            {
-                SAVE_STRING( p_module->pp_shortcuts[j] ); // FIX
-            }
-            SAVE_STRING( p_module->psz_capability );
-            SAVE_IMMEDIATE( p_module->i_score );
-            SAVE_IMMEDIATE( p_module->i_cpu );
-            SAVE_IMMEDIATE( p_module->b_unloadable );
-            SAVE_IMMEDIATE( p_module->b_reentrant );
-        }
-    }
+    header.i_entries = i_cache;
+    header.i_data = data.i_size;
+    header.i_strings = strings.i_size;
+    header.i_reserved = 0;
+    if (fwrite (&header, sizeof (header), 1, file) != 1
+     || fwrite (data.p, 1, data.i_size, file) != data.i_size
+     || fwrite (strings.p, 1, strings.i_size, file) != strings.i_size)
+        goto error;
+    free( data.p );
+    data.p = NULL;
+    free( strings.p );
+    strings.p = NULL;
 
     /* Fill-up file size */
     i_file_size = ftell( file );
@@ -626,6 +1026,8 @@ void CacheSave( vlc_object_t *p_this )
 error:
     msg_Warn (p_this, "could not write plugins cache %s (%m)",
               psz_filename);
+    free( data.p );
+    free( strings.p );
     if (file != NULL)
     {
         clearerr (file);
@@ -633,59 +1035,6 @@ error:
     }
 }
 
-static int CacheSaveConfig( module_t *p_module, FILE *file )
-{
-    uint32_t i_lines = p_module->confsize;
-
-    SAVE_IMMEDIATE( p_module->i_config_items );
-    SAVE_IMMEDIATE( p_module->i_bool_items );
-    SAVE_IMMEDIATE( i_lines );
-
-    for (size_t i = 0; i < i_lines ; i++)
-    {
-        SAVE_IMMEDIATE( p_module->p_config[i] );
-
-        SAVE_STRING( p_module->p_config[i].psz_type );
-        SAVE_STRING( p_module->p_config[i].psz_name );
-        SAVE_STRING( p_module->p_config[i].psz_text );
-        SAVE_STRING( p_module->p_config[i].psz_longtext );
-        SAVE_STRING( p_module->p_config[i].psz_oldname );
-        SAVE_IMMEDIATE( p_module->p_config[i].b_removed );
-
-        if (IsConfigStringType (p_module->p_config[i].i_type))
-            SAVE_STRING( p_module->p_config[i].orig.psz );
-
-        if( p_module->p_config[i].i_list )
-        {
-            if( p_module->p_config[i].ppsz_list )
-            {
-                for (int j = 0; j < p_module->p_config[i].i_list; j++)
-                    SAVE_STRING( p_module->p_config[i].ppsz_list[j] );
-            }
-
-            if( p_module->p_config[i].ppsz_list_text )
-            {
-                for (int j = 0; j < p_module->p_config[i].i_list; j++)
-                    SAVE_STRING( p_module->p_config[i].ppsz_list_text[j] );
-            }
-            if( p_module->p_config[i].pi_list )
-            {
-                for (int j = 0; j < p_module->p_config[i].i_list; j++)
-                    SAVE_IMMEDIATE( p_module->p_config[i].pi_list[j] );
-            }
-        }
-
-        for (int j = 0; j < p_module->p_config[i].i_action; j++)
-            SAVE_STRING( p_module->p_config[i].ppsz_action_text[j] );
-
-        SAVE_IMMEDIATE( p_module->p_config[i].pf_callback );
-    }
-    return 0;
-
-error:
-    return -1;
-}
-
 /*****************************************************************************
  * CacheMerge: Merge a cache module descriptor with a full module descriptor.
  *****************************************************************************/
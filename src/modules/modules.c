@@ -86,6 +86,7 @@
 
 #include "vlc_charset.h"
 #include "vlc_arrays.h"
+#include "vlc_block.h"
 
 #include "modules/modules.h"
 #include "modules/builtin.h"
@@ -130,6 +131,7 @@ void __module_InitBank( vlc_object_t *p_this )
         p_bank->pp_cache = p_bank->pp_loaded_cache = NULL;
         p_bank->b_cache = p_bank->b_cache_dirty =
         p_bank->b_cache_delete = false;
+        p_bank->p_cache_block = NULL;
 
         /* Everything worked, attach the object */
         p_libvlc_global->p_module_bank = p_bank;
@@ -178,14 +180,18 @@ void __module_EndBank( vlc_object_t *p_this )
     /* Save the configuration */
     config_AutoSaveConfigFile( p_this );
 
+    /* Pending messages may point to format strings of plugins */
+    msg_Flush( p_this->p_libvlc );
+
 #ifdef HAVE_DYNAMIC_PLUGINS
 # define p_bank p_libvlc_global->p_module_bank
-    if( p_bank->b_cache ) CacheSave( p_this );
+    if( p_bank->b_cache && p_bank->b_cache_dirty ) CacheSave( p_this );
     while( p_bank->i_loaded_cache-- )
     {
         if( p_bank->pp_loaded_cache[p_bank->i_loaded_cache] )
         {
-            DeleteModule(
+            if( p_bank->pp_loaded_cache[p_bank->i_loaded_cache]->p_module )
+                DeleteModule(
                     p_bank->pp_loaded_cache[p_bank->i_loaded_cache]->p_module,
                     p_bank->pp_loaded_cache[p_bank->i_loaded_cache]->b_used );
             free( p_bank->pp_loaded_cache[p_bank->i_loaded_cache]->psz_file );
@@ -220,6 +226,10 @@ void __module_EndBank( vlc_object_t *p_this )
         DeleteModule( p_next, true );
     }
 
+    /* Cached modules pointed to the cache file until now */
+    if( p_libvlc_global->p_module_bank->p_cache_block != NULL )
+        block_Release( p_libvlc_global->p_module_bank->p_cache_block );
+
     vlc_object_release( p_libvlc_global->p_module_bank );
     p_libvlc_global->p_module_bank = NULL;
 }
@@ -279,6 +289,11 @@ void __module_LoadPlugins( vlc_object_t * p_this )
         p_libvlc_global->p_module_bank->b_cache_delete ) CacheLoad( p_this );
 
     AllocateAllPlugins( p_this );
+
+    /* Only rewrite the cache if some plugin was added, changed or removed */
+    if( p_libvlc_global->p_module_bank->i_cache !=
+        p_libvlc_global->p_module_bank->i_loaded_cache )
+        p_libvlc_global->p_module_bank->b_cache_dirty = true;
 #endif
 }
 
@@ -814,8 +829,12 @@ char ** __module_GetModulesNamesForCapability( vlc_object_t *p_this,
 module_config_t *module_GetConfig( const module_t *module, unsigned *restrict psize )
 {
     unsigned i,j;
-    unsigned size = module->confsize;
-    module_config_t *config = malloc( size * sizeof( *config ) );
+    unsigned size;
+    module_config_t *config;
+
+    module_LoadConfig( (module_t *)module );
+    size = module->confsize;
+    config = malloc( size * sizeof( *config ) );
 
     assert( psize != NULL );
     *psize = 0;
@@ -1155,6 +1174,7 @@ static int AllocatePluginFile( vlc_object_t * p_this, char * psz_file,
     if( !p_cache_entry )
     {
         p_module = AllocatePlugin( p_this, psz_file );
+        vlc_global()->p_module_bank->b_cache_dirty = true;
     }
     else
     {
@@ -1165,32 +1185,23 @@ static int AllocatePluginFile( vlc_object_t * p_this, char * psz_file,
         }
         else
         {
-            module_config_t *p_item = NULL, *p_end = NULL;
-
             p_module = p_cache_entry->p_module;
             p_module->b_loaded = false;
 
             /* For now we force loading if the module's config contains
              * callbacks or actions.
              * Could be optimized by adding an API call.*/
-            for( p_item = p_module->p_config, p_end = p_item + p_module->confsize;
-                 p_item < p_end; p_item++ )
-            {
-                if( p_item->pf_callback || p_item->i_action )
-                {
-                    p_module = AllocatePlugin( p_this, psz_file );
-                    break;
-                }
-            }
+            if( p_cache_entry->b_callbacks )
+                p_module = AllocatePlugin( p_this, psz_file );
             if( p_module == p_cache_entry->p_module )
                 p_cache_entry->b_used = true;
         }
     }
 
+    libvlc_global_data_t *p_libvlc_global = vlc_global();
+
     if( p_module )
     {
-        libvlc_global_data_t *p_libvlc_global = vlc_global();
-
         /* Everything worked fine !
          * The module is ready to be added to the list. */
         p_module->b_builtin = false;
@@ -1199,26 +1210,31 @@ static int AllocatePluginFile( vlc_object_t * p_this, char * psz_file,
                     p_module->psz_object_name, p_module->psz_longname ); */
 
         vlc_object_attach( p_module, p_libvlc_global->p_module_bank );
+    }
 
-        if( !p_libvlc_global->p_module_bank->b_cache )
-            return 0;
+    if( !p_libvlc_global->p_module_bank->b_cache )
+        return p_module ? 0 : -1;
 
 #define p_bank p_libvlc_global->p_module_bank
-        /* Add entry to cache */
-        p_bank->pp_cache =
-            realloc( p_bank->pp_cache, (p_bank->i_cache + 1) * sizeof(void *) );
-        p_bank->pp_cache[p_bank->i_cache] = malloc( sizeof(module_cache_t) );
-        if( !p_bank->pp_cache[p_bank->i_cache] )
-            return -1;
-        p_bank->pp_cache[p_bank->i_cache]->psz_file = strdup( psz_file );
-        p_bank->pp_cache[p_bank->i_cache]->i_time = i_file_time;
-        p_bank->pp_cache[p_bank->i_cache]->i_size = i_file_size;
-        p_bank->pp_cache[p_bank->i_cache]->b_junk = p_module ? 0 : 1;
-        p_bank->pp_cache[p_bank->i_cache]->b_used = true;
-        p_bank->pp_cache[p_bank->i_cache]->p_module = p_module;
-        p_bank->i_cache++;
+    /* Add entry to cache, junk files included so that they are not tried
+     * again at every start */
+    module_cache_t **pp_cache =
+        realloc( p_bank->pp_cache, (p_bank->i_cache + 1) * sizeof(void *) );
+    if( pp_cache == NULL )
+        return -1;
+    p_bank->pp_cache = pp_cache;
+    p_bank->pp_cache[p_bank->i_cache] = malloc( sizeof(module_cache_t) );
+    if( !p_bank->pp_cache[p_bank->i_cache] )
+        return -1;
+    p_bank->pp_cache[p_bank->i_cache]->psz_file = strdup( psz_file );
+    p_bank->pp_cache[p_bank->i_cache]->i_time = i_file_time;
+    p_bank->pp_cache[p_bank->i_cache]->i_size = i_file_size;
+    p_bank->pp_cache[p_bank->i_cache]->b_junk = p_module ? 0 : 1;
+    p_bank->pp_cache[p_bank->i_cache]->b_used = true;
+    p_bank->pp_cache[p_bank->i_cache]->b_callbacks = false;
+    p_bank->pp_cache[p_bank->i_cache]->p_module = p_module;
+    p_bank->i_cache++;
 #undef p_bank
-    }
 
     return p_module ? 0 : -1;
 }
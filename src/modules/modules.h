@@ -56,6 +56,11 @@ struct module_bank_t
 
     int            i_loaded_cache;
     module_cache_t **pp_loaded_cache;
+
+    /* Mapping of the loaded cache file, which the cached modules point to */
+    block_t         *p_cache_block;
+    const uint8_t   *p_cache_data;
+    const char      *p_cache_strings;
 };
 
 /*****************************************************************************
@@ -72,6 +77,7 @@ struct module_cache_t
     /* Optional extra data */
     module_t *p_module;
     bool b_used;
+    bool b_callbacks;    /* The configuration needs code from the plugin */
 };
 
 
@@ -139,6 +145,10 @@ struct module_t
 
     bool          b_builtin;  /* Set to true if the module is built in */
     bool          b_loaded;        /* Set to true if the dll is loaded */
+
+    /* Configuration record in the plugins cache, until it is needed */
+    const void   *p_config_cache;
+    bool          b_config_mapped;   /* Strings point into the cache file */
 };
 
 
@@ -163,5 +173,35 @@ void   CacheMerge (vlc_object_t *, module_t *, module_t *);
 void   CacheLoad  (vlc_object_t * );
 void   CacheSave  (vlc_object_t * );
 module_cache_t * CacheFind (const char *, int64_t, int64_t);
+void   CacheLoadConfig (module_t *);
+
+/**
+ * Tells whether the configuration items of a module are loaded. If so, they
+ * can be read without the module lock: the memory barrier pairs with the
+ * one issued by CacheLoadConfig() before it clears p_config_cache, so that
+ * p_config and confsize are not read before p_config_cache on weakly
+ * ordered CPUs.
+ */
+static inline bool module_HasConfig( const module_t *p_module )
+{
+    if( p_module->p_config_cache != NULL )
+        return false;
+    barrier();
+    return true;
+}
+
+/**
+ * Makes sure the configuration items of a module are available. Modules
+ * coming from the plugins cache only get them on first use.
+ */
+static inline void module_LoadConfig( module_t *p_module )
+{
+#ifdef HAVE_DYNAMIC_PLUGINS
+    if( !module_HasConfig( p_module ) )
+        CacheLoadConfig( p_module );
+#else
+    (void)p_module;
+#endif
+}
 
 #endif /* !__LIBVLC_MODULES_H */
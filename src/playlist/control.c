@@ -35,7 +35,7 @@
  *****************************************************************************/
 static int PlaylistVAControl( playlist_t * p_playlist, int i_query, va_list args );
 
-static void PreparseEnqueueItemSub( playlist_t *, playlist_item_t * );
+static int PreparseEnqueueItemSub( playlist_t *, playlist_item_t * );
 
 /*****************************************************************************
  * Playlist control
@@ -190,20 +190,18 @@ static int PlaylistVAControl( playlist_t * p_playlist, int i_query, va_list args
 int playlist_PreparseEnqueue( playlist_t *p_playlist,
                               input_item_t *p_item )
 {
-    vlc_object_lock( p_playlist->p_preparse );
-    if( !vlc_object_alive( p_playlist->p_preparse ) )
-    {
-        vlc_object_unlock( p_playlist->p_preparse );
-        return VLC_EGENERIC;
-    }
-    vlc_gc_incref( p_item );
-    INSERT_ELEM( p_playlist->p_preparse->pp_waiting,
-                 p_playlist->p_preparse->i_waiting,
-                 p_playlist->p_preparse->i_waiting,
-                 p_item );
-    vlc_object_signal_unlocked( p_playlist->p_preparse );
-    vlc_object_unlock( p_playlist->p_preparse );
-    return VLC_SUCCESS;
+    return playlist_QueuePush( VLC_OBJECT(p_playlist->p_preparse),
+                               &p_playlist->p_preparse->queue, p_item,
+                               false, playlist_PreparseRun );
+}
+
+/** Enqueue an item shown to the user for preparsing, before the others */
+int playlist_PreparseEnqueueVisible( playlist_t *p_playlist,
+                                     input_item_t *p_item )
+{
+    return playlist_QueuePush( VLC_OBJECT(p_playlist->p_preparse),
+                               &p_playlist->p_preparse->queue, p_item,
+                               true, playlist_PreparseRun );
 }
 
 /** Enqueue a playlist item or a node for peparsing.
@@ -211,58 +209,37 @@ int playlist_PreparseEnqueue( playlist_t *p_playlist,
 int playlist_PreparseEnqueueItem( playlist_t *p_playlist,
                                   playlist_item_t *p_item )
 {
+    int i_ret;
+
     vlc_object_lock( p_playlist );
-    vlc_object_lock( p_playlist->p_preparse );
-    if( !vlc_object_alive( p_playlist->p_preparse ) )
-    {
-        vlc_object_unlock( p_playlist->p_preparse );
-        vlc_object_unlock( p_playlist );
-        return VLC_EGENERIC;
-    }
-    PreparseEnqueueItemSub( p_playlist, p_item );
-    vlc_object_unlock( p_playlist->p_preparse );
+    i_ret = PreparseEnqueueItemSub( p_playlist, p_item );
     vlc_object_unlock( p_playlist );
-    return VLC_SUCCESS;
+    return i_ret;
 }
 
+/** The art is asked for by the user, so it is fetched before the art of
+ *  the items queued by the preparser */
 int playlist_AskForArtEnqueue( playlist_t *p_playlist,
                                input_item_t *p_item )
 {
-    vlc_object_lock( p_playlist->p_fetcher );
-    if( !vlc_object_alive( p_playlist->p_fetcher ) )
-    {
-        vlc_object_unlock( p_playlist->p_fetcher );
-        return VLC_EGENERIC;
-    }
-
-    vlc_gc_incref( p_item );
-    INSERT_ELEM( p_playlist->p_fetcher->pp_waiting,
-                 p_playlist->p_fetcher->i_waiting,
-                 p_playlist->p_fetcher->i_waiting, p_item );
-    vlc_object_signal_unlocked( p_playlist->p_fetcher );
-    vlc_object_unlock( p_playlist->p_fetcher );
-    return VLC_SUCCESS;
+    return playlist_QueuePush( VLC_OBJECT(p_playlist->p_fetcher),
+                               &p_playlist->p_fetcher->queue, p_item,
+                               true, playlist_FetcherRun );
 }
 
-static void PreparseEnqueueItemSub( playlist_t *p_playlist,
-                                    playlist_item_t *p_item )
+static int PreparseEnqueueItemSub( playlist_t *p_playlist,
+                                   playlist_item_t *p_item )
 {
     int i;
     if( p_item->i_children == -1 )
+        return playlist_PreparseEnqueue( p_playlist, p_item->p_input );
+
+    for( i = 0; i < p_item->i_children; i++)
     {
-        vlc_gc_incref( p_item->p_input );
-        INSERT_ELEM( p_playlist->p_preparse->pp_waiting,
-                     p_playlist->p_preparse->i_waiting,
-                     p_playlist->p_preparse->i_waiting,
-                     p_item->p_input );
-    }
-    else
-    {
-        for( i = 0; i < p_item->i_children; i++)
-        {
-            PreparseEnqueueItemSub( p_playlist, p_item->pp_children[i] );
-        }
+        if( PreparseEnqueueItemSub( p_playlist, p_item->pp_children[i] ) )
+            return VLC_EGENERIC;
     }
+    return VLC_SUCCESS;
 }
 
 /*****************************************************************************
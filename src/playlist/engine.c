@@ -84,6 +84,7 @@ playlist_t * playlist_Create( vlc_object_t *p_parent )
 
     ARRAY_INIT( p_playlist->items );
     ARRAY_INIT( p_playlist->all_items );
+    p_playlist->p_index = playlist_IndexNew();
     ARRAY_INIT( p_playlist->items_to_delete );
     ARRAY_INIT( p_playlist->current );
 
@@ -183,6 +184,9 @@ static void playlist_Destructor( vlc_object_t * p_this )
     {
         vlc_object_release( p_playlist->p_fetcher );
     }
+
+    if( p_playlist->p_index )
+        playlist_IndexDelete( p_playlist->p_index );
     msg_Dbg( p_this, "Destroyed" );
 }
 
@@ -517,10 +521,13 @@ void playlist_LastLoop( playlist_t *p_playlist )
     playlist_ServicesDiscoveryKillAll( p_playlist );
     playlist_MLDump( p_playlist );
 
+    /* The preparser queues items for the fetcher, so it goes first */
     vlc_object_kill( p_playlist->p_preparse );
-    vlc_thread_join( p_playlist->p_preparse );
+    playlist_QueueDelete( VLC_OBJECT(p_playlist->p_preparse),
+                          &p_playlist->p_preparse->queue );
     vlc_object_kill( p_playlist->p_fetcher );
-    vlc_thread_join( p_playlist->p_fetcher );
+    playlist_QueueDelete( VLC_OBJECT(p_playlist->p_fetcher),
+                          &p_playlist->p_fetcher->queue );
 
     PL_LOCK;
 
@@ -536,6 +543,11 @@ void playlist_LastLoop( playlist_t *p_playlist )
         free( p_del );
     FOREACH_END();
     ARRAY_RESET( p_playlist->all_items );
+    if( p_playlist->p_index )
+    {
+        playlist_IndexDelete( p_playlist->p_index );
+        p_playlist->p_index = NULL;
+    }
     FOREACH_ARRAY( playlist_item_t *p_del, p_playlist->items_to_delete )
         free( p_del->pp_children );
         vlc_gc_decref( p_del->p_input );
@@ -549,193 +561,260 @@ void playlist_LastLoop( playlist_t *p_playlist )
     PL_UNLOCK;
 }
 
+/*****************************************************************************
+ * Preparser and fetcher queues
+ *****************************************************************************/
+int playlist_QueueNew( vlc_object_t *p_obj, playlist_queue_t *p_queue,
+                       unsigned i_threads )
+{
+    p_queue->i_waiting = 0;
+    p_queue->p_waiting = NULL;
+    p_queue->i_visible = 0;
+    p_queue->i_done = 0;
+    p_queue->i_delay = p_queue->i_delay_max = 0;
+
+    /* Below the default priority, so that the items do not delay the jobs
+     * of the inputs */
+    p_queue->p_jobs = job_queue_New( p_obj, -1, i_threads );
+    return p_queue->p_jobs ? VLC_SUCCESS : VLC_EGENERIC;
+}
+
+/* The owner has to be killed first, so that nothing is queued anymore */
+void playlist_QueueDelete( vlc_object_t *p_obj, playlist_queue_t *p_queue )
+{
+    if( p_queue->p_jobs )
+        job_queue_Delete( p_queue->p_jobs );
+    p_queue->p_jobs = NULL;
+
+    vlc_object_lock( p_obj );
+    for( int i = 0; i < p_queue->i_waiting; i++ )
+        vlc_gc_decref( p_queue->p_waiting[i].p_item );
+    FREENULL( p_queue->p_waiting );
+    p_queue->i_waiting = p_queue->i_visible = 0;
+    vlc_object_unlock( p_obj );
+
+    if( p_queue->i_done > 0 )
+        msg_Dbg( p_obj, "%u items run, waited %"PRId64" ms on average, "
+                 "%"PRId64" ms at most", p_queue->i_done,
+                 p_queue->i_delay / p_queue->i_done / 1000,
+                 p_queue->i_delay_max / 1000 );
+}
+
 /**
- * Preparse loop
+ * Queue an item, unless it is already waiting
  *
- * Main loop for preparser queue
- * \param p_obj items to preparse
- * \return nothing
+ * \param b_visible the item is shown to the user, so it is run before the
+ * items which are not
+ * \param pf_run job running the first waiting item of the queue
  */
-void playlist_PreparseLoop( playlist_preparse_t *p_obj )
+int playlist_QueuePush( vlc_object_t *p_obj, playlist_queue_t *p_queue,
+                        input_item_t *p_item, bool b_visible,
+                        void (*pf_run)( void * ) )
 {
-    playlist_t *p_playlist = (playlist_t *)p_obj->p_parent;
-    input_item_t *p_current;
-    int i_activity;
+    playlist_waiting_t waiting;
+    int i;
 
     vlc_object_lock( p_obj );
-
-    while( vlc_object_alive( p_obj ) )
+    if( !vlc_object_alive( p_obj ) || !p_queue->p_jobs )
     {
-        if( p_obj->i_waiting == 0 )
-        {
-            vlc_object_wait( p_obj );
-            continue;
-        }
-
-        p_current = p_obj->pp_waiting[0];
-        REMOVE_ELEM( p_obj->pp_waiting, p_obj->i_waiting, 0 );
         vlc_object_unlock( p_obj );
+        return VLC_EGENERIC;
+    }
 
-        PL_LOCK;
-        if( p_current )
+    for( i = 0; i < p_queue->i_waiting; i++ )
+        if( p_queue->p_waiting[i].p_item == p_item )
+            break;
+    if( i < p_queue->i_waiting )
+    {
+        /* Already waiting: move it up with the visible items if needed */
+        if( b_visible && i >= p_queue->i_visible )
         {
-            if( p_current->i_type == ITEM_TYPE_FILE )
-            {
-                stats_TimerStart( p_playlist, "Preparse run",
-                                  STATS_TIMER_PREPARSE );
-                /* Do not preparse if it is already done (like by playing it) */
-                if( !input_item_IsPreparsed( p_current ) )
-                {
-                    PL_UNLOCK;
-                    input_Preparse( p_playlist, p_current );
-                    PL_LOCK;
-                }
-                stats_TimerStop( p_playlist, STATS_TIMER_PREPARSE );
-                PL_UNLOCK;
-                input_item_SetPreparsed( p_current, true );
-                var_SetInteger( p_playlist, "item-change", p_current->i_id );
-                PL_LOCK;
-            }
-            /* If we haven't retrieved enough meta, add to secondary queue
-             * which will run the "meta fetchers".
-             * This only checks for meta, not for art
-             * \todo don't do this for things we won't get meta for, like vids
-             */
-            char *psz_arturl = input_item_GetArtURL( p_current );
-            char *psz_name = input_item_GetName( p_current );
-            if( p_playlist->p_fetcher->i_art_policy == ALBUM_ART_ALL &&
-                        ( !psz_arturl || strncmp( psz_arturl, "file://", 7 ) ) )
-            {
-                PL_DEBUG("meta ok for %s, need to fetch art", psz_name );
-                vlc_object_lock( p_playlist->p_fetcher );
-                if( vlc_object_alive( p_playlist->p_fetcher ) )
-                {
-                    INSERT_ELEM( p_playlist->p_fetcher->pp_waiting,
-                        p_playlist->p_fetcher->i_waiting,
-                        p_playlist->p_fetcher->i_waiting, p_current);
-                    vlc_object_signal_unlocked( p_playlist->p_fetcher );
-                }
-                else
-                    vlc_gc_decref( p_current );
-                vlc_object_unlock( p_playlist->p_fetcher );
-            }
-            else
-            {
-                PL_DEBUG( "no fetch required for %s (art currently %s)",
-                          psz_name, psz_arturl );
-                vlc_gc_decref( p_current );
-            }
-            free( psz_name );
-            free( psz_arturl );
-            PL_UNLOCK;
+            waiting = p_queue->p_waiting[i];
+            REMOVE_ELEM( p_queue->p_waiting, p_queue->i_waiting, i );
+            INSERT_ELEM( p_queue->p_waiting, p_queue->i_waiting,
+                         p_queue->i_visible, waiting );
+            p_queue->i_visible++;
         }
-        else
-            PL_UNLOCK;
-
-        vlc_object_lock( p_obj );
-        i_activity = var_GetInteger( p_playlist, "activity" );
-        if( i_activity < 0 ) i_activity = 0;
         vlc_object_unlock( p_obj );
-        /* Sleep at least 1ms */
-        msleep( (i_activity+1) * 1000 );
-        vlc_object_lock( p_obj );
+        return VLC_SUCCESS;
     }
 
-    while( p_obj->i_waiting > 0 )
+    if( job_queue_Submit( p_queue->p_jobs, pf_run, p_obj, 0 ) )
     {
-        vlc_gc_decref( p_obj->pp_waiting[0] );
-        REMOVE_ELEM( p_obj->pp_waiting, p_obj->i_waiting, 0 );
+        vlc_object_unlock( p_obj );
+        return VLC_ENOMEM;
+    }
+    vlc_gc_incref( p_item );
+    waiting.p_item = p_item;
+    waiting.i_date = mdate();
+    if( b_visible )
+    {
+        INSERT_ELEM( p_queue->p_waiting, p_queue->i_waiting,
+                     p_queue->i_visible, waiting );
+        p_queue->i_visible++;
     }
+    else
+        INSERT_ELEM( p_queue->p_waiting, p_queue->i_waiting,
+                     p_queue->i_waiting, waiting );
+    vlc_object_unlock( p_obj );
+    return VLC_SUCCESS;
+}
+
+/* Takes the first waiting item, NULL if the owner is being killed */
+static input_item_t *QueuePop( vlc_object_t *p_obj, playlist_queue_t *p_queue )
+{
+    input_item_t *p_item = NULL;
+
+    vlc_object_lock( p_obj );
+    if( vlc_object_alive( p_obj ) && p_queue->i_waiting > 0 )
+    {
+        const mtime_t i_delay = mdate() - p_queue->p_waiting[0].i_date;
+
+        p_item = p_queue->p_waiting[0].p_item;
+        REMOVE_ELEM( p_queue->p_waiting, p_queue->i_waiting, 0 );
+        if( p_queue->i_visible > 0 )
+            p_queue->i_visible--;
 
+        p_queue->i_done++;
+        p_queue->i_delay += i_delay;
+        if( i_delay > p_queue->i_delay_max )
+            p_queue->i_delay_max = i_delay;
+    }
     vlc_object_unlock( p_obj );
+    return p_item;
+}
+
+/* Leaves some time to the playback if it is busy */
+static void QueueYield( playlist_t *p_playlist )
+{
+    int i_activity = var_GetInteger( p_playlist, "activity" );
+
+    if( i_activity > 0 )
+        msleep( i_activity * 1000 );
 }
 
 /**
- * Fetcher loop
+ * Preparse job
  *
- * Main loop for secondary preparser queue
- * \param p_obj items to preparse
+ * Preparses the first item of the preparser queue
+ * \param data the preparser
  * \return nothing
  */
-void playlist_FetcherLoop( playlist_fetcher_t *p_obj )
+void playlist_PreparseRun( void *data )
 {
+    playlist_preparse_t *p_obj = data;
     playlist_t *p_playlist = (playlist_t *)p_obj->p_parent;
-    input_item_t *p_item;
-    int i_activity;
+    input_item_t *p_current;
 
-    vlc_object_lock( p_obj );
+    p_current = QueuePop( VLC_OBJECT(p_obj), &p_obj->queue );
+    if( !p_current )
+        return;
 
-    while( vlc_object_alive( p_obj ) )
+    PL_LOCK;
+    if( p_current->i_type == ITEM_TYPE_FILE )
     {
-        if( p_obj->i_waiting == 0 )
+        stats_TimerStart( p_playlist, "Preparse run",
+                          STATS_TIMER_PREPARSE );
+        /* Do not preparse if it is already done (like by playing it) */
+        if( !input_item_IsPreparsed( p_current ) )
         {
-            vlc_object_wait( p_obj );
-            continue;
+            PL_UNLOCK;
+            input_Preparse( p_playlist, p_current );
+            PL_LOCK;
         }
+        stats_TimerStop( p_playlist, STATS_TIMER_PREPARSE );
+        PL_UNLOCK;
+        input_item_SetPreparsed( p_current, true );
+        var_SetInteger( p_playlist, "item-change", p_current->i_id );
+        PL_LOCK;
+    }
+    /* If we haven't retrieved enough meta, add to secondary queue
+     * which will run the "meta fetchers".
+     * This only checks for meta, not for art
+     * \todo don't do this for things we won't get meta for, like vids
+     */
+    char *psz_arturl = input_item_GetArtURL( p_current );
+    char *psz_name = input_item_GetName( p_current );
+    if( p_playlist->p_fetcher->i_art_policy == ALBUM_ART_ALL &&
+                ( !psz_arturl || strncmp( psz_arturl, "file://", 7 ) ) )
+    {
+        PL_DEBUG("meta ok for %s, need to fetch art", psz_name );
+        playlist_QueuePush( VLC_OBJECT(p_playlist->p_fetcher),
+                            &p_playlist->p_fetcher->queue, p_current,
+                            false, playlist_FetcherRun );
+    }
+    else
+    {
+        PL_DEBUG( "no fetch required for %s (art currently %s)",
+                  psz_name, psz_arturl );
+    }
+    free( psz_name );
+    free( psz_arturl );
+    PL_UNLOCK;
+    vlc_gc_decref( p_current );
 
-        p_item = p_obj->pp_waiting[0];
-        REMOVE_ELEM( p_obj->pp_waiting, p_obj->i_waiting, 0 );
-        vlc_object_unlock( p_obj );
-        if( p_item )
-        {
-            int i_ret;
+    QueueYield( p_playlist );
+}
 
-            /* Check if it is not yet preparsed and if so wait for it (at most 0.5s)
-             * (This can happen if we fetch art on play)
-             * FIXME this doesn't work if we need to fetch meta before art ... */
-            for( i_ret = 0; i_ret < 10 && !input_item_IsPreparsed( p_item ); i_ret++ )
-            {
-                bool b_break;
-                PL_LOCK;
-                b_break = ( !p_playlist->p_input || input_GetItem(p_playlist->p_input) != p_item  ||
-                            p_playlist->p_input->b_die || p_playlist->p_input->b_eof || p_playlist->p_input->b_error );
-                PL_UNLOCK;
-                if( b_break )
-                    break;
-                msleep( 50000 );
-            }
+/**
+ * Fetcher job
+ *
+ * Fetches the art of the first item of the fetcher queue
+ * \param data the fetcher
+ * \return nothing
+ */
+void playlist_FetcherRun( void *data )
+{
+    playlist_fetcher_t *p_obj = data;
+    playlist_t *p_playlist = (playlist_t *)p_obj->p_parent;
+    input_item_t *p_item;
+    int i_ret;
 
-            i_ret = input_ArtFind( p_playlist, p_item );
-            if( i_ret == 1 )
-            {
-                PL_DEBUG( "downloading art for %s", p_item->psz_name );
-                if( input_DownloadAndCacheArt( p_playlist, p_item ) )
-                    input_item_SetArtNotFound( p_item, true );
-                else {
-                    input_item_SetArtFetched( p_item, true );
-                    var_SetInteger( p_playlist, "item-change",
-                                    p_item->i_id );
-                }
-            }
-            else if( i_ret == 0 ) /* Was in cache */
-            {
-                PL_DEBUG( "found art for %s in cache", p_item->psz_name );
-                input_item_SetArtFetched( p_item, true );
-                var_SetInteger( p_playlist, "item-change", p_item->i_id );
-            }
-            else
-            {
-                PL_DEBUG( "art not found for %s", p_item->psz_name );
-                input_item_SetArtNotFound( p_item, true );
-            }
-            vlc_gc_decref( p_item );
-        }
-        vlc_object_lock( p_obj );
-        i_activity = var_GetInteger( p_playlist, "activity" );
-        if( i_activity < 0 ) i_activity = 0;
-        vlc_object_unlock( p_obj );
-        /* Sleep at least 1ms */
-        msleep( (i_activity+1) * 1000 );
-        vlc_object_lock( p_obj );
+    p_item = QueuePop( VLC_OBJECT(p_obj), &p_obj->queue );
+    if( !p_item )
+        return;
+
+    /* Check if it is not yet preparsed and if so wait for it (at most 0.5s)
+     * (This can happen if we fetch art on play)
+     * FIXME this doesn't work if we need to fetch meta before art ... */
+    for( i_ret = 0; i_ret < 10 && !input_item_IsPreparsed( p_item ); i_ret++ )
+    {
+        bool b_break;
+        PL_LOCK;
+        b_break = ( !p_playlist->p_input || input_GetItem(p_playlist->p_input) != p_item  ||
+                    p_playlist->p_input->b_die || p_playlist->p_input->b_eof || p_playlist->p_input->b_error );
+        PL_UNLOCK;
+        if( b_break )
+            break;
+        msleep( 50000 );
     }
 
-    while( p_obj->i_waiting > 0 )
+    i_ret = input_ArtFind( p_playlist, p_item );
+    if( i_ret == 1 )
     {
-        vlc_gc_decref( p_obj->pp_waiting[0] );
-        REMOVE_ELEM( p_obj->pp_waiting, p_obj->i_waiting, 0 );
+        PL_DEBUG( "downloading art for %s", p_item->psz_name );
+        if( input_DownloadAndCacheArt( p_playlist, p_item ) )
+            input_item_SetArtNotFound( p_item, true );
+        else {
+            input_item_SetArtFetched( p_item, true );
+            var_SetInteger( p_playlist, "item-change",
+                            p_item->i_id );
+        }
     }
+    else if( i_ret == 0 ) /* Was in cache */
+    {
+        PL_DEBUG( "found art for %s in cache", p_item->psz_name );
+        input_item_SetArtFetched( p_item, true );
+        var_SetInteger( p_playlist, "item-change", p_item->i_id );
+    }
+    else
+    {
+        PL_DEBUG( "art not found for %s", p_item->psz_name );
+        input_item_SetArtNotFound( p_item, true );
+    }
+    vlc_gc_decref( p_item );
 
-    vlc_object_unlock( p_obj );
+    QueueYield( p_playlist );
 }
 
 static void VariablesInit( playlist_t *p_playlist )
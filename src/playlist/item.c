@@ -114,8 +114,10 @@ static void input_item_subitem_added( const vlc_event_t * p_event,
 static void input_item_changed( const vlc_event_t * p_event,
                                 void * user_data )
 {
-    (void)p_event;
     playlist_item_t * p_item = user_data;
+    if( p_event->type == vlc_InputItemMetaChanged ||
+        p_event->type == vlc_InputItemNameChanged )
+        playlist_IndexChanged( p_item->p_playlist, p_item->p_input );
     var_SetInteger( p_item->p_playlist, "item-change", p_item->i_id );
 }
 
@@ -897,6 +899,7 @@ static void AddItem( playlist_t *p_playlist, playlist_item_t *p_item,
     PL_ASSERT_LOCKED;
     ARRAY_APPEND(p_playlist->items, p_item);
     ARRAY_APPEND(p_playlist->all_items, p_item);
+    playlist_IndexAdd( p_playlist, p_item );
 
     if( i_pos == PLAYLIST_END )
         playlist_NodeAppend( p_playlist, p_item, p_node );
@@ -940,6 +943,7 @@ static int DeleteInner( playlist_t * p_playlist, playlist_item_t *p_item,
     ARRAY_BSEARCH( p_playlist->all_items,->i_id, int, i_id, i );
     if( i != -1 )
         ARRAY_REMOVE( p_playlist->all_items, i );
+    playlist_IndexRemove( p_playlist, p_item );
 
     ARRAY_BSEARCH( p_playlist->items,->i_id, int, i_id, i );
     if( i != -1 )
@@ -30,9 +30,12 @@
 #include "playlist_internal.h"
 #include "config/configuration.h"
 #include <vlc_charset.h>
+#include <vlc_block.h>
+#include <vlc_rand.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 
@@ -92,6 +95,546 @@ int playlist_Export( playlist_t * p_playlist, const char *psz_filename ,
     return i_ret;
 }
 
+/*****************************************************************************
+ * Media library snapshot
+ *****************************************************************************
+ * Next to ml.xspf, which is kept for the other programs and as a fallback,
+ * the media library is saved as a binary snapshot that is mapped and turned
+ * into playlist items directly, without going through the demuxers and the
+ * XML parser. It is made of a header, the tree in preorder, the meta data
+ * and options of its entries, and a pool of the (shared) strings; all the
+ * sizes are multiples of 8 so the tables can be used where they are mapped.
+ * The snapshot is only meant for the machine that wrote it.
+ *****************************************************************************/
+#define ML_SNAPSHOT_MAGIC     "VLCMLSNP"
+#define ML_SNAPSHOT_VERSION   1
+#define ML_SNAPSHOT_MAX_DEPTH 64
+
+typedef struct
+{
+    char     magic[8];
+    uint32_t i_version;
+    uint32_t i_entries;
+    uint32_t i_metas;
+    uint32_t i_options;
+    uint64_t i_strings;         /* size of the string pool */
+    uint64_t i_xspf_size;       /* of the ml.xspf saved with the snapshot */
+    int64_t  i_xspf_mtime;
+} ml_snapshot_header_t;
+
+typedef struct
+{
+    int32_t  i_children;        /* -1 for an item */
+    uint32_t i_type;
+    int64_t  i_duration;
+    uint32_t i_name;            /* offsets in the string pool, 0 for none */
+    uint32_t i_uri;
+    uint32_t i_metas;           /* number of meta data and options, which */
+    uint32_t i_options;         /* follow those of the previous entries */
+    uint32_t i_status;          /* of the meta data */
+    uint32_t i_reserved;
+} ml_snapshot_entry_t;
+
+typedef struct
+{
+    uint32_t i_type;
+    uint32_t i_value;
+} ml_snapshot_meta_t;
+
+typedef struct
+{
+    uint32_t i_value;
+    uint32_t i_flags;
+} ml_snapshot_option_t;
+
+typedef struct
+{
+    const ml_snapshot_entry_t  *p_entries;
+    const ml_snapshot_meta_t   *p_metas;
+    const ml_snapshot_option_t *p_options;
+    const char                 *p_strings;
+    uint32_t i_entries, i_metas, i_options;
+    uint64_t i_strings;
+
+    uint32_t i_entry, i_meta, i_option;     /* read positions */
+} ml_snapshot_t;
+
+static char *MLSnapshotName( const char *psz_datadir )
+{
+    char *psz_name;
+
+    if( asprintf( &psz_name, "%s" DIR_SEP "ml.snapshot", psz_datadir ) == -1 )
+        return NULL;
+    return psz_name;
+}
+
+static const char *MLSnapshotString( const ml_snapshot_t *p_snap,
+                                     uint32_t i_offset )
+{
+    return i_offset ? p_snap->p_strings + i_offset : NULL;
+}
+
+/* Checks every offset and count, and the shape of the tree, so that the
+ * snapshot can then be read without any further check */
+static bool MLSnapshotCheck( const ml_snapshot_t *p_snap )
+{
+    uint32_t pi_left[ML_SNAPSHOT_MAX_DEPTH];
+    uint64_t i_metas = 0, i_options = 0;
+    int i_depth = 0;
+
+    if( p_snap->i_entries == 0 || p_snap->i_strings == 0 ||
+        p_snap->p_strings[p_snap->i_strings - 1] != '\0' ||
+        p_snap->p_entries[0].i_children < 0 )
+        return false;
+
+    pi_left[0] = 1;
+    for( uint32_t i = 0; i < p_snap->i_entries; i++ )
+    {
+        const ml_snapshot_entry_t *p_entry = &p_snap->p_entries[i];
+
+        while( i_depth > 0 && pi_left[i_depth] == 0 )
+            i_depth--;
+        if( pi_left[i_depth] == 0 )
+            return false;       /* more entries than the tree has */
+        pi_left[i_depth]--;
+
+        if( p_entry->i_name >= p_snap->i_strings ||
+            p_entry->i_uri >= p_snap->i_strings )
+            return false;
+        for( uint32_t j = 0; j < p_entry->i_metas; j++ )
+        {
+            const ml_snapshot_meta_t *p_meta = &p_snap->p_metas[i_metas + j];
+            if( i_metas + j >= p_snap->i_metas ||
+                p_meta->i_type >= VLC_META_TYPE_COUNT ||
+                p_meta->i_value >= p_snap->i_strings )
+                return false;
+        }
+        i_metas += p_entry->i_metas;
+        for( uint32_t j = 0; j < p_entry->i_options; j++ )
+            if( i_options + j >= p_snap->i_options ||
+                p_snap->p_options[i_options + j].i_value == 0 ||
+                p_snap->p_options[i_options + j].i_value >= p_snap->i_strings )
+                return false;
+        i_options += p_entry->i_options;
+
+        if( p_entry->i_children > 0 )
+        {
+            if( ++i_depth >= ML_SNAPSHOT_MAX_DEPTH )
+                return false;
+            pi_left[i_depth] = p_entry->i_children;
+        }
+    }
+    while( i_depth > 0 && pi_left[i_depth] == 0 )
+        i_depth--;
+    return pi_left[i_depth] == 0 && i_metas == p_snap->i_metas &&
+           i_options == p_snap->i_options;
+}
+
+static input_item_t *MLSnapshotInput( playlist_t *p_playlist,
+                                      ml_snapshot_t *p_snap,
+                                      const ml_snapshot_entry_t *p_entry )
+{
+    const ml_snapshot_meta_t *p_metas = &p_snap->p_metas[p_snap->i_meta];
+    const ml_snapshot_option_t *p_options =
+                                    &p_snap->p_options[p_snap->i_option];
+    input_item_t *p_input;
+
+    p_snap->i_meta += p_entry->i_metas;
+    p_snap->i_option += p_entry->i_options;
+
+    p_input = input_item_NewWithType( VLC_OBJECT(p_playlist),
+                                      MLSnapshotString( p_snap, p_entry->i_uri ),
+                                      MLSnapshotString( p_snap, p_entry->i_name ),
+                                      0, NULL, p_entry->i_duration,
+                                      p_entry->i_type );
+    if( !p_input )
+        return NULL;
+
+    for( uint32_t i = 0; i < p_entry->i_options; i++ )
+        input_item_AddOpt( p_input,
+                           MLSnapshotString( p_snap, p_options[i].i_value ),
+                           p_options[i].i_flags );
+
+    /* Nobody knows about this item yet, no need to send the events */
+    if( p_entry->i_metas > 0 || p_entry->i_status )
+    {
+        if( !p_input->p_meta )
+            p_input->p_meta = vlc_meta_New();
+        if( p_input->p_meta )
+        {
+            for( uint32_t i = 0; i < p_entry->i_metas; i++ )
+                vlc_meta_Set( p_input->p_meta, p_metas[i].i_type,
+                              MLSnapshotString( p_snap, p_metas[i].i_value ) );
+            p_input->p_meta->i_status = p_entry->i_status;
+        }
+    }
+    return p_input;
+}
+
+/* Adds the next i_count entries (and their children) to a node */
+static void MLSnapshotBuild( playlist_t *p_playlist, ml_snapshot_t *p_snap,
+                             playlist_item_t *p_parent, int i_count )
+{
+    PL_ASSERT_LOCKED;
+
+    for( int i = 0; i < i_count; i++ )
+    {
+        const ml_snapshot_entry_t *p_entry =
+                                    &p_snap->p_entries[p_snap->i_entry++];
+        input_item_t *p_input = MLSnapshotInput( p_playlist, p_snap, p_entry );
+        playlist_item_t *p_node = NULL;
+
+        if( p_entry->i_children >= 0 )
+        {
+            /* Like an XSPF node, which is turned into a node of the
+             * category tree only, with its children in both trees */
+            if( p_input )
+                p_node = playlist_NodeCreate( p_playlist, p_input->psz_name,
+                                              p_parent, 0, p_input );
+            MLSnapshotBuild( p_playlist, p_snap, p_node ? p_node : p_parent,
+                             p_entry->i_children );
+        }
+        else if( p_input && p_parent == p_playlist->p_ml_category )
+            playlist_AddInput( p_playlist, p_input, PLAYLIST_APPEND,
+                               PLAYLIST_END, false, pl_Locked );
+        else if( p_input )
+            playlist_BothAddInput( p_playlist, p_input, p_parent,
+                                   PLAYLIST_APPEND, PLAYLIST_END,
+                                   NULL, NULL, pl_Locked );
+        if( p_input )
+            vlc_gc_decref( p_input );
+    }
+}
+
+/* Loads the snapshot saved with the given ml.xspf, if it is still there */
+static int MLSnapshotLoad( playlist_t *p_playlist, const char *psz_datadir,
+                           const struct stat *p_xspf )
+{
+    ml_snapshot_header_t header;
+    ml_snapshot_t snap;
+    block_t *p_block;
+    uint64_t i_size;
+    char *psz_name;
+    int fd;
+
+    psz_name = MLSnapshotName( psz_datadir );
+    if( !psz_name )
+        return VLC_ENOMEM;
+    fd = utf8_open( psz_name, O_RDONLY, 0 );
+    if( fd == -1 )
+    {
+        free( psz_name );
+        return VLC_EGENERIC;
+    }
+    p_block = block_File( fd );
+    close( fd );
+    if( !p_block )
+    {
+        free( psz_name );
+        return VLC_EGENERIC;
+    }
+
+    if( p_block->i_buffer < sizeof( header ) )
+        goto error;
+    memcpy( &header, p_block->p_buffer, sizeof( header ) );
+    if( memcmp( header.magic, ML_SNAPSHOT_MAGIC, 8 ) ||
+        header.i_version != ML_SNAPSHOT_VERSION )
+        goto error;
+    if( header.i_xspf_size != (uint64_t)p_xspf->st_size ||
+        header.i_xspf_mtime != (int64_t)p_xspf->st_mtime )
+    {
+        msg_Dbg( p_playlist, "%s does not match the media library",
+                 psz_name );
+        goto error;
+    }
+    i_size = sizeof( header ) +
+             (uint64_t)header.i_entries * sizeof( ml_snapshot_entry_t ) +
+             (uint64_t)header.i_metas * sizeof( ml_snapshot_meta_t ) +
+             (uint64_t)header.i_options * sizeof( ml_snapshot_option_t );
+    if( header.i_strings > p_block->i_buffer ||
+        i_size + header.i_strings != p_block->i_buffer )
+        goto error;
+
+    snap.i_entries = header.i_entries;
+    snap.i_metas = header.i_metas;
+    snap.i_options = header.i_options;
+    snap.i_strings = header.i_strings;
+    snap.p_entries = (const ml_snapshot_entry_t *)
+                     (p_block->p_buffer + sizeof( header ));
+    snap.p_metas = (const ml_snapshot_meta_t *)
+                   (snap.p_entries + snap.i_entries);
+    snap.p_options = (const ml_snapshot_option_t *)
+                     (snap.p_metas + snap.i_metas);
+    snap.p_strings = (const char *)(snap.p_options + snap.i_options);
+    if( !MLSnapshotCheck( &snap ) )
+    {
+        msg_Warn( p_playlist, "%s is corrupt", psz_name );
+        goto error;
+    }
+
+    /* The first entry is the media library itself */
+    snap.i_entry = 1;
+    snap.i_meta = snap.p_entries[0].i_metas;
+    snap.i_option = snap.p_entries[0].i_options;
+
+    PL_LOCK;
+    p_playlist->b_doing_ml = true;
+    MLSnapshotBuild( p_playlist, &snap, p_playlist->p_ml_category,
+                     snap.p_entries[0].i_children );
+    p_playlist->b_doing_ml = false;
+    PL_UNLOCK;
+
+    msg_Dbg( p_playlist, "loaded %u media library entries from %s",
+             snap.i_entries - 1, psz_name );
+    block_Release( p_block );
+    free( psz_name );
+    return VLC_SUCCESS;
+
+error:
+    block_Release( p_block );
+    free( psz_name );
+    return VLC_EGENERIC;
+}
+
+typedef struct
+{
+    DECL_ARRAY(ml_snapshot_entry_t)  entries;
+    DECL_ARRAY(ml_snapshot_meta_t)   metas;
+    DECL_ARRAY(ml_snapshot_option_t) options;
+
+    char             *p_strings;
+    uint64_t         i_strings;
+    uint64_t         i_strings_alloc;
+    vlc_dictionary_t pool;          /* string -> offset in p_strings */
+
+    bool             b_error;
+} ml_snapshot_writer_t;
+
+/* Returns the offset of a string in the pool, adding it if needed */
+static uint32_t MLSnapshotPool( ml_snapshot_writer_t *p_writer,
+                                const char *psz )
+{
+    void *p_offset;
+    size_t i_len;
+
+    if( !psz )
+        return 0;
+    p_offset = vlc_dictionary_value_for_key( &p_writer->pool, psz );
+    if( p_offset )
+        return (uintptr_t)p_offset;
+
+    i_len = strlen( psz ) + 1;
+    if( p_writer->i_strings + i_len > p_writer->i_strings_alloc )
+    {
+        uint64_t i_alloc = __MAX( 2 * p_writer->i_strings_alloc,
+                                  p_writer->i_strings + i_len );
+        char *p_strings = i_alloc <= UINT32_MAX ?
+                          realloc( p_writer->p_strings, i_alloc ) : NULL;
+        if( !p_strings )
+        {
+            p_writer->b_error = true;
+            return 0;
+        }
+        p_writer->p_strings = p_strings;
+        p_writer->i_strings_alloc = i_alloc;
+    }
+    memcpy( p_writer->p_strings + p_writer->i_strings, psz, i_len );
+    p_offset = (void *)(uintptr_t)p_writer->i_strings;
+    p_writer->i_strings += i_len;
+    vlc_dictionary_insert( &p_writer->pool, psz, p_offset );
+    return (uintptr_t)p_offset;
+}
+
+static void MLSnapshotAdd( ml_snapshot_writer_t *p_writer,
+                           playlist_item_t *p_item, int i_depth )
+{
+    input_item_t *p_input = p_item->p_input;
+    ml_snapshot_entry_t entry;
+
+    if( i_depth >= ML_SNAPSHOT_MAX_DEPTH )
+    {
+        p_writer->b_error = true;
+        return;
+    }
+
+    memset( &entry, 0, sizeof( entry ) );
+    entry.i_children = p_item->i_children;
+
+    vlc_mutex_lock( &p_input->lock );
+    entry.i_type = p_input->i_type;
+    entry.i_duration = p_input->i_duration;
+    entry.i_name = MLSnapshotPool( p_writer, p_input->psz_name );
+    entry.i_uri = MLSnapshotPool( p_writer, p_input->psz_uri );
+    if( p_input->p_meta )
+    {
+        for( int i = 0; i < VLC_META_TYPE_COUNT; i++ )
+        {
+            const char *psz = vlc_meta_Get( p_input->p_meta, i );
+            ml_snapshot_meta_t meta;
+
+            if( !psz )
+                continue;
+            meta.i_type = i;
+            meta.i_value = MLSnapshotPool( p_writer, psz );
+            ARRAY_APPEND( p_writer->metas, meta );
+            entry.i_metas++;
+        }
+        entry.i_status = p_input->p_meta->i_status;
+    }
+    for( int i = 0; i < p_input->i_options; i++ )
+    {
+        ml_snapshot_option_t option;
+
+        option.i_value = MLSnapshotPool( p_writer, p_input->ppsz_options[i] );
+        option.i_flags = (unsigned)i < p_input->optflagc ?
+                         p_input->optflagv[i] : 0;
+        ARRAY_APPEND( p_writer->options, option );
+        entry.i_options++;
+    }
+    vlc_mutex_unlock( &p_input->lock );
+    ARRAY_APPEND( p_writer->entries, entry );
+
+    for( int i = 0; i < p_item->i_children; i++ )
+        MLSnapshotAdd( p_writer, p_item->pp_children[i], i_depth + 1 );
+}
+
+/* Creates a new temporary file next to the snapshot: the snapshot may be
+ * mapped by a concurrent load, so it is only ever replaced by rename() */
+static FILE *MLSnapshotCreate( const char *psz_name, char **ppsz_tmp )
+{
+    for( int i = 0; i < 16; i++ )
+    {
+        uint32_t i_rand;
+        int fd, i_errno;
+
+        vlc_rand_bytes( &i_rand, sizeof( i_rand ) );
+        if( asprintf( ppsz_tmp, "%s.%08"PRIx32".tmp", psz_name, i_rand ) == -1 )
+            break;
+
+        fd = utf8_open( *ppsz_tmp, O_WRONLY | O_CREAT | O_EXCL, 0600 );
+        if( fd != -1 )
+        {
+            FILE *file = fdopen( fd, "wb" );
+            if( file != NULL )
+                return file;
+            close( fd );
+            utf8_unlink( *ppsz_tmp );
+        }
+        i_errno = errno;
+        free( *ppsz_tmp );
+        if( fd != -1 || i_errno != EEXIST )
+        {
+            errno = i_errno;
+            break;
+        }
+    }
+    *ppsz_tmp = NULL;
+    return NULL;
+}
+
+static int MLSnapshotSave( playlist_t *p_playlist, const char *psz_datadir,
+                           const char *psz_xspf )
+{
+    static const char pad[8];
+    ml_snapshot_writer_t writer;
+    ml_snapshot_header_t header;
+    struct stat st;
+    char *psz_name, *psz_tmp = NULL;
+    FILE *file = NULL;
+    int i_ret = VLC_EGENERIC;
+
+    if( utf8_stat( psz_xspf, &st ) )
+        return VLC_EGENERIC;
+    psz_name = MLSnapshotName( psz_datadir );
+    if( !psz_name )
+        return VLC_ENOMEM;
+
+    ARRAY_INIT( writer.entries );
+    ARRAY_INIT( writer.metas );
+    ARRAY_INIT( writer.options );
+    writer.p_strings = NULL;
+    writer.i_strings = writer.i_strings_alloc = 0;
+    vlc_dictionary_init( &writer.pool, 4096 );
+    writer.b_error = false;
+
+    /* Offset 0 stands for no string */
+    writer.p_strings = malloc( 4096 );
+    if( !writer.p_strings )
+        writer.b_error = true;
+    else
+    {
+        writer.p_strings[0] = '\0';
+        writer.i_strings = 1;
+        writer.i_strings_alloc = 4096;
+    }
+
+    vlc_object_lock( p_playlist );
+    if( !writer.b_error )
+        MLSnapshotAdd( &writer, p_playlist->p_ml_category, 0 );
+    vlc_object_unlock( p_playlist );
+    if( writer.b_error )
+    {
+        msg_Warn( p_playlist, "cannot save the media library snapshot" );
+        goto out;
+    }
+
+    memset( &header, 0, sizeof( header ) );
+    memcpy( header.magic, ML_SNAPSHOT_MAGIC, 8 );
+    header.i_version = ML_SNAPSHOT_VERSION;
+    header.i_entries = writer.entries.i_size;
+    header.i_metas = writer.metas.i_size;
+    header.i_options = writer.options.i_size;
+    header.i_strings = ( writer.i_strings + 7 ) & ~UINT64_C(7);
+    header.i_xspf_size = st.st_size;
+    header.i_xspf_mtime = st.st_mtime;
+
+    file = MLSnapshotCreate( psz_name, &psz_tmp );
+    if( !file )
+    {
+        msg_Warn( p_playlist, "cannot create %s (%m)", psz_name );
+        goto out;
+    }
+    if( fwrite( &header, sizeof( header ), 1, file ) != 1 ||
+        fwrite( writer.entries.p_elems, sizeof( ml_snapshot_entry_t ),
+                header.i_entries, file ) != header.i_entries ||
+        fwrite( writer.metas.p_elems, sizeof( ml_snapshot_meta_t ),
+                header.i_metas, file ) != header.i_metas ||
+        fwrite( writer.options.p_elems, sizeof( ml_snapshot_option_t ),
+                header.i_options, file ) != header.i_options ||
+        fwrite( writer.p_strings, writer.i_strings, 1, file ) != 1 ||
+        ( header.i_strings > writer.i_strings &&
+          fwrite( pad, header.i_strings - writer.i_strings, 1, file ) != 1 ) )
+    {
+        msg_Warn( p_playlist, "cannot write %s (%m)", psz_tmp );
+        fclose( file );
+        utf8_unlink( psz_tmp );
+        goto out;
+    }
+    if( fclose( file ) )
+    {
+        msg_Warn( p_playlist, "cannot write %s (%m)", psz_tmp );
+        utf8_unlink( psz_tmp );
+        goto out;
+    }
+    if( utf8_rename( psz_tmp, psz_name ) )
+    {
+        msg_Warn( p_playlist, "cannot replace %s (%m)", psz_name );
+        utf8_unlink( psz_tmp );
+        goto out;
+    }
+    i_ret = VLC_SUCCESS;
+
+out:
+    free( psz_tmp );
+    ARRAY_RESET( writer.entries );
+    ARRAY_RESET( writer.metas );
+    ARRAY_RESET( writer.options );
+    free( writer.p_strings );
+    vlc_dictionary_clear( &writer.pool );
+    free( psz_name );
+    return i_ret;
+}
+
 /*****************************************************************************
  * A subitem has been added to the Media Library (Event Callback)
  *****************************************************************************/
@@ -112,6 +655,7 @@ int playlist_MLLoad( playlist_t *p_playlist )
     char *psz_datadir = config_GetUserDataDir();
     char *psz_uri = NULL;
     input_item_t *p_input;
+    int i_ret;
 
     if( !config_GetInt( p_playlist, "media-library") ) return VLC_SUCCESS;
     if( !psz_datadir ) /* XXX: This should never happen */
@@ -130,6 +674,16 @@ int playlist_MLLoad( playlist_t *p_playlist )
     if( utf8_stat( psz_uri , &p_stat ) )
         goto error;
     free( psz_uri );
+    psz_uri = NULL;
+
+    stats_TimerStart( p_playlist, "ML Load", STATS_TIMER_ML_LOAD );
+    i_ret = MLSnapshotLoad( p_playlist, psz_datadir, &p_stat );
+    stats_TimerStop( p_playlist, STATS_TIMER_ML_LOAD );
+    if( i_ret == VLC_SUCCESS )
+    {
+        free( psz_datadir );
+        return VLC_SUCCESS;
+    }
 
     /* FIXME: WTF? stat() should never be used right before open()! */
     if( asprintf( &psz_uri, "file/xspf-open://%s" DIR_SEP "ml.xspf",
@@ -200,18 +754,20 @@ int playlist_MLDump( playlist_t *p_playlist )
 
     char psz_dirname[ strlen( psz_datadir ) + sizeof( DIR_SEP "ml.xspf")];
     strcpy( psz_dirname, psz_datadir );
-    free( psz_datadir );
     if( config_CreateDir( (vlc_object_t *)p_playlist, psz_dirname ) )
     {
+        free( psz_datadir );
         return VLC_EGENERIC;
     }
 
     strcat( psz_dirname, DIR_SEP "ml.xspf" );
 
     stats_TimerStart( p_playlist, "ML Dump", STATS_TIMER_ML_DUMP );
-    playlist_Export( p_playlist, psz_dirname, p_playlist->p_ml_category,
-                     "export-xspf" );
+    if( playlist_Export( p_playlist, psz_dirname, p_playlist->p_ml_category,
+                         "export-xspf" ) == VLC_SUCCESS )
+        MLSnapshotSave( p_playlist, psz_datadir, psz_dirname );
     stats_TimerStop( p_playlist, STATS_TIMER_ML_DUMP );
+    free( psz_datadir );
 
     return VLC_SUCCESS;
 }
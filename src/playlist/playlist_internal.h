@@ -35,14 +35,38 @@
  */
 
 #include "input/input_internal.h"
+#include <vlc_jobs.h>
 #include <assert.h>
 
+/* An item waiting for the preparser or the fetcher */
+typedef struct
+{
+    input_item_t    *p_item;
+    mtime_t         i_date;         /* when it was queued */
+} playlist_waiting_t;
+
+/* Items waiting for the preparser or the fetcher, protected by the object
+ * lock of their owner. Each item queued submits one job, which runs the
+ * first waiting item on the worker threads. An item is only queued once,
+ * and the items shown to the user are run before the others. */
+typedef struct
+{
+    int                 i_waiting;
+    playlist_waiting_t  *p_waiting;
+    int                 i_visible;  /* the first i_visible are shown */
+    job_queue_t         *p_jobs;
+
+    /* statistics */
+    unsigned            i_done;
+    mtime_t             i_delay;    /* total time spent waiting */
+    mtime_t             i_delay_max;
+} playlist_queue_t;
+
 struct playlist_preparse_t
 {
     VLC_COMMON_MEMBERS
     vlc_mutex_t     lock;
-    int             i_waiting;
-    input_item_t  **pp_waiting;
+    playlist_queue_t queue;
 };
 
 struct playlist_fetcher_t
@@ -50,8 +74,7 @@ struct playlist_fetcher_t
     VLC_COMMON_MEMBERS
     vlc_mutex_t     lock;
     int             i_art_policy;
-    int             i_waiting;
-    input_item_t    **pp_waiting;
+    playlist_queue_t queue;
 
     DECL_ARRAY(playlist_album_t) albums;
 };
@@ -73,8 +96,19 @@ playlist_t *playlist_Create   ( vlc_object_t * );
 /* Engine */
 void playlist_MainLoop( playlist_t * );
 void playlist_LastLoop( playlist_t * );
-void playlist_PreparseLoop( playlist_preparse_t * );
-void playlist_FetcherLoop( playlist_fetcher_t * );
+int  playlist_QueueNew( vlc_object_t *, playlist_queue_t *, unsigned );
+void playlist_QueueDelete( vlc_object_t *, playlist_queue_t * );
+int  playlist_QueuePush( vlc_object_t *, playlist_queue_t *, input_item_t *,
+                         bool b_visible, void (*pf_run)( void * ) );
+void playlist_PreparseRun( void * );
+void playlist_FetcherRun( void * );
+
+/* Search index */
+playlist_index_t *playlist_IndexNew( void );
+void playlist_IndexDelete( playlist_index_t * );
+void playlist_IndexAdd( playlist_t *, playlist_item_t * );
+void playlist_IndexRemove( playlist_t *, playlist_item_t * );
+void playlist_IndexChanged( playlist_t *, input_item_t * );
 
 void ResetCurrentlyPlaying( playlist_t *, bool, playlist_item_t * );
 
@@ -29,6 +29,437 @@
 #include "vlc_playlist.h"
 #include "playlist_internal.h"
 
+/***************************************************************************
+ * Search index
+ ***************************************************************************/
+
+/* The index maps the input ids to their playlist items, and the
+ * case-folded trigrams of the names, albums and artists to the inputs that
+ * contain them. A search only looks at the inputs that have every trigram
+ * of the string, and still matches them with the exact tests of the live
+ * search, so the results do not change. Strings shorter than a trigram or
+ * with non ASCII characters, which do not fold bytewise, are not indexed
+ * and fall back to the full walk.
+ *
+ * Everything is protected by the playlist lock, except the list of the
+ * inputs whose meta data changed, which is filled by the input item event
+ * callbacks and indexed again by the next search. Posting lists are only
+ * appended to; the stale entries are skipped, and dropped once they make
+ * up a third of the index. */
+
+TYPEDEF_ARRAY(uint32_t, index_grams_t)
+TYPEDEF_ARRAY(int, index_ids_t)
+
+typedef struct
+{
+    DECL_ARRAY(playlist_item_t *) items;    /* of this input */
+    uint32_t *pi_grams;                     /* sorted */
+    int       i_grams;
+} index_input_t;
+
+struct playlist_index_t
+{
+    vlc_dictionary_t inputs;    /* input id -> index_input_t */
+    vlc_dictionary_t grams;     /* trigram -> index_ids_t */
+    int              i_postings;
+    int              i_stale;
+
+    vlc_mutex_t      lock;
+    index_ids_t      changed;   /* ids of the inputs to index again */
+};
+
+static int IndexCompareGram( const void *a, const void *b )
+{
+    uint32_t i_a = *(const uint32_t *)a, i_b = *(const uint32_t *)b;
+    return i_a < i_b ? -1 : i_a > i_b;
+}
+
+static int IndexCompareId( const void *a, const void *b )
+{
+    int i_a = *(const int *)a, i_b = *(const int *)b;
+    return i_a < i_b ? -1 : i_a > i_b;
+}
+
+static void IndexInputKey( char *psz_key, int i_id )
+{
+    sprintf( psz_key, "%d", i_id );
+}
+
+static void IndexGramKey( char *psz_key, uint32_t i_gram )
+{
+    psz_key[0] = i_gram >> 16;
+    psz_key[1] = i_gram >> 8;
+    psz_key[2] = i_gram;
+    psz_key[3] = '\0';
+}
+
+/* Appends the trigrams of a string; returns false if it has non ASCII
+ * characters, whose trigrams are skipped */
+static bool IndexStringGrams( index_grams_t *p_grams, const char *psz )
+{
+    bool b_ascii = true;
+    uint32_t i_gram = 0;
+    int i_len = 0;
+
+    for( ; psz && *psz; psz++ )
+    {
+        uint8_t c = *psz;
+
+        if( c >= 0x80 )
+        {
+            b_ascii = false;
+            i_len = 0;
+            continue;
+        }
+        if( c >= 'A' && c <= 'Z' )
+            c += 'a' - 'A';
+        i_gram = ( ( i_gram << 8 ) | c ) & 0xffffff;
+        if( ++i_len >= 3 )
+            ARRAY_APPEND( (*p_grams), i_gram );
+    }
+    return b_ascii;
+}
+
+/* Sorts the trigrams and drops the duplicates */
+static void IndexSortGrams( index_grams_t *p_grams )
+{
+    int i_count = 0;
+
+    if( p_grams->i_size == 0 )
+        return;
+    qsort( p_grams->p_elems, p_grams->i_size, sizeof( uint32_t ),
+           IndexCompareGram );
+    for( int i = 1; i < p_grams->i_size; i++ )
+        if( p_grams->p_elems[i] != p_grams->p_elems[i_count] )
+            p_grams->p_elems[++i_count] = p_grams->p_elems[i];
+    p_grams->i_size = i_count + 1;
+}
+
+/* Computes the trigrams of an input; the old ones are left to the caller */
+static void IndexInputGrams( index_input_t *p_entry )
+{
+    input_item_t *p_input = ARRAY_VAL( p_entry->items, 0 )->p_input;
+    index_grams_t grams;
+    char *psz;
+
+    ARRAY_INIT( grams );
+    psz = input_item_GetName( p_input );
+    IndexStringGrams( &grams, psz );
+    free( psz );
+    psz = input_item_GetMeta( p_input, vlc_meta_Album );
+    IndexStringGrams( &grams, psz );
+    free( psz );
+    psz = input_item_GetMeta( p_input, vlc_meta_Artist );
+    IndexStringGrams( &grams, psz );
+    free( psz );
+    IndexSortGrams( &grams );
+
+    p_entry->pi_grams = grams.p_elems;
+    p_entry->i_grams = grams.i_size;
+}
+
+static bool IndexHasGram( const uint32_t *pi_grams, int i_grams,
+                          uint32_t i_gram )
+{
+    return i_grams > 0 &&
+           bsearch( &i_gram, pi_grams, i_grams, sizeof( uint32_t ),
+                    IndexCompareGram ) != NULL;
+}
+
+static void IndexPost( playlist_index_t *p_index, uint32_t i_gram, int i_id )
+{
+    index_ids_t *p_posting;
+    char psz_key[4];
+
+    IndexGramKey( psz_key, i_gram );
+    p_posting = vlc_dictionary_value_for_key( &p_index->grams, psz_key );
+    if( !p_posting )
+    {
+        p_posting = malloc( sizeof( *p_posting ) );
+        if( !p_posting )
+            return;
+        ARRAY_INIT( (*p_posting) );
+        vlc_dictionary_insert( &p_index->grams, psz_key, p_posting );
+    }
+    ARRAY_APPEND( (*p_posting), i_id );
+    p_index->i_postings++;
+}
+
+static void IndexClearGrams( playlist_index_t *p_index )
+{
+    vlc_dictionary_t *p_dict = &p_index->grams;
+
+    for( int i = 0; i < p_dict->i_size; i++ )
+        for( struct vlc_dictionary_entry_t *p_dentry = p_dict->p_entries[i];
+             p_dentry; p_dentry = p_dentry->p_next )
+        {
+            index_ids_t *p_posting = p_dentry->p_value;
+            ARRAY_RESET( (*p_posting) );
+            free( p_posting );
+        }
+    vlc_dictionary_clear( p_dict );
+    p_index->i_postings = p_index->i_stale = 0;
+}
+
+/* Builds the posting lists again, without the stale entries */
+static void IndexCompact( playlist_index_t *p_index )
+{
+    vlc_dictionary_t *p_dict = &p_index->inputs;
+
+    IndexClearGrams( p_index );
+    vlc_dictionary_init( &p_index->grams, 1024 );
+    for( int i = 0; i < p_dict->i_size; i++ )
+        for( struct vlc_dictionary_entry_t *p_dentry = p_dict->p_entries[i];
+             p_dentry; p_dentry = p_dentry->p_next )
+        {
+            index_input_t *p_entry = p_dentry->p_value;
+            int i_id = ARRAY_VAL( p_entry->items, 0 )->p_input->i_id;
+
+            for( int j = 0; j < p_entry->i_grams; j++ )
+                IndexPost( p_index, p_entry->pi_grams[j], i_id );
+        }
+}
+
+/* Indexes the inputs whose meta data changed again */
+static void IndexUpdate( playlist_index_t *p_index )
+{
+    index_ids_t changed;
+
+    vlc_mutex_lock( &p_index->lock );
+    changed = p_index->changed;
+    ARRAY_INIT( p_index->changed );
+    vlc_mutex_unlock( &p_index->lock );
+
+    FOREACH_ARRAY( int i_id, changed )
+        index_input_t *p_entry;
+        uint32_t *pi_old;
+        int i_old;
+        char psz_key[16];
+
+        IndexInputKey( psz_key, i_id );
+        p_entry = vlc_dictionary_value_for_key( &p_index->inputs, psz_key );
+        if( !p_entry )
+            continue;
+        pi_old = p_entry->pi_grams;
+        i_old = p_entry->i_grams;
+        IndexInputGrams( p_entry );
+
+        for( int i = 0; i < p_entry->i_grams; i++ )
+            if( !IndexHasGram( pi_old, i_old, p_entry->pi_grams[i] ) )
+                IndexPost( p_index, p_entry->pi_grams[i], i_id );
+        for( int i = 0; i < i_old; i++ )
+            if( !IndexHasGram( p_entry->pi_grams, p_entry->i_grams,
+                               pi_old[i] ) )
+                p_index->i_stale++;
+        free( pi_old );
+    FOREACH_END();
+    ARRAY_RESET( changed );
+
+    if( p_index->i_stale > 4096 && p_index->i_stale > p_index->i_postings / 3 )
+        IndexCompact( p_index );
+}
+
+/* Finds the inputs that may match a string.
+ * \return the number of candidates, whose sorted ids are stored in
+ * *ppi_ids, or -1 if the index cannot be used for this string */
+static int IndexSearch( playlist_index_t *p_index, const char *psz_string,
+                        int **ppi_ids )
+{
+    index_grams_t query;
+    index_ids_t *p_rarest = NULL;
+    int *pi_ids, i_ids = 0;
+
+    ARRAY_INIT( query );
+    if( !IndexStringGrams( &query, psz_string ) || query.i_size == 0 )
+    {
+        ARRAY_RESET( query );
+        return -1;
+    }
+    IndexSortGrams( &query );
+    IndexUpdate( p_index );
+
+    /* Only the inputs of the shortest posting list can match */
+    FOREACH_ARRAY( uint32_t i_gram, query )
+        index_ids_t *p_posting;
+        char psz_key[4];
+
+        IndexGramKey( psz_key, i_gram );
+        p_posting = vlc_dictionary_value_for_key( &p_index->grams, psz_key );
+        if( !p_posting )
+        {
+            p_rarest = NULL;
+            break;
+        }
+        if( !p_rarest || p_posting->i_size < p_rarest->i_size )
+            p_rarest = p_posting;
+    FOREACH_END();
+
+    pi_ids = p_rarest ? malloc( p_rarest->i_size * sizeof( int ) ) : NULL;
+    if( p_rarest && !pi_ids )
+    {
+        ARRAY_RESET( query );
+        return -1;
+    }
+
+    for( int i = 0; p_rarest && i < p_rarest->i_size; i++ )
+    {
+        const int i_id = ARRAY_VAL( (*p_rarest), i );
+        index_input_t *p_entry;
+        char psz_key[16];
+        int j;
+
+        IndexInputKey( psz_key, i_id );
+        p_entry = vlc_dictionary_value_for_key( &p_index->inputs, psz_key );
+        if( !p_entry )
+            continue;
+        for( j = 0; j < query.i_size; j++ )
+            if( !IndexHasGram( p_entry->pi_grams, p_entry->i_grams,
+                               ARRAY_VAL( query, j ) ) )
+                break;
+        if( j == query.i_size )
+            pi_ids[i_ids++] = i_id;
+    }
+    ARRAY_RESET( query );
+
+    /* An input that was indexed again can be listed twice */
+    if( i_ids > 0 )
+    {
+        int i_count = 0;
+
+        qsort( pi_ids, i_ids, sizeof( int ), IndexCompareId );
+        for( int i = 1; i < i_ids; i++ )
+            if( pi_ids[i] != pi_ids[i_count] )
+                pi_ids[++i_count] = pi_ids[i];
+        i_ids = i_count + 1;
+    }
+    *ppi_ids = pi_ids;
+    return i_ids;
+}
+
+playlist_index_t *playlist_IndexNew( void )
+{
+    playlist_index_t *p_index = malloc( sizeof( *p_index ) );
+
+    if( !p_index )
+        return NULL;
+    vlc_dictionary_init( &p_index->inputs, 1024 );
+    vlc_dictionary_init( &p_index->grams, 1024 );
+    p_index->i_postings = p_index->i_stale = 0;
+    vlc_mutex_init( &p_index->lock );
+    ARRAY_INIT( p_index->changed );
+    return p_index;
+}
+
+void playlist_IndexDelete( playlist_index_t *p_index )
+{
+    vlc_dictionary_t *p_dict = &p_index->inputs;
+
+    for( int i = 0; i < p_dict->i_size; i++ )
+        for( struct vlc_dictionary_entry_t *p_dentry = p_dict->p_entries[i];
+             p_dentry; p_dentry = p_dentry->p_next )
+        {
+            index_input_t *p_entry = p_dentry->p_value;
+            ARRAY_RESET( p_entry->items );
+            free( p_entry->pi_grams );
+            free( p_entry );
+        }
+    vlc_dictionary_clear( p_dict );
+    IndexClearGrams( p_index );
+    vlc_mutex_destroy( &p_index->lock );
+    ARRAY_RESET( p_index->changed );
+    free( p_index );
+}
+
+/**
+ * Adds a playlist item to the index
+ *
+ * The playlist lock must be held.
+ */
+void playlist_IndexAdd( playlist_t *p_playlist, playlist_item_t *p_item )
+{
+    playlist_index_t *p_index = p_playlist->p_index;
+    index_input_t *p_entry;
+    char psz_key[16];
+
+    PL_ASSERT_LOCKED;
+    if( !p_index )
+        return;
+
+    IndexInputKey( psz_key, p_item->p_input->i_id );
+    p_entry = vlc_dictionary_value_for_key( &p_index->inputs, psz_key );
+    if( p_entry )
+    {
+        ARRAY_APPEND( p_entry->items, p_item );
+        return;
+    }
+
+    p_entry = malloc( sizeof( *p_entry ) );
+    if( !p_entry )
+        return;
+    ARRAY_INIT( p_entry->items );
+    ARRAY_APPEND( p_entry->items, p_item );
+    IndexInputGrams( p_entry );
+    for( int i = 0; i < p_entry->i_grams; i++ )
+        IndexPost( p_index, p_entry->pi_grams[i], p_item->p_input->i_id );
+    vlc_dictionary_insert( &p_index->inputs, psz_key, p_entry );
+}
+
+/**
+ * Removes a playlist item from the index
+ *
+ * The playlist lock must be held.
+ */
+void playlist_IndexRemove( playlist_t *p_playlist, playlist_item_t *p_item )
+{
+    playlist_index_t *p_index = p_playlist->p_index;
+    index_input_t *p_entry;
+    char psz_key[16];
+    int i;
+
+    PL_ASSERT_LOCKED;
+    if( !p_index )
+        return;
+
+    IndexInputKey( psz_key, p_item->p_input->i_id );
+    p_entry = vlc_dictionary_value_for_key( &p_index->inputs, psz_key );
+    if( !p_entry )
+        return;
+    for( i = 0; i < p_entry->items.i_size; i++ )
+        if( ARRAY_VAL( p_entry->items, i ) == p_item )
+            break;
+    if( i == p_entry->items.i_size )
+        return;
+    ARRAY_REMOVE( p_entry->items, i );
+    if( p_entry->items.i_size > 0 )
+        return;
+
+    p_index->i_stale += p_entry->i_grams;
+    vlc_dictionary_remove_value_for_key( &p_index->inputs, psz_key );
+    ARRAY_RESET( p_entry->items );
+    free( p_entry->pi_grams );
+    free( p_entry );
+}
+
+/**
+ * Marks an input whose name or meta data changed, so that it is indexed
+ * again by the next search
+ *
+ * This can be called from any thread.
+ */
+void playlist_IndexChanged( playlist_t *p_playlist, input_item_t *p_input )
+{
+    playlist_index_t *p_index = p_playlist->p_index;
+
+    if( !p_index )
+        return;
+    vlc_mutex_lock( &p_index->lock );
+    if( p_index->changed.i_size == 0 ||
+        ARRAY_VAL( p_index->changed, p_index->changed.i_size - 1 )
+            != p_input->i_id )
+        ARRAY_APPEND( p_index->changed, p_input->i_id );
+    vlc_mutex_unlock( &p_index->lock );
+}
+
 /***************************************************************************
  * Item search functions
  ***************************************************************************/
@@ -77,7 +508,17 @@ playlist_item_t * playlist_ItemGetByInput( playlist_t * p_playlist ,
         PL_UNLOCK_IF( !b_locked );
         return p_ret;
     }
-    /** \todo Check if this is always incremental and whether we can bsearch */
+    if( p_playlist->p_index )
+    {
+        index_input_t *p_entry;
+        char psz_key[16];
+
+        IndexInputKey( psz_key, p_item->i_id );
+        p_entry = vlc_dictionary_value_for_key( &p_playlist->p_index->inputs,
+                                                psz_key );
+        PL_UNLOCK_IF( !b_locked );
+        return p_entry ? ARRAY_VAL( p_entry->items, 0 ) : NULL;
+    }
     for( i =  0 ; i < p_playlist->all_items.i_size; i++ )
     {
         if( ARRAY_VAL(p_playlist->all_items, i)->p_input->i_id == p_item->i_id )
@@ -149,17 +590,24 @@ static void playlist_LiveSearchClean( playlist_item_t *p_root )
  * @return true if an item match
  */
 static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
-                                               const char *psz_string )
+                                               const char *psz_string,
+                                               const int *pi_ids, int i_ids )
 {
    int i;
    bool b_match = false;
    for( i = 0 ; i < p_root->i_children ; i ++ )
    {
         playlist_item_t *p_item = p_root->pp_children[i];
+        /* Skip the inputs the index rules out */
+        const bool b_candidate = i_ids < 0 ||
+            ( i_ids > 0 && bsearch( &p_item->p_input->i_id, pi_ids, i_ids,
+                                    sizeof( int ), IndexCompareId ) );
         if( p_item->i_children > -1 )
         {
-            if( playlist_LiveSearchUpdateInternal( p_item, psz_string ) ||
-                strcasestr( p_item->p_input->psz_name, psz_string ) )
+            if( playlist_LiveSearchUpdateInternal( p_item, psz_string,
+                                                   pi_ids, i_ids ) ||
+                ( b_candidate &&
+                  strcasestr( p_item->p_input->psz_name, psz_string ) ) )
             {
                 p_item->i_flags &= ~PLAYLIST_DBL_FLAG;
                 b_match = true;
@@ -171,9 +619,10 @@ static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
         }
         else
         {
-            if( strcasestr( p_item->p_input->psz_name, psz_string ) || /* Soon to be replaced by vlc_meta_Title */
-                input_item_MetaMatch( p_item->p_input, vlc_meta_Album, psz_string ) ||
-                input_item_MetaMatch( p_item->p_input, vlc_meta_Artist, psz_string ) )
+            if( b_candidate &&
+                ( strcasestr( p_item->p_input->psz_name, psz_string ) || /* Soon to be replaced by vlc_meta_Title */
+                  input_item_MetaMatch( p_item->p_input, vlc_meta_Album, psz_string ) ||
+                  input_item_MetaMatch( p_item->p_input, vlc_meta_Artist, psz_string ) ) )
             {
                 p_item->i_flags &= ~PLAYLIST_DBL_FLAG;
                 b_match = true;
@@ -193,7 +642,15 @@ int playlist_LiveSearchUpdate( playlist_t *p_playlist, playlist_item_t *p_root,
     PL_ASSERT_LOCKED;
     p_playlist->b_reset_currently_playing = true;
     if( *psz_string )
-        playlist_LiveSearchUpdateInternal( p_root, psz_string );
+    {
+        int *pi_ids = NULL;
+        int i_ids = -1;
+
+        if( p_playlist->p_index )
+            i_ids = IndexSearch( p_playlist->p_index, psz_string, &pi_ids );
+        playlist_LiveSearchUpdateInternal( p_root, psz_string, pi_ids, i_ids );
+        free( pi_ids );
+    }
     else
         playlist_LiveSearchClean( p_root );
     vlc_object_signal_unlocked( p_playlist );
@@ -36,8 +36,6 @@
  * Local prototypes
  *****************************************************************************/
 static void* RunControlThread   ( vlc_object_t * );
-static void* RunPreparse        ( vlc_object_t * );
-static void* RunFetcher         ( vlc_object_t * );
 static void PreparseDestructor  ( vlc_object_t * );
 static void FetcherDestructor   ( vlc_object_t * );
 
@@ -69,16 +67,15 @@ void __playlist_ThreadCreate( vlc_object_t *p_parent )
         vlc_object_release( p_playlist );
         return;
     }
-    p_playlist->p_preparse->i_waiting = 0;
-    p_playlist->p_preparse->pp_waiting = NULL;
-
     vlc_object_set_destructor( p_playlist->p_preparse, PreparseDestructor );
 
     vlc_object_attach( p_playlist->p_preparse, p_playlist );
-    if( vlc_thread_create( p_playlist->p_preparse, "preparser",
-                           RunPreparse, VLC_THREAD_PRIORITY_LOW, true ) )
+    if( playlist_QueueNew( VLC_OBJECT(p_playlist->p_preparse),
+                           &p_playlist->p_preparse->queue,
+                           __MAX( config_GetInt( p_playlist,
+                                                 "preparse-threads" ), 0 ) ) )
     {
-        msg_Err( p_playlist, "cannot spawn preparse thread" );
+        msg_Err( p_playlist, "cannot create preparse queue" );
         vlc_object_release( p_playlist->p_preparse );
         return;
     }
@@ -94,20 +91,18 @@ void __playlist_ThreadCreate( vlc_object_t *p_parent )
         vlc_object_release( p_playlist );
         return;
     }
-    p_playlist->p_fetcher->i_waiting = 0;
-    p_playlist->p_fetcher->pp_waiting = NULL;
     p_playlist->p_fetcher->i_art_policy = var_CreateGetInteger( p_playlist,
                                                                 "album-art" );
 
     vlc_object_set_destructor( p_playlist->p_fetcher, FetcherDestructor );
 
     vlc_object_attach( p_playlist->p_fetcher, p_playlist );
-    if( vlc_thread_create( p_playlist->p_fetcher,
-                           "fetcher",
-                           RunFetcher,
-                           VLC_THREAD_PRIORITY_LOW, true ) )
+    if( playlist_QueueNew( VLC_OBJECT(p_playlist->p_fetcher),
+                           &p_playlist->p_fetcher->queue,
+                           __MAX( config_GetInt( p_playlist,
+                                                 "fetch-threads" ), 0 ) ) )
     {
-        msg_Err( p_playlist, "cannot spawn secondary preparse thread" );
+        msg_Err( p_playlist, "cannot create secondary preparse queue" );
         vlc_object_release( p_playlist->p_fetcher );
         return;
     }
@@ -169,34 +164,16 @@ static void* RunControlThread ( vlc_object_t *p_this )
 /*****************************************************************************
  * Preparse-specific functions
  *****************************************************************************/
-static void* RunPreparse ( vlc_object_t *p_this )
-{
-    playlist_preparse_t *p_obj = (playlist_preparse_t*)p_this;
-    /* Tell above that we're ready */
-    vlc_thread_ready( p_obj );
-    playlist_PreparseLoop( p_obj );
-    return NULL;
-}
-
-static void* RunFetcher( vlc_object_t *p_this )
-{
-    playlist_fetcher_t *p_obj = (playlist_fetcher_t *)p_this;
-    /* Tell above that we're ready */
-    vlc_thread_ready( p_obj );
-    playlist_FetcherLoop( p_obj );
-    return NULL;
-}
-
 static void PreparseDestructor( vlc_object_t * p_this )
 {
     playlist_preparse_t * p_preparse = (playlist_preparse_t *)p_this;
-    free( p_preparse->pp_waiting );
+    free( p_preparse->queue.p_waiting );
     msg_Dbg( p_this, "Destroyed" );
 }
 
 static void FetcherDestructor( vlc_object_t * p_this )
 {
     playlist_fetcher_t * p_fetcher = (playlist_fetcher_t *)p_this;
-    free( p_fetcher->pp_waiting );
+    free( p_fetcher->queue.p_waiting );
     msg_Dbg( p_this, "Destroyed" );
 }
@@ -77,6 +77,7 @@ playlist_item_t * playlist_NodeCreate( playlist_t *p_playlist,
     p_item->i_children = 0;
 
     ARRAY_APPEND(p_playlist->all_items, p_item);
+    playlist_IndexAdd( p_playlist, p_item );
 
     if( p_parent != NULL )
         playlist_NodeAppend( p_playlist, p_item, p_parent );
@@ -169,6 +170,7 @@ int playlist_NodeDelete( playlist_t *p_playlist, playlist_item_t *p_root,
                        p_root->i_id, i );
         if( i != -1 )
             ARRAY_REMOVE( p_playlist->all_items, i );
+        playlist_IndexRemove( p_playlist, p_root );
 
         /* Remove the item from its parent */
         if( p_root->p_parent )
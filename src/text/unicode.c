@@ -666,6 +666,64 @@ int utf8_unlink( const char *filename )
     return ret;
 }
 
+/**
+ * Renames a file, replacing the destination if it exists. On POSIX systems
+ * the replacement is atomic: the destination always refers either to the
+ * old or to the new file.
+ *
+ * @param oldpath a UTF-8 string with the current name of the file
+ * @param newpath a UTF-8 string with the new name of the file
+ * @return A 0 return value indicates success. A -1 return value indicates an
+ *        error, and an error code is stored in errno
+ */
+int utf8_rename( const char *oldpath, const char *newpath )
+{
+#if defined (WIN32) && !defined (UNDER_CE)
+    if( GetVersion() < 0x80000000 )
+    {
+        /* for Windows NT and above */
+        wchar_t wold[MAX_PATH + 1], wnew[MAX_PATH + 1];
+
+        if( !MultiByteToWideChar( CP_UTF8, 0, oldpath, -1, wold, MAX_PATH )
+         || !MultiByteToWideChar( CP_UTF8, 0, newpath, -1, wnew, MAX_PATH ) )
+        {
+            errno = ENOENT;
+            return -1;
+        }
+        wold[MAX_PATH] = wnew[MAX_PATH] = L'\0';
+
+        /* rename() does not replace an existing file on Windows */
+        if( !MoveFileExW( wold, wnew, MOVEFILE_REPLACE_EXISTING ) )
+        {
+            errno = EACCES;
+            return -1;
+        }
+        return 0;
+    }
+#endif
+    const char *local_old = ToLocale( oldpath );
+
+    if( local_old == NULL )
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    const char *local_new = ToLocale( newpath );
+
+    if( local_new == NULL )
+    {
+        LocaleFree( local_old );
+        errno = ENOENT;
+        return -1;
+    }
+
+    int ret = rename( local_old, local_new );
+    LocaleFree( local_new );
+    LocaleFree( local_old );
+    return ret;
+}
+
 
 
 /**
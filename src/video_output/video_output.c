@@ -802,6 +802,7 @@ static void* RunThread( vlc_object_t *p_this )
     bool            b_drop_late;
 
     int             i_displayed = 0, i_lost = 0;
+    mtime_t         i_lateness = -1;
 /*
     vlc_event_t event;
     libvlc_priv_t *p_priv;
@@ -866,14 +867,17 @@ static void* RunThread( vlc_object_t *p_this )
         p_input = vlc_object_find( p_vout, VLC_OBJECT_INPUT, FIND_PARENT );
         if( p_input )
         {
-            vlc_mutex_lock( &p_input->p->counters.counters_lock );
             stats_UpdateInteger( p_vout, p_input->p->counters.p_lost_pictures,
                                  i_lost , NULL);
             stats_UpdateInteger( p_vout,
                                  p_input->p->counters.p_displayed_pictures,
                                  i_displayed , NULL);
             i_displayed = i_lost = 0;
-            vlc_mutex_unlock( &p_input->p->counters.counters_lock );
+            if( i_lateness >= 0 )
+                stats_UpdateHistogram( p_vout,
+                                       p_input->p->counters.p_picture_lateness,
+                                       i_lateness );
+            i_lateness = -1;
             vlc_object_release( p_input );
         }
 
@@ -1071,6 +1075,8 @@ static void* RunThread( vlc_object_t *p_this )
             /* Display the direct buffer returned by vout_RenderPicture */
             if( p_vout->pf_display )
                 p_vout->pf_display( p_vout, p_directbuffer );
+            if( display_date != 0 )
+                i_lateness = __MAX( mdate() - display_date, 0 );
 
             /* Tell the vout this was the last picture and that it does not
              * need to be forced anymore. */
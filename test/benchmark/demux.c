@@ -0,0 +1,281 @@
+/*
+ * demux.c - demux and decode throughput benchmark
+ *
+ * $Id$
+ */
+
+/**********************************************************************
+ *  Copyright (C) 2008 the VideoLAN team                              *
+ *  This program is free software; you can redistribute and/or modify *
+ *  it under the terms of the GNU General Public License as published *
+ *  by the Free Software Foundation; version 2 of the license, or (at *
+ *  your option) any later version.                                   *
+ *                                                                    *
+ *  This program is distributed in the hope that it will be useful,   *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of    *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *  See the GNU General Public License for more details.              *
+ *                                                                    *
+ *  You should have received a copy of the GNU General Public License *
+ *  along with this program; if not, you can get it from:             *
+ *  http://www.gnu.org/copyleft/gpl.html                              *
+ **********************************************************************/
+
+/* Pushes each sample as fast as possible through the real input chain,
+ * with every output discarded, in two passes:
+ *  - "demux": access, demux and packetizers, into a dummy stream output;
+ *  - "decode": the same plus the decoders, transcoding to dummy encoders.
+ * The CPU time of the decoders is the difference between both passes.
+ *
+ * Samples are given on the command line, or generated with
+ * "make bench-samples" into samples/bench/. With -m, one line of
+ * tab-separated key=value pairs is printed per sample and pass. */
+
+#include "../libvlc/test.h"
+
+#include <string.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+static const char *passes[][2] = {
+    { "demux",  ":sout=#dummy" },
+    { "decode", ":sout=#transcode{vcodec=I420,venc=dummy,"
+                "acodec=s16l,aenc=dummy,hurry-up=false}:dummy" },
+};
+
+static const char *default_samples[] = {
+    "samples/bench/sample.ts",
+    "samples/bench/sample.mp4",
+    "samples/bench/sample.mkv",
+    "samples/bench/sample.avi",
+    "samples/bench/sample.ogg",
+};
+
+typedef struct
+{
+    double wall;    /* seconds */
+    double cpu;     /* seconds, user + system */
+    long   rss;     /* peak resident set size, kB */
+    libvlc_media_stats_t stats;
+} result_t;
+
+static double now (void)
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.;
+}
+
+static double cpu_time (void)
+{
+    struct rusage ru;
+
+    getrusage (RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1000000.
+         + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1000000.;
+}
+
+/* On Linux, the peak RSS can be reset so that it covers one run only.
+ * Elsewhere, the process-wide maximum is reported. */
+static void reset_peak_rss (void)
+{
+    FILE *stream = fopen ("/proc/self/clear_refs", "w");
+
+    if (stream != NULL)
+    {
+        fputs ("5", stream);
+        fclose (stream);
+    }
+}
+
+static long peak_rss (void)
+{
+    FILE *stream = fopen ("/proc/self/status", "r");
+    struct rusage ru;
+    char line[128];
+    long kb = -1;
+
+    if (stream != NULL)
+    {
+        while (fgets (line, sizeof (line), stream) != NULL)
+            if (sscanf (line, "VmHWM: %ld kB", &kb) == 1)
+                break;
+        fclose (stream);
+    }
+    if (kb >= 0)
+        return kb;
+
+    getrusage (RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static bool run (libvlc_instance_t *vlc, const char *path, const char *opt,
+                 result_t *res)
+{
+    libvlc_media_t *md;
+    libvlc_media_player_t *mp;
+    libvlc_state_t state;
+    double wall, cpu;
+    bool ok;
+
+    md = libvlc_media_new (vlc, path, &ex);
+    catch ();
+    libvlc_media_add_option (md, opt, &ex);
+    catch ();
+    mp = libvlc_media_player_new_from_media (md, &ex);
+    catch ();
+
+    reset_peak_rss ();
+    wall = now ();
+    cpu = cpu_time ();
+
+    libvlc_media_player_play (mp, &ex);
+    catch ();
+    do
+    {
+        usleep (1000);
+        state = libvlc_media_player_get_state (mp, &ex);
+        catch ();
+    }
+    while (state != libvlc_Ended && state != libvlc_Error);
+
+    res->wall = now () - wall;
+    res->cpu = cpu_time () - cpu;
+    res->rss = peak_rss ();
+
+    /* Stopping joins the input thread, which flushes the statistics */
+    libvlc_media_player_stop (mp, &ex);
+    catch ();
+
+    ok = state == libvlc_Ended
+      && libvlc_media_get_stats (md, &res->stats, &ex);
+    catch ();
+
+    libvlc_media_player_release (mp);
+    libvlc_media_release (md);
+    return ok;
+}
+
+static void report (const char *path, const char *pass, off_t size,
+                    const result_t *res, const result_t *base,
+                    bool machine)
+{
+    const libvlc_media_stats_t *st = &res->stats;
+    double mbps = size / res->wall / 1000000.;
+    double pps = st->i_demux_read_packets / res->wall;
+    /* CPU time spent in this pass only, i.e. in the decoders */
+    double own = base ? res->cpu - base->cpu : res->cpu;
+
+    if (machine)
+    {
+        printf ("sample=%s\tpass=%s\tbytes=%lld\twall_s=%.6f\tcpu_s=%.6f\t"
+                "module_cpu_s=%.6f\tmb_per_s=%.3f\tpackets=%d\t"
+                "packets_per_s=%.1f\tdecoded_video=%d\tdecoded_audio=%d\t"
+                "peak_rss_kb=%ld\n", path, pass, (long long)size,
+                res->wall, res->cpu, own, mbps, st->i_demux_read_packets,
+                pps, st->i_decoded_video, st->i_decoded_audio, res->rss);
+        return;
+    }
+
+    printf ("%-28s %-6s %8.2f MB/s %10.0f pkt/s  cpu %7.3f s "
+            "(%s %7.3f s)  rss %6ld kB\n", path, pass, mbps, pps,
+            res->cpu, pass, own, res->rss);
+}
+
+static void usage (const char *name)
+{
+    fprintf (stderr, "Usage: %s [-m] [-n runs] [sample...]\n"
+             " -m       machine-readable output\n"
+             " -n runs  keep the fastest of that many runs (default 3)\n",
+             name);
+    exit (1);
+}
+
+int main (int argc, char *argv[])
+{
+    static const char *args[] = {
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--plugin-path=../modules",
+        "--vout=dummy",
+        "--aout=dummy",
+        "--stats",
+    };
+    const int nargs = sizeof (args) / sizeof (args[0]);
+    const char **samples = default_samples;
+    unsigned nsamples = sizeof (default_samples) / sizeof (default_samples[0]);
+    unsigned runs = 3;
+    bool machine = false;
+    libvlc_instance_t *vlc;
+    int c;
+
+    while ((c = getopt (argc, argv, "mn:")) != -1)
+        switch (c)
+        {
+            case 'm':
+                machine = true;
+                break;
+            case 'n':
+                runs = strtoul (optarg, NULL, 0);
+                if (runs == 0)
+                    runs = 1;
+                break;
+            default:
+                usage (argv[0]);
+        }
+
+    if (optind < argc)
+    {
+        samples = (const char **)argv + optind;
+        nsamples = argc - optind;
+    }
+
+    test_init ();
+    alarm (0); /* this may take longer than a regular test */
+
+    libvlc_exception_init (&ex);
+    vlc = libvlc_new (nargs, args, &ex);
+    catch ();
+
+    for (unsigned i = 0; i < nsamples; i++)
+    {
+        const char *path = samples[i];
+        result_t best[2];
+        struct stat st;
+
+        if (stat (path, &st))
+        {
+            fprintf (stderr, "%s: skipped (%m)\n", path);
+            continue;
+        }
+
+        for (unsigned p = 0; p < 2; p++)
+        {
+            best[p].wall = -1.;
+            for (unsigned r = 0; r < runs; r++)
+            {
+                result_t res;
+
+                if (!run (vlc, path, passes[p][1], &res))
+                {
+                    fprintf (stderr, "%s: %s pass failed\n", path,
+                             passes[p][0]);
+                    break;
+                }
+                if (best[p].wall < 0. || res.wall < best[p].wall)
+                    best[p] = res;
+            }
+            if (best[p].wall < 0.)
+                break;
+            report (path, passes[p][0], st.st_size, best + p,
+                    p ? best : NULL, machine);
+        }
+    }
+
+    libvlc_release (vlc);
+    return 0;
+}
@@ -0,0 +1,35 @@
+#!/bin/sh
+# samples.sh - generates the demux benchmark samples
+#
+# Usage: samples.sh [directory] [duration]
+#
+# Needs an ffmpeg binary with its lavfi test sources. Each container gets
+# codecs that the avcodec plugin can decode; Ogg gets Theora and Vorbis.
+
+DIR="${1:-samples/bench}"
+DURATION="${2:-60}"
+FFMPEG="${FFMPEG:-ffmpeg}"
+
+if ! "$FFMPEG" -version >/dev/null 2>&1; then
+	echo "$0: $FFMPEG not found, cannot generate samples" >&2
+	exit 1
+fi
+
+mkdir -p "$DIR" || exit 1
+
+SRC="-f lavfi -i testsrc=duration=$DURATION:size=720x576:rate=25 \
+ -f lavfi -i sine=frequency=440:duration=$DURATION:sample_rate=48000"
+
+gen() {
+	out="$DIR/sample.$1"
+	shift
+	test -f "$out" && return 0
+	echo "Generating $out"
+	"$FFMPEG" -loglevel error -y $SRC "$@" "$out"
+}
+
+gen ts  -c:v mpeg2video -b:v 6M -c:a mp2 -b:a 192k -f mpegts || exit 1
+gen mp4 -c:v mpeg4 -b:v 4M -c:a aac -b:a 128k || exit 1
+gen mkv -c:v mpeg4 -b:v 4M -c:a mp2 -b:a 192k || exit 1
+gen avi -c:v mpeg4 -b:v 4M -c:a mp2 -b:a 192k || exit 1
+gen ogg -c:v libtheora -b:v 4M -c:a libvorbis -b:a 128k || exit 1
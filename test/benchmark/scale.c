@@ -0,0 +1,224 @@
+/*
+ * scale.c - video scaling filters benchmark
+ *
+ * $Id$
+ */
+
+/**********************************************************************
+ *  Copyright (C) 2009 the VideoLAN team                              *
+ *  This program is free software; you can redistribute and/or modify *
+ *  it under the terms of the GNU General Public License as published *
+ *  by the Free Software Foundation; version 2 of the license, or (at *
+ *  your option) any later version.                                   *
+ *                                                                    *
+ *  This program is distributed in the hope that it will be useful,   *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of    *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *  See the GNU General Public License for more details.              *
+ *                                                                    *
+ *  You should have received a copy of the GNU General Public License *
+ *  along with this program; if not, you can get it from:             *
+ *  http://www.gnu.org/copyleft/gpl.html                              *
+ **********************************************************************/
+
+/* Scales I420 pictures with the native scaler (C and SSE2 versions) and
+ * with swscale, in each of their comparable modes, for a few typical
+ * conversions. The modules which are not available are skipped.
+ * Options after the picture count are given to libvlc, e.g.
+ * "bench_scale 100 --worker-threads=1" to scale without slices. */
+
+#define MODULE_STRING "bench" /* for the messages of vlc_filter.h */
+
+#include "../libvlc/test.h"
+#include "../../src/control/libvlc_internal.h"
+
+#include <vlc_vout.h>
+#include <vlc_filter.h>
+
+#include <string.h>
+#include <sys/time.h>
+
+static const struct
+{
+    int src_width, src_height;
+    int dst_width, dst_height;
+} sizes[] = {
+    { 1920, 1080, 1280,  720 },
+    { 1920, 1080,  480,  270 }, /* mosaic tile */
+    { 3840, 2160, 1920, 1080 },
+    {  720,  576, 1920, 1080 },
+};
+
+static const struct
+{
+    const char *module;
+    const char *option;
+    int mode;
+    const char *name;
+} scalers[] = {
+    { "scale",      "scale-mode",   0, "nearest" },
+    { "scale",      "scale-mode",   1, "bilinear" },
+    { "scale",      "scale-mode",   2, "bicubic" },
+    { "scale",      "scale-mode",   3, "area" },
+    { "scale_sse2", "scale-mode",   1, "bilinear" },
+    { "scale_sse2", "scale-mode",   2, "bicubic" },
+    { "scale_sse2", "scale-mode",   3, "area" },
+    { "swscale",    "swscale-mode", 1, "bilinear" },
+    { "swscale",    "swscale-mode", 2, "bicubic" },
+    { "swscale",    "swscale-mode", 5, "area" },
+};
+
+static double now (void)
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.;
+}
+
+static void video_format (es_format_t *fmt, int width, int height)
+{
+    es_format_Init (fmt, VIDEO_ES, VLC_FOURCC('I','4','2','0'));
+    fmt->video.i_chroma = VLC_FOURCC('I','4','2','0');
+    fmt->video.i_width = fmt->video.i_visible_width = width;
+    fmt->video.i_height = fmt->video.i_visible_height = height;
+    fmt->video.i_aspect = VOUT_ASPECT_FACTOR * width / height;
+}
+
+/* The same output picture is used again and again, so that its allocation
+ * is not measured */
+static picture_t *buffer_new (filter_t *filter)
+{
+    picture_t *pic = (picture_t *)filter->p_owner;
+
+    picture_Yield (pic);
+    return pic;
+}
+
+static void buffer_del (filter_t *filter, picture_t *pic)
+{
+    (void)filter;
+    picture_Release (pic);
+}
+
+static int buffer_init (filter_t *filter, void *data)
+{
+    filter->pf_vout_buffer_new = buffer_new;
+    filter->pf_vout_buffer_del = buffer_del;
+    filter->p_owner = data;
+    return VLC_SUCCESS;
+}
+
+/* Returns the best time per picture, or a negative value if the module
+ * cannot do the conversion */
+static double bench_scale (vlc_object_t *obj, const char *module,
+                           picture_t *pic, const es_format_t *in,
+                           const es_format_t *out, unsigned count)
+{
+    filter_chain_t *chain;
+    picture_t *dst;
+    double best = 1e9;
+
+    dst = picture_New (out->video.i_chroma, out->video.i_width,
+                       out->video.i_height, out->video.i_aspect);
+    assert (dst != NULL);
+    chain = filter_chain_New (obj, "video filter2", false, buffer_init, NULL,
+                              dst);
+    assert (chain != NULL);
+    filter_chain_Reset (chain, in, out);
+    if (filter_chain_AppendFilter (chain, module, NULL, in, out) == NULL)
+    {
+        filter_chain_Delete (chain);
+        picture_Release (dst);
+        return -1.;
+    }
+
+    for (unsigned i = 0; i <= count; i++)
+    {
+        double start = now ();
+        picture_t *res;
+
+        picture_Yield (pic);
+        res = filter_chain_VideoFilter (chain, pic);
+        assert (res != NULL);
+        picture_Release (res);
+
+        double elapsed = now () - start;
+        if (i > 0 && elapsed < best) /* the first one computes tables */
+            best = elapsed;
+    }
+    filter_chain_Delete (chain);
+    picture_Release (dst);
+    return best;
+}
+
+int main (int argc, char *argv[])
+{
+    const char *args[16] = {
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--plugin-path=../modules",
+    };
+    int nargs = 5;
+    unsigned count = (argc > 1) ? strtoul (argv[1], NULL, 0) : 50;
+    libvlc_instance_t *vlc;
+    vlc_object_t *obj;
+
+    if (count == 0)
+        count = 1;
+    for (int i = 2; i < argc && nargs < 16; i++)
+        args[nargs++] = argv[i];
+
+    test_init ();
+    alarm (0); /* this may take longer than a regular test */
+
+    libvlc_exception_init (&ex);
+    vlc = libvlc_new (nargs, args, &ex);
+    catch ();
+    obj = VLC_OBJECT (vlc->p_libvlc_int);
+
+    for (unsigned s = 0; s < sizeof (sizes) / sizeof (sizes[0]); s++)
+    {
+        es_format_t in, out;
+        picture_t *pic;
+
+        video_format (&in, sizes[s].src_width, sizes[s].src_height);
+        video_format (&out, sizes[s].dst_width, sizes[s].dst_height);
+        pic = picture_New (in.video.i_chroma, in.video.i_width,
+                           in.video.i_height, in.video.i_aspect);
+        assert (pic != NULL);
+        for (int p = 0; p < pic->i_planes; p++)
+            for (int y = 0; y < pic->p[p].i_lines; y++)
+                for (int x = 0; x < pic->p[p].i_pitch; x++)
+                    pic->p[p].p_pixels[y * pic->p[p].i_pitch + x] =
+                        (x * 7 + y * 3 + p * 64) ^ (x >> 4);
+
+        printf ("%dx%d -> %dx%d\n", in.video.i_width, in.video.i_height,
+                out.video.i_width, out.video.i_height);
+        for (unsigned i = 0; i < sizeof (scalers) / sizeof (scalers[0]); i++)
+        {
+            double best;
+
+            var_Create (obj, scalers[i].option, VLC_VAR_INTEGER);
+            var_SetInteger (obj, scalers[i].option, scalers[i].mode);
+            best = bench_scale (obj, scalers[i].module, pic, &in, &out, count);
+            var_Destroy (obj, scalers[i].option);
+
+            if (best < 0.)
+                printf ("  %-10s %-8s  not available\n", scalers[i].module,
+                        scalers[i].name);
+            else
+                printf ("  %-10s %-8s %8.2f ms %8.1f fps\n",
+                        scalers[i].module, scalers[i].name, 1000. * best,
+                        1. / best);
+        }
+        picture_Release (pic);
+        es_format_Clean (&in);
+        es_format_Clean (&out);
+    }
+
+    libvlc_release (vlc);
+    return 0;
+}
@@ -0,0 +1,269 @@
+/*
+ * startcode.c - start code scanner benchmark
+ *
+ * $Id$
+ */
+
+/**********************************************************************
+ *  Copyright (C) 2008 the VideoLAN team                              *
+ *  This program is free software; you can redistribute and/or modify *
+ *  it under the terms of the GNU General Public License as published *
+ *  by the Free Software Foundation; version 2 of the license, or (at *
+ *  your option) any later version.                                   *
+ *                                                                    *
+ *  This program is distributed in the hope that it will be useful,   *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of    *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *  See the GNU General Public License for more details.              *
+ *                                                                    *
+ *  You should have received a copy of the GNU General Public License *
+ *  along with this program; if not, you can get it from:             *
+ *  http://www.gnu.org/copyleft/gpl.html                              *
+ **********************************************************************/
+
+/* Splits an elementary stream into blocks, as a demuxer would, and finds
+ * every 00 00 01 start code with block_FindStartcodeFromOffset(), compared
+ * with the former byte by byte search. Both must find the same offsets.
+ * The elementary stream is read from a file, e.g. as written by the es
+ * stream output. Without a file argument, a random stream with a start code about every
+ * 2 kB is used. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block_helper.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* Former implementation, for reference */
+static int FindStartcodeRef( block_bytestream_t *p_bytestream,
+                             size_t *pi_offset, uint8_t *p_startcode,
+                             int i_startcode_length )
+{
+    block_t *p_block, *p_block_backup = 0;
+    int i_size = 0;
+    size_t i_offset, i_offset_backup = 0;
+    int i_caller_offset_backup = 0, i_match;
+
+    i_size = *pi_offset + p_bytestream->i_offset;
+    for( p_block = p_bytestream->p_block;
+         p_block != NULL; p_block = p_block->p_next )
+    {
+        i_size -= p_block->i_buffer;
+        if( i_size < 0 ) break;
+    }
+
+    if( i_size >= 0 )
+        return VLC_EGENERIC;
+
+    i_size += p_block->i_buffer;
+    *pi_offset -= i_size;
+    i_match = 0;
+    for( ; p_block != NULL; p_block = p_block->p_next )
+    {
+        for( i_offset = i_size; i_offset < p_block->i_buffer; i_offset++ )
+        {
+            if( p_block->p_buffer[i_offset] == p_startcode[i_match] )
+            {
+                if( !i_match )
+                {
+                    p_block_backup = p_block;
+                    i_offset_backup = i_offset;
+                    i_caller_offset_backup = *pi_offset;
+                }
+
+                if( i_match + 1 == i_startcode_length )
+                {
+                    *pi_offset += i_offset - i_match;
+                    return VLC_SUCCESS;
+                }
+
+                i_match++;
+            }
+            else if ( i_match )
+            {
+                p_block = p_block_backup;
+                i_offset = i_offset_backup;
+                *pi_offset = i_caller_offset_backup;
+                i_match = 0;
+            }
+        }
+        i_size = 0;
+        *pi_offset += i_offset;
+    }
+
+    *pi_offset -= i_match;
+    return VLC_EGENERIC;
+}
+
+typedef int (*find_t)( block_bytestream_t *, size_t *, uint8_t *, int );
+
+static double now (void)
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.;
+}
+
+/* Finds all start codes, skipping the data before each of them like a
+ * packetizer does */
+static unsigned scan (block_t *chain, find_t find, size_t *offsets,
+                      unsigned max)
+{
+    uint8_t startcode[3] = { 0, 0, 1 };
+    block_bytestream_t bs;
+    size_t base = 0, offset = 0;
+    unsigned n = 0;
+
+    bs.p_chain = bs.p_block = chain;
+    bs.i_offset = 0;
+
+    while (find (&bs, &offset, startcode, 3) == VLC_SUCCESS)
+    {
+        if (offsets != NULL && n < max)
+            offsets[n] = base + offset;
+        n++;
+        block_SkipBytes (&bs, offset);
+        base += offset;
+        offset = 1;
+    }
+    return n;
+}
+
+static uint8_t *load (const char *path, size_t *size)
+{
+    uint8_t *buf;
+
+    if (path == NULL)
+    {
+        /* Random payload; zeroes are made rare like in compressed data,
+         * with a start code every 2 kB or so, and a few false positives. */
+        *size = 64 << 20;
+        buf = malloc (*size);
+        assert (buf != NULL);
+        srand (42);
+        for (size_t i = 0; i < *size; i++)
+        {
+            buf[i] = rand () & 0xff;
+            if (buf[i] == 0)
+                buf[i] = 0x80;
+        }
+        for (size_t i = 1000; i + 3 < *size; i += 1000 + rand () % 2000)
+        {
+            buf[i] = buf[i + 1] = 0;
+            buf[i + 2] = (rand () % 4) ? 1 : 2;
+        }
+        return buf;
+    }
+
+    FILE *stream = fopen (path, "rb");
+    if (stream == NULL)
+    {
+        perror (path);
+        exit (1);
+    }
+    fseek (stream, 0, SEEK_END);
+    *size = ftell (stream);
+    rewind (stream);
+    buf = malloc (*size);
+    assert (buf != NULL);
+    if (fread (buf, 1, *size, stream) != *size)
+    {
+        perror (path);
+        exit (1);
+    }
+    fclose (stream);
+    return buf;
+}
+
+int main (int argc, char *argv[])
+{
+    const char *path = NULL;
+    /* TS payload size by default, to stress the block boundaries */
+    size_t blocksize = 184;
+    size_t size, nblocks;
+    uint8_t *buf;
+    block_t *blocks;
+    int c;
+
+    while ((c = getopt (argc, argv, "b:")) != -1)
+        switch (c)
+        {
+            case 'b':
+                blocksize = strtoul (optarg, NULL, 0);
+                break;
+            default:
+                blocksize = 0;
+        }
+    if (blocksize == 0)
+    {
+        fprintf (stderr, "Usage: %s [-b blocksize] [file]\n", argv[0]);
+        return 1;
+    }
+    if (optind < argc)
+        path = argv[optind];
+
+    buf = load (path, &size);
+    nblocks = (size + blocksize - 1) / blocksize;
+    blocks = calloc (nblocks, sizeof (*blocks));
+    assert (blocks != NULL);
+    for (size_t i = 0; i < nblocks; i++)
+    {
+        blocks[i].p_buffer = buf + i * blocksize;
+        blocks[i].i_buffer = (i + 1 < nblocks) ? blocksize
+                                               : size - i * blocksize;
+        blocks[i].p_next = (i + 1 < nblocks) ? blocks + i + 1 : NULL;
+    }
+
+    /* Both implementations must agree */
+    unsigned count = scan (blocks, FindStartcodeRef, NULL, 0);
+    size_t *ref = malloc (count * sizeof (*ref));
+    size_t *fast = malloc (count * sizeof (*fast));
+    assert (ref != NULL && fast != NULL);
+    scan (blocks, FindStartcodeRef, ref, count);
+    assert (scan (blocks, block_FindStartcodeFromOffset, fast, count) == count);
+    for (unsigned i = 0; i < count; i++)
+        assert (ref[i] == fast[i]);
+
+    printf ("%s: %zu bytes in %zu-byte blocks, %u start codes\n",
+            path ? path : "random", size, blocksize, count);
+
+    static const struct
+    {
+        const char *name;
+        find_t find;
+    } impls[] = {
+        { "byte by byte", FindStartcodeRef },
+        { "scanner", block_FindStartcodeFromOffset },
+    };
+
+    for (unsigned i = 0; i < sizeof (impls) / sizeof (impls[0]); i++)
+    {
+        double best = 1e9;
+
+        for (unsigned r = 0; r < 5; r++)
+        {
+            double start = now ();
+            scan (blocks, impls[i].find, NULL, 0);
+            double elapsed = now () - start;
+            if (elapsed < best)
+                best = elapsed;
+        }
+        printf ("%-14s %9.1f MB/s\n", impls[i].name, size / best / 1e6);
+    }
+
+    free (fast);
+    free (ref);
+    free (blocks);
+    free (buf);
+    return 0;
+}
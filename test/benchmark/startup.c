@@ -0,0 +1,95 @@
+/*
+ * startup.c - libvlc start-up time benchmark
+ *
+ * $Id$
+ */
+
+/**********************************************************************
+ *  Copyright (C) 2008 the VideoLAN team                              *
+ *  This program is free software; you can redistribute and/or modify *
+ *  it under the terms of the GNU General Public License as published *
+ *  by the Free Software Foundation; version 2 of the license, or (at *
+ *  your option) any later version.                                   *
+ *                                                                    *
+ *  This program is distributed in the hope that it will be useful,   *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of    *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.              *
+ *  See the GNU General Public License for more details.              *
+ *                                                                    *
+ *  You should have received a copy of the GNU General Public License *
+ *  along with this program; if not, you can get it from:             *
+ *  http://www.gnu.org/copyleft/gpl.html                              *
+ **********************************************************************/
+
+/* Measures how long creating and destroying a short-lived libvlc instance
+ * takes, with and without the plugins cache. The first instance warms the
+ * cache up and is not counted. */
+
+#include "../libvlc/test.h"
+
+#include <string.h>
+#include <sys/time.h>
+
+static double now (void)
+{
+    struct timeval tv;
+
+    gettimeofday (&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.;
+}
+
+static void bench_startup (const char *name, const char **argv, int argc,
+                           unsigned count)
+{
+    double min = 1e9, total = 0.;
+
+    for (unsigned i = 0; i <= count; i++)
+    {
+        double start = now ();
+        libvlc_instance_t *vlc;
+
+        libvlc_exception_init (&ex);
+        vlc = libvlc_new (argc, argv, &ex);
+        catch ();
+        libvlc_release (vlc);
+
+        double elapsed = now () - start;
+        if (i == 0)
+            continue; /* warm-up */
+        total += elapsed;
+        if (elapsed < min)
+            min = elapsed;
+    }
+
+    printf ("%-16s %3u runs: mean %7.2f ms, best %7.2f ms\n", name, count,
+            1000. * total / count, 1000. * min);
+}
+
+int main (int argc, char *argv[])
+{
+    static const char *args[] = {
+        "--ignore-config",
+        "-I",
+        "dummy",
+        "--no-media-library",
+        "--plugin-path=../modules",
+        "--vout=dummy",
+        "--aout=dummy",
+        NULL, /* cache option */
+    };
+    const int nargs = sizeof (args) / sizeof (args[0]);
+    unsigned count = (argc > 1) ? strtoul (argv[1], NULL, 0) : 20;
+
+    if (count == 0)
+        count = 1;
+
+    test_init ();
+    alarm (0); /* this may take longer than a regular test */
+
+    args[nargs - 1] = "--plugins-cache";
+    bench_startup ("plugins cache", args, nargs, count);
+    args[nargs - 1] = "--no-plugins-cache";
+    bench_startup ("no cache", args, nargs, count);
+
+    return 0;
+}